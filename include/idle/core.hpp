@@ -30,6 +30,7 @@
 #include <idle/core/async.hpp>
 #include <idle/core/casting.hpp>
 #include <idle/core/context.hpp>
+#include <idle/core/coroutine.hpp>
 #include <idle/core/declare.hpp>
 #include <idle/core/dep.hpp>
 #include <idle/core/exception.hpp>
@@ -47,6 +48,7 @@
 #include <idle/core/platform.hpp>
 #include <idle/core/ref.hpp>
 #include <idle/core/registry.hpp>
+#include <idle/core/registry_snapshot.hpp>
 #include <idle/core/service.hpp>
 #include <idle/core/stacktrace.hpp>
 #include <idle/core/support.hpp>
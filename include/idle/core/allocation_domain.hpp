@@ -0,0 +1,87 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_ALLOCATION_DOMAIN_HPP_INCLUDED
+#define IDLE_CORE_ALLOCATION_DOMAIN_HPP_INCLUDED
+
+#include <cstddef>
+#include <idle/core/api.hpp>
+#include <idle/core/ref.hpp>
+
+namespace idle {
+/// Represents a region of memory from which reference counted objects and
+/// services are allocated, such that objects belonging together are placed
+/// contiguously in memory and are returned to the system in bulk.
+///
+/// Blocks are handed out in size classes from large slabs and are reused
+/// after their object was deallocated. The slabs are only released after
+/// the domain itself and all objects allocated from it were released.
+///
+/// A domain is used by `make_ref` and `spawn` while it is active through an
+/// AllocationScope, or implicitly by `spawn` for all children of a service
+/// returning the domain from Service::allocationDomain().
+class IDLE_API(idle) AllocationDomain : public ReferenceCounted {
+  friend class AllocationDomainImpl;
+
+  AllocationDomain() = default;
+
+public:
+  struct Statistics {
+    /// The count of slabs that were reserved
+    std::size_t slabs{0};
+    /// The bytes reserved by all slabs
+    std::size_t reserved{0};
+    /// The count of blocks which are currently in use
+    std::size_t blocks{0};
+    /// The bytes of all blocks which are currently in use
+    std::size_t allocated{0};
+  };
+
+  /// Returns the current statistics of this domain
+  Statistics statistics() const noexcept;
+
+  /// Creates a new domain which reserves slabs of the given size
+  static Ref<AllocationDomain> create(std::size_t slab_size = 64U * 1024U);
+};
+
+/// Makes the given AllocationDomain the default for all allocations
+/// through `make_ref` and `spawn` on the current thread while this scope
+/// is alive. Passing a nullptr makes allocations use the heap.
+class IDLE_API(idle) AllocationScope {
+public:
+  explicit AllocationScope(AllocationDomain* domain) noexcept;
+  ~AllocationScope();
+
+  AllocationScope(AllocationScope&&) = delete;
+  AllocationScope(AllocationScope const&) = delete;
+  AllocationScope& operator=(AllocationScope&&) = delete;
+  AllocationScope& operator=(AllocationScope const&) = delete;
+
+private:
+  AllocationDomain* previous_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_ALLOCATION_DOMAIN_HPP_INCLUDED
@@ -0,0 +1,78 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_COMPOSITION_HPP_INCLUDED
+#define IDLE_CORE_COMPOSITION_HPP_INCLUDED
+
+#include <cstddef>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/ref.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/util/span.hpp>
+
+namespace idle {
+/// Represents the frozen startup order of a set of services whose
+/// dependencies don't change anymore, as it is the case for services
+/// that are linked statically into the same binary.
+///
+/// A StaticComposition is created once through Context::compose and can be
+/// started repeatedly through Context::start, which marks the clusters
+/// in their precomputed order instead of traversing the dependency graph.
+class IDLE_API(idle) StaticComposition {
+  friend class Scheduler;
+
+public:
+  struct Entry {
+    /// The head of the cluster
+    WeakRef<Service> head;
+    /// Is true if the cluster was requested explicitly,
+    /// otherwise it is a transitive dependency of a requested cluster.
+    bool requested;
+    /// Is true if no other cluster of the composition depends on it
+    bool sink;
+  };
+
+  StaticComposition() = default;
+
+  /// Returns the clusters ordered such that every cluster is placed
+  /// after all of its dependencies.
+  Span<Entry const> entries() const noexcept {
+    return {entries_.data(), entries_.size()};
+  }
+
+  std::size_t size() const noexcept {
+    return entries_.size();
+  }
+  bool empty() const noexcept {
+    return entries_.empty();
+  }
+
+private:
+  std::vector<Entry> entries_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_COMPOSITION_HPP_INCLUDED
@@ -29,11 +29,15 @@
 #include <cstddef>
 #include <iosfwd>
 #include <type_traits>
+#include <vector>
 #include <idle/core/api.hpp>
+#include <idle/core/composition.hpp>
 #include <idle/core/dep/continuable.hpp>
+#include <idle/core/dep/function.hpp>
 #include <idle/core/fwd.hpp>
 #include <idle/core/parts/container.hpp>
 #include <idle/core/ref.hpp>
+#include <idle/core/registry_snapshot.hpp>
 #include <idle/core/service.hpp>
 #include <idle/core/support.hpp>
 #include <idle/core/util/assert.hpp>
@@ -43,6 +47,8 @@
 
 namespace idle {
 class RegistryImplementation;
+class Metrics;
+class Tracing;
 
 class IDLE_API(idle) Context : public Implements<Container>,
                                public Locality,
@@ -73,6 +79,8 @@ public:
   /// The parent of the context is always the context itself.
   using Service::parent;
 
+  using Service::start;
+
   /// Runs the context, this will block the current thread
   /// until Context::stop is called.
   int run();
@@ -81,6 +89,36 @@ public:
   /// its correct intended state again.
   continuable<> update();
 
+  /// Updates the given services and all services which transitively
+  /// depend on them, without visiting the rest of the system.
+  ///
+  /// The affected services are started in topological waves,
+  /// such that a service is only started after its dependencies.
+  continuable<> update(std::vector<WeakRef<Service>> origins);
+
+  /// Freezes the dependency graph of the given services into
+  /// a StaticComposition, which contains their clusters and the clusters
+  /// of their transitive dependencies in topological order.
+  ///
+  /// \attention This method needs to be called from the event loop!
+  StaticComposition compose(std::vector<WeakRef<Service>> const& services);
+
+  /// Starts the services of the given composition without traversing
+  /// the dependency graph, the returned continuable is resolved
+  /// when all requested services are running.
+  ///
+  /// \attention This method needs to be called from the event loop!
+  continuable<> start(StaticComposition const& composition);
+
+  /// Sets a handler which is invoked from the event loop whenever it ran
+  /// out of queued work, instead of blocking until new work arrives.
+  ///
+  /// The handler returns true if it made progress, which makes the event loop
+  /// poll its queue again. This is used to drive a Simulation inline.
+  ///
+  /// \attention This method needs to be called from the event loop!
+  void setIdleHandler(unique_function<bool()> handler) noexcept;
+
   /// Stops the context and all registered child objects,
   /// and lets run return with the given exit code.
   continuable<> stop(int exit_code = 0);
@@ -101,6 +139,12 @@ public:
     return find(Interface::id());
   }
 
+  /// Returns the latest published snapshot of all registries
+  ///
+  /// This method can be called from any thread, the snapshot stays valid
+  /// as long as the returned view is alive and never blocks the event loop.
+  RegistryView snapshot() const noexcept;
+
   /// Creates a new context
   static Ref<Context> create();
 
@@ -109,6 +153,12 @@ public:
 
   bool verify(std::ostream& os) noexcept;
 
+  /// Returns the metrics of the scheduler and the service lifecycle
+  Metrics& metrics() noexcept;
+
+  /// Returns the tracing of the service lifecycle and plugin reloads
+  Tracing& tracing() noexcept;
+
 private:
   bool can_dispatch_inplace() const noexcept;
   void queue(work work) noexcept;
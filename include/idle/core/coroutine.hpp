@@ -0,0 +1,455 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_COROUTINE_HPP_INCLUDED
+#define IDLE_CORE_COROUTINE_HPP_INCLUDED
+
+#include <cstddef>
+#include <idle/core/api.hpp>
+#include <idle/core/exception.hpp>
+
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+#  define IDLE_HAS_COROUTINES
+#endif
+
+#ifdef IDLE_HAS_COROUTINES
+#  include <atomic>
+#  include <coroutine>
+#  include <exception>
+#  include <tuple>
+#  include <type_traits>
+#  include <utility>
+#  include <idle/core/context.hpp>
+#  include <idle/core/dep/continuable.hpp>
+#  include <idle/core/dep/optional.hpp>
+#  include <idle/core/detail/unreachable.hpp>
+#  include <idle/core/util/assert.hpp>
+#endif
+
+namespace idle {
+/// Is thrown out of a `co_await` on a continuable that was cancelled.
+///
+/// A task that ends through this exception is resolved as cancelled
+/// when it is converted back into a continuable.
+class IDLE_API(idle) CancellationException : public AsyncException {
+public:
+  CancellationException();
+
+  char const* what() const noexcept override;
+};
+
+namespace detail {
+/// Allocates a coroutine frame from the frame pool of the current thread
+IDLE_API(idle) void* allocate_coroutine_frame(std::size_t size);
+
+/// Returns a frame allocated through allocate_coroutine_frame to the
+/// frame pool of the current thread.
+IDLE_API(idle)
+void deallocate_coroutine_frame(void* frame, std::size_t size) noexcept;
+} // namespace detail
+
+#ifdef IDLE_HAS_COROUTINES
+template <typename T = void>
+class Task;
+
+namespace detail {
+/// Makes the coroutine frames of a promise_type use the frame pool
+struct pooled_frame {
+  static void* operator new(std::size_t size) {
+    return allocate_coroutine_frame(size);
+  }
+  static void operator delete(void* frame, std::size_t size) noexcept {
+    deallocate_coroutine_frame(frame, size);
+  }
+};
+
+template <typename... Args>
+struct await_result : std::common_type<std::tuple<Args...>> {};
+template <>
+struct await_result<> : std::common_type<void> {};
+template <typename T>
+struct await_result<T> : std::common_type<T> {};
+
+/// Suspends the awaiting coroutine until the continuable is resolved
+template <typename Continuable, typename... Args>
+class continuable_awaiter {
+  using result_t = typename await_result<Args...>::type;
+
+  struct callback {
+    template <typename... Values>
+    void operator()(Values&&... values) {
+      me->value_.emplace(std::forward<Values>(values)...);
+      me->complete();
+    }
+    void operator()(exception_arg_t, exception_t exception) {
+      me->exception_ = std::move(exception);
+      me->complete();
+    }
+
+    continuable_awaiter* me;
+  };
+
+public:
+  explicit continuable_awaiter(Continuable&& continuation)
+    : continuation_(std::move(continuation)) {}
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    std::move(continuation_).next(callback{this}).done();
+
+    // The flag is set already when the continuable was resolved inside next,
+    // in that case we resume directly instead of recursing into the handle.
+    if (completed_.exchange(true, std::memory_order_acq_rel)) {
+      return handle;
+    } else {
+      return std::noop_coroutine();
+    }
+  }
+
+  result_t await_resume() {
+    if (exception_) {
+      std::rethrow_exception(std::move(exception_));
+    }
+    if (!value_) {
+      throw CancellationException();
+    }
+
+    if constexpr (sizeof...(Args) == 0) {
+      return;
+    } else if constexpr (sizeof...(Args) == 1) {
+      return std::get<0>(std::move(*value_));
+    } else {
+      return std::move(*value_);
+    }
+  }
+
+private:
+  void complete() {
+    if (completed_.exchange(true, std::memory_order_acq_rel)) {
+      handle_.resume();
+    }
+  }
+
+  Continuable continuation_;
+  std::coroutine_handle<> handle_;
+  std::atomic<bool> completed_{false};
+  optional<std::tuple<Args...>> value_;
+  exception_t exception_;
+};
+
+class task_promise_base : public pooled_frame {
+  struct final_awaiter {
+    bool await_ready() const noexcept {
+      return false;
+    }
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      // Symmetric transfer to the awaiting coroutine
+      task_promise_base& me = handle.promise();
+      return me.continuation_;
+    }
+    void await_resume() const noexcept {}
+  };
+
+public:
+  std::suspend_always initial_suspend() const noexcept {
+    return {};
+  }
+  final_awaiter final_suspend() const noexcept {
+    return {};
+  }
+
+  void unhandled_exception() noexcept {
+    exception_ = std::current_exception();
+  }
+
+  template <typename Data, typename... Args>
+  auto await_transform(
+      continuable_base<Data, cti::signature_arg_t<Args...>>&& continuation) {
+    using continuable_t = continuable_base<Data, cti::signature_arg_t<Args...>>;
+    return continuable_awaiter<continuable_t, Args...>(std::move(continuation));
+  }
+  template <typename Awaitable>
+  Awaitable&& await_transform(Awaitable&& awaitable) noexcept {
+    return std::forward<Awaitable>(awaitable);
+  }
+
+  void set_continuation(std::coroutine_handle<> continuation) noexcept {
+    continuation_ = continuation;
+  }
+
+protected:
+  void rethrow_if_exceptional() {
+    if (exception_) {
+      std::rethrow_exception(std::move(exception_));
+    }
+  }
+
+private:
+  std::coroutine_handle<> continuation_{std::noop_coroutine()};
+  std::exception_ptr exception_;
+};
+
+template <typename T>
+class task_promise final : public task_promise_base {
+public:
+  Task<T> get_return_object() noexcept;
+
+  template <typename Value>
+  void return_value(Value&& value) {
+    value_.emplace(std::forward<Value>(value));
+  }
+
+  T result() {
+    rethrow_if_exceptional();
+    return std::move(*value_);
+  }
+
+private:
+  optional<T> value_;
+};
+
+template <>
+class task_promise<void> final : public task_promise_base {
+public:
+  Task<void> get_return_object() noexcept;
+
+  void return_void() const noexcept {}
+
+  void result() {
+    rethrow_if_exceptional();
+  }
+};
+
+/// The eagerly started coroutine that resolves a continuable promise
+/// from the outcome of a Task.
+struct detached_task {
+  struct promise_type : pooled_frame {
+    detached_task get_return_object() const noexcept {
+      return {};
+    }
+    std::suspend_never initial_suspend() const noexcept {
+      return {};
+    }
+    std::suspend_never final_suspend() const noexcept {
+      return {};
+    }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept {
+      IDLE_DETAIL_UNREACHABLE();
+    }
+  };
+};
+
+template <typename T, typename Promise>
+detached_task launch_task(Task<T> task, Promise promise) {
+  optional<std::conditional_t<std::is_void<T>::value, bool, T>> value;
+  exception_t exception;
+  bool canceled = false;
+
+  try {
+    if constexpr (std::is_void<T>::value) {
+      co_await std::move(task);
+      value.emplace(true);
+    } else {
+      value.emplace(co_await std::move(task));
+    }
+  } catch (CancellationException const&) {
+    canceled = true;
+  } catch (...) {
+    exception = std::current_exception();
+  }
+
+  if (value) {
+    if constexpr (std::is_void<T>::value) {
+      promise.set_value();
+    } else {
+      promise.set_value(std::move(*value));
+    }
+  } else if (canceled) {
+    promise.set_canceled();
+  } else {
+    promise.set_exception(std::move(exception));
+  }
+}
+
+template <typename T>
+struct task_continuable : std::common_type<continuable<T>> {};
+template <>
+struct task_continuable<void> : std::common_type<continuable<>> {};
+
+template <typename Executor>
+class resume_on_awaiter {
+public:
+  explicit resume_on_awaiter(Executor& executor, bool ready) noexcept
+    : executor_(executor)
+    , ready_(ready) {}
+
+  bool await_ready() const noexcept {
+    return ready_;
+  }
+  void await_suspend(std::coroutine_handle<> handle) {
+    executor_.post([handle] {
+      handle.resume();
+    });
+  }
+  void await_resume() const noexcept {}
+
+private:
+  Executor& executor_;
+  bool ready_;
+};
+} // namespace detail
+
+/// Represents a lazily started coroutine that yields a T
+///
+/// A Task is started when it is awaited from another coroutine or when
+/// the continuable it was converted into is started. This makes it possible
+/// to return a Task from Service::onStart and Service::onStop:
+/// ```cpp
+/// continuable<> onStart() override {
+///   return startAsync();
+/// }
+///
+/// Task<> startAsync() {
+///   co_await timer_->waitFor(std::chrono::seconds(1));
+///   co_await resume_on(root());
+///   FileChanges changes = co_await watcher_->watch();
+/// }
+/// ```
+///
+/// Every continuable can be awaited inside a Task, which includes
+/// Timer::waitFor, FileWatcher::watch and ProcessGroup::spawnProcess.
+/// An exceptional continuable rethrows its exception, and a cancelled one
+/// throws a CancellationException.
+///
+/// The completion of a Task resumes its awaiter through symmetric transfer,
+/// and all coroutine frames are allocated from a thread local frame pool,
+/// such that chains of Tasks don't allocate in the steady state.
+template <typename T>
+class Task {
+public:
+  using promise_type = detail::task_promise<T>;
+  using continuable_type = typename detail::task_continuable<T>::type;
+
+  Task() noexcept = default;
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+    : handle_(handle) {}
+  Task(Task&& other) noexcept
+    : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  Task(Task const&) = delete;
+  Task& operator=(Task const&) = delete;
+  ~Task() {
+    reset();
+  }
+
+  explicit operator bool() const noexcept {
+    return bool(handle_);
+  }
+
+  auto operator co_await() && noexcept {
+    struct awaiter {
+      bool await_ready() const noexcept {
+        return false;
+      }
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().set_continuation(awaiting);
+        return handle_;
+      }
+      T await_resume() {
+        return handle_.promise().result();
+      }
+
+      std::coroutine_handle<promise_type> handle_;
+    };
+
+    IDLE_ASSERT(handle_);
+    return awaiter{handle_};
+  }
+
+  /// Converts the Task into a continuable that starts the Task
+  /// when it is started itself.
+  operator continuable_type() && {
+    IDLE_ASSERT(handle_);
+
+    return make_continuable<T>(
+        [task = std::move(*this)](auto&& promise) mutable {
+          detail::launch_task(std::move(task),
+                              std::forward<decltype(promise)>(promise));
+        });
+  }
+
+private:
+  void reset() noexcept {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = nullptr;
+    }
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+template <typename T>
+Task<T> task_promise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+inline Task<void> task_promise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+} // namespace detail
+
+/// Returns an awaitable that resumes the awaiting coroutine on the executor
+template <typename Executor>
+detail::resume_on_awaiter<Executor> resume_on(Executor& executor) noexcept {
+  return detail::resume_on_awaiter<Executor>(executor, false);
+}
+
+/// Returns an awaitable that resumes the awaiting coroutine on the event loop
+/// of the Context, it doesn't suspend when being on the event loop already.
+inline detail::resume_on_awaiter<Context::executor_type>
+resume_on(Context& context) noexcept {
+  return detail::resume_on_awaiter<Context::executor_type>(
+      context.event_loop(), context.is_on_event_loop());
+}
+#endif // IDLE_HAS_COROUTINES
+} // namespace idle
+
+#endif // IDLE_CORE_COROUTINE_HPP_INCLUDED
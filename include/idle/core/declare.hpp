@@ -35,11 +35,13 @@
 #include <idle/core/ref.hpp>
 #include <idle/core/service.hpp>
 #include <idle/core/support.hpp>
+#include <idle/core/util/assert.hpp>
 #include <idle/core/util/intrusive_list.hpp>
 
 namespace idle {
 namespace detail {
 using service_creator_ptr_t = Ref<Service> (*const)(Inheritance);
+using interface_id_ptr_t = Interface::Id (*const)();
 class ServiceDeclaration;
 struct DeclarationListTag {};
 using DeclarationList = intrusive_forward_list<ServiceDeclaration,
@@ -47,6 +49,10 @@ using DeclarationList = intrusive_forward_list<ServiceDeclaration,
 class IDLE_API(idle) ServiceDeclaration : public DeclarationList::node {
 public:
   explicit ServiceDeclaration(service_creator_ptr_t creator);
+  /// Declares a service that is only instantiated when a Dependency
+  /// on the given Interface can't be satisfied by any other service.
+  explicit ServiceDeclaration(service_creator_ptr_t creator,
+                              interface_id_ptr_t lazy);
   ServiceDeclaration(ServiceDeclaration const&) = delete;
   ServiceDeclaration(ServiceDeclaration&&) = delete;
   ServiceDeclaration& operator=(ServiceDeclaration const&) = delete;
@@ -55,8 +61,17 @@ public:
     return creator_(std::move(inh));
   }
 
+  bool isLazy() const noexcept {
+    return lazy_ != nullptr;
+  }
+  Interface::Id lazyInterface() const {
+    IDLE_ASSERT(isLazy());
+    return lazy_();
+  }
+
 private:
   service_creator_ptr_t creator_;
+  interface_id_ptr_t lazy_{nullptr};
 };
 } // namespace detail
 } // namespace idle
@@ -72,6 +87,21 @@ private:
               CLASS_NAME_OR_PART,                                              \
               ::idle::DefaultService<CLASS_NAME_OR_PART>>>(std::move(parent)); \
         }));
+#  define IDLE_DECLARE_LAZY(CLASS_NAME_OR_PART, INTERFACE)                     \
+    static ::idle::detail::ServiceDeclaration const IDLE_DETAIL_CAT(           \
+        sd_lazy_##CLASS_NAME_OR_PART, __LINE__)(                               \
+        static_cast<::idle::detail::service_creator_ptr_t>(                    \
+            [](::idle::Inheritance parent) -> ::idle::Ref<::idle::Service> {   \
+              return ::idle::spawn<::std::conditional_t<                       \
+                  ::idle::is_service<CLASS_NAME_OR_PART>::value,               \
+                  CLASS_NAME_OR_PART,                                          \
+                  ::idle::DefaultService<CLASS_NAME_OR_PART>>>(                \
+                  std::move(parent));                                          \
+            }),                                                                \
+        static_cast<::idle::detail::interface_id_ptr_t>(                       \
+            []() -> ::idle::Interface::Id {                                    \
+              return INTERFACE::id();                                          \
+            }));
 #elif defined(IDLE_HAS_DYNAMIC_LINKING)
 #  if !defined(IDLE_DETAIL_EXPORT_SECTION_NAME)
 #    define IDLE_DETAIL_EXPORT_SECTION_NAME idlesvex
@@ -123,4 +153,19 @@ private:
 #  define IDLE_DECLARE(...)
 #endif
 
+#ifndef IDLE_DECLARE_LAZY
+/// Declares a service like IDLE_DECLARE but defers its instantiation
+/// until a Dependency or DynDependency on the given Interface is created
+/// which can't be satisfied by any other service.
+///
+/// The service is created as default service, thus it is stopped
+/// again as soon as it isn't used anymore. Add an IdleTimeout Component
+/// to the service in order to keep it running for a while after that.
+///
+/// \note Plugins can only export their services eagerly,
+///       where this macro is equivalent to IDLE_DECLARE.
+#  define IDLE_DECLARE_LAZY(CLASS_NAME_OR_PART, INTERFACE)                     \
+    IDLE_DECLARE(CLASS_NAME_OR_PART)
+#endif
+
 #endif // IDLE_CORE_DECLARE_HPP_INCLUDED
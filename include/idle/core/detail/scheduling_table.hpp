@@ -0,0 +1,220 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_DETAIL_SCHEDULING_TABLE_HPP_INCLUDED
+#define IDLE_CORE_DETAIL_SCHEDULING_TABLE_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/util/assert.hpp>
+
+namespace idle {
+class Service;
+
+namespace detail {
+/// Stores the scheduling state of all services of a Context densely
+/// in struct-of-arrays form, addressed by the row every initialized
+/// Service holds.
+///
+/// Rows are stored in chunks which are never moved or freed before the
+/// table itself, such that the state of a service can be read from any
+/// thread while other rows are allocated on the event loop.
+class IDLE_API(idle) SchedulingTable {
+  static constexpr std::size_t chunk_bits = 10U;
+  static constexpr std::size_t chunk_size = std::size_t(1U) << chunk_bits;
+  static constexpr std::size_t max_chunks = std::size_t(1U) << 12U;
+
+  struct Chunk {
+    std::atomic<std::uint8_t> phase[chunk_size];
+    std::uint8_t flags[chunk_size];
+    std::uint16_t inner_deps_missing[chunk_size];
+    Service* service[chunk_size];
+  };
+
+public:
+  using Row = std::uint32_t;
+
+  /// The row of a service that was not initialized yet
+  static constexpr Row uninitialized_row = std::numeric_limits<Row>::max();
+  /// The row of a service that was destroyed already
+  static constexpr Row destroyed_row = uninitialized_row - 1U;
+
+  enum Flags : std::uint8_t {
+    /// The service is the head of its cluster
+    flag_cluster_head = 1U << 0U,
+    /// The cluster is pushed by itself or a dependent
+    flag_cluster_pushed = 1U << 1U,
+    /// The cluster is marked for stop
+    flag_cluster_marked_for_stop = 1U << 2U,
+    /// The cluster was changed since the last system update
+    flag_cluster_dirty = 1U << 3U
+  };
+
+  SchedulingTable();
+  ~SchedulingTable();
+
+  SchedulingTable(SchedulingTable&&) = delete;
+  SchedulingTable(SchedulingTable const&) = delete;
+  SchedulingTable& operator=(SchedulingTable&&) = delete;
+  SchedulingTable& operator=(SchedulingTable const&) = delete;
+
+  static bool isValid(Row row) noexcept {
+    return row < destroyed_row;
+  }
+
+  /// Allocates a row for the given service
+  ///
+  /// \event_loop
+  Row allocate(Service& current, std::uint8_t phase);
+
+  /// Releases the given row such that it can be reused
+  ///
+  /// \event_loop
+  void release(Row row) noexcept;
+
+  std::atomic<std::uint8_t>& phase(Row row) const noexcept {
+    return chunk(row).phase[offset(row)];
+  }
+  std::uint8_t& flags(Row row) const noexcept {
+    return chunk(row).flags[offset(row)];
+  }
+  std::uint16_t& inner_deps_missing(Row row) const noexcept {
+    return chunk(row).inner_deps_missing[offset(row)];
+  }
+  Service* service(Row row) const noexcept {
+    return chunk(row).service[offset(row)];
+  }
+
+  /// Invokes the given callable with every live service whose row has all
+  /// of the required flags set.
+  ///
+  /// Only the flags column is read for rows that don't match, so full system
+  /// scans stay within a few dense cache lines per chunk.
+  ///
+  /// \event_loop
+  template <typename Callable>
+  void scan(std::uint8_t required, Callable&& callable) const {
+    std::size_t const chunks = (size_ + chunk_size - 1U) >> chunk_bits;
+
+    for (std::size_t c = 0U; c < chunks; ++c) {
+      Chunk const& current = *chunks_[c].load(std::memory_order_relaxed);
+      std::size_t const remaining = std::size_t(size_) - (c << chunk_bits);
+      std::size_t const end = (remaining < chunk_size) ? remaining
+                                                       : chunk_size;
+
+      for (std::size_t i = 0U; i < end; ++i) {
+        if ((current.flags[i] & required) == required) {
+          IDLE_ASSERT(current.service[i]);
+          callable(*current.service[i]);
+        }
+      }
+    }
+  }
+
+  /// Adds the given row to the dirty set, which is visited by the next
+  /// system update instead of scanning all rows.
+  ///
+  /// \event_loop
+  void mark_dirty(Row row) {
+    std::uint8_t& current = flags(row);
+    if (!(current & flag_cluster_dirty)) {
+      current |= flag_cluster_dirty;
+      dirty_.push_back(row);
+    }
+  }
+
+  /// Invokes the given callable with every live service that was marked
+  /// dirty and clears the dirty set before.
+  ///
+  /// Rows that were released in the meantime are skipped, the callable
+  /// is allowed to mark services as dirty again.
+  ///
+  /// \event_loop
+  template <typename Callable>
+  void drain_dirty(Callable&& callable) {
+    IDLE_ASSERT(draining_.empty());
+    draining_.swap(dirty_);
+
+    // Clear the dirty flag first which also drops duplicated rows
+    // that were released and allocated again in the meantime.
+    auto const end = std::remove_if(draining_.begin(), draining_.end(),
+                                    [&](Row row) {
+                                      std::uint8_t& current = flags(row);
+                                      if (current & flag_cluster_dirty) {
+                                        current &= ~flag_cluster_dirty;
+                                        return false;
+                                      } else {
+                                        return true;
+                                      }
+                                    });
+
+    for (auto itr = draining_.begin(); itr != end; ++itr) {
+      if (Service* const current = service(*itr)) {
+        callable(*current);
+      }
+    }
+
+    draining_.clear();
+  }
+
+  /// Returns the count of rows that are allocated
+  std::size_t size() const noexcept {
+    return size_ - free_.size();
+  }
+
+private:
+  Chunk& chunk(Row row) const noexcept {
+    IDLE_ASSERT(isValid(row));
+    IDLE_ASSERT((row >> chunk_bits) < max_chunks);
+
+    Chunk* const current = chunks_[row >> chunk_bits].load(
+        std::memory_order_acquire);
+    IDLE_ASSERT(current);
+    return *current;
+  }
+  static std::size_t offset(Row row) noexcept {
+    return row & (chunk_size - 1U);
+  }
+
+  std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+  /// The high water mark of allocated rows
+  Row size_{0U};
+  /// Rows released for reuse
+  std::vector<Row> free_;
+  /// Rows marked as dirty since the last drain
+  std::vector<Row> dirty_;
+  /// The dirty rows currently drained, cached for allocated heap reuse
+  std::vector<Row> draining_;
+};
+} // namespace detail
+} // namespace idle
+
+#endif // IDLE_CORE_DETAIL_SCHEDULING_TABLE_HPP_INCLUDED
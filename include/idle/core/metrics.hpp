@@ -0,0 +1,194 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_METRICS_HPP_INCLUDED
+#define IDLE_CORE_METRICS_HPP_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <idle/core/api.hpp>
+#include <idle/core/detail/unordered_map.hpp>
+#include <idle/core/guid.hpp>
+#include <idle/core/util/span.hpp>
+
+namespace idle {
+/// A histogram with logarithmic buckets, where the bucket i contains
+/// the values in the range [2^(i - 1), 2^i).
+class IDLE_API(idle) Histogram {
+public:
+  static constexpr std::size_t bucket_count = 32U;
+
+  Histogram() = default;
+
+  void record(std::uint64_t value) noexcept;
+
+  std::uint64_t count() const noexcept {
+    return count_;
+  }
+  std::uint64_t total() const noexcept {
+    return total_;
+  }
+  std::uint64_t max() const noexcept {
+    return max_;
+  }
+  std::uint64_t mean() const noexcept {
+    return count_ ? (total_ / count_) : 0U;
+  }
+
+  /// Returns an upper bound of the value at the given percentile (0 - 100)
+  std::uint64_t percentile(unsigned p) const noexcept;
+
+  Span<std::uint64_t const> buckets() const noexcept {
+    return {buckets_.data(), buckets_.size()};
+  }
+
+private:
+  std::array<std::uint64_t, bucket_count> buckets_{};
+  std::uint64_t count_{0U};
+  std::uint64_t total_{0U};
+  std::uint64_t max_{0U};
+};
+
+/// Collects the metrics of the scheduler and the service lifecycle
+///
+/// Counters can be incremented from any thread, they are stored in
+/// per-thread shards of relaxed atomics, such that threads don't contend.
+/// Distributions are recorded on the event loop only.
+class IDLE_API(idle) Metrics {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  enum class Counter : std::uint8_t {
+    Handlers,         ///< Dispatched event loop handlers
+    SchedulerPasses,  ///< Scheduling passes
+    ScheduledServices, ///< Services popped from the scheduling queue
+    ServiceStarts,    ///< Completed service starts
+    ServiceStops,     ///< Completed service stops
+    DFSTraversals,    ///< Depth-first traversals over the dependency graph
+  };
+  static constexpr std::size_t counter_count = 6U;
+
+  enum class Distribution : std::uint8_t {
+    ServiceStart, ///< Duration of Service::onStart in microseconds
+    ServiceStop,  ///< Duration of Service::onStop in microseconds
+    EventLoopLag, ///< Time the oldest handler waited in microseconds
+    QueueDepth,   ///< Scheduling queue size at the begin of a pass
+    DFSSize,      ///< Visited nodes of a depth-first traversal
+    ReloadStop,   ///< Plugin reload phase stop in microseconds
+    ReloadUnload, ///< Plugin reload phase unload in microseconds
+    ReloadLoad,   ///< Plugin reload phase load in microseconds
+    ReloadStart,  ///< Plugin reload phase start in microseconds
+  };
+  static constexpr std::size_t distribution_count = 9U;
+
+  /// The start and stop durations of a single service
+  struct ServiceTimings {
+    Histogram start;
+    Histogram stop;
+  };
+
+  using ServiceMap = detail::unordered_map<Guid::Low, ServiceTimings>;
+
+  Metrics() = default;
+  Metrics(Metrics const&) = delete;
+  Metrics& operator=(Metrics const&) = delete;
+
+  /// Increments the given counter
+  ///
+  /// \note This method is thread-safe.
+  void add(Counter counter, std::uint64_t value = 1U) noexcept;
+
+  /// Returns the sum of the given counter over all threads
+  ///
+  /// \note This method is thread-safe, the returned value
+  ///       is approximated while other threads are incrementing it.
+  std::uint64_t get(Counter counter) const noexcept;
+
+  /// Records the given value into the distribution
+  ///
+  /// \event_loop
+  /// This method should be called from the event loop.
+  void record(Distribution distribution, std::uint64_t value) noexcept {
+    distributions_[static_cast<std::size_t>(distribution)].record(value);
+  }
+  /// \copydoc record
+  void record(Distribution distribution, clock_type::duration value) noexcept {
+    record(distribution, micros(value));
+  }
+
+  /// Returns the histogram of the given distribution
+  ///
+  /// \event_loop
+  /// This method should be called from the event loop.
+  Histogram const& get(Distribution distribution) const noexcept {
+    return distributions_[static_cast<std::size_t>(distribution)];
+  }
+
+  /// Records the start or stop duration of the given service
+  ///
+  /// \event_loop
+  /// This method should be called from the event loop.
+  void recordService(Guid guid, Distribution distribution,
+                     clock_type::duration value) noexcept;
+
+  /// Removes the recorded timings of the given service
+  void forgetService(Guid guid) noexcept;
+
+  /// Returns the timings of all services by the low part of their guid,
+  /// which identifies the cluster the service is the head of.
+  ///
+  /// \event_loop
+  /// This method should be called from the event loop.
+  ServiceMap const& services() const noexcept {
+    return services_;
+  }
+
+  /// Returns a readable name of the given counter
+  static char const* nameOf(Counter counter) noexcept;
+  /// Returns a readable name of the given distribution
+  static char const* nameOf(Distribution distribution) noexcept;
+
+  static std::uint64_t micros(clock_type::duration value) noexcept {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(value).count());
+  }
+
+private:
+  static constexpr std::size_t shard_count = 16U;
+
+  struct alignas(64) Shard {
+    std::array<std::atomic<std::uint64_t>, counter_count> counters{};
+  };
+
+  std::array<Shard, shard_count> shards_{};
+  std::array<Histogram, distribution_count> distributions_{};
+  ServiceMap services_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_METRICS_HPP_INCLUDED
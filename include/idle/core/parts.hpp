@@ -28,6 +28,7 @@
 
 #include <idle/core/parts/collection.hpp>
 #include <idle/core/parts/component.hpp>
+#include <idle/core/parts/concurrent_dyn_dependency.hpp>
 #include <idle/core/parts/container.hpp>
 #include <idle/core/parts/dependency.hpp>
 #include <idle/core/parts/dependency_hooks.hpp>
@@ -0,0 +1,204 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_PARTS_CONCURRENT_DYN_DEPENDENCY_HPP_INCLUDED
+#define IDLE_CORE_PARTS_CONCURRENT_DYN_DEPENDENCY_HPP_INCLUDED
+
+#include <atomic>
+#include <utility>
+#include <idle/core/api.hpp>
+#include <idle/core/dep/optional.hpp>
+#include <idle/core/detail/chaining.hpp>
+#include <idle/core/parts/dependency_hooks.hpp>
+#include <idle/core/parts/dyn_dependency.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/use.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/core/util/rcu.hpp>
+
+namespace idle {
+/// A DynDependencyBase which additionally publishes its current Interface
+/// to readers on arbitrary threads.
+///
+/// Every publication holds a Use of its Interface and is retired into an
+/// EpochDomain when the Interface is swapped. Thus a swapped Interface
+/// can't stop before all readers that could have observed it have finished.
+///
+/// Retired publications are reclaimed on the event loop. While a reader
+/// still pins one, the reclamation is parked until a reader unpins
+/// or the next Interface is stored, instead of being retried busily.
+class IDLE_API(idle) ConcurrentDynDependencyBase : public DynDependencyBase {
+protected:
+  struct Publication {
+    Use<Interface> use;
+    Interface* current{nullptr};
+  };
+
+  using Snapshot = Rcu<Publication>::Snapshot;
+
+public:
+  explicit ConcurrentDynDependencyBase(Service& owner);
+
+protected:
+  /// Pins the currently published Interface
+  ///
+  /// Can be called from any thread.
+  Snapshot acquire() const noexcept {
+    return published_.read();
+  }
+
+  /// Resumes a parked reclamation, must be called after a Snapshot
+  /// was released.
+  ///
+  /// Can be called from any thread.
+  void release() const noexcept {
+    // Orders the unpinning before the check, such that either this
+    // reader observes the parking or the reclamation observes the unpin.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (is_parked_.load(std::memory_order_relaxed)) {
+      const_cast<ConcurrentDynDependencyBase*>(this)->unpark();
+    }
+  }
+
+  void onStore(Interface* current) noexcept override;
+
+private:
+  void scheduleReclaim() noexcept;
+  void reclaim() noexcept;
+  void unpark() noexcept;
+
+  Rcu<Publication> published_;
+  std::atomic<bool> is_reclaiming_;
+  std::atomic<bool> is_parked_;
+};
+
+/// Implements a dynamic dependency whose current Interface can be read
+/// from any thread, while the Interface is swapped at runtime.
+///
+/// Reading through ConcurrentDynDependency::pin or operator-> pins the
+/// Interface for the duration of the read, which doesn't block and
+/// doesn't touch the use count of the Interface.
+template <typename Dependency, typename Owner = Service,
+          typename OnInspect = hooks::OnInspectDyn<Owner, Dependency>>
+class ConcurrentDynDependency final : public ConcurrentDynDependencyBase,
+                                      private OnInspect {
+  using chain_trait = detail::chain_trait<Dependency>;
+
+public:
+  /// Keeps the Interface that was published on acquisition alive
+  class Pinned {
+    friend class ConcurrentDynDependency;
+
+    explicit Pinned(ConcurrentDynDependency const& dependency,
+                    Snapshot snapshot) noexcept
+      : dependency_(&dependency)
+      , snapshot_(std::move(snapshot)) {}
+
+  public:
+    Pinned(Pinned&& other) noexcept
+      : dependency_(std::exchange(other.dependency_, nullptr))
+      , snapshot_(std::move(other.snapshot_)) {}
+    Pinned(Pinned const&) = delete;
+    Pinned& operator=(Pinned&&) = delete;
+    Pinned& operator=(Pinned const&) = delete;
+    ~Pinned() {
+      if (dependency_) {
+        snapshot_.reset();
+        dependency_->release();
+      }
+    }
+
+    Dependency* get() const noexcept {
+      return detail::possible_null_cast<Dependency>((*snapshot_)->current);
+    }
+
+    Dependency& operator*() const noexcept {
+      IDLE_ASSERT(get());
+      return *get();
+    }
+    typename chain_trait::type operator->() const noexcept {
+      return chain_trait::do_chain(**this);
+    }
+    explicit operator bool() const noexcept {
+      return (*snapshot_)->current != nullptr;
+    }
+
+  private:
+    ConcurrentDynDependency const* dependency_;
+    optional<Snapshot> snapshot_;
+  };
+
+  explicit ConcurrentDynDependency(Owner& owner, OnInspect on_filter = {})
+    : ConcurrentDynDependencyBase(owner)
+    , OnInspect(std::move(on_filter))
+    , owner_(owner) {}
+
+  /// Pins the current Interface, which is empty while the owner is stopped
+  ///
+  /// Can be called from any thread.
+  Pinned pin() const noexcept {
+    return Pinned(*this, acquire());
+  }
+
+  /// Calls into the current Interface, which stays pinned until
+  /// the end of the full expression.
+  Pinned operator->() const noexcept {
+    return pin();
+  }
+
+  Owner& owner() noexcept override {
+    return owner_;
+  }
+
+  Owner const& owner() const noexcept override {
+    return owner_;
+  }
+
+protected:
+  Interface::Id type() const noexcept override {
+    return Dependency::id();
+  }
+
+  bool hasDefault() const noexcept override {
+    return detail::has_create<Dependency>::value;
+  }
+
+  Ref<Interface> createDefault() override {
+    return detail::do_create<Dependency>(
+        Inheritance::weak(owner().root().anchor(),
+                          Inheritance::Relation::anchor));
+  }
+
+  BitSet<DependenciesFlags> onInspect(Interface& dep) noexcept override {
+    return OnInspect::operator()(owner_, cast<Dependency>(dep));
+  }
+
+private:
+  Owner& owner_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_PARTS_CONCURRENT_DYN_DEPENDENCY_HPP_INCLUDED
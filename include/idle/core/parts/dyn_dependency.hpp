@@ -138,6 +138,14 @@ protected:
   virtual bool hasDefault() const noexcept;
   virtual Ref<Interface> createDefault();
 
+  /// Is called after the userspace pointer was changed to the given
+  /// Interface, possibly from a thread other than the event loop.
+  ///
+  /// The hook is invoked from the noexcept lock and unlock of the import,
+  /// thus it must not throw. An allocation failure inside of it is fatal
+  /// as with any other allocation on the event loop.
+  virtual void onStore(Interface* current) noexcept;
+
   void partName(std::ostream& os) const override;
 
 private:
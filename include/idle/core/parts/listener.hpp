@@ -26,9 +26,12 @@
 #ifndef IDLE_CORE_PARTS_LISTENER_HPP_INCLUDED
 #define IDLE_CORE_PARTS_LISTENER_HPP_INCLUDED
 
+#include <vector>
 #include <idle/core/api.hpp>
+#include <idle/core/guid.hpp>
 #include <idle/core/service.hpp>
 #include <idle/core/util/bitset.hpp>
+#include <idle/core/util/span.hpp>
 
 namespace idle {
 class IDLE_API(idle) Listener : public Interface {
@@ -41,6 +44,53 @@ public:
     OnServiceChanged,
     OnUsageConnected,
     OnUsageDisconnected,
+    OnServiceChangedBatch,
+  };
+
+  /// Contains the service phase transitions that happened during a single
+  /// scheduling pass in order, stored as struct of arrays.
+  class IDLE_API(idle) ChangeLog {
+    friend class ContextImpl;
+
+  public:
+    ChangeLog() = default;
+
+    std::size_t size() const noexcept {
+      return guids_.size();
+    }
+    bool empty() const noexcept {
+      return guids_.empty();
+    }
+
+    /// Returns the guids of the changed services
+    Span<Guid const> guids() const noexcept {
+      return {guids_.data(), guids_.size()};
+    }
+    /// Returns the phases the services were changed from
+    Span<Service::Phase const> from() const noexcept {
+      return {from_.data(), from_.size()};
+    }
+    /// Returns the phases the services were changed to
+    Span<Service::Phase const> to() const noexcept {
+      return {to_.data(), to_.size()};
+    }
+
+  private:
+    void push(Guid guid, Service::Phase from, Service::Phase to) {
+      guids_.push_back(guid);
+      from_.push_back(from);
+      to_.push_back(to);
+    }
+
+    void clear() noexcept {
+      guids_.clear();
+      from_.clear();
+      to_.clear();
+    }
+
+    std::vector<Guid> guids_;
+    std::vector<Service::Phase> from_;
+    std::vector<Service::Phase> to_;
   };
 
   explicit Listener(Service& owner,
@@ -69,6 +119,17 @@ protected:
     IDLE_ASSERT(detail::is_on_event_loop(owner()));
   }
 
+  /// Is called once per scheduling pass with all phase transitions of
+  /// the pass, which is preferred over onServiceChanged by listeners
+  /// that only require aggregated data.
+  ///
+  /// \note The services of the change log could be destroyed already,
+  ///       use Context::lookup to retrieve them.
+  virtual void onServiceChangedBatch(ChangeLog const& changes) noexcept {
+    (void)changes;
+    IDLE_ASSERT(detail::is_on_event_loop(owner()));
+  }
+
   virtual void onUsageDisconnect(Usage& current) noexcept {
     (void)current;
     IDLE_ASSERT(detail::is_on_event_loop(owner()));
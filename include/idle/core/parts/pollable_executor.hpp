@@ -26,6 +26,8 @@
 #ifndef IDLE_CORE_PARTS_POLLABLE_EXECUTOR_HPP_INCLUDED
 #define IDLE_CORE_PARTS_POLLABLE_EXECUTOR_HPP_INCLUDED
 
+#include <chrono>
+#include <cstddef>
 #include <idle/core/api.hpp>
 #include <idle/core/fwd.hpp>
 #include <idle/core/import.hpp>
@@ -35,6 +37,10 @@
 namespace idle {
 /// Represents a pollable executor that can receive work from
 /// any thread and dispatches the work when PollableExecutor::pool is called.
+///
+/// A waitable executor additionally exposes a handle that becomes readable
+/// when the executor transitions from empty to non empty, which can be
+/// registered in the epoll or io_uring loop of the owning thread.
 class IDLE_API(idle) PollableExecutor final
   : public Import,
     public ExecutorFacade<PollableExecutor> {
@@ -43,7 +49,7 @@ class IDLE_API(idle) PollableExecutor final
   friend class ExecutorFacade<PollableExecutor>;
 
 public:
-  explicit PollableExecutor(Service& owner);
+  explicit PollableExecutor(Service& owner, bool waitable = false);
   ~PollableExecutor() override;
 
   /// Sets the current thread as the active one, where work is dispatched.
@@ -58,6 +64,25 @@ public:
   ///            from the active thead.
   void poll();
 
+  /// Dispatches at most `max` outstanding work items on the current thread,
+  /// and returns the count of dispatched items.
+  ///
+  /// Use this to bound the time spent on work, for example per frame.
+  std::size_t pollSome(std::size_t max);
+
+  /// Waits until work is available or the timeout has expired
+  /// and dispatches all outstanding work afterwards.
+  ///
+  /// Returns the count of dispatched items.
+  std::size_t pollFor(std::chrono::milliseconds timeout);
+
+  /// Returns the native handle (an eventfd on Linux) that becomes readable
+  /// when work is available, or -1 if the executor isn't waitable
+  /// or the platform doesn't support it.
+  ///
+  /// The handle is reset by polling and should only be waited on.
+  int waitableHandle() const noexcept;
+
   /// Returns true if the current thread is the active thread,
   /// where the executor is dispatched on.
   bool isThisThread() const noexcept;
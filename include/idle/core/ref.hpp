@@ -27,14 +27,32 @@
 #define IDLE_CORE_REF_HPP_INCLUDED
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
+#include <idle/core/api.hpp>
 #include <idle/core/detail/ref_base.hpp>
 #include <idle/core/util/meta.hpp>
 
 namespace idle {
+class AllocationDomain;
+
 namespace detail {
+/// Returns the AllocationDomain which is used on the current thread
+IDLE_API(idle) AllocationDomain* current_allocation_domain() noexcept;
+
+/// Allocates memory from the given domain and acquires a reference to it
+IDLE_API(idle)
+void* allocate_from(AllocationDomain& domain, std::size_t size,
+                    std::size_t alignment);
+
+/// Returns memory to the given domain and releases the reference to it
+IDLE_API(idle)
+void deallocate_to(AllocationDomain& domain, void* ptr, std::size_t size,
+                   std::size_t alignment) noexcept;
+
 /// A control block which dispatches actions through a vtable
 class vblock_t_base {
 public:
@@ -56,8 +74,9 @@ using virtual_cb = atomic_cb<vblock_t_base>;
 template <typename T, typename Trait>
 class vblock_t final : private Trait, public virtual_cb {
 public:
-  constexpr vblock_t(Trait trait) noexcept
-    : Trait(std::move(trait)) {}
+  constexpr vblock_t(Trait trait, AllocationDomain* domain = nullptr) noexcept
+    : Trait(std::move(trait))
+    , domain_(domain) {}
   virtual ~vblock_t() noexcept = default;
 
   template <typename... Args>
@@ -73,11 +92,21 @@ public:
     Trait::on_destruct(get());
   }
 
+  void on_deallocate() noexcept override {
+    if (AllocationDomain* const domain = domain_) {
+      this->~vblock_t();
+      deallocate_to(*domain, this, sizeof(vblock_t), alignof(vblock_t));
+    } else {
+      delete this;
+    }
+  }
+
   T* get() {
     return reinterpret_cast<T*>(&object_);
   }
 
 private:
+  AllocationDomain* domain_;
   std::aligned_storage_t<sizeof(T), alignof(T)> object_{};
 };
 
@@ -167,8 +196,46 @@ struct reference_counted_trait {
   }
 };
 
+namespace detail {
+template <typename Block>
+struct domain_block_deleter {
+  void operator()(Block* block) const noexcept {
+    block->~Block();
+    deallocate_to(*domain, block, sizeof(Block), alignof(Block));
+  }
+
+  AllocationDomain* domain;
+};
+} // namespace detail
+
+/// Allocates the object inside the given AllocationDomain
+template <typename T, typename Trait, typename... Args>
+Ref<T> allocate_in(AllocationDomain& domain, Trait&& trait, Args&&... args) {
+  using type = detail::vblock_t<T, std::decay_t<Trait>>;
+
+  void* const memory = detail::allocate_from(domain, sizeof(type),
+                                             alignof(type));
+
+  std::unique_ptr<type, detail::domain_block_deleter<type>> raii(
+      new (memory) type(std::forward<Trait>(trait), &domain),
+      detail::domain_block_deleter<type>{&domain});
+  raii->emplace(std::forward<Args>(args)...);
+
+  type* cb = raii.release();
+  Ref<T> rc(cb->get(), RefCounter(cb, false));
+  reference_counted_trait::set(rc.get(), cb);
+  return rc;
+}
+
+/// Allocates the object inside the AllocationDomain of the current thread
+/// or on the heap if there is none.
 template <typename T, typename Trait, typename... Args>
 Ref<T> allocate(Trait&& trait, Args&&... args) {
+  if (AllocationDomain* const domain = detail::current_allocation_domain()) {
+    return allocate_in<T>(*domain, std::forward<Trait>(trait),
+                          std::forward<Args>(args)...);
+  }
+
   using type = detail::vblock_t<T, std::decay_t<Trait>>;
 
   auto raii = std::make_unique<type>(std::forward<Trait>(trait));
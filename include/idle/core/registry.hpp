@@ -118,6 +118,15 @@ public:
 
   Interface::Id const& id() const noexcept;
 
+  /// Instantiates the service that was declared through IDLE_DECLARE_LAZY
+  /// for this Interface, if there is any.
+  ///
+  /// Returns true if a service was instantiated which publishes
+  /// the Interface through this Registry now.
+  ///
+  /// \event_loop
+  bool instantiateLazy();
+
   void subscriberAdd(Subscriber& subscriber);
   void subscriberDel(Subscriber& subscriber);
 };
@@ -0,0 +1,87 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_REGISTRY_SNAPSHOT_HPP_INCLUDED
+#define IDLE_CORE_REGISTRY_SNAPSHOT_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/ref.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/util/rcu.hpp>
+
+namespace idle {
+/// Represents an immutable and versioned view onto all published
+/// Interfaces of a Context.
+///
+/// A new snapshot is published after every scheduler pass that changed
+/// a registry, and can be queried from any thread without synchronizing
+/// with the event loop.
+///
+/// \attention The Interfaces are referenced weakly only, an Interface
+///            might have been revoked after the snapshot was published.
+class IDLE_API(idle) RegistrySnapshot {
+  friend class RegistryManager;
+
+public:
+  using Version = std::uint64_t;
+  using Interfaces = std::vector<WeakRef<Interface>>;
+
+  RegistrySnapshot() = default;
+
+  /// Returns the version of this snapshot, which increases monotonically
+  Version version() const noexcept {
+    return version_;
+  }
+
+  /// Returns the Interfaces published for the given id ordered by priority
+  Interfaces const& find(Interface::Id const& id) const noexcept;
+
+  /// \copydoc find
+  template <typename T>
+  Interfaces const& find() const noexcept {
+    static_assert(is_interface<T>::value,
+                  "T does not implement Interface::id()!");
+    return find(T::id());
+  }
+
+  /// Returns the count of Interface ids with published Interfaces
+  std::size_t size() const noexcept {
+    return entries_.size();
+  }
+
+private:
+  Version version_{0};
+  std::unordered_map<Interface::Id, Interfaces> entries_;
+};
+
+/// A pinned RegistrySnapshot which prevents its reclamation
+using RegistryView = Rcu<RegistrySnapshot>::Snapshot;
+} // namespace idle
+
+#endif // IDLE_CORE_REGISTRY_SNAPSHOT_HPP_INCLUDED
@@ -32,11 +32,13 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <idle/core/allocation_domain.hpp>
 #include <idle/core/api.hpp>
 #include <idle/core/async.hpp>
 #include <idle/core/dep/continuable.hpp>
 #include <idle/core/detail/chaining.hpp>
 #include <idle/core/detail/detection.hpp>
+#include <idle/core/detail/scheduling_table.hpp>
 #include <idle/core/detail/service_deleter.hpp>
 #include <idle/core/detail/state.hpp>
 #include <idle/core/detail/unreachable.hpp>
@@ -412,6 +414,9 @@ public:
     return relation_ == Relation::anchor;
   }
 
+  /// Returns the AllocationDomain the service is allocated from
+  AllocationDomain* domain() const noexcept;
+
   /// The call to adjust needs to happen inside a templated context such
   /// that the compiler uses this_locality() from the current translation unit.
   Inheritance& anchor(Ref<Locality> loc) noexcept {
@@ -586,7 +591,7 @@ public:
     ///
     /// \event_loop_consistent
     Phase phase() const noexcept {
-      return me_->phase_.load(std::memory_order_acquire);
+      return me_->load_phase();
     }
 
     /// TODO
@@ -648,7 +653,7 @@ public:
     ///
     /// \event_loop_consistent
     bool isStopping() const noexcept {
-      return me_->phase_.load(std::memory_order_acquire) == Phase::stopping;
+      return me_->load_phase() == Phase::stopping;
     }
 
     /// TODO
@@ -687,7 +692,7 @@ public:
 
   private:
     bool is(Phase phase) const noexcept {
-      return me_->phase_.load(std::memory_order_acquire) == phase;
+      return me_->load_phase() == phase;
     }
     bool isBetween(Phase from_inclusive, //
                    Phase to_inclusive) const noexcept;
@@ -712,6 +717,12 @@ public:
   /// Writes a printable name of this service to the given std::ostream
   virtual void name(std::ostream& os) const;
 
+  /// Returns the AllocationDomain the children of this service are
+  /// allocated from, the domain is inherited from the parent by default.
+  ///
+  /// Services that own a domain shall overwrite this method.
+  virtual AllocationDomain* allocationDomain() const noexcept;
+
   /// Prints this service to the given ostream.
   friend IDLE_API(idle) std::ostream& operator<<(std::ostream& os,
                                                  Service const& obj);
@@ -796,12 +807,59 @@ private:
   void print_usage(std::ostream& os) const;
   void print_cluster(std::ostream& os) const;
 
-  std::atomic<Phase> phase_;
-  std::uint16_t inner_deps_missing_; // Missing inner cluster deps
-  Guid::High high_guid_;             // The high part of the service guid
-  Ref<Part> parent_;                 // The parent of this service
-  PartList parts_;                   // An intrusive forward list of all parts
+  using Row = detail::SchedulingTable::Row;
+
+  Phase load_phase() const noexcept {
+    switch (Row const row = row_.load(std::memory_order_acquire)) {
+      case detail::SchedulingTable::uninitialized_row:
+        return Phase::uninitialized;
+      case detail::SchedulingTable::destroyed_row:
+        return Phase::destroyed;
+      default: {
+        auto const phase = static_cast<Phase>(
+            table_->phase(row).load(std::memory_order_acquire));
+
+        // The row could have been released and reused by another service
+        // while the phase was read, the row is never valid again after
+        // the release, thus a changed row means that this is destroyed.
+        if (row_.load(std::memory_order_acquire) != row) {
+          return Phase::destroyed;
+        }
+        return phase;
+      }
+    }
+  }
+  void store_phase(Phase phase) noexcept {
+    table_->phase(row()).store(static_cast<std::uint8_t>(phase),
+                               std::memory_order_release);
+  }
+
+  /// Returns the row of this service, only valid while it is initialized
+  Row row() const noexcept {
+    Row const current = row_.load(std::memory_order_relaxed);
+    IDLE_ASSERT(detail::SchedulingTable::isValid(current));
+    return current;
+  }
+
+  /// Missing inner cluster deps
+  std::uint16_t& row_inner_deps_missing() const noexcept {
+    return table_->inner_deps_missing(row());
+  }
+  /// Cluster flags mirrored for the cluster head
+  std::uint8_t& row_flags() const noexcept {
+    return table_->flags(row());
+  }
+
+  // The scheduling hot state (phase and counters) is stored in the
+  // SchedulingTable of the Context, only the row to it is kept here.
+  // The uses stay inside the service since they are acquired from any
+  // thread, even while the row is released concurrently.
+  std::atomic<Row> row_;              // The row inside the scheduling table
   mutable std::atomic<std::uint32_t> uses_; // All active uses
+  Guid::High high_guid_;              // The high part of the service guid
+  detail::SchedulingTable* table_;    // The table of the context
+  Ref<Part> parent_;                  // The parent of this service
+  PartList parts_;                    // An intrusive forward list of all parts
   detail::Cluster* cluster_; // All services in the cluster share common data
 };
 
@@ -828,6 +886,9 @@ Ref<T> spawn(Inheritance inh, Args&&... args) {
   if (inh.isInCluster()) {
     IDLE_ASSERT(!inh.isAnchored());
 
+    // Objects created by the constructor are placed next to the service
+    AllocationScope const scope(inh.domain());
+
     // Allocate the service directly
     return allocate<T, detail::service_deleter>(detail::service_deleter{},
                                                 std::move(inh),
@@ -846,6 +907,9 @@ Ref<T> spawn(Inheritance inh, Args&&... args) {
     // Embed a cluster object into the service allocation block
     using block_t = joined_allocation_block<T, detail::Cluster>;
 
+    // Objects created by the constructor are placed next to the service
+    AllocationScope const scope(inh.domain());
+
     Ref<block_t> ptr = allocate<block_t, detail::service_deleter>(
         detail::service_deleter{std::move(counter)}, std::move(inh),
         std::forward<Args>(args)...);
@@ -0,0 +1,229 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_TRACING_HPP_INCLUDED
+#define IDLE_CORE_TRACING_HPP_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/util/string_view.hpp>
+
+namespace idle {
+/// Records begin and end spans of the service lifecycle, the scheduler
+/// and plugin reloads, which can be exported as Chrome trace-event JSON
+/// and inspected through `chrome://tracing` or Perfetto.
+///
+/// Spans are written into fixed-size per-thread ring buffers, such that
+/// threads don't contend while tracing. When tracing is disabled,
+/// emitting a span costs a single relaxed load and a predictable branch.
+class IDLE_API(idle) Tracing {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  enum class Category : std::uint8_t {
+    Service,   ///< Service::onStart and Service::onStop continuations
+    Scheduler, ///< Scheduling passes and update requests
+    Plugin,    ///< Plugin reload phases and shared library loading
+    Compiler,  ///< CMake configure, build and install invocations
+  };
+
+  enum class Phase : std::uint8_t { Begin, End };
+
+  /// The maximum amount of label characters stored per event
+  static constexpr std::size_t label_size = 48U;
+  /// The amount of events a single thread keeps before it overwrites
+  /// its oldest event.
+  static constexpr std::size_t ring_size = 4096U;
+
+  struct Event {
+    /// A string with static storage duration naming the span
+    char const* name;
+    Category category;
+    Phase phase;
+    /// Identifies matching begin and end events of the same name
+    std::uint64_t id;
+    /// The index of the thread that recorded the event
+    std::uint32_t thread;
+    clock_type::time_point time;
+    /// The null-terminated and possibly truncated label of the span
+    std::array<char, label_size> label;
+  };
+
+  /// Ends the span it was created for on destruction
+  class IDLE_API(idle) Span {
+    friend class Tracing;
+
+    Span(Tracing* tracing, Category category, char const* name,
+         std::uint64_t id) noexcept
+      : tracing_(tracing)
+      , category_(category)
+      , name_(name)
+      , id_(id) {}
+
+  public:
+    Span() noexcept = default;
+    ~Span() {
+      end();
+    }
+
+    Span(Span&& other) noexcept
+      : tracing_(other.tracing_)
+      , category_(other.category_)
+      , name_(other.name_)
+      , id_(other.id_) {
+      other.tracing_ = nullptr;
+    }
+    Span& operator=(Span&& other) noexcept {
+      if (this != &other) {
+        end();
+        tracing_ = other.tracing_;
+        category_ = other.category_;
+        name_ = other.name_;
+        id_ = other.id_;
+        other.tracing_ = nullptr;
+      }
+      return *this;
+    }
+
+    /// Ends the span early
+    void end() noexcept {
+      if (tracing_) {
+        tracing_->end(category_, name_, id_);
+        tracing_ = nullptr;
+      }
+    }
+
+  private:
+    Tracing* tracing_{nullptr};
+    Category category_{Category::Service};
+    char const* name_{nullptr};
+    std::uint64_t id_{0U};
+  };
+
+  Tracing();
+  ~Tracing();
+
+  Tracing(Tracing const&) = delete;
+  Tracing& operator=(Tracing const&) = delete;
+
+  /// Returns true if spans are recorded
+  bool isEnabled() const noexcept {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /// Enables or disables the recording of spans
+  ///
+  /// \note This method is thread-safe.
+  void setEnabled(bool enabled) noexcept {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /// Begins a span with the given static name
+  ///
+  /// \note This method is thread-safe.
+  void begin(Category category, char const* name, std::uint64_t id = 0U,
+             StringView label = {}) noexcept {
+    if (isEnabled()) {
+      emit(category, Phase::Begin, name, id, label);
+    }
+  }
+
+  /// Ends a span previously started through begin
+  ///
+  /// \note This method is thread-safe.
+  void end(Category category, char const* name,
+           std::uint64_t id = 0U) noexcept {
+    if (isEnabled()) {
+      emit(category, Phase::End, name, id, {});
+    }
+  }
+
+  /// Begins a span with a unique id that ends when the returned Span
+  /// is destroyed, which is useful for spans crossing continuations.
+  ///
+  /// \note This method is thread-safe.
+  Span span(Category category, char const* name,
+            StringView label = {}) noexcept {
+    if (isEnabled()) {
+      std::uint64_t const id = next_id_.fetch_add(
+          1U, std::memory_order_relaxed);
+      emit(category, Phase::Begin, name, id, label);
+      return Span(this, category, name, id);
+    } else {
+      return Span();
+    }
+  }
+
+  /// Returns a copy of all recorded events ordered by their time
+  ///
+  /// \note This method is thread-safe.
+  std::vector<Event> events() const;
+
+  /// Returns the amount of events that were overwritten because
+  /// the ring buffer of their thread was full.
+  std::uint64_t dropped() const noexcept;
+
+  /// Removes all recorded events
+  ///
+  /// \note This method is thread-safe.
+  void clear() noexcept;
+
+  /// Writes all recorded events as Chrome trace-event JSON
+  ///
+  /// \note This method is thread-safe.
+  void write(std::ostream& os) const;
+
+  /// Returns a readable name of the given category
+  static char const* nameOf(Category category) noexcept;
+
+private:
+  struct Ring;
+
+  void emit(Category category, Phase phase, char const* name,
+            std::uint64_t id, StringView label) noexcept;
+
+  Ring& this_thread_ring();
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<std::uint64_t> next_id_{1U};
+
+  /// Identifies this instance in the thread-local ring cache
+  std::uint64_t const instance_;
+  clock_type::time_point const created_;
+
+  mutable std::mutex rings_mutex_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_TRACING_HPP_INCLUDED
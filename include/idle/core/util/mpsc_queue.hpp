@@ -0,0 +1,135 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_UTIL_MPSC_QUEUE_HPP_INCLUDED
+#define IDLE_CORE_UTIL_MPSC_QUEUE_HPP_INCLUDED
+
+#include <atomic>
+#include <type_traits>
+#include <idle/core/util/assert.hpp>
+
+namespace idle {
+/// The hook that needs to be inherited by values of a MpscQueue
+class MpscQueueNode {
+  template <typename>
+  friend class MpscQueue;
+
+  std::atomic<MpscQueueNode*> next_{nullptr};
+};
+
+/// An intrusive lock-free multi-producer single-consumer queue
+///
+/// Any thread can push values, while only one thread at a time is
+/// allowed to pop them. The queue does not own its values,
+/// pushing never allocates.
+///
+/// See Dmitry Vyukov's "Intrusive MPSC node-based queue".
+template <typename T>
+class MpscQueue {
+public:
+  MpscQueue() noexcept
+    : head_(&stub_)
+    , tail_(&stub_) {}
+
+  MpscQueue(MpscQueue const&) = delete;
+  MpscQueue(MpscQueue&&) = delete;
+  MpscQueue& operator=(MpscQueue const&) = delete;
+  MpscQueue& operator=(MpscQueue&&) = delete;
+
+  /// Pushes the value to the back of the queue
+  ///
+  /// Can be called from any thread.
+  void push(T& value) noexcept {
+    static_assert(std::is_base_of<MpscQueueNode, T>::value,
+                  "T must inherit from MpscQueueNode!");
+
+    push_node(static_cast<MpscQueueNode&>(value));
+  }
+
+  /// Pops the value from the front of the queue
+  ///
+  /// Returns a nullptr if the queue is empty, or a producer has not
+  /// finished to link its value yet. In the latter case the producer
+  /// becomes visible to a subsequent pop after its push has returned.
+  ///
+  /// \attention Must only be called from the consumer.
+  T* pop() noexcept {
+    MpscQueueNode* tail = tail_;
+    MpscQueueNode* next = tail->next_.load(std::memory_order_acquire);
+
+    if (tail == &stub_) {
+      if (!next) {
+        return nullptr;
+      }
+
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer is in the middle of pushing
+      return nullptr;
+    }
+
+    push_node(stub_);
+
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+
+    return nullptr;
+  }
+
+  /// Returns true if the queue appears to be empty
+  ///
+  /// \attention Must only be called from the consumer.
+  bool emptyUnsafe() const noexcept {
+    return tail_ == &stub_ &&
+           !stub_.next_.load(std::memory_order_acquire);
+  }
+
+private:
+  void push_node(MpscQueueNode& node) noexcept {
+    node.next_.store(nullptr, std::memory_order_relaxed);
+    MpscQueueNode* const previous = head_.exchange(&node,
+                                                   std::memory_order_acq_rel);
+    previous->next_.store(&node, std::memory_order_release);
+  }
+
+  alignas(64) std::atomic<MpscQueueNode*> head_;
+  alignas(64) MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_UTIL_MPSC_QUEUE_HPP_INCLUDED
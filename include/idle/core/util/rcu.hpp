@@ -0,0 +1,233 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_UTIL_RCU_HPP_INCLUDED
+#define IDLE_CORE_UTIL_RCU_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/util/assert.hpp>
+
+namespace idle {
+/// Implements an epoch based reclamation of objects that are replaced
+/// while readers might still access them.
+///
+/// Readers pin the domain for the duration of their read-side critical
+/// section, which never blocks unless all reader slots are occupied.
+/// A retired object is deleted as soon as no reader is pinned anymore,
+/// that could have observed the object before it was retired.
+class IDLE_API(idle) EpochDomain {
+public:
+  /// The count of readers that can be pinned concurrently
+  static constexpr std::size_t slot_count = 64U;
+
+  /// Keeps the domain pinned as long as it is alive
+  class Guard {
+    friend class EpochDomain;
+
+    Guard(EpochDomain& domain, std::size_t slot) noexcept
+      : domain_(&domain)
+      , slot_(slot) {}
+
+  public:
+    Guard(Guard&& other) noexcept
+      : domain_(std::exchange(other.domain_, nullptr))
+      , slot_(other.slot_) {}
+    Guard(Guard const&) = delete;
+    Guard& operator=(Guard&&) = delete;
+    Guard& operator=(Guard const&) = delete;
+    ~Guard() {
+      if (domain_) {
+        domain_->unpin(slot_);
+      }
+    }
+
+  private:
+    EpochDomain* domain_;
+    std::size_t slot_;
+  };
+
+  EpochDomain() = default;
+  ~EpochDomain();
+
+  EpochDomain(EpochDomain const&) = delete;
+  EpochDomain(EpochDomain&&) = delete;
+  EpochDomain& operator=(EpochDomain const&) = delete;
+  EpochDomain& operator=(EpochDomain&&) = delete;
+
+  /// Pins the domain for the current read-side critical section
+  Guard pin() noexcept;
+
+  /// Retires an object which is deleted through the given deleter,
+  /// as soon as it isn't reachable by any pinned reader anymore.
+  ///
+  /// The object must be unreachable for readers that pin
+  /// the domain after this call.
+  void retire(void* object, void (*deleter)(void*));
+
+  template <typename T>
+  void retire(T const* object) {
+    retire(const_cast<T*>(object), [](void* ptr) {
+      delete static_cast<T*>(ptr);
+    });
+  }
+
+  /// Deletes all retired objects that aren't reachable anymore
+  void collect();
+
+  /// Returns the count of retired objects that weren't deleted yet
+  std::size_t pending() const;
+
+private:
+  void unpin(std::size_t slot) noexcept;
+
+  struct Slot {
+    /// The epoch the reader was pinned at, or 0 if the slot is free
+    std::atomic<std::uint64_t> epoch{0};
+
+    /// Avoids false sharing between readers of neighbouring slots
+    char padding[64U - sizeof(std::atomic<std::uint64_t>)];
+  };
+
+  struct Retired {
+    std::uint64_t epoch;
+    void* object;
+    void (*deleter)(void*);
+  };
+
+  std::atomic<std::uint64_t> epoch_{1U};
+  Slot slots_[slot_count];
+
+  mutable std::mutex mutex_;
+  std::vector<Retired> retired_;
+};
+
+/// Represents a read-mostly value that is replaced copy-on-write
+///
+/// Reads never block writers and always observe a consistent snapshot,
+/// while an update copies the current value, modifies the copy and
+/// publishes it atomically. Replaced snapshots are reclaimed through
+/// an EpochDomain after their last reader has finished.
+///
+/// Updates are serialized against each other, which makes the Rcu
+/// suitable for values that are read much more often than they are changed.
+template <typename T>
+class Rcu {
+public:
+  /// A pinned snapshot of the value
+  class Snapshot {
+    friend class Rcu;
+
+    Snapshot(EpochDomain::Guard guard, T const* value) noexcept
+      : guard_(std::move(guard))
+      , value_(value) {}
+
+  public:
+    T const& operator*() const noexcept {
+      return *value_;
+    }
+    T const* operator->() const noexcept {
+      return value_;
+    }
+
+  private:
+    EpochDomain::Guard guard_;
+    T const* value_;
+  };
+
+  Rcu()
+    : current_(new T()) {}
+  explicit Rcu(T value)
+    : current_(new T(std::move(value))) {}
+  ~Rcu() {
+    delete current_.load(std::memory_order_relaxed);
+  }
+
+  Rcu(Rcu const&) = delete;
+  Rcu(Rcu&&) = delete;
+  Rcu& operator=(Rcu const&) = delete;
+  Rcu& operator=(Rcu&&) = delete;
+
+  /// Returns a snapshot of the current value
+  ///
+  /// Can be called from any thread.
+  Snapshot read() const noexcept {
+    EpochDomain::Guard guard = domain_.pin();
+    T const* const value = current_.load(std::memory_order_seq_cst);
+    return Snapshot(std::move(guard), value);
+  }
+
+  /// Modifies a copy of the current value through the given callable
+  /// and publishes it afterwards.
+  ///
+  /// Can be called from any thread.
+  template <typename Modifier>
+  void update(Modifier&& modifier) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+
+    auto next = std::make_unique<T>(
+        *current_.load(std::memory_order_relaxed));
+    std::forward<Modifier>(modifier)(*next);
+    publish(next.release());
+  }
+
+  /// Replaces the current value
+  ///
+  /// Can be called from any thread.
+  void store(T value) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    publish(new T(std::move(value)));
+  }
+
+  /// Deletes all replaced values that aren't read anymore
+  void collect() {
+    domain_.collect();
+  }
+
+  /// Returns the count of replaced values that weren't deleted yet
+  std::size_t pending() const {
+    return domain_.pending();
+  }
+
+private:
+  void publish(T* next) {
+    T const* const previous = current_.exchange(next,
+                                                std::memory_order_seq_cst);
+    domain_.retire(previous);
+  }
+
+  mutable EpochDomain domain_;
+  std::atomic<T const*> current_;
+  std::mutex update_mutex_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_UTIL_RCU_HPP_INCLUDED
@@ -0,0 +1,198 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_UTIL_WORK_STEALING_DEQUE_HPP_INCLUDED
+#define IDLE_CORE_UTIL_WORK_STEALING_DEQUE_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <idle/core/util/assert.hpp>
+
+namespace idle {
+/// A lock-free Chase-Lev work-stealing deque of trivially copyable values
+/// (usually pointers).
+///
+/// The owning thread pushes and takes from the bottom of the deque,
+/// while any other thread is allowed to steal from the top concurrently.
+/// The deque grows on demand, previous buffers are retained until
+/// destruction since stealers may still read from them.
+///
+/// See "Correct and Efficient Work-Stealing for Weak Memory Models"
+/// (Lê, Pop, Cohen, Zappa Nardelli 2013).
+template <typename T>
+class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "T must be trivially copyable!");
+
+  class Buffer {
+  public:
+    explicit Buffer(std::int64_t capacity)
+      : mask_(capacity - 1)
+      , values_(new std::atomic<T>[static_cast<std::size_t>(capacity)]) {
+      IDLE_ASSERT(capacity > 0);
+      IDLE_ASSERT((capacity & mask_) == 0);
+    }
+
+    std::int64_t capacity() const noexcept {
+      return mask_ + 1;
+    }
+
+    T load(std::int64_t index) const noexcept {
+      return values_[index & mask_].load(std::memory_order_relaxed);
+    }
+    void store(std::int64_t index, T value) noexcept {
+      values_[index & mask_].store(value, std::memory_order_relaxed);
+    }
+
+  private:
+    std::int64_t mask_;
+    std::unique_ptr<std::atomic<T>[]> values_;
+  };
+
+public:
+  explicit WorkStealingDeque(std::size_t capacity = 256) {
+    std::int64_t size = 1;
+    while (size < static_cast<std::int64_t>(capacity)) {
+      size <<= 1;
+    }
+
+    buffers_.push_back(std::make_unique<Buffer>(size));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(WorkStealingDeque const&) = delete;
+  WorkStealingDeque(WorkStealingDeque&&) = delete;
+  WorkStealingDeque& operator=(WorkStealingDeque const&) = delete;
+  WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+  /// Pushes a value to the bottom of the deque
+  ///
+  /// \attention Must only be called from the owning thread.
+  void push(T value) {
+    std::int64_t const b = bottom_.load(std::memory_order_relaxed);
+    std::int64_t const t = top_.load(std::memory_order_acquire);
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+
+    if (b - t > buffer->capacity() - 1) {
+      buffer = grow(*buffer, t, b);
+    }
+
+    buffer->store(b, value);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// Takes the most recently pushed value from the bottom of the deque,
+  /// returns false if the deque was empty.
+  ///
+  /// \attention Must only be called from the owning thread.
+  bool take(T& out) noexcept {
+    std::int64_t const b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* const buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top_.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      // The deque was empty
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    out = buffer->load(b);
+    if (t != b) {
+      // There is more than one value left, no race with stealers possible
+      return true;
+    }
+
+    // The last value could be stolen concurrently
+    bool const won = top_.compare_exchange_strong(t, t + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return won;
+  }
+
+  /// Steals the oldest value from the top of the deque,
+  /// returns false if the deque was empty or the steal lost a race.
+  ///
+  /// Can be called from any thread.
+  bool steal(T& out) noexcept {
+    std::int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t const b = bottom_.load(std::memory_order_acquire);
+
+    if (t >= b) {
+      return false;
+    }
+
+    Buffer* const buffer = buffer_.load(std::memory_order_acquire);
+    T const value = buffer->load(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+
+    out = value;
+    return true;
+  }
+
+  /// Returns an approximate count of the values inside the deque
+  std::size_t sizeUnsafe() const noexcept {
+    std::int64_t const b = bottom_.load(std::memory_order_relaxed);
+    std::int64_t const t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<std::size_t>(b - t) : 0U;
+  }
+
+  /// Returns true if the deque appears to be empty
+  bool emptyUnsafe() const noexcept {
+    return sizeUnsafe() == 0U;
+  }
+
+private:
+  Buffer* grow(Buffer const& current, std::int64_t t, std::int64_t b) {
+    buffers_.push_back(std::make_unique<Buffer>(current.capacity() * 2));
+    Buffer* const next = buffers_.back().get();
+
+    for (std::int64_t i = t; i < b; ++i) {
+      next->store(i, current.load(i));
+    }
+
+    buffer_.store(next, std::memory_order_release);
+    return next;
+  }
+
+  alignas(64) std::atomic<std::int64_t> top_{0};
+  alignas(64) std::atomic<std::int64_t> bottom_{0};
+  alignas(64) std::atomic<Buffer*> buffer_{nullptr};
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+} // namespace idle
+
+#endif // IDLE_CORE_UTIL_WORK_STEALING_DEQUE_HPP_INCLUDED
@@ -33,6 +33,8 @@ namespace idle {
 class DependencyGraph;
 class ServiceDependencyGraph;
 class ClusterDependencyGraph;
+class Edge;
+class Service;
 
 /// Prints the graph in the graphviz format (".dot")
 IDLE_API(idle)
@@ -54,6 +56,20 @@ void graphviz(std::ostream& os, ClusterDependencyGraph const& graph);
 /// Prints the reverse graph in the graphviz format (".dot")
 IDLE_API(idle)
 void graphvizReverse(std::ostream& os, ClusterDependencyGraph const& graph);
+
+/// Prints the head of a graph in the graphviz format (".dot")
+///
+/// Together with graphvizNode, graphvizEdge and graphvizTail this allows
+/// to print a ServiceDependencyGraph piece by piece without clusters.
+IDLE_API(idle) void graphvizHead(std::ostream& os);
+/// Prints the service as node in the graphviz format (".dot")
+IDLE_API(idle) void graphvizNode(std::ostream& os, Service const& service);
+/// Prints the edge in the graphviz format (".dot")
+IDLE_API(idle)
+void graphvizEdge(std::ostream& os, Edge const& edge,
+                  ServiceDependencyGraph const& graph);
+/// Prints the tail of a graph in the graphviz format (".dot")
+IDLE_API(idle) void graphvizTail(std::ostream& os);
 } // namespace idle
 
 #endif // IDLE_EXTRA_GRAPHVIZ_HPP_INCLUDED
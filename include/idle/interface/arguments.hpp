@@ -26,18 +26,109 @@
 #ifndef IDLE_INTERFACE_ARGUMENTS_HPP_INCLUDED
 #define IDLE_INTERFACE_ARGUMENTS_HPP_INCLUDED
 
+#include <cstddef>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <idle/core/api.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/core/util/iterator_facade.hpp>
 #include <idle/core/util/string_view.hpp>
 #include <idle/interface/command.hpp>
 
 namespace idle {
+/// A non owning view over the space separated arguments of a string
+///
+/// The arguments are tokenized lazily while iterating, every argument is
+/// a slice of the viewed string, and the view never allocates.
+class ArgumentsView {
+public:
+  class iterator
+    : public iterator_facade<iterator, std::forward_iterator_tag, StringView,
+                             std::ptrdiff_t, StringView const*,
+                             StringView const&> {
+  public:
+    constexpr iterator() noexcept {}
+
+    explicit iterator(StringView remaining) noexcept
+      : remaining_(remaining) {
+      increment();
+    }
+
+    bool equal(iterator const& other) const noexcept {
+      return current_.data() == other.current_.data();
+    }
+
+    void increment() noexcept {
+      std::size_t begin = 0U;
+      while ((begin < remaining_.size()) && (remaining_[begin] == ' ')) {
+        ++begin;
+      }
+
+      std::size_t end = begin;
+      while ((end < remaining_.size()) && (remaining_[end] != ' ')) {
+        ++end;
+      }
+
+      if (begin == end) {
+        current_ = {};
+        remaining_ = {};
+      } else {
+        current_ = remaining_.substr(begin, end - begin);
+        remaining_ = remaining_.substr(end);
+      }
+    }
+
+    StringView const& dereference() const noexcept {
+      return current_;
+    }
+
+  private:
+    StringView current_;
+    StringView remaining_;
+  };
+
+  constexpr ArgumentsView() noexcept {}
+  explicit constexpr ArgumentsView(StringView str) noexcept
+    : str_(str) {}
+
+  iterator begin() const noexcept {
+    return iterator(str_);
+  }
+  iterator end() const noexcept {
+    return iterator();
+  }
+
+  bool empty() const noexcept {
+    return begin() == end();
+  }
+  /// Returns the count of arguments, which tokenizes the whole view
+  std::size_t size() const noexcept {
+    return static_cast<std::size_t>(std::distance(begin(), end()));
+  }
+
+  /// Returns the viewed string
+  constexpr StringView str() const noexcept {
+    return str_;
+  }
+
+private:
+  StringView str_;
+};
+
+/// Owns a string and the slices of its space separated arguments
+///
+/// The arguments are tokenized once on construction into slices of
+/// the owned string, such that accessing an argument doesn't allocate.
 class IDLE_API(idle) Arguments {
-  explicit Arguments(std::vector<std::string> args)
-    : args_(std::move(args)) {}
+  struct Slice {
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  using storage_t = std::vector<Slice>;
 
-  using storage_t = std::vector<std::string>;
+  Arguments(std::string buffer, std::size_t offset);
 
 public:
   using size_type = storage_t::size_type;
@@ -48,20 +139,38 @@ public:
   Arguments& operator=(Arguments const&) = default;
 
   bool empty() const noexcept {
-    return args_.empty();
+    return slices_.empty();
   }
   size_t size() const noexcept {
-    return args_.size();
+    return slices_.size();
   }
 
-  std::string const& get_string(std::size_t index) const;
+  StringView get_string(std::size_t index) const noexcept {
+    IDLE_ASSERT(index < slices_.size());
+    return StringView(buffer_.data() + slices_[index].offset,
+                      slices_[index].size);
+  }
+  /// Returns the argument as number, accepts the range of a `long long`
+  ///
+  /// \throws std::invalid_argument if the argument is not a number
+  /// \throws std::out_of_range if the number is out of range
   std::size_t get_uint(std::size_t index) const;
 
+  /// Returns a view over the arguments of the owned string
+  ArgumentsView view() const noexcept {
+    return ArgumentsView(StringView(buffer_).substr(offset_));
+  }
+
   /// Converts a string into arguments
   static Arguments from(StringView str);
+  /// Converts a string into arguments without copying it,
+  /// the arguments begin at the given offset.
+  static Arguments from(std::string&& str, std::size_t offset = 0U);
 
 private:
-  storage_t args_;
+  std::string buffer_;
+  std::size_t offset_;
+  storage_t slices_;
 };
 } // namespace idle
 
@@ -0,0 +1,69 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_INTERFACE_CLOCK_HPP_INCLUDED
+#define IDLE_INTERFACE_CLOCK_HPP_INCLUDED
+
+#include <chrono>
+#include <idle/core/api.hpp>
+#include <idle/core/dep/function.hpp>
+#include <idle/core/service.hpp>
+
+namespace idle {
+/// Represents the source of time for all services that measure
+/// or wait for durations.
+///
+/// The default implementation is backed by the std::chrono::steady_clock,
+/// while a Simulation exports a virtual clock which is only advanced
+/// explicitly or whenever the system became idle.
+class IDLE_API(idle) Clock : public Interface {
+public:
+  using Interface::Interface;
+
+  using Duration = std::chrono::steady_clock::duration;
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  /// Returns the current time point of this clock
+  virtual TimePoint now() const noexcept = 0;
+
+  /// Returns true if the clock isn't driven by the system time
+  ///
+  /// Timed waits must be scheduled through Clock::alarm then,
+  /// since platform timers will never observe the simulated time.
+  virtual bool isSimulated() const noexcept;
+
+  /// Invokes the given callback on the event loop once the clock
+  /// has reached the given deadline.
+  ///
+  /// \attention This is only supported by simulated clocks!
+  virtual void alarm(TimePoint deadline, unique_function<void()> callback);
+
+  static Ref<Clock> create(Inheritance parent);
+
+  IDLE_INTERFACE
+};
+} // namespace idle
+
+#endif // IDLE_INTERFACE_CLOCK_HPP_INCLUDED
@@ -0,0 +1,121 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_INTERFACE_TASK_POOL_HPP_INCLUDED
+#define IDLE_INTERFACE_TASK_POOL_HPP_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/dep/continuable.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/util/executor_facade.hpp>
+
+namespace idle {
+/// Represents a pool of worker threads that is shared between services
+/// for compute heavy work.
+///
+/// The default implementation schedules work through per-worker
+/// work-stealing deques, work posted from a worker is kept local to it
+/// while idle workers steal from others (preferring workers placed on
+/// the same NUMA node first).
+///
+/// Prefer the TaskPool over owning a Thread part when the work is
+/// short-lived and CPU bound, so services share cores instead of
+/// oversubscribing them.
+class IDLE_API(idle) TaskPool : public Interface,
+                                public ExecutorFacade<TaskPool> {
+
+  friend class ExecutorFacade<TaskPool>;
+
+public:
+  using Interface::Interface;
+
+  /// Returns the count of worker threads
+  virtual std::size_t concurrency() const noexcept = 0;
+
+  /// Returns true if the current thread is a worker of this pool
+  virtual bool isThisThread() const noexcept = 0;
+
+  /// Runs all given callables concurrently on the pool and resolves
+  /// the returned continuable when all of them have finished.
+  ///
+  /// The results of the callables are joined as with when_all.
+  template <typename... Callables>
+  auto fork(Callables&&... callables) {
+    return when_all(this->async_post(std::forward<Callables>(callables))...);
+  }
+
+  /// Invokes the callable for every index in [0, count) on the pool and
+  /// resolves the returned continuable when all invocations have finished.
+  ///
+  /// The range is split into chunks of at least `grain` indices,
+  /// the callable is shared between all chunks and therefore needs to be
+  /// callable concurrently. A pool without workers runs the range as
+  /// a single chunk.
+  template <typename Callable>
+  continuable<> fork_each(std::size_t count, Callable&& callable,
+                          std::size_t grain = 1) {
+    using callable_t = std::decay_t<Callable>;
+
+    grain = std::max(grain, std::size_t(1U));
+    std::size_t const workers = std::max(concurrency(), std::size_t(1U));
+    std::size_t const chunks = std::min((count + grain - 1) / grain,
+                                        workers * 4U);
+
+    auto shared = std::make_shared<callable_t>(
+        std::forward<Callable>(callable));
+
+    std::vector<continuable<>> forked;
+    forked.reserve(chunks);
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      std::size_t const begin = count * chunk / chunks;
+      std::size_t const end = count * (chunk + 1) / chunks;
+
+      forked.push_back(this->async_post([shared, begin, end] {
+        for (std::size_t i = begin; i < end; ++i) {
+          (*shared)(i);
+        }
+      }));
+    }
+
+    return when_all(std::move(forked));
+  }
+
+  static Ref<TaskPool> create(Inheritance parent);
+
+protected:
+  bool can_dispatch_inplace() const noexcept;
+  virtual void queue(work work) noexcept = 0;
+
+  IDLE_INTERFACE
+};
+} // namespace idle
+
+#endif // IDLE_INTERFACE_TASK_POOL_HPP_INCLUDED
@@ -28,6 +28,7 @@
 
 #include <chrono>
 #include <string>
+#include <vector>
 #include <idle/core/api.hpp>
 #include <idle/core/ref.hpp>
 #include <idle/plugin/plugin.hpp>
@@ -81,6 +82,8 @@ public:
 
   continuable<> generate();
   continuable<> build(std::string target = "ALL_BUILD");
+  /// Builds all given targets, in parallel if the generator permits it
+  continuable<> buildTargets(std::vector<std::string> targets);
   continuable<> buildInstall();
   continuable<> installComponent(std::string component);
 
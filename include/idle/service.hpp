@@ -31,6 +31,7 @@
 #include <idle/service/command_line.hpp>
 #include <idle/service/commands.hpp>
 #include <idle/service/file_watcher.hpp>
+#include <idle/service/handoff.hpp>
 #include <idle/service/presets.hpp>
 #include <idle/service/process_group.hpp>
 #include <idle/service/properties.hpp>
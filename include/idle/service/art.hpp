@@ -26,6 +26,7 @@
 #ifndef IDLE_SERVICE_ART_HPP_INCLUDED
 #define IDLE_SERVICE_ART_HPP_INCLUDED
 
+#include <idle/service/art/binary.hpp>
 #include <idle/service/art/equals.hpp>
 #include <idle/service/art/reflection.hpp>
 #include <idle/service/art/reflection_tree.hpp>
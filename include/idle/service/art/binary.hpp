@@ -0,0 +1,61 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_SERVICE_ART_BINARY_HPP_INCLUDED
+#define IDLE_SERVICE_ART_BINARY_HPP_INCLUDED
+
+#include <cstdint>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/util/span.hpp>
+#include <idle/service/art/reflection.hpp>
+
+namespace idle {
+namespace art {
+/// Returns a hash of the layout described by the given Reflection
+///
+/// The hash changes when a field is added, removed, renamed or reordered,
+/// or when the type of a field changes, but it is independent of the
+/// addresses of the reflection tables. Thus it is stable across different
+/// generations of the same plugin.
+IDLE_API(idle)
+std::uint64_t schema_hash(Reflection const& reflection) noexcept;
+
+/// Appends a compact binary representation of the object to the buffer
+///
+/// \note The representation does not contain any field names,
+///       compare the schema_hash of both sides before reading it back.
+IDLE_API(idle)
+void binary_serialize(std::vector<char>& buffer, ConstReflectionPtr ptr);
+
+/// Reads the object back from its binary representation
+///
+/// \returns false if the buffer is truncated or doesn't match the object
+IDLE_API(idle)
+bool binary_deserialize(Span<char const> buffer, ReflectionPtr ptr);
+} // namespace art
+} // namespace idle
+
+#endif // IDLE_SERVICE_ART_BINARY_HPP_INCLUDED
@@ -151,6 +151,37 @@ public:
   IDLE_SERVICE
 };
 
+class IDLE_API(idle) MetricsCommand : public Implements<Command> {
+  using Implements<Command>::Implements;
+
+public:
+  std::string command_name() const noexcept override {
+    return "idle metrics";
+  }
+
+  /// Prints the scheduler and service lifecycle metrics,
+  /// or dumps them as JSON when invoked with the argument `json`.
+  continuable<> invoke(Ref<Session> session, Arguments&& args) override;
+
+  IDLE_SERVICE
+};
+
+class IDLE_API(idle) TraceCommand : public Implements<Command> {
+  using Implements<Command>::Implements;
+
+public:
+  std::string command_name() const noexcept override {
+    return "idle trace";
+  }
+
+  /// Enables (`on`) or disables (`off`) the tracing of the service
+  /// lifecycle and plugin reloads, removes all recorded spans (`clear`)
+  /// or writes them as Chrome trace-event JSON (`export <path>`).
+  continuable<> invoke(Ref<Session> session, Arguments&& args) override;
+
+  IDLE_SERVICE
+};
+
 class IDLE_API(idle) GraphShowCommand : public Implements<Command> {
   friend class graph_show_command_impl;
   using Implements<Command>::Implements;
@@ -168,8 +199,9 @@ public:
 namespace detail {
 using CommandComposition = Implements<
     Introduce<ExitCommand>, Introduce<GraphShowCommand>, Introduce<HelpCommand>,
-    Introduce<LSCommand>, Introduce<RestartCommand>, Introduce<StartCommand>,
-    Introduce<StopCommand>, Introduce<TreeCommand>, Introduce<VerifyCommand>,
+    Introduce<LSCommand>, Introduce<MetricsCommand>, Introduce<RestartCommand>,
+    Introduce<StartCommand>, Introduce<StopCommand>, Introduce<TraceCommand>,
+    Introduce<TreeCommand>, Introduce<VerifyCommand>,
     Introduce<VersionCommand>>;
 }
 
@@ -0,0 +1,198 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_SERVICE_HANDOFF_HPP_INCLUDED
+#define IDLE_SERVICE_HANDOFF_HPP_INCLUDED
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <idle/core/api.hpp>
+#include <idle/core/detail/chaining.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/ref.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/util/string_view.hpp>
+#include <idle/service/art/reflection.hpp>
+
+namespace idle {
+/// Transfers the in-memory state of a Service from one generation
+/// to the next one, for instance when a plugin is reloaded.
+///
+/// States are only recorded while a handoff window is open,
+/// states which were not taken until the last window is closed are dropped.
+class IDLE_API(idle) StateHandoff : public Interface {
+  friend class DefaultStateHandoff;
+  using Interface::Interface;
+
+public:
+  /// Keeps the handoff open until it is destroyed
+  class IDLE_API(idle) Window {
+    friend class DefaultStateHandoff;
+
+    explicit Window(WeakRef<StateHandoff> handoff)
+      : handoff_(std::move(handoff)) {}
+
+  public:
+    Window() = default;
+    ~Window();
+
+    Window(Window const&) = delete;
+    Window(Window&&) = default;
+    Window& operator=(Window const&) = delete;
+    Window& operator=(Window&& other) noexcept;
+
+    void reset() noexcept;
+
+  private:
+    WeakRef<StateHandoff> handoff_;
+  };
+
+  /// Opens the handoff, the returned Window closes it again
+  ///
+  /// \attention Must be called on the event loop.
+  Window open();
+
+  /// Returns true if at least one Window is open
+  bool isOpen() const noexcept;
+
+  /// Records the state under the given key if the handoff is open
+  ///
+  /// The state is stored together with the schema_hash of its reflection.
+  void put(StringView key, ConstReflectionPtr state);
+
+  /// Restores the state recorded under the given key
+  ///
+  /// \returns false if no state was recorded under the key or
+  ///          if the recorded state has a mismatching layout.
+  ///          The state is left in an unspecified state then and
+  ///          should be reset by the caller (cold start).
+  bool take(StringView key, ReflectionPtr state);
+
+  static Ref<StateHandoff> create(Inheritance parent);
+
+  IDLE_INTERFACE
+};
+
+class IDLE_API(idle) HandoffBase : protected DependencyBase {
+public:
+  explicit HandoffBase(Service& owner, std::string key);
+
+  std::string const& key() const noexcept {
+    return key_;
+  }
+
+  /// Returns true if the value was restored from a previous generation
+  bool isWarm() const noexcept {
+    return warm_;
+  }
+
+protected:
+  void partName(std::ostream& os) const override;
+
+  void onImportUnlock() noexcept override;
+
+  StateHandoff& raw() noexcept;
+  StateHandoff const& raw() const noexcept;
+
+  Interface::Id type() const noexcept override;
+
+  bool hasDefault() const noexcept override;
+  Ref<Interface> createDefault(Inheritance inh) override;
+
+  bool warm_{false};
+
+private:
+  std::string const key_;
+};
+
+/// Implements a state of a Service that survives its replacement
+///
+/// The state is restored before the Service is started and recorded
+/// after it was stopped. When the layout of the state was changed
+/// in between or there was no previous generation, the state
+/// is default constructed instead (cold start).
+///
+/// ```cpp
+/// Handoff<Cache> cache_{*this, "my_service.cache"};
+/// ```
+template <typename T>
+class Handoff final : public HandoffBase {
+  using traits = detail::def_chain_traits<T>;
+
+  static_assert(std::is_default_constructible<T>::value,
+                "A handoff type must be default constructible!");
+
+public:
+  using HandoffBase::HandoffBase;
+
+  T& operator*() noexcept {
+    IDLE_ASSERT(isLocked());
+    return value_;
+  }
+  T const& operator*() const noexcept {
+    IDLE_ASSERT(isLocked());
+    return value_;
+  }
+
+  typename traits::mutable_trait::type operator->() noexcept {
+    return traits::mutable_trait::do_chain(operator*());
+  }
+  typename traits::const_trait::type operator->() const noexcept {
+    return traits::const_trait::do_chain(operator*());
+  }
+
+  T* get() noexcept {
+    return std::addressof(operator*());
+  }
+  T const* get() const noexcept {
+    return std::addressof(operator*());
+  }
+
+protected:
+  void onImportLock() noexcept override {
+    HandoffBase::onImportLock();
+
+    T restored{};
+    warm_ = raw().take(key(), restored);
+    if (warm_) {
+      value_ = std::move(restored);
+    }
+  }
+
+  void onImportUnlock() noexcept override {
+    raw().put(key(), value_);
+
+    HandoffBase::onImportUnlock();
+
+    value_ = T{};
+  }
+
+private:
+  T value_{};
+};
+} // namespace idle
+
+#endif // IDLE_SERVICE_HANDOFF_HPP_INCLUDED
@@ -0,0 +1,72 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_SERVICE_IDLE_TIMEOUT_HPP_INCLUDED
+#define IDLE_SERVICE_IDLE_TIMEOUT_HPP_INCLUDED
+
+#include <idle/core/api.hpp>
+#include <idle/core/ref.hpp>
+#include <idle/core/service.hpp>
+#include <idle/service/timer.hpp>
+
+namespace idle {
+/// Keeps the service it is a Component of running for an idle timeout
+/// after its last user was stopped, instead of stopping it immediately.
+///
+/// This is meant for services declared through IDLE_DECLARE_LAZY whose
+/// users come and go frequently, such that they aren't restarted each time:
+/// ```cpp
+/// class LazyService final : public Implements<Lazy> {
+/// public:
+///   using Implements<Lazy>::Implements;
+///
+/// private:
+///   Component<IdleTimeout> idle_timeout_{*this, std::chrono::seconds(30)};
+///
+///   IDLE_SERVICE
+/// };
+/// ```
+///
+/// The service is checked for running users once per timeout on the Timer
+/// and stopped as soon as two consecutive checks didn't find any.
+///
+/// \note Only users that depend on an export of the service are observed,
+///       a Use that was acquired through a Handle doesn't keep it running.
+class IDLE_API(idle) IdleTimeout : public Service {
+  friend class IdleTimeoutImpl;
+
+protected:
+  using Service::Service;
+
+public:
+  using Duration = Timer::Duration;
+
+  static Ref<IdleTimeout> create(Inheritance parent, Duration timeout);
+
+  IDLE_SERVICE
+};
+} // namespace idle
+
+#endif // IDLE_SERVICE_IDLE_TIMEOUT_HPP_INCLUDED
@@ -111,6 +111,10 @@ struct SpawnOptions {
 struct StreamingOptions {
   Ref<Sink> out;
   Ref<Sink> err;
+
+  /// Writes every line of the output separately to the sinks without its
+  /// line delimiter, otherwise the output is written in chunks as it arrives.
+  bool split_lines = true;
 };
 
 /// The process_group makes it possible to invoke child processes.
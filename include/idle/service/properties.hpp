@@ -67,6 +67,13 @@ public:
   /// Returns true if the given key has changed from the previous generation.
   virtual bool changed(StringView key) const noexcept = 0;
 
+  /// Returns true if the given key is equal in the other generation,
+  /// without deserializing the values of the key.
+  ///
+  /// The result may be false negative if both generations can't be compared
+  /// without deserializing them.
+  virtual bool equals(Properties const& other, StringView key) const noexcept;
+
   /// Stores the structure of the given key into the reflectable object
   virtual bool get(ReflectionPtr out, StringView key) const noexcept = 0;
 
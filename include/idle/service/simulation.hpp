@@ -0,0 +1,142 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_SERVICE_SIMULATION_HPP_INCLUDED
+#define IDLE_SERVICE_SIMULATION_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/dep/optional.hpp>
+#include <idle/core/ref.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/support.hpp>
+#include <idle/interface/clock.hpp>
+#include <idle/interface/io_context.hpp>
+
+namespace idle {
+/// Runs the system in a deterministic single-threaded simulated time mode
+///
+/// The Simulation exports a virtual Clock and an IOContext whose handlers
+/// are dispatched inline from the event loop one after another.
+/// Whenever the system became idle the simulated time jumps to the
+/// next pending alarm, such that timed waits resolve without
+/// actually waiting for them.
+///
+/// Because the Simulation takes precedence over the default Clock and
+/// IOContext, creating it in the Context is enough to run every Timer,
+/// debounce and asynchronous operation on simulated time:
+/// ```cpp
+/// Ref<Context> context = Context::create();
+/// Ref<Simulation> simulation = Simulation::create(*context);
+/// ```
+///
+/// The events observed by the Simulation can be recorded into a Trace
+/// which can be replayed later to reproduce and verify the same ordering.
+///
+/// \attention Work must only be posted to the IOContext from the event loop
+///            or from handlers running on it, since work posted from
+///            other threads doesn't wake up an idle event loop.
+class IDLE_API(idle) Simulation : public Implements<Clock, IOContext> {
+  friend class SimulationImpl;
+  using Super::Super;
+
+public:
+  /// An event that was observed by the Simulation
+  struct Event {
+    enum class Kind : std::uint8_t {
+      Handler, ///< A handler of the IOContext was dispatched
+      Alarm,   ///< An alarm of the Clock has fired
+      Advance  ///< The simulated time was advanced
+    };
+
+    Kind kind;
+    /// The simulated time elapsed since the start of the simulation
+    Duration at;
+    /// The sequence number of the handler or alarm, zero otherwise
+    std::uint64_t sequence;
+
+    friend bool operator==(Event const& left, Event const& right) noexcept {
+      return (left.kind == right.kind) && (left.at == right.at) &&
+             (left.sequence == right.sequence);
+    }
+    friend bool operator!=(Event const& left, Event const& right) noexcept {
+      return !(left == right);
+    }
+  };
+
+  using Trace = std::vector<Event>;
+
+  /// Advances the simulated time by the given duration while firing all
+  /// alarms which are due until then in the order of their deadline.
+  ///
+  /// \attention This method needs to be called from the event loop!
+  void advance(Duration duration);
+
+  /// Advances the simulated time to the given time point
+  ///
+  /// \copydetails advance
+  void advanceTo(TimePoint deadline);
+
+  /// Sets whether the simulated time jumps to the next pending alarm
+  /// whenever the system became idle, which is enabled by default.
+  void setAutoAdvance(bool enabled) noexcept;
+
+  /// Starts recording all observed events into the trace
+  void record();
+
+  /// Returns the trace that was recorded so far
+  Trace const& trace() const noexcept;
+
+  /// Replays the given trace
+  ///
+  /// Instead of advancing automatically the simulated time is advanced
+  /// exactly as recorded, while every observed event is compared
+  /// to the recorded one.
+  ///
+  /// \attention This method needs to be called before the Simulation
+  ///            is started, so the sequence numbers line up.
+  void replay(Trace trace);
+
+  /// Returns the index of the first event that diverged from the
+  /// replayed trace, or an empty optional if all events matched so far.
+  optional<std::size_t> divergence() const noexcept;
+
+  /// Writes the given trace line by line to the given stream
+  static void writeTrace(std::ostream& os, Trace const& trace);
+
+  /// Reads a trace that was written by Simulation::writeTrace,
+  /// returns false if the input is malformed.
+  static bool readTrace(std::istream& is, Trace& trace);
+
+  static Ref<Simulation> create(Inheritance parent);
+
+  IDLE_SERVICE
+};
+} // namespace idle
+
+#endif // IDLE_SERVICE_SIMULATION_HPP_INCLUDED
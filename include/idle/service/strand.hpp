@@ -26,6 +26,8 @@
 #ifndef IDLE_SERVICE_STRAND_HPP_INCLUDED
 #define IDLE_SERVICE_STRAND_HPP_INCLUDED
 
+#include <cstddef>
+#include <cstdint>
 #include <idle/core/api.hpp>
 #include <idle/core/ref.hpp>
 #include <idle/core/service.hpp>
@@ -34,6 +36,12 @@
 namespace idle {
 class Strand;
 
+/// Serializes the work posted to it, while running it on an underlying
+/// executor (the IOContext, the TaskPool or the EventLoop).
+///
+/// Work is queued into a lock-free mailbox and dispatched in turns,
+/// a turn runs at most `batch` items before it is re-posted,
+/// such that a busy strand does not starve other work on the executor.
 class IDLE_API(idle) Strand : public Service, public ExecutorFacade<Strand> {
   friend class ExecutorFacade<Strand>;
 
@@ -41,7 +49,30 @@ protected:
   using Service::Service;
 
 public:
-  static Ref<Strand> create(Inheritance parent);
+  struct Statistics {
+    /// The count of items queued but not dispatched yet
+    std::size_t depth{0};
+    /// The highest depth that was observed
+    std::size_t max_depth{0};
+    /// The count of items that were dispatched
+    std::uint64_t dispatched{0};
+    /// The count of turns that were posted to the executor
+    std::uint64_t turns{0};
+  };
+
+  /// Returns a snapshot of the mailbox statistics
+  Statistics statistics() const noexcept;
+
+  /// Creates a strand that runs on the IOContext
+  static Ref<Strand> create(Inheritance parent, std::size_t batch = 64);
+
+  /// Creates a strand that runs on the TaskPool
+  static Ref<Strand> createOnTaskPool(Inheritance parent,
+                                      std::size_t batch = 64);
+
+  /// Creates a strand that runs on the EventLoop
+  static Ref<Strand> createOnEventLoop(Inheritance parent,
+                                       std::size_t batch = 64);
 
 private:
   bool can_dispatch_inplace() const noexcept;
@@ -26,11 +26,14 @@
 #ifndef IDLE_SERVICE_VAR_HPP_INCLUDED
 #define IDLE_SERVICE_VAR_HPP_INCLUDED
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <vector>
 #include <idle/core/api.hpp>
 #include <idle/core/context.hpp>
+#include <idle/core/dep/function.hpp>
 #include <idle/core/detail/chaining.hpp>
 #include <idle/core/interface.hpp>
 #include <idle/core/parts/dyn_dependency.hpp>
@@ -67,8 +70,22 @@ protected:
 
   void save(ConstReflectionPtr reflected) noexcept;
 
+  /// Returns true if the key is known to be equal in both Properties
+  /// generations without deserializing its values.
+  bool isEqualIn(Interface const& from, Interface const& to) const noexcept;
+
+  /// Deserializes the key from the given generation into the staged value,
+  /// such that a following onSwap to the same generation can reuse it.
+  void stage(Interface const& to, ReflectionPtr staged) noexcept;
+
+  /// Returns true if the staged value was deserialized from the given
+  /// generation and consumes it.
+  bool takeStaged(Interface const& to) noexcept;
+
 private:
   std::string const key_;
+  std::size_t staged_generation_{0};
+  bool is_staged_{false};
 };
 
 struct MoveApplier {
@@ -123,6 +140,110 @@ private:
   T* dest_;
 };
 
+/// Represents the grouped VarUpdates of a single service that were caused
+/// by the same Properties change.
+class IDLE_API(idle) VarUpdates {
+  friend class VarGroupBase;
+
+public:
+  using Commit = unique_function<bool()>;
+
+  VarUpdates() = default;
+
+  /// Returns the count of grouped updates
+  std::size_t size() const noexcept {
+    return commits_.size();
+  }
+
+  bool empty() const noexcept {
+    return commits_.empty();
+  }
+
+  /// Applies all grouped updates in the order they were received
+  ///
+  /// \returns the count of updates that were applied, updates are skipped
+  ///          if they became outdated due to a Service stop.
+  std::size_t apply() noexcept;
+
+private:
+  std::vector<Commit> commits_;
+};
+
+/// Collects the updates of all Vars of a service that are connected to it,
+/// such that a Properties change touching many Vars is delivered through
+/// a single hook invocation instead of one per Var.
+///
+/// \attention The VarGroup needs to be declared before its Vars.
+class IDLE_API(idle) VarGroupBase {
+public:
+  explicit VarGroupBase(Service& owner) noexcept
+    : owner_(owner) {}
+  virtual ~VarGroupBase() = default;
+
+  VarGroupBase(VarGroupBase&&) = delete;
+  VarGroupBase(VarGroupBase const&) = delete;
+  VarGroupBase& operator=(VarGroupBase&&) = delete;
+  VarGroupBase& operator=(VarGroupBase const&) = delete;
+
+  /// Adds the update of a Var to the group and schedules the delivery
+  /// of the group after all currently pending updates.
+  ///
+  /// \event_loop
+  void add(VarUpdates::Commit commit);
+
+protected:
+  virtual void onUpdates(VarUpdates&& updates) noexcept = 0;
+
+private:
+  void deliver() noexcept;
+
+  Service& owner_;
+  VarUpdates pending_;
+};
+
+namespace hooks {
+template <typename Owner>
+class OnVarUpdatesDyn {
+  using value_type = void (*)(Owner&, VarUpdates&& updates);
+
+public:
+  OnVarUpdatesDyn() noexcept = default;
+
+  template <typename V, decltype(value_type(std::declval<V>()))* = nullptr>
+  /* implicit */ OnVarUpdatesDyn(V&& value)
+    : value_(static_cast<value_type>(std::forward<V>(value))) {}
+
+  void operator()(Owner& owner, VarUpdates&& updates) noexcept {
+    if (value_) {
+      value_(owner, std::move(updates));
+    } else {
+      updates.apply();
+    }
+  }
+
+private:
+  value_type value_{nullptr};
+};
+} // namespace hooks
+
+template <typename Owner = Service,
+          typename OnVarUpdates = hooks::OnVarUpdatesDyn<Owner>>
+class VarGroup final : public VarGroupBase, private OnVarUpdates {
+public:
+  explicit VarGroup(Owner& owner, OnVarUpdates on_var_updates = {})
+    : VarGroupBase(owner)
+    , OnVarUpdates(std::move(on_var_updates))
+    , owner_(owner) {}
+
+protected:
+  void onUpdates(VarUpdates&& updates) noexcept override {
+    OnVarUpdates::operator()(owner_, std::move(updates));
+  }
+
+private:
+  Owner& owner_;
+};
+
 namespace hooks {
 template <typename Owner, typename T>
 class OnVarUpdateDyn {
@@ -147,6 +268,33 @@ public:
 private:
   value_type value_{nullptr};
 };
+
+/// Forwards the updates of a Var to a VarGroup
+template <typename Owner, typename T>
+class OnVarUpdateGrouped {
+public:
+  OnVarUpdateGrouped() noexcept = default;
+
+  /* implicit */ OnVarUpdateGrouped(VarGroupBase& group) noexcept
+    : group_(&group) {}
+
+  bool operator()(Owner& owner, VarUpdate<T>&& update) noexcept {
+    IDLE_ASSERT(group_);
+    (void)owner;
+
+    group_->add([update = std::move(update)]() mutable {
+      return update.apply();
+    });
+    return true;
+  }
+
+  explicit operator bool() const noexcept {
+    return !!group_;
+  }
+
+private:
+  VarGroupBase* group_{nullptr};
+};
 } // namespace hooks
 
 // TODO Var vs DynVar?
@@ -169,7 +317,8 @@ public:
     , DefaultFactory(std::move(factory))
     , owner_(owner)
     , event_space_current_(createDefaultValue())
-    , user_space_current_(event_space_current_) {}
+    , user_space_current_(event_space_current_)
+    , staged_(event_space_current_) {}
 
   Owner& owner() noexcept override {
     return owner_;
@@ -228,12 +377,19 @@ protected:
       return false;
     }
 
-    // Swap to the latest properties generation if the content matches
+    // Swap to the latest properties generation if the content matches,
+    // which is decided without deserializing for unchanged keys.
+    if (isEqualIn(*from, *to)) {
+      return true;
+    }
+
+    // Deserialize the changed value only once, onSwap reuses it
+    staged_ = createDefaultValue();
+    stage(*to, staged_);
+
     T src(createDefaultValue());
     cast<Properties>(*from).get(src, key());
-    T target(createDefaultValue());
-    cast<Properties>(*to).get(target, key());
-    if (art::equals(src, target)) {
+    if (art::equals(src, staged_)) {
       return true;
     }
 
@@ -243,10 +399,12 @@ protected:
   void onSwap(SwapAction<Interface>&& action) noexcept override {
     IDLE_ASSERT(isLocked());
 
-    Properties const& to = cast<Properties>(*action.to());
-
     T updated(createDefaultValue());
-    to.get(updated, key());
+    if (takeStaged(*action.to())) {
+      updated = std::move(staged_);
+    } else {
+      cast<Properties>(*action.to()).get(updated, key());
+    }
 
     // We have to check against the real object to take the
     // default object state into account.
@@ -296,7 +454,14 @@ private:
   Owner& owner_;
   T event_space_current_;
   T user_space_current_;
+  T staged_;
 };
+
+/// A Var whose updates are delivered grouped through a VarGroup
+template <typename T, typename Owner = Service,
+          typename DefaultFactory = DefaultConstruct<T>>
+using GroupedVar = Var<T, Owner, hooks::OnVarUpdateGrouped<Owner, T>,
+                       DefaultFactory>;
 } // namespace idle
 
 #endif // IDLE_SERVICE_VAR_HPP_INCLUDED
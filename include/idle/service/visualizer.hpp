@@ -26,6 +26,7 @@
 #ifndef IDLE_SERVICE_VISUALIZER_HPP_INCLUDED
 #define IDLE_SERVICE_VISUALIZER_HPP_INCLUDED
 
+#include <cstddef>
 #include <string>
 #include <idle/core/api.hpp>
 #include <idle/core/graph.hpp>
@@ -53,6 +54,18 @@ public:
     GraphFlags flags;
   };
 
+  struct ExportOptions {
+    constexpr ExportOptions() noexcept {} // Clang bug workaround
+
+    /// The count of services that are rendered at once before
+    /// the export yields back to the event loop
+    std::size_t chunk_size{512};
+    /// Exports only the services which changed since the given snapshot,
+    /// the full graph is exported if the snapshot is 0 or unknown.
+    std::size_t since{0};
+    GraphFlags flags;
+  };
+
   /// Saves the \see dependency_graph into a .gv file and opens it
   ///
   /// If the `dot` application from graphviz is found the graphviz
@@ -62,6 +75,22 @@ public:
   /// \copydoc showGraph
   continuable<> showGraph(std::string file_path, Options opt = {});
 
+  /// Streams the \see ServiceDependencyGraph into a graphviz file
+  ///
+  /// In contrast to showGraph the graph is rendered in small chunks
+  /// on the event loop and written from the TaskPool, such that
+  /// the event loop is not stalled on large graphs.
+  /// The graph is not captured atomically, services which change
+  /// during the export may be exported in either state.
+  ///
+  /// \returns The id of the exported snapshot, that can be passed to
+  ///          ExportOptions::since in order to export only the services
+  ///          that changed in the meantime (a delta). A service of a delta
+  ///          replaces the service and all its outgoing edges, removed
+  ///          services are listed as comments.
+  continuable<std::size_t> exportGraph(std::string file_path,
+                                       ExportOptions opt = {});
+
   static Ref<Visualizer> create(Inheritance parent);
 
   IDLE_SERVICE
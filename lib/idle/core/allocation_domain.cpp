@@ -0,0 +1,231 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <idle/core/allocation_domain.hpp>
+#include <idle/core/util/assert.hpp>
+
+namespace idle {
+class AllocationDomainImpl final : public AllocationDomain {
+  /// The granularity of the size classes
+  static constexpr std::size_t granularity = alignof(std::max_align_t);
+  /// Blocks larger than this are allocated from the heap
+  static constexpr std::size_t max_block_size = 4096U;
+  static constexpr std::size_t size_classes = max_block_size / granularity;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+public:
+  explicit AllocationDomainImpl(std::size_t slab_size)
+    : slab_size_(std::max(slab_size, max_block_size)) {}
+
+  static bool is_heap_allocated(std::size_t size,
+                                std::size_t alignment) noexcept {
+    return (size > max_block_size) || (alignment > granularity);
+  }
+
+  static std::size_t size_class_of(std::size_t size) noexcept {
+    IDLE_ASSERT(size);
+    return (size - 1U) / granularity;
+  }
+
+  static void* allocate_heap(std::size_t size, std::size_t alignment) {
+#ifdef __cpp_aligned_new
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      return ::operator new(size, std::align_val_t(alignment));
+    }
+    return ::operator new(size);
+#else
+    if (alignment <= granularity) {
+      return ::operator new(size);
+    }
+
+    // Over-align the block manually and store the address of the
+    // underlying allocation right in front of the aligned block.
+    IDLE_ASSERT((alignment & (alignment - 1U)) == 0U);
+    IDLE_ASSERT(alignment >= sizeof(void*));
+    void* const raw = ::operator new(size + alignment);
+    std::uintptr_t const aligned = (reinterpret_cast<std::uintptr_t>(raw) +
+                                    alignment) &
+                                   ~(std::uintptr_t(alignment) - 1U);
+    void* const ptr = reinterpret_cast<void*>(aligned);
+    static_cast<void**>(ptr)[-1] = raw;
+    return ptr;
+#endif
+  }
+
+  static void deallocate_heap(void* ptr, std::size_t size,
+                              std::size_t alignment) noexcept {
+#ifdef __cpp_aligned_new
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(ptr, size, std::align_val_t(alignment));
+      return;
+    }
+    ::operator delete(ptr, size);
+#else
+    (void)size;
+    if (alignment <= granularity) {
+      ::operator delete(ptr);
+    } else {
+      ::operator delete(static_cast<void**>(ptr)[-1]);
+    }
+#endif
+  }
+
+  void* allocate(std::size_t size, std::size_t alignment) {
+    if (is_heap_allocated(size, alignment)) {
+      void* const ptr = allocate_heap(size, alignment);
+      record(size, true);
+      return ptr;
+    }
+
+    std::size_t const index = size_class_of(size);
+    std::size_t const block_size = (index + 1U) * granularity;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (FreeBlock* const block = free_[index]) {
+      free_[index] = block->next;
+      record_unlocked(block_size, true);
+      return block;
+    }
+
+    if (static_cast<std::size_t>(end_ - cursor_) < block_size) {
+      // The remainder of the current slab is abandoned
+      slabs_.emplace_back(new unsigned char[slab_size_]);
+      cursor_ = slabs_.back().get();
+      end_ = cursor_ + slab_size_;
+      statistics_.reserved += slab_size_;
+      ++statistics_.slabs;
+    }
+
+    void* const ptr = cursor_;
+    cursor_ += block_size;
+    record_unlocked(block_size, true);
+    return ptr;
+  }
+
+  void deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept {
+    if (is_heap_allocated(size, alignment)) {
+      deallocate_heap(ptr, size, alignment);
+      record(size, false);
+      return;
+    }
+
+    std::size_t const index = size_class_of(size);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    FreeBlock* const block = new (ptr) FreeBlock{free_[index]};
+    free_[index] = block;
+    record_unlocked((index + 1U) * granularity, false);
+  }
+
+  Statistics statistics_impl() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+  }
+
+private:
+  void record(std::size_t size, bool allocated) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    record_unlocked(size, allocated);
+  }
+
+  void record_unlocked(std::size_t size, bool allocated) noexcept {
+    if (allocated) {
+      ++statistics_.blocks;
+      statistics_.allocated += size;
+    } else {
+      IDLE_ASSERT(statistics_.blocks);
+      --statistics_.blocks;
+      statistics_.allocated -= size;
+    }
+  }
+
+  mutable std::mutex mutex_;
+  std::size_t const slab_size_;
+  std::vector<std::unique_ptr<unsigned char[]>> slabs_;
+  unsigned char* cursor_{nullptr};
+  unsigned char* end_{nullptr};
+  std::array<FreeBlock*, size_classes> free_{};
+  Statistics statistics_;
+};
+
+static thread_local AllocationDomain* current_domain = nullptr;
+
+AllocationDomain::Statistics AllocationDomain::statistics() const noexcept {
+  return static_cast<AllocationDomainImpl const*>(this)->statistics_impl();
+}
+
+Ref<AllocationDomain> AllocationDomain::create(std::size_t slab_size) {
+  // The domain itself is never allocated inside another domain
+  AllocationScope const heap(nullptr);
+  return make_ref<AllocationDomainImpl>(slab_size);
+}
+
+AllocationScope::AllocationScope(AllocationDomain* domain) noexcept
+  : previous_(current_domain) {
+  current_domain = domain;
+}
+
+AllocationScope::~AllocationScope() {
+  current_domain = previous_;
+}
+
+namespace detail {
+AllocationDomain* current_allocation_domain() noexcept {
+  return current_domain;
+}
+
+void* allocate_from(AllocationDomain& domain, std::size_t size,
+                    std::size_t alignment) {
+  void* const ptr = static_cast<AllocationDomainImpl&>(domain).allocate(
+      size, alignment);
+
+  // Every block keeps the domain and thus its slabs alive
+  RefCounter counter = domain.refCounter();
+  counter.release();
+  return ptr;
+}
+
+void deallocate_to(AllocationDomain& domain, void* ptr, std::size_t size,
+                   std::size_t alignment) noexcept {
+  static_cast<AllocationDomainImpl&>(domain).deallocate(ptr, size, alignment);
+
+  // Release the reference that was acquired through allocate_from,
+  // which possibly releases the domain and all of its slabs.
+  RefCounter counter = domain.refCounter();
+  counter.decrement();
+}
+} // namespace detail
+} // namespace idle
@@ -29,9 +29,11 @@
 #include <idle/core/detail/log.hpp>
 #include <idle/core/detail/rtti.hpp>
 #include <idle/core/detail/service_impl.hpp>
+#include <idle/core/metrics.hpp>
 #include <idle/core/ref.hpp>
 #include <idle/core/registry.hpp>
 #include <idle/core/service.hpp>
+#include <idle/core/tracing.hpp>
 #include <idle/core/util/assert.hpp>
 
 namespace idle {
@@ -47,14 +49,38 @@ Ref<Service> Context::lookup(Guid guid) const noexcept {
   return ContextImpl::from(this)->lookupImpl(guid);
 }
 
+RegistryView Context::snapshot() const noexcept {
+  return ContextImpl::from(this)->snapshot();
+}
+
 continuable<> Context::update() {
   return ContextImpl::from(this)->do_update_system();
 }
 
+continuable<> Context::update(std::vector<WeakRef<Service>> origins) {
+  return ContextImpl::from(this)->do_update_dependents(std::move(origins));
+}
+
+StaticComposition
+Context::compose(std::vector<WeakRef<Service>> const& services) {
+  IDLE_ASSERT(is_on_event_loop());
+  return ContextImpl::from(this)->associated_scheduler().do_compose(services);
+}
+
+continuable<> Context::start(StaticComposition const& composition) {
+  IDLE_ASSERT(is_on_event_loop());
+  return ServiceImpl::request_start(*this, composition);
+}
+
 bool Context::is_on_event_loop() const noexcept {
   return ContextImpl::from(this)->is_on_event_loop_impl();
 }
 
+void Context::setIdleHandler(unique_function<bool()> handler) noexcept {
+  IDLE_ASSERT(is_on_event_loop());
+  ContextImpl::from(this)->set_idle_handler(std::move(handler));
+}
+
 continuable<> Context::stop(int exit_code) {
   return ContextImpl::from(this)->stop_impl(exit_code);
 }
@@ -78,6 +104,14 @@ bool Context::verify(std::ostream& os) noexcept {
   return successful;
 }
 
+Metrics& Context::metrics() noexcept {
+  return ContextImpl::from(this)->metrics_;
+}
+
+Tracing& Context::tracing() noexcept {
+  return ContextImpl::from(this)->tracing_;
+}
+
 bool Context::can_dispatch_inplace() const noexcept {
   ContextImpl const* const impl = ContextImpl::from(this);
   return impl->is_running_impl() && impl->is_on_event_loop_impl();
@@ -0,0 +1,128 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <new>
+#include <idle/core/coroutine.hpp>
+
+namespace idle {
+CancellationException::CancellationException() = default;
+
+char const* CancellationException::what() const noexcept {
+  return "The awaited continuable was cancelled";
+}
+
+namespace detail {
+/// Frames are pooled in size classes of 64 bytes up to 1 KiB,
+/// larger frames are passed to the global allocator directly.
+static constexpr std::size_t frame_granularity = 64U;
+static constexpr std::size_t frame_classes = 16U;
+/// The maximum count of free frames retained per size class and thread
+static constexpr std::size_t frame_pool_depth = 64U;
+
+namespace {
+struct free_frame {
+  free_frame* next;
+};
+
+/// Is trivially destructible and therefore still accessible
+/// while the frame pool of the thread is destroyed.
+thread_local bool frame_pool_destroyed = false;
+
+class frame_pool {
+public:
+  frame_pool() = default;
+  ~frame_pool() {
+    frame_pool_destroyed = true;
+
+    for (free_frame* head : heads_) {
+      while (head) {
+        free_frame* const next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+    }
+  }
+
+  frame_pool(frame_pool const&) = delete;
+  frame_pool& operator=(frame_pool const&) = delete;
+
+  void* pop(std::size_t size_class) noexcept {
+    free_frame* const head = heads_[size_class];
+    if (head) {
+      heads_[size_class] = head->next;
+      --counts_[size_class];
+    }
+    return head;
+  }
+
+  bool push(std::size_t size_class, void* frame) noexcept {
+    if (counts_[size_class] >= frame_pool_depth) {
+      return false;
+    }
+
+    auto* const current = static_cast<free_frame*>(frame);
+    current->next = heads_[size_class];
+    heads_[size_class] = current;
+    ++counts_[size_class];
+    return true;
+  }
+
+private:
+  free_frame* heads_[frame_classes]{};
+  std::size_t counts_[frame_classes]{};
+};
+
+thread_local frame_pool pool;
+} // namespace
+
+static std::size_t size_class_of(std::size_t size) noexcept {
+  return (size + frame_granularity - 1U) / frame_granularity - 1U;
+}
+
+void* allocate_coroutine_frame(std::size_t size) {
+  std::size_t const size_class = size_class_of(size);
+  if (size_class >= frame_classes || frame_pool_destroyed) {
+    return ::operator new(size);
+  }
+
+  if (void* const frame = pool.pop(size_class)) {
+    return frame;
+  }
+
+  // Allocate the whole size class such that the frame can be reused
+  // for all frames of the same class.
+  return ::operator new((size_class + 1U) * frame_granularity);
+}
+
+void deallocate_coroutine_frame(void* frame, std::size_t size) noexcept {
+  std::size_t const size_class = size_class_of(size);
+  if (size_class >= frame_classes || frame_pool_destroyed ||
+      !pool.push(size_class, frame)) {
+    ::operator delete(frame);
+  }
+}
+} // namespace detail
+} // namespace idle
@@ -37,6 +37,10 @@ void DeclaredServicesContainer::onPartInit() noexcept {
 
   for (detail::ServiceDeclaration const& declared :
        detail::declared_services()) {
+    if (declared.isLazy()) {
+      // Lazy services are instantiated on demand through the registry
+      continue;
+    }
 
     Ref<Service> instantiated = declared(*this);
     instantiated->init();
@@ -169,6 +173,7 @@ void ContextImpl::recycle_guid(Service& current, Guid::Low low) noexcept {
   IDLE_ASSERT(*(services_.find(low)->second) == current);
 
   services_.erase(low);
+  metrics_.forgetService(current.guid());
   recycler_.recycle(low);
 }
 
@@ -201,20 +206,76 @@ void ContextImpl::call_on_service_destroy(Service& current) const noexcept {
 }
 
 void ContextImpl::call_on_service_changed(Service& current, Phase from,
-                                          Phase to) const noexcept {
+                                          Phase to) noexcept {
   IDLE_ASSERT(listener_);
 
 #ifndef IDLE_HAS_NO_SERVICE_LISTENER
+  bool is_batched = false;
   for (Interface& inter : listener_->interfaces()) {
     Listener& li = cast<Listener>(inter);
-    if (li.filter_.contains(Listener::Event::OnServiceChanged) &&
-        inter.owner().state().isRunning()) {
+    if (!inter.owner().state().isRunning()) {
+      continue;
+    }
+
+    if (li.filter_.contains(Listener::Event::OnServiceChanged)) {
       li.onServiceChanged(current, from, to);
     }
+    if (li.filter_.contains(Listener::Event::OnServiceChangedBatch)) {
+      is_batched = true;
+    }
+  }
+
+  if (!is_batched) {
+    // Don't buffer the transition if no listener is interested in batches
+    return;
   }
+
+  change_log_.push(current.guid(), from, to);
+
+  // The change log is flushed at the end of every scheduling pass,
+  // changes outside of a pass are flushed on the next event loop iteration.
+  if (!change_log_flush_dispatched_) {
+    change_log_flush_dispatched_ = true;
+
+    event_loop().post([weak = weakOf(*static_cast<Context*>(this))] {
+      if (auto me = weak.lock()) {
+        ContextImpl& impl = ContextImpl::from(*me);
+        impl.change_log_flush_dispatched_ = false;
+        impl.flush_change_log();
+      }
+    });
+  }
+#else
+  (void)current;
+  (void)from;
+  (void)to;
 #endif
 }
 
+void ContextImpl::flush_change_log() noexcept {
+  IDLE_ASSERT(is_on_event_loop_impl());
+
+  if (change_log_.empty()) {
+    return;
+  }
+
+  if (!listener_) {
+    // The context is destroyed already
+    change_log_.clear();
+    return;
+  }
+
+  for (Interface& inter : listener_->interfaces()) {
+    Listener& li = cast<Listener>(inter);
+    if (li.filter_.contains(Listener::Event::OnServiceChangedBatch) &&
+        inter.owner().state().isRunning()) {
+      li.onServiceChangedBatch(change_log_);
+    }
+  }
+
+  change_log_.clear();
+}
+
 void ContextImpl::call_on_usage_connect(Usage& current) const noexcept {
   IDLE_ASSERT(listener_);
 
@@ -252,6 +313,7 @@ void ContextImpl::onDestroy() {
   DeclaredServicesContainer::onPartDestroy();
   RegistryManager::onPartDestroy();
 
+  change_log_.clear();
   listener_ = {};
 }
 } // namespace idle
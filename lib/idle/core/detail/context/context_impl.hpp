@@ -32,12 +32,15 @@
 #include <idle/core/detail/context/event_loop_executor_impl.hpp>
 #include <idle/core/detail/context/registry_impl.hpp>
 #include <idle/core/detail/context/scheduler.hpp>
+#include <idle/core/detail/scheduling_table.hpp>
 #include <idle/core/detail/unordered_map.hpp>
+#include <idle/core/metrics.hpp>
 #include <idle/core/parts/container.hpp>
 #include <idle/core/parts/listener.hpp>
 #include <idle/core/ref.hpp>
 #include <idle/core/registry.hpp>
 #include <idle/core/service.hpp>
+#include <idle/core/tracing.hpp>
 #include <idle/core/util/assert.hpp>
 #include <idle/core/util/flat_set.hpp>
 #include <idle/core/util/upcastable.hpp>
@@ -97,6 +100,10 @@ public:
     return *this;
   }
 
+  detail::SchedulingTable& scheduling_table() noexcept {
+    return scheduling_table_;
+  }
+
   Ref<Service> lookupImpl(Guid guid) const noexcept;
 
   bool is_running_impl() const noexcept {
@@ -125,10 +132,14 @@ public:
   void call_on_service_init(Service& current) const noexcept;
   void call_on_service_destroy(Service& current) const noexcept;
   void call_on_service_changed(Service& current, Phase from,
-                               Phase to) const noexcept;
+                               Phase to) noexcept;
   void call_on_usage_connect(Usage& current) const noexcept;
   void call_on_usage_disconnect(Usage& current) const noexcept;
 
+  /// Delivers the phase transitions collected since the last call
+  /// to the listeners in one batch
+  void flush_change_log() noexcept;
+
 protected:
   void onInit() override;
   void onDestroy() override;
@@ -137,9 +148,14 @@ protected:
   void onChildDestroy(Service& child) override;
 
   Ref<Registry> listener_;
+  Listener::ChangeLog change_log_;
+  bool change_log_flush_dispatched_{false};
   std::atomic<int> exit_code_{EXIT_SUCCESS};
   id_recycler recycler_;
   detail::unordered_map<Guid::Low, Service*> services_;
+  Metrics metrics_;
+  Tracing tracing_;
+  detail::SchedulingTable scheduling_table_;
 };
 } // namespace idle
 
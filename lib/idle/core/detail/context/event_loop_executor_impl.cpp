@@ -29,6 +29,7 @@
 #include <idle/core/detail/for_each.hpp>
 #include <idle/core/detail/log.hpp>
 #include <idle/core/iterators.hpp>
+#include <idle/core/metrics.hpp>
 #include <idle/core/util/thread_name.hpp>
 
 namespace idle {
@@ -54,6 +55,10 @@ void EventLoopExecutorImpl::run_ev() {
       break;
     }
 
+    if (idle_handler_ && dispatch_idle()) {
+      continue;
+    }
+
     condition_.wait(lock);
   }
 
@@ -92,6 +97,14 @@ void EventLoopExecutorImpl::run_ev() {
 
 void EventLoopExecutorImpl::queue(work&& work) {
   if (is_running()) {
+    // Only the oldest pending handler is timed to measure the event loop lag
+    if (oldest_queued_.load(std::memory_order_relaxed) == 0) {
+      std::chrono::steady_clock::rep expected = 0;
+      oldest_queued_.compare_exchange_strong(
+          expected, std::chrono::steady_clock::now().time_since_epoch().count(),
+          std::memory_order_relaxed);
+    }
+
     queue_.enqueue(std::move(work));
     condition_.notify_one();
   } else {
@@ -99,6 +112,19 @@ void EventLoopExecutorImpl::queue(work&& work) {
   }
 }
 
+bool EventLoopExecutorImpl::dispatch_idle() {
+  // The handler is allowed to replace or unset itself while being invoked
+  unique_function<bool()> handler = std::move(idle_handler_);
+  std::size_t const generation = idle_handler_generation_;
+
+  bool const progress = handler();
+
+  if (generation == idle_handler_generation_) {
+    idle_handler_ = std::move(handler);
+  }
+  return progress;
+}
+
 /*
 void event_loop_executor_impl::printPartDetails(std::ostream& os) const {
   print(os, FMT_STRING("~{} handlers in queue"), queue_.size_approx());
@@ -106,10 +132,26 @@ void event_loop_executor_impl::printPartDetails(std::ostream& os) const {
 */
 
 void EventLoopExecutorImpl::dispatch_all() {
-  work w;
+  Metrics& metrics = owner().root().metrics();
+
+  std::chrono::steady_clock::rep const queued = oldest_queued_.exchange(
+      0, std::memory_order_relaxed);
+  if (queued) {
+    std::chrono::steady_clock::time_point const now = std::chrono::
+        steady_clock::now();
+    metrics.record(Metrics::Distribution::EventLoopLag,
+                   now - std::chrono::steady_clock::time_point(
+                             std::chrono::steady_clock::duration(queued)));
+  }
 
+  std::uint64_t handlers = 0U;
+
+  work w;
   while (queue_.try_dequeue(consumer_token_, w)) {
     std::move(w).set_value();
+    ++handlers;
   }
+
+  metrics.add(Metrics::Counter::Handlers, handlers);
 }
 } // namespace idle
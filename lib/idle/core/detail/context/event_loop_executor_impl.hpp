@@ -27,6 +27,7 @@
 #define IDLE_CORE_DETAIL_CONTEXT_EVENT_LOOP_EXECUTOR_IMPL_HPP_INCLUDED
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <ostream>
@@ -34,6 +35,7 @@
 #include <concurrentqueue/concurrentqueue.h>
 #include <idle/core/context.hpp>
 #include <idle/core/dep/continuable.hpp>
+#include <idle/core/dep/function.hpp>
 #include <idle/core/service.hpp>
 
 #ifdef _MSC_VER
@@ -106,6 +108,11 @@ public:
 
   void queue(work&& work);
 
+  void set_idle_handler(unique_function<bool()>&& handler) noexcept {
+    idle_handler_ = std::move(handler);
+    ++idle_handler_generation_;
+  }
+
   void set_running_from_this_thread() noexcept {
     IDLE_ASSERT(is(state_t::ready));
     thread_id_ = std::this_thread::get_id();
@@ -122,6 +129,7 @@ protected:
 
 private:
   void dispatch_all();
+  bool dispatch_idle();
 
   bool is(state_t state) const noexcept {
     return state == state_.load(std::memory_order_acquire);
@@ -136,6 +144,12 @@ private:
   moodycamel::ConsumerToken consumer_token_;
   std::thread::id thread_id_{};
   std::atomic<state_t> state_{state_t::ready};
+  /// The time the oldest pending handler was queued at or zero
+  std::atomic<std::chrono::steady_clock::rep> oldest_queued_{0};
+  /// Invoked on the event loop when the queue ran empty
+  unique_function<bool()> idle_handler_;
+  /// Detects a replacement of the idle handler while it is invoked
+  std::size_t idle_handler_generation_{0};
 };
 } // namespace idle
 
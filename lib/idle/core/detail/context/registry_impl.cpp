@@ -24,11 +24,14 @@
  */
 
 #include <algorithm>
+#include <memory>
 #include <ostream>
+#include <utility>
 #include <idle/core/async.hpp>
 #include <idle/core/context.hpp>
 #include <idle/core/detail/context/context_impl.hpp>
 #include <idle/core/detail/context/registry_impl.hpp>
+#include <idle/core/detail/declare_impl.hpp>
 #include <idle/core/detail/log.hpp>
 #include <idle/core/detail/service_impl.hpp>
 #include <idle/core/ref.hpp>
@@ -55,10 +58,26 @@ Ref<Registry> RegistryManager::findImpl(Interface::Id const& id) {
   }
 }
 
+RegistrySnapshot::Interfaces const&
+RegistrySnapshot::find(Interface::Id const& id) const noexcept {
+  static Interfaces const empty;
+
+  auto const itr = entries_.find(id);
+  if (itr != entries_.end()) {
+    return itr->second;
+  } else {
+    return empty;
+  }
+}
+
 Interface::Id const& RegistryImpl::idImpl() const noexcept {
   return id_;
 }
 
+bool RegistryImpl::instantiateLazyImpl() {
+  return owner_->instantiateLazy(id_);
+}
+
 void RegistryManager::onChildInit(Service& child) {
   IDLE_ASSERT(owner().root().is_on_event_loop());
   IDLE_ASSERT(!auto_created_services_.contains_unsafe(child));
@@ -94,6 +113,98 @@ void RegistryManager::onRegistryEntryDestroy(Interface::Id const& id) {
   }
 }
 
+bool RegistryManager::instantiateLazy(Interface::Id const& id) {
+  IDLE_ASSERT(owner().root().is_on_event_loop());
+
+  auto const itr = lazy_.find(id);
+  if (itr == lazy_.end()) {
+    return false;
+  }
+
+  LazyEntry& entry = itr->second;
+  if (auto instance = entry.instance.lock()) {
+    if (!instance->state().isDestroyedUnsafe()) {
+      // The service exports the interface already
+      return false;
+    }
+  }
+
+  // Lazy services are created as default services such that they are
+  // referenced by their users only and stopped when being unused again.
+  Ref<Service> instance = (*entry.declaration)(
+      Inheritance::weak(*this, Inheritance::Relation::anchor));
+  entry.instance = instance;
+  instance->init();
+
+  IDLE_DETAIL_LOG_DEBUG("Instantiated a lazily declared service for {}: {}", id,
+                        *instance);
+  return true;
+}
+
+void RegistryManager::markSnapshotDirty() {
+  IDLE_ASSERT(owner().root().is_on_event_loop());
+
+  snapshot_dirty_ = true;
+
+  // The snapshot is published at the end of every scheduling pass,
+  // changes outside of a pass are published on the next event loop iteration.
+  if (!snapshot_publish_dispatched_) {
+    snapshot_publish_dispatched_ = true;
+
+    owner().root().event_loop().post([weak = weakOf(*this)] {
+      if (auto me = weak.lock()) {
+        me->snapshot_publish_dispatched_ = false;
+        me->publishSnapshot();
+      }
+    });
+  }
+}
+
+void RegistryManager::publishSnapshot() {
+  IDLE_ASSERT(owner().root().is_on_event_loop());
+
+  if (!snapshot_dirty_) {
+    return;
+  }
+
+  snapshot_dirty_ = false;
+
+  RegistrySnapshot next;
+  next.version_ = ++snapshot_version_;
+  next.entries_.reserve(entries_.size());
+
+  for (auto const& entry : entries_) {
+    if (auto registry = entry.second.lock()) {
+      auto const interfaces = registry->interfaces();
+      if (interfaces.empty()) {
+        continue;
+      }
+
+      RegistrySnapshot::Interfaces& published = next.entries_[entry.first];
+      published.reserve(interfaces.size());
+      for (Interface& inter : interfaces) {
+        published.push_back(weakOf(inter));
+      }
+    }
+  }
+
+  // The replaced snapshot is reclaimed as soon as its last reader has
+  // finished, which happens on the event loop through the retire.
+  snapshot_.store(std::move(next));
+}
+
+void RegistryManager::onPartInit() noexcept {
+  Export::onPartInit();
+
+  for (detail::ServiceDeclaration const& declared :
+       detail::declared_services()) {
+    if (declared.isLazy()) {
+      lazy_.insert(std::make_pair(declared.lazyInterface(),
+                                  LazyEntry{std::addressof(declared), {}}));
+    }
+  }
+}
+
 void RegistryManager::onPartDestroy() noexcept {
   while (!auto_created_services_.empty()) {
     Service& current = auto_created_services_.front();
@@ -101,6 +212,10 @@ void RegistryManager::onPartDestroy() noexcept {
   }
 
   IDLE_ASSERT(auto_created_services_.empty());
+
+  // Release the weak references to the interfaces of the context
+  snapshot_dirty_ = false;
+  snapshot_.store(RegistrySnapshot{});
 }
 
 RegistryImpl::~RegistryImpl() {
@@ -151,6 +266,7 @@ void RegistryImpl::onInterfaceCreate(Interface& inter) {
   IDLE_ASSERT(!interfaces_.contains_unsafe(inter));
 
   insert_sorted(interfaces_, inter);
+  owner_->markSnapshotDirty();
 
   for (Subscriber& sub : subscribers_) {
     sub.callSubscribedCreated(inter);
@@ -192,6 +308,7 @@ void RegistryImpl::onInterfaceDestroy(Interface& inter) {
                         inter);
 
   interfaces_.erase(inter);
+  owner_->markSnapshotDirty();
 
   auto const exported = inter.exports();
   stable_for_each(exported, [&](Usage& u) {
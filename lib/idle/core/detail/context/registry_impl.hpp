@@ -29,11 +29,17 @@
 #include <unordered_map>
 #include <idle/core/ref.hpp>
 #include <idle/core/registry.hpp>
+#include <idle/core/registry_snapshot.hpp>
 #include <idle/core/service.hpp>
 #include <idle/core/util/range.hpp>
+#include <idle/core/util/rcu.hpp>
 #include <idle/core/util/upcastable.hpp>
 
 namespace idle {
+namespace detail {
+class ServiceDeclaration;
+} // namespace detail
+
 class RegistryManager : public Export {
 public:
   using Export::Export;
@@ -56,7 +62,22 @@ public:
 
   void onRegistryEntryDestroy(Interface::Id const& id);
 
+  bool instantiateLazy(Interface::Id const& id);
+
+  /// Returns the latest published registry snapshot from any thread
+  RegistryView snapshot() const noexcept {
+    return snapshot_.read();
+  }
+
+  /// Marks the registry snapshot as outdated, changes outside of a
+  /// scheduler pass are published on the next event loop iteration.
+  void markSnapshotDirty();
+
+  /// Publishes a new registry snapshot if any registry has changed
+  void publishSnapshot();
+
 protected:
+  void onPartInit() noexcept override;
   void onPartDestroy() noexcept override;
 
   void onChildInit(Service& child) override;
@@ -65,8 +86,20 @@ protected:
   void partName(std::ostream& os) const override;
 
 private:
+  /// Represents a service that was declared through IDLE_DECLARE_LAZY
+  struct LazyEntry {
+    detail::ServiceDeclaration const* declaration;
+    WeakRef<Service> instance;
+  };
+
   std::unordered_map<Interface::Id, WeakRef<Registry>> entries_;
+  std::unordered_map<Interface::Id, LazyEntry> lazy_;
   ChildrenList auto_created_services_;
+
+  Rcu<RegistrySnapshot> snapshot_;
+  RegistrySnapshot::Version snapshot_version_{0};
+  bool snapshot_dirty_{false};
+  bool snapshot_publish_dispatched_{false};
 };
 
 /// Represents the extensions depending on a single interf::id
@@ -85,6 +118,8 @@ public:
 
   Interface::Id const& idImpl() const noexcept;
 
+  bool instantiateLazyImpl();
+
   void subscriberAddImpl(Subscriber& subscriber);
   void subscriberDelImpl(Subscriber& subscriber);
 
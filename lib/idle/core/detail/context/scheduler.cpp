@@ -26,20 +26,22 @@
 #include <boost/graph/reverse_graph.hpp>
 #include <boost/graph/tiernan_all_cycles.hpp>
 #include <idle/core/dep/format.hpp>
+#include <idle/core/detail/context/context_impl.hpp>
 #include <idle/core/detail/context/scheduler.hpp>
 #include <idle/core/detail/for_each.hpp>
 #include <idle/core/detail/graph/dfs.hpp>
 #include <idle/core/detail/log.hpp>
 #include <idle/core/detail/service_impl.hpp>
 #include <idle/core/detail/streams.hpp>
+#include <idle/core/detail/unordered_map.hpp>
 #include <idle/core/detail/when_completed.hpp>
 #include <idle/core/external/boost/graph.hpp>
 #include <idle/core/graph.hpp>
 #include <idle/core/iterators.hpp>
+#include <idle/core/metrics.hpp>
+#include <idle/core/tracing.hpp>
 #include <idle/core/util/panic.hpp>
 #include <idle/core/util/printable.hpp>
-#include <idle/core/views/filter.hpp>
-#include <idle/core/views/start.hpp>
 
 #ifdef _MSC_VER
 #  pragma warning(disable : 4267)
@@ -101,6 +103,25 @@ static auto details_of(Service& current) {
   });
 }
 
+/// Returns the name of the lifecycle hook measured by the distribution
+static char const* hook_of(Metrics::Distribution distribution) noexcept {
+  return (distribution == Metrics::Distribution::ServiceStart) ? "onStart"
+                                                               : "onStop";
+}
+
+/// Begins the span of a lifecycle hook, which is labeled by the service name
+static void trace_service_begin(Service& current,
+                                Metrics::Distribution distribution) noexcept {
+  Tracing& tracing = current.root().tracing();
+  if (tracing.isEnabled()) {
+    fmt::memory_buffer buffer;
+    format_to(buffer, FMT_STRING("{}"), current);
+    tracing.begin(Tracing::Category::Service, hook_of(distribution),
+                  current.guid().value(),
+                  StringView(buffer.data(), buffer.size()));
+  }
+}
+
 void SchedulingQueue::push_down(Service& value) {
   IDLE_DETAIL_LOG_DEBUG("Pushed '{}' ({} - {} - {}) to iteration queue (down)",
                         value, value.stats().state(), value.stats().usage(),
@@ -247,6 +268,121 @@ void Scheduler::on_service_start_request(Service& current) {
 
   // The above dfs algorithm never encounters a cycle
   IDLE_ASSERT(dfs_data_.acyclic);
+  record_dfs();
+  iterate();
+}
+
+StaticComposition
+Scheduler::do_compose(std::vector<WeakRef<Service>> const& services) {
+  IDLE_ASSERT(root_.is_on_event_loop());
+
+  ClusterDependencyGraph const graph(root_, graph_view);
+  auto const rev = boost::make_reverse_graph(graph);
+
+  DFSScope const scope(dfs_data_);
+  (void)scope;
+
+  // Collect the requested heads and their transitive dependencies,
+  // the visited set is shared such that every head is visited once.
+  FlatSet<Service*> requested;
+  for (WeakRef<Service> const& service : services) {
+    if (auto current = service.lock()) {
+      if (current->state().isInitializedUnsafe()) {
+        Service& head = get_cluster_head_of(*current);
+        requested.insert(&head);
+
+        dfs(rev, &head, dfs_data_, detail::none2{}, detail::none1{},
+            {DFSFlags::flag_post_cancel_cycles});
+      }
+    }
+  }
+
+  record_dfs();
+
+  FlatSet<Service*> const& closure = dfs_data_.visited;
+
+  // Count the dependencies of every head that are part of the closure
+  detail::unordered_map<Service*, std::size_t> pending;
+  FlatSet<Service*> dependencies;
+  for (Service* head : closure) {
+    pending.insert(std::make_pair(head, 0U));
+  }
+  for (Service* head : closure) {
+    for (Edge const& e : out_edges(head, graph)) {
+      Service* const dependent = target(e, graph);
+      if (dependent != head && closure.find(dependent) != closure.end()) {
+        ++pending[dependent];
+        dependencies.insert(head);
+      }
+    }
+  }
+
+  std::vector<Service*> ordered;
+  ordered.reserve(closure.size());
+  for (Service* head : closure) {
+    if (pending[head] == 0U) {
+      ordered.push_back(head);
+    }
+  }
+
+  for (std::size_t i = 0; i < ordered.size(); ++i) {
+    for (Edge const& e : out_edges(ordered[i], graph)) {
+      Service* const dependent = target(e, graph);
+      if (dependent != ordered[i] &&
+          closure.find(dependent) != closure.end()) {
+        IDLE_ASSERT(pending[dependent] != 0U);
+        if (--pending[dependent] == 0U) {
+          ordered.push_back(dependent);
+        }
+      }
+    }
+  }
+
+  // Services on a cyclic path can't be ordered, they are placed last
+  // which reports the cycle through the regular start request.
+  if (ordered.size() != closure.size()) {
+    for (Service* head : closure) {
+      if (pending[head] != 0U) {
+        ordered.push_back(head);
+      }
+    }
+  }
+
+  StaticComposition composition;
+  composition.entries_.reserve(ordered.size());
+  for (Service* head : ordered) {
+    bool const is_requested = requested.find(head) != requested.end();
+    bool const is_sink = dependencies.find(head) == dependencies.end();
+    composition.entries_.push_back({weakOf(*head), is_requested, is_sink});
+  }
+  return composition;
+}
+
+void Scheduler::on_composition_start_request(
+    StaticComposition const& composition) {
+  IDLE_ASSERT(root_.is_on_event_loop());
+
+  IDLE_DETAIL_LOG_DEBUG("Requesting start of a composition of {} clusters",
+                        composition.size());
+
+  // Dependencies are placed before their dependents, thus the clusters
+  // are marked in the same order a traversal would visit them.
+  for (StaticComposition::Entry const& entry : composition.entries()) {
+    if (auto head = entry.head.lock()) {
+      if (!head->state().isInitializedUnsafe()) {
+        continue;
+      }
+
+      IDLE_ASSERT(is_cluster_head(*head));
+
+      if (start_traversal_progresses_further(*head)) {
+        ServiceImpl::do_mark_cluster_for_start(*head, true);
+      }
+
+      insert_into_queue_if_startable(*head);
+    }
+  }
+
   iterate();
 }
 
@@ -330,6 +466,7 @@ void Scheduler::on_service_stop_request(Service& current) {
 
   // The dfs algorithm above never encounters a cycle
   IDLE_ASSERT(dfs_data_.acyclic);
+  record_dfs();
 
   IDLE_DETAIL_LOG_TRACE("V: stop raversal of '{}' finished.", current);
 
@@ -380,32 +517,245 @@ continuable<> Scheduler::do_update_system() {
       wrap(*this, [](auto&& me) mutable -> continuable<> {
         IDLE_ASSERT(me->owner().state().isRunning());
 
-        auto const unhealthy = clusters(me->root_) |
-                               views::filter([](Service& head) {
-                                 return is_unhealthy(head);
-                               }) |
-                               views::start(Reason::Implicit);
+        // Only visit the clusters that changed since the last update
+        // instead of scanning the scheduling table of the whole system.
+        me->collect_dirty_frontier();
+
+        FlatSet<Service*> unhealthy;
+        for (Service* head : me->frontier_) {
+          if (is_unhealthy(*head)) {
+            // Unhealthy clusters stay dirty until an update observes them
+            // as healthy, such that the fixpoint iteration revisits them.
+            ServiceImpl::mark_cluster_dirty(*head);
+            unhealthy.insert(head);
+          }
+        }
 
-        if (!unhealthy) {
+#ifndef NDEBUG
+        me->verify_dirty_frontier(unhealthy);
+#endif // NDEBUG
+
+        if (unhealthy.empty()) {
           return make_ready_continuable();
         }
 
-        IDLE_DETAIL_LOG_DEBUG("Updating {} unhealthy services...",
-                              unhealthy.size());
+        IDLE_DETAIL_LOG_DEBUG("Updating {} unhealthy services of {} "
+                              "dirty clusters...",
+                              unhealthy.size(), me->frontier_.size());
+
+        std::vector<continuable<>> starts;
+        starts.reserve(unhealthy.size());
+        for (Service* head : unhealthy) {
+          starts.push_back(head->start(Reason::Implicit));
+        }
 
         // Perform a fixpoint iteration until the system is stable
-        return detail::when_completed(unhealthy).then(
+        return detail::when_completed(starts).then(
             wrap(*me, [](auto&& me) mutable {
               return me->do_update_system();
             }));
       }));
 }
 
+void Scheduler::collect_dirty_frontier() {
+  IDLE_ASSERT(root_.is_on_event_loop());
+
+  detail::SchedulingTable& table = ContextImpl::from(root_).scheduling_table();
+  ClusterDependencyGraph const graph(root_, graph_view);
+
+  frontier_.clear();
+  table.drain_dirty([&](Service& head) {
+    IDLE_ASSERT(is_cluster_head(head));
+    frontier_.insert(&head);
+
+    // The reverse dependents of a changed cluster are affected as well
+    for (Edge const& e : out_edges(&head, graph)) {
+      Service* const dependent = target(e, graph);
+      IDLE_ASSERT(dependent);
+      frontier_.insert(dependent);
+    }
+  });
+}
+
+#ifndef NDEBUG
+void Scheduler::verify_dirty_frontier(
+    FlatSet<Service*> const& unhealthy) const {
+  using table_t = detail::SchedulingTable;
+  table_t const& table = ContextImpl::from(root_).scheduling_table();
+
+  // Cross-check the dirty frontier against the full scan it replaces
+  std::size_t count = 0U;
+  table.scan(table_t::flag_cluster_head | table_t::flag_cluster_pushed,
+             [&](Service& head) {
+               if (is_unhealthy(head)) {
+                 IDLE_ASSERT(unhealthy.contains(&head) &&
+                             "Missed an unhealthy cluster that is not dirty!");
+                 ++count;
+               }
+             });
+
+  IDLE_ASSERT(count == unhealthy.size());
+  (void)count;
+}
+#endif // NDEBUG
+
+continuable<> Scheduler::do_update_dependents(
+    std::vector<WeakRef<Service>> origins) {
+  return root_.event_loop().async_post(wrap(
+      *this,
+      [origins = std::move(origins)](auto&& me) mutable -> continuable<> {
+        IDLE_ASSERT(me->owner().state().isRunning());
+
+        std::vector<Service*> heads;
+        heads.reserve(origins.size());
+        for (WeakRef<Service> const& origin : origins) {
+          if (auto current = origin.lock()) {
+            if (current->state().isInitializedUnsafe()) {
+              heads.push_back(&get_cluster_head_of(*current));
+            }
+          }
+        }
+
+        if (heads.empty()) {
+          return make_ready_continuable();
+        }
+
+        std::vector<Wave> waves = me->dependent_waves_of(heads);
+
+        IDLE_DETAIL_LOG_DEBUG("Updating the dependents of {} services in {} "
+                              "waves...",
+                              heads.size(), waves.size());
+
+        return me->start_waves(std::move(waves), 0U);
+      }));
+}
+
+std::vector<Scheduler::Wave>
+Scheduler::dependent_waves_of(std::vector<Service*> const& heads) {
+  IDLE_ASSERT(root_.is_on_event_loop());
+
+  ClusterDependencyGraph const graph(root_, graph_view);
+
+  DFSScope const scope(dfs_data_);
+  (void)scope;
+
+  // The visited set is shared across all traversals,
+  // so every head is only visited once.
+  for (Service* head : heads) {
+    IDLE_ASSERT(is_cluster_head(*head));
+
+    dfs(graph, head, dfs_data_, detail::none2{}, detail::none1{},
+        {DFSFlags::flag_post_cancel_cycles});
+  }
+
+  record_dfs();
+
+  FlatSet<Service*> const& closure = dfs_data_.visited;
+
+  // Count the dependencies of every head that are part of the closure
+  detail::unordered_map<Service*, std::size_t> pending;
+  for (Service* head : closure) {
+    pending.insert(std::make_pair(head, 0U));
+  }
+  for (Service* head : closure) {
+    for (Edge const& e : out_edges(head, graph)) {
+      Service* const dependent = target(e, graph);
+      if (dependent != head && closure.find(dependent) != closure.end()) {
+        ++pending[dependent];
+      }
+    }
+  }
+
+  std::vector<Service*> current;
+  for (Service* head : closure) {
+    if (pending[head] == 0U) {
+      current.push_back(head);
+    }
+  }
+
+  std::vector<Wave> waves;
+  std::size_t ordered = 0U;
+  while (!current.empty()) {
+    std::vector<Service*> next;
+    Wave wave;
+    wave.reserve(current.size());
+
+    for (Service* head : current) {
+      wave.push_back(weakOf(*head));
+
+      for (Edge const& e : out_edges(head, graph)) {
+        Service* const dependent = target(e, graph);
+        if (dependent != head && closure.find(dependent) != closure.end()) {
+          IDLE_ASSERT(pending[dependent] != 0U);
+          if (--pending[dependent] == 0U) {
+            next.push_back(dependent);
+          }
+        }
+      }
+    }
+
+    ordered += wave.size();
+    waves.push_back(std::move(wave));
+    current = std::move(next);
+  }
+
+  // Services on a cyclic path can't be ordered, they are started last
+  // which reports the cycle through the regular start request.
+  if (ordered != closure.size()) {
+    Wave remaining;
+    for (Service* head : closure) {
+      if (pending[head] != 0U) {
+        remaining.push_back(weakOf(*head));
+      }
+    }
+    waves.push_back(std::move(remaining));
+  }
+
+  return waves;
+}
+
+continuable<> Scheduler::start_waves(std::vector<Wave> waves,
+                                     std::size_t index) {
+  IDLE_ASSERT(root_.is_on_event_loop());
+
+  if (index == waves.size()) {
+    return make_ready_continuable();
+  }
+
+  std::vector<continuable<>> started;
+  for (WeakRef<Service> const& weak : waves[index]) {
+    if (auto head = weak.lock()) {
+      if (head->state().isInitializedUnsafe() && is_unhealthy(*head)) {
+        started.push_back(head->start(Reason::Implicit));
+      }
+    }
+  }
+
+  IDLE_DETAIL_LOG_TRACE("Starting {} unhealthy services of wave {}...",
+                        started.size(), index);
+
+  // The span of the wave ends when all of its services were started
+  Tracing::Span span = root_.tracing().span(Tracing::Category::Scheduler,
+                                            "wave");
+
+  return detail::when_completed(std::move(started))
+      .then(wrap(*this,
+                 [waves = std::move(waves), index,
+                  span = std::move(span)](auto&& me) mutable {
+                   span.end();
+                   return me->start_waves(std::move(waves), index + 1);
+                 }),
+            root_.event_loop().through_post());
+}
+
 void Scheduler::partName(std::ostream& os) const {
   os << "idle::Scheduler";
 }
 
 bool Scheduler::try_start_service_inplace(Service& current) {
+  Metrics::clock_type::time_point const started = Metrics::clock_type::now();
+  trace_service_begin(current, Metrics::Distribution::ServiceStart);
+
   continuable<> hook = ServiceImpl::do_start_eager(current);
   if (hook.is_ready()) {
     result<> result = std::move(hook).unpack();
@@ -415,6 +765,8 @@ bool Scheduler::try_start_service_inplace(Service& current) {
     } else {
       IDLE_DETAIL_LOG_DEBUG("Called service::on_start of '{}' synchronously",
                             current);
+      record_service_timing(current, Metrics::Distribution::ServiceStart,
+                            started);
       return true;
     }
   } else {
@@ -423,8 +775,10 @@ bool Scheduler::try_start_service_inplace(Service& current) {
 
     std::move(hook)
         .next(
-            [this, current = &current](auto&&... args) mutable {
+            [this, current = &current, started](auto&&... args) mutable {
               IDLE_ASSERT(current->root().is_on_event_loop());
+              record_service_timing(
+                  *current, Metrics::Distribution::ServiceStart, started);
               on_service_start_cb(*current,
                                   std::forward<decltype(args)>(args)...);
             },
@@ -499,6 +853,9 @@ void Scheduler::on_service_start_cb(Service& current, exception_arg_t,
 }
 
 bool Scheduler::try_stop_service_inplace(Service& current) {
+  Metrics::clock_type::time_point const stopped = Metrics::clock_type::now();
+  trace_service_begin(current, Metrics::Distribution::ServiceStop);
+
   continuable<> hook = ServiceImpl::do_stop_eager(current);
   if (hook.is_ready()) {
     result<> result = std::move(hook).unpack();
@@ -508,6 +865,8 @@ bool Scheduler::try_stop_service_inplace(Service& current) {
     } else {
       IDLE_DETAIL_LOG_DEBUG("Called service::on_stop of '{}' synchronously",
                             current);
+      record_service_timing(current, Metrics::Distribution::ServiceStop,
+                            stopped);
       return true;
     }
   } else {
@@ -516,8 +875,10 @@ bool Scheduler::try_stop_service_inplace(Service& current) {
 
     std::move(hook)
         .next(
-            [this, current = &current](auto&&... args) mutable {
+            [this, current = &current, stopped](auto&&... args) mutable {
               IDLE_ASSERT(current->root().is_on_event_loop());
+              record_service_timing(
+                  *current, Metrics::Distribution::ServiceStop, stopped);
               on_service_stop_cb(*current,
                                  std::forward<decltype(args)>(args)...);
             },
@@ -567,6 +928,27 @@ void Scheduler::on_service_stop_cb(Service& current, exception_arg_t,
   handle_start_async_exception(current, e);
 }
 
+void Scheduler::record_service_timing(
+    Service& current, Metrics::Distribution distribution,
+    Metrics::clock_type::time_point started) noexcept {
+  Metrics& metrics = root_.metrics();
+
+  metrics.recordService(current.guid(), distribution,
+                        Metrics::clock_type::now() - started);
+  metrics.add(distribution == Metrics::Distribution::ServiceStart
+                  ? Metrics::Counter::ServiceStarts
+                  : Metrics::Counter::ServiceStops);
+
+  root_.tracing().end(Tracing::Category::Service, hook_of(distribution),
+                      current.guid().value());
+}
+
+void Scheduler::record_dfs() noexcept {
+  Metrics& metrics = root_.metrics();
+  metrics.add(Metrics::Counter::DFSTraversals);
+  metrics.record(Metrics::Distribution::DFSSize, dfs_data_.visited.size());
+}
+
 void Scheduler::stop_root() {
   if (ServiceImpl::is_cluster_stopped(root_)) {
     return;
@@ -647,7 +1029,16 @@ void Scheduler::process() noexcept {
 
   IDLE_DETAIL_LOG_TRACE("Processing {} services from queue...", queue_.size());
 
+  Metrics& metrics = root_.metrics();
+  metrics.add(Metrics::Counter::SchedulerPasses);
+  metrics.record(Metrics::Distribution::QueueDepth, queue_.size());
+
+  Tracing& tracing = root_.tracing();
+  tracing.begin(Tracing::Category::Scheduler, "process");
+
   while (Nullable<Service> changing = queue_.pop()) {
+    metrics.add(Metrics::Counter::ScheduledServices);
+
     IDLE_DETAIL_LOG_DEBUG("Popped '{}' ({} - {} - {}) from iteration queue",
                           *changing, changing->stats().state(),
                           changing->stats().usage(),
@@ -673,6 +1064,15 @@ void Scheduler::process() noexcept {
   }
 
   IDLE_ASSERT(queue_.empty());
+
+  // Deliver the transitions of this pass at once
+  ContextImpl& impl = ContextImpl::from(root_);
+  impl.flush_change_log();
+
+  // Publish the registries changed by this pass to other threads
+  impl.anchor().publishSnapshot();
+
+  tracing.end(Tracing::Category::Scheduler, "process");
 }
 
 void Scheduler::on_service_init(Service&) {
@@ -29,10 +29,13 @@
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <vector>
+#include <idle/core/composition.hpp>
 #include <idle/core/context.hpp>
 #include <idle/core/dep/continuable.hpp>
 #include <idle/core/detail/graph/dfs.hpp>
 #include <idle/core/graph.hpp>
+#include <idle/core/metrics.hpp>
 #include <idle/core/service.hpp>
 #include <idle/core/util/flat_set.hpp>
 #include <idle/core/util/nullable.hpp>
@@ -79,8 +82,24 @@ public:
   /// A hook which gets called when the service 'can' be stopped
   void on_service_stoppable(Service& current);
 
+  /// Starts all unhealthy clusters until the system is stable
+  ///
+  /// Only the clusters which were marked as dirty since the last update
+  /// and their direct dependents are visited, instead of the whole system.
   continuable<> do_update_system();
 
+  /// Updates the services which transitively depend on the given origins only
+  continuable<> do_update_dependents(std::vector<WeakRef<Service>> origins);
+
+  /// Orders the clusters of the given services and their transitive
+  /// dependencies topologically
+  StaticComposition
+  do_compose(std::vector<WeakRef<Service>> const& services);
+
+  /// Marks the clusters of the composition for start in their precomputed
+  /// order, which replaces the traversal of on_service_start_request.
+  void on_composition_start_request(StaticComposition const& composition);
+
 protected:
   void partName(std::ostream& os) const override;
 
@@ -103,11 +122,35 @@ private:
   void on_service_stop_cb(Service& current, exception_arg_t,
                           std::exception_ptr e);
 
+  /// Records the duration of Service::onStart or Service::onStop
+  /// and ends its trace span.
+  void record_service_timing(Service& current,
+                             Metrics::Distribution distribution,
+                             Metrics::clock_type::time_point started) noexcept;
+
+  /// Records the size of the last depth-first traversal
+  void record_dfs() noexcept;
+
   void insert_into_queue_if_startable(Service& current);
   void insert_into_queue_if_stoppable(Service& current);
 
   void stop_root();
 
+  using Wave = std::vector<WeakRef<Service>>;
+
+  /// Returns the cluster heads that transitively depend on the given origins
+  /// ordered in waves, where every wave only depends on the previous ones.
+  std::vector<Wave> dependent_waves_of(std::vector<Service*> const& heads);
+  continuable<> start_waves(std::vector<Wave> waves, std::size_t index);
+
+  /// Collects the dirty cluster heads and their direct dependents
+  void collect_dirty_frontier();
+#ifndef NDEBUG
+  /// Checks that the unhealthy clusters of the dirty frontier equal
+  /// the unhealthy clusters of a full scheduling table scan.
+  void verify_dirty_frontier(FlatSet<Service*> const& unhealthy) const;
+#endif // NDEBUG
+
   void iterate() noexcept;
   void process() noexcept;
 
@@ -118,6 +161,8 @@ private:
 
   // The dfs_data object is cached for allowing allocated heap reuse
   DFSData dfs_data_;
+  // The dirty frontier is cached for allowing allocated heap reuse
+  FlatSet<Service*> frontier_;
 };
 } // namespace idle
 
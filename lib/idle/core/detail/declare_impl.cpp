@@ -35,6 +35,13 @@ ServiceDeclaration::ServiceDeclaration(service_creator_ptr_t creator)
   declared.push(*this);
 }
 
+ServiceDeclaration::ServiceDeclaration(service_creator_ptr_t creator,
+                                       interface_id_ptr_t lazy)
+  : creator_(creator)
+  , lazy_(lazy) {
+  declared.push(*this);
+}
+
 Range<DeclarationList::const_iterator> declared_services() noexcept {
   return {declared.cbegin(), declared.cend()};
 }
@@ -0,0 +1,59 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_CORE_DETAIL_JSON_HPP_INCLUDED
+#define IDLE_CORE_DETAIL_JSON_HPP_INCLUDED
+
+#include <fmt/format.h>
+#include <idle/core/util/string_view.hpp>
+
+namespace idle {
+namespace detail {
+/// Appends the given string escaped for the use inside a JSON string
+inline void format_json_string(fmt::memory_buffer& buffer, StringView str) {
+  for (char const c : str) {
+    switch (c) {
+      case '"':
+        format_to(buffer, FMT_STRING("\\\""));
+        break;
+      case '\\':
+        format_to(buffer, FMT_STRING("\\\\"));
+        break;
+      default: {
+        if (static_cast<unsigned char>(c) < 0x20) {
+          format_to(buffer, FMT_STRING("\\u{:04x}"),
+                    static_cast<unsigned>(c));
+        } else {
+          buffer.push_back(c);
+        }
+        break;
+      }
+    }
+  }
+}
+} // namespace detail
+} // namespace idle
+
+#endif // IDLE_CORE_DETAIL_JSON_HPP_INCLUDED
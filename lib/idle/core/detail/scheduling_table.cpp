@@ -0,0 +1,82 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <idle/core/detail/scheduling_table.hpp>
+#include <idle/core/service.hpp>
+
+namespace idle {
+namespace detail {
+SchedulingTable::SchedulingTable()
+  : chunks_(new std::atomic<Chunk*>[max_chunks]) {
+  for (std::size_t i = 0U; i < max_chunks; ++i) {
+    chunks_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+SchedulingTable::~SchedulingTable() {
+  for (std::size_t i = 0U; i < max_chunks; ++i) {
+    delete chunks_[i].load(std::memory_order_relaxed);
+  }
+}
+
+SchedulingTable::Row SchedulingTable::allocate(Service& current,
+                                               std::uint8_t phase) {
+  Row row;
+  if (free_.empty()) {
+    IDLE_CHECK(size_ < (max_chunks << chunk_bits));
+    row = size_++;
+
+    std::size_t const index = row >> chunk_bits;
+    if (!chunks_[index].load(std::memory_order_relaxed)) {
+      chunks_[index].store(new Chunk(), std::memory_order_release);
+    }
+  } else {
+    row = free_.back();
+    free_.pop_back();
+  }
+
+  Chunk& c = chunk(row);
+  std::size_t const i = offset(row);
+
+  // Released to readers of the previous owner, which observe its
+  // destroyed row afterwards (see Service::load_phase)
+  c.phase[i].store(phase, std::memory_order_release);
+  c.flags[i] = 0U;
+  c.inner_deps_missing[i] = 0U;
+  c.service[i] = &current;
+  return row;
+}
+
+void SchedulingTable::release(Row row) noexcept {
+  Chunk& c = chunk(row);
+  std::size_t const i = offset(row);
+
+  c.flags[i] = 0U;
+  c.service[i] = nullptr;
+
+  free_.push_back(row);
+}
+} // namespace detail
+} // namespace idle
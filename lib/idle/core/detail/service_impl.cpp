@@ -114,6 +114,7 @@ void ServiceImpl::interface_publish(Interface& self) noexcept {
                           self, self.owner());
 
     RegistryImpl::from(*self.registry_entry_).onInterfaceCreate(self);
+    mark_cluster_dirty(self.owner());
   } else {
     IDLE_DETAIL_LOG_DEBUG(
         "Hidden interface {} of service {} is not added to a registry!", self,
@@ -128,6 +129,7 @@ void ServiceImpl::interface_revoke(Interface& self) noexcept {
         self.owner());
 
     RegistryImpl::from(*self.registry_entry_).onInterfaceDestroy(self);
+    mark_cluster_dirty(self.owner());
   }
 }
 
@@ -266,6 +268,54 @@ continuable<> ServiceImpl::request_start(Service& me, Reason reason) {
       }));
 }
 
+continuable<> ServiceImpl::request_start(Context& root,
+                                         StaticComposition const& composition) {
+  IDLE_ASSERT(root.is_on_event_loop());
+
+  // The requested heads and whether they are a sink of the composition
+  std::vector<std::pair<Ref<Service>, bool>> requested;
+  requested.reserve(composition.size());
+  for (StaticComposition::Entry const& entry : composition.entries()) {
+    if (entry.requested) {
+      if (auto head = entry.head.lock()) {
+        if (head->state().isInitializedUnsafe()) {
+          set_override(*head, override_t::start);
+          requested.emplace_back(std::move(head), entry.sink);
+        }
+      }
+    }
+  }
+
+  ContextImpl::from(root).associated_scheduler().on_composition_start_request(
+      composition);
+
+  // It is enough to wait for the sinks of the composition,
+  // since those transitively depend on all other clusters.
+  std::vector<continuable<>> sinks;
+  for (auto& current : requested) {
+    Ref<Service>& head = current.first;
+    if (!is_cluster_running(*head)) {
+      transition_target_set(*head, target_t::start);
+    }
+
+    if (current.second) {
+      sinks.push_back(make_continuable<void>(
+          [head = std::move(head)](auto&& promise) mutable {
+            IDLE_ASSERT(head->root().is_on_event_loop());
+
+            if (is_cluster_running(*head)) {
+              std::forward<decltype(promise)>(promise)();
+            } else {
+              chain_promise(head->cluster_->promise_,
+                            std::forward<decltype(promise)>(promise));
+            }
+          }));
+    }
+  }
+
+  return when_all(std::move(sinks));
+}
+
 continuable<> ServiceImpl::request_stop(Service& me, Reason reason) {
   Service& head = get_cluster_head_of(me);
   return head.root().event_loop().async_post(
@@ -653,10 +703,15 @@ void ServiceImpl::do_transition_phase(Service& me, phase_t from,
 
 void ServiceImpl::do_transition_phase_silent(Service& me, phase_t from,
                                              phase_t to) noexcept {
-  IDLE_ASSERT(me.phase_.load(std::memory_order_acquire) == from);
+  IDLE_ASSERT(me.load_phase() == from);
   (void)from;
 
-  me.phase_.store(to, std::memory_order_release);
+  me.store_phase(to);
+
+  // The health of a cluster only depends on the phase of its head
+  if (me.row_flags() & detail::SchedulingTable::flag_cluster_head) {
+    me.table_->mark_dirty(me.row());
+  }
 }
 
 void ServiceImpl::on_usage_connected(Usage& use) {
@@ -1113,6 +1168,7 @@ void ServiceImpl::call_on_cluster_pushes_increment(
                                 head->cluster_->pushes_, *head);
 
           head->cluster_->pushes_ += 1;
+          sync_cluster_flags(*head);
 
           if (head->cluster_->pushes_ == 1U) {
             return true;
@@ -1162,6 +1218,7 @@ void ServiceImpl::call_on_cluster_pushes_decrement(
           IDLE_ASSERT(head->cluster_->pushes_ != 0);
 
           head->cluster_->pushes_ -= 1;
+          sync_cluster_flags(*head);
 
           if (head->cluster_->pushes_ == 0U) {
             IDLE_ASSERT(!ServiceImpl::is_cluster_overriden_for_start(*head));
@@ -1312,19 +1369,20 @@ void ServiceImpl::on_outer_required_decrement(Service& me) noexcept {
 void ServiceImpl::on_inner_required_increment(Service& me) noexcept {
   IDLE_ASSERT(me.root().is_on_event_loop());
   IDLE_ASSERT(me.state().isInitializedUnsafe());
-  IDLE_ASSERT(me.inner_deps_missing_ < (1 << 12));
+  IDLE_ASSERT(me.row_inner_deps_missing() < (1 << 12));
 
-  ++me.inner_deps_missing_;
+  ++me.row_inner_deps_missing();
 }
 
 void ServiceImpl::on_inner_required_decrement(Service& me) noexcept {
   IDLE_ASSERT(me.root().is_on_event_loop());
   IDLE_ASSERT(me.state().isInitializedUnsafe());
-  IDLE_ASSERT(me.inner_deps_missing_ > 0U);
+  std::uint16_t& missing = me.row_inner_deps_missing();
+  IDLE_ASSERT(missing > 0U);
 
-  --me.inner_deps_missing_;
+  --missing;
 
-  if (me.inner_deps_missing_ == 0) {
+  if (missing == 0) {
     check_inner_startable(me);
   }
 }
@@ -1332,6 +1390,7 @@ void ServiceImpl::on_inner_required_decrement(Service& me) noexcept {
 void ServiceImpl::do_mark_cluster_for_stop(Service& head, bool set) noexcept {
   if (set != head.cluster_->is_marked_for_stop_) {
     head.cluster_->is_marked_for_stop_ = set;
+    sync_cluster_flags(head);
 
     if (set) {
       call_on_cluster_pulls_increment(head);
@@ -1341,6 +1400,30 @@ void ServiceImpl::do_mark_cluster_for_stop(Service& head, bool set) noexcept {
   }
 }
 
+void ServiceImpl::sync_cluster_flags(Service& head) noexcept {
+  IDLE_ASSERT(is_cluster_head(head));
+
+  using table_t = detail::SchedulingTable;
+  std::uint8_t& flags = head.row_flags();
+  flags &= table_t::flag_cluster_head | table_t::flag_cluster_dirty;
+
+  if (head.cluster_->pushes_ != 0U) {
+    flags |= table_t::flag_cluster_pushed;
+  }
+  if (head.cluster_->is_marked_for_stop_) {
+    flags |= table_t::flag_cluster_marked_for_stop;
+  }
+
+  head.table_->mark_dirty(head.row());
+}
+
+void ServiceImpl::mark_cluster_dirty(Service& member) noexcept {
+  IDLE_ASSERT(member.root().is_on_event_loop());
+
+  Service& head = get_cluster_head_of(member);
+  head.table_->mark_dirty(head.row());
+}
+
 bool ServiceImpl::shall_cluster_start(Service& me) noexcept {
   // TODO Maybe we should start when the cluster is influencing or marked?
   return (is_cluster_pushed(me) && is_cluster_marked_for_start(me)) &&
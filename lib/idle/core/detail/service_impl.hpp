@@ -56,6 +56,8 @@ public:
   static void used_started(Usage& u, Export& exp) noexcept;
 
   static continuable<> request_start(Service& me, Reason reason);
+  static continuable<> request_start(Context& root,
+                                     StaticComposition const& composition);
   static continuable<> request_stop(Service& me, Reason reason);
   static continuable<> request_observe(Service& me);
 
@@ -76,7 +78,7 @@ public:
   static void on_import_unsatisfied(Service& me, Import& imp) noexcept;
 
   static phase_t get_phase(Service const& me) noexcept {
-    return me.phase_.load(std::memory_order_acquire);
+    return me.load_phase();
   }
   static bool is_in_phase(Service const& current, phase_t phase) noexcept {
     return get_phase(current) == phase;
@@ -102,6 +104,14 @@ public:
 
   static void do_mark_cluster_for_stop(Service& head, bool set) noexcept;
 
+  /// Mirrors the cluster state of the head into its scheduling table row,
+  /// such that system scans don't have to visit the cluster itself.
+  static void sync_cluster_flags(Service& head) noexcept;
+
+  /// Adds the cluster of the given member to the dirty set of the
+  /// scheduling table, which is revisited by the next system update.
+  static void mark_cluster_dirty(Service& member) noexcept;
+
   static bool shall_cluster_start(Service& me) noexcept;
   static bool shall_cluster_stop(Service& me) noexcept;
 
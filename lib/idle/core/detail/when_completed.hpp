@@ -65,7 +65,7 @@ private:
 template <typename Range>
 auto when_completed(Range&& range) {
   return make_continuable<void>(
-      [range = std::forward<Range>(range)](auto&& promise) {
+      [range = std::forward<Range>(range)](auto&& promise) mutable {
         using frame_t = when_completed_frame<
             std::remove_reference_t<decltype(promise)>>;
 
@@ -0,0 +1,160 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <idle/core/metrics.hpp>
+#include <idle/core/detail/unreachable.hpp>
+#include <idle/core/util/assert.hpp>
+
+namespace idle {
+static std::size_t bucket_of(std::uint64_t value) noexcept {
+  std::size_t bucket = 0U;
+  while (value && (bucket < (Histogram::bucket_count - 1U))) {
+    value >>= 1U;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void Histogram::record(std::uint64_t value) noexcept {
+  ++buckets_[bucket_of(value)];
+  ++count_;
+  total_ += value;
+  max_ = std::max(max_, value);
+}
+
+std::uint64_t Histogram::percentile(unsigned p) const noexcept {
+  IDLE_ASSERT(p <= 100U);
+
+  if (!count_) {
+    return 0U;
+  }
+
+  std::uint64_t const rank = (count_ * p + 99U) / 100U;
+  std::uint64_t seen = 0U;
+  for (std::size_t i = 0; i < bucket_count; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      if (i == bucket_count - 1U) {
+        // The last bucket is unbounded
+        return max_;
+      }
+
+      // The upper bound of the bucket, but never more than the maximum
+      std::uint64_t const bound = (i == 0U) ? 0U : (std::uint64_t(1U) << i);
+      return std::min(bound, max_);
+    }
+  }
+  return max_;
+}
+
+/// Assigns every thread to a fixed shard, such that threads
+/// mostly increment counters on their own cache line.
+static std::size_t this_thread_shard(std::size_t count) noexcept {
+  static std::atomic<std::size_t> next{0U};
+  thread_local std::size_t const shard = next.fetch_add(
+      1U, std::memory_order_relaxed);
+  return shard % count;
+}
+
+void Metrics::add(Counter counter, std::uint64_t value) noexcept {
+  Shard& shard = shards_[this_thread_shard(shard_count)];
+  shard.counters[static_cast<std::size_t>(counter)].fetch_add(
+      value, std::memory_order_relaxed);
+}
+
+std::uint64_t Metrics::get(Counter counter) const noexcept {
+  std::uint64_t sum = 0U;
+  for (Shard const& shard : shards_) {
+    sum += shard.counters[static_cast<std::size_t>(counter)].load(
+        std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+void Metrics::recordService(Guid guid, Distribution distribution,
+                            clock_type::duration value) noexcept {
+  IDLE_ASSERT(distribution == Distribution::ServiceStart ||
+              distribution == Distribution::ServiceStop);
+
+  std::uint64_t const duration = micros(value);
+  record(distribution, duration);
+
+  ServiceTimings& timings = services_[guid.low()];
+  if (distribution == Distribution::ServiceStart) {
+    timings.start.record(duration);
+  } else {
+    timings.stop.record(duration);
+  }
+}
+
+void Metrics::forgetService(Guid guid) noexcept {
+  services_.erase(guid.low());
+}
+
+char const* Metrics::nameOf(Counter counter) noexcept {
+  switch (counter) {
+    case Counter::Handlers:
+      return "handlers";
+    case Counter::SchedulerPasses:
+      return "scheduler_passes";
+    case Counter::ScheduledServices:
+      return "scheduled_services";
+    case Counter::ServiceStarts:
+      return "service_starts";
+    case Counter::ServiceStops:
+      return "service_stops";
+    case Counter::DFSTraversals:
+      return "dfs_traversals";
+  }
+
+  IDLE_DETAIL_UNREACHABLE();
+}
+
+char const* Metrics::nameOf(Distribution distribution) noexcept {
+  switch (distribution) {
+    case Distribution::ServiceStart:
+      return "service_start_us";
+    case Distribution::ServiceStop:
+      return "service_stop_us";
+    case Distribution::EventLoopLag:
+      return "event_loop_lag_us";
+    case Distribution::QueueDepth:
+      return "queue_depth";
+    case Distribution::DFSSize:
+      return "dfs_size";
+    case Distribution::ReloadStop:
+      return "reload_stop_us";
+    case Distribution::ReloadUnload:
+      return "reload_unload_us";
+    case Distribution::ReloadLoad:
+      return "reload_load_us";
+    case Distribution::ReloadStart:
+      return "reload_start_us";
+  }
+
+  IDLE_DETAIL_UNREACHABLE();
+}
+} // namespace idle
@@ -0,0 +1,94 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <utility>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/concurrent_dyn_dependency.hpp>
+#include <idle/core/ref.hpp>
+
+namespace idle {
+ConcurrentDynDependencyBase::ConcurrentDynDependencyBase(Service& owner)
+  : DynDependencyBase(owner)
+  , is_reclaiming_(false)
+  , is_parked_(false) {}
+
+void ConcurrentDynDependencyBase::onStore(Interface* current) noexcept {
+  Publication next;
+  if (current) {
+    // The Use keeps the Interface running until the publication is
+    // reclaimed, which requires that no reader pins it anymore.
+    if ((next.use = Use<Interface>::tryUse(*current))) {
+      next.current = current;
+    }
+  }
+
+  published_.store(std::move(next));
+
+  is_parked_.store(false, std::memory_order_relaxed);
+  scheduleReclaim();
+}
+
+void ConcurrentDynDependencyBase::scheduleReclaim() noexcept {
+  if (!published_.pending() ||
+      is_reclaiming_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+
+  owner().root().event_loop().post([weak = weakOf(*this)] {
+    if (auto me = weak.lock()) {
+      me->reclaim();
+    }
+  });
+}
+
+void ConcurrentDynDependencyBase::reclaim() noexcept {
+  IDLE_ASSERT(owner().root().is_on_event_loop());
+
+  published_.collect();
+  is_reclaiming_.store(false, std::memory_order_release);
+
+  if (!published_.pending()) {
+    return;
+  }
+
+  // A reader still pins a replaced publication. Instead of retrying on
+  // every event loop iteration, the next reader that unpins or the next
+  // store resumes the reclamation.
+  is_parked_.store(true, std::memory_order_seq_cst);
+
+  // Readers that unpinned before they could observe the parking
+  // are visible to this collection.
+  published_.collect();
+  if (!published_.pending()) {
+    is_parked_.store(false, std::memory_order_relaxed);
+  }
+}
+
+void ConcurrentDynDependencyBase::unpark() noexcept {
+  if (is_parked_.exchange(false, std::memory_order_acq_rel)) {
+    scheduleReclaim();
+  }
+}
+} // namespace idle
@@ -88,6 +88,9 @@ void DependencyBase::onPartInit() noexcept {
   if (auto const interfaces = registry_entry_->interfaces()) {
     ref_ = reference_of(interfaces.front());
     connect();
+  } else if (registry_entry_->instantiateLazy()) {
+    // The interface is inserted through the onSubscribedCreated hook
+    IDLE_ASSERT(ref_);
   } else if (hasDefault()) {
     setDefault();
   } else {
@@ -149,6 +149,9 @@ void DynDependencyBase::onPartInit() noexcept {
   if (auto const interfaces = registry_entry_->interfaces()) {
     active().ptr() = reference_of(interfaces.front());
     active().connect();
+  } else if (registry_entry_->instantiateLazy()) {
+    // The interface is inserted through the onSubscribedCreated hook
+    IDLE_ASSERT(active().ptr());
   } else if (hasDefault()) {
     setDefault();
   } else {
@@ -447,6 +450,12 @@ bool DynDependencyBase::apply(Handle<DynDependencyBase>&& handle,
 void DynDependencyBase::store(Interface* preferred) noexcept {
   // Updates the user pointers
   userspace_ptr_.store(preferred, std::memory_order_relaxed);
+
+  onStore(preferred);
+}
+
+void DynDependencyBase::onStore(Interface* current) noexcept {
+  (void)current;
 }
 
 void DynDependencyBase::finalize() noexcept {
@@ -23,31 +23,95 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
 #include <thread>
 #include <concurrentqueue/concurrentqueue.h>
 #include <idle/core/parts/pollable_executor.hpp>
 #include <idle/core/service.hpp>
 #include <idle/core/util/assert.hpp>
 
+#ifdef __linux__
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#endif
+
 namespace idle {
 class PollableExecutor::Impl final {
 public:
-  Impl()
-    : consumer_token_(queue_) {}
+  explicit Impl(bool waitable)
+    : consumer_token_(queue_) {
+#ifdef __linux__
+    if (waitable) {
+      event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+#else
+    (void)waitable;
+#endif
+  }
   ~Impl() {
     IDLE_ASSERT(queue_.size_approx() == 0U);
+
+#ifdef __linux__
+    if (event_fd_ >= 0) {
+      ::close(event_fd_);
+    }
+#endif
+  }
+
+  /// Signals waiters that the executor became non empty
+  void arm() noexcept {
+#ifdef __linux__
+    if (event_fd_ >= 0) {
+      std::uint64_t const value = 1;
+      (void)!::write(event_fd_, &value, sizeof(value));
+    }
+#endif
+
+    // Only take the lock when a thread is blocked inside pollFor,
+    // which keeps the lock off the posting path otherwise.
+    if (waiters_.load(std::memory_order_seq_cst) != 0U) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+      }
+      available_.notify_one();
+    }
+  }
+
+  /// Resets the waitable handle before draining
+  void disarm() noexcept {
+#ifdef __linux__
+    if (event_fd_ >= 0) {
+      std::uint64_t value;
+      (void)!::read(event_fd_, &value, sizeof(value));
+    }
+#endif
   }
 
   std::atomic<std::thread::id> this_thread_;
   moodycamel::ConcurrentQueue<work> queue_;
   moodycamel::ConcurrentQueue<work>::consumer_token_t consumer_token_;
+
+  // The count of queued items, this can become negative temporarily
+  // when an item is dequeued before its producer has counted it.
+  std::atomic<std::ptrdiff_t> pending_{0};
+
+  int event_fd_{-1};
+  std::atomic<std::size_t> waiters_{0U};
+  std::mutex mutex_;
+  std::condition_variable available_;
 };
 
-PollableExecutor::PollableExecutor(Service& owner)
+PollableExecutor::PollableExecutor(Service& owner, bool waitable)
   : Import(owner)
   , owner_(owner)
-  , impl_(new Impl()) {
+  , impl_(new Impl(waitable)) {
   IDLE_ASSERT(impl_);
 }
 
@@ -69,16 +133,71 @@ void PollableExecutor::setRunningFromThisThread() noexcept {
 }
 
 void PollableExecutor::poll() {
+  (void)pollSome(std::numeric_limits<std::size_t>::max());
+}
+
+std::size_t PollableExecutor::pollSome(std::size_t max) {
   IDLE_ASSERT(((impl_->this_thread_.load(std::memory_order_acquire) ==
                 std::thread::id{}) ||
                isThisThread()) &&
               "Used pool from a different thread than the active one!");
 
-  work w;
+  impl_->disarm();
+
+  std::array<work, 32> buffer;
+  std::size_t dispatched = 0;
 
-  while (impl_->queue_.try_dequeue(impl_->consumer_token_, w)) {
-    std::move(w).set_value();
+  while (dispatched < max) {
+    std::size_t const count = impl_->queue_.try_dequeue_bulk(
+        impl_->consumer_token_, buffer.begin(),
+        std::min(buffer.size(), max - dispatched));
+    if (!count) {
+      break;
+    }
+
+    impl_->pending_.fetch_sub(static_cast<std::ptrdiff_t>(count),
+                              std::memory_order_acq_rel);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      std::move(buffer[i]).set_value();
+    }
+
+    dispatched += count;
   }
+
+  // Keep the handle readable while work is left over
+  if (impl_->pending_.load(std::memory_order_acquire) > 0) {
+    impl_->arm();
+  }
+
+  return dispatched;
+}
+
+std::size_t PollableExecutor::pollFor(std::chrono::milliseconds timeout) {
+  IDLE_ASSERT(impl_);
+
+  if (impl_->pending_.load(std::memory_order_acquire) <= 0) {
+    // Producers observe the waiter before they skip the notification,
+    // or the waiter observes their work inside the predicate.
+    impl_->waiters_.fetch_add(1U, std::memory_order_seq_cst);
+
+    {
+      std::unique_lock<std::mutex> lock(impl_->mutex_);
+      impl_->available_.wait_for(lock, timeout, [&] {
+        return impl_->pending_.load(std::memory_order_seq_cst) > 0;
+      });
+    }
+
+    impl_->waiters_.fetch_sub(1U, std::memory_order_relaxed);
+  }
+
+  return pollSome(std::numeric_limits<std::size_t>::max());
+}
+
+int PollableExecutor::waitableHandle() const noexcept {
+  IDLE_ASSERT(impl_);
+
+  return impl_->event_fd_;
 }
 
 bool PollableExecutor::isThisThread() const noexcept {
@@ -107,6 +226,11 @@ void PollableExecutor::queue(work&& work) noexcept {
 
   if (owner().state().isRunning()) {
     impl_->queue_.enqueue(std::move(work));
+
+    // Only the transition from empty to non empty wakes up waiters
+    if (impl_->pending_.fetch_add(1, std::memory_order_seq_cst) == 0) {
+      impl_->arm();
+    }
   } else {
     work.set_canceled();
   }
@@ -58,6 +58,10 @@ Interface::Id const& Registry::id() const noexcept {
   return RegistryImpl::from(this)->idImpl();
 }
 
+bool Registry::instantiateLazy() {
+  return RegistryImpl::from(this)->instantiateLazyImpl();
+}
+
 void Registry::subscriberAdd(Subscriber& subscriber) {
   return RegistryImpl::from(this)->subscriberAddImpl(subscriber);
 }
@@ -234,12 +234,20 @@ bool Inheritance::isInCluster() const noexcept {
   return isa<Import>(*parent_);
 }
 
+AllocationDomain* Inheritance::domain() const noexcept {
+  if (AllocationDomain* const domain = parent_->owner().allocationDomain()) {
+    return domain;
+  } else {
+    return detail::current_allocation_domain();
+  }
+}
+
 Service::Service(Inheritance inh)
-  : phase_(Phase::uninitialized)
-  , inner_deps_missing_(0U)
+  : row_(detail::SchedulingTable::uninitialized_row)
+  , uses_(0U)
   , high_guid_(Guid{}.high())
+  , table_(nullptr)
   , parent_(std::move(inh.parent_))
-  , uses_(0U)
   , cluster_(nullptr) {
 
   IDLE_ASSERT(isa<Export>(*parent_) || isa<Import>(*parent_));
@@ -269,10 +277,17 @@ static Guid next_child_guid(Guid current) noexcept {
 
 void Service::init() {
   IDLE_ASSERT(root().is_on_event_loop());
-  IDLE_ASSERT(phase_ == Phase::uninitialized);
+  IDLE_ASSERT(state().phase() == Phase::uninitialized);
 
   ContextImpl& context = ContextImpl::from(root());
 
+  // Move the scheduling state into the table of the context,
+  // the table is published before the row which guards it.
+  table_ = &context.scheduling_table();
+  row_.store(table_->allocate(*this,
+                              static_cast<std::uint8_t>(Phase::uninitialized)),
+             std::memory_order_release);
+
   if (!isRoot() && isa<Import>(parent())) {
     IDLE_ASSERT(cluster_ == nullptr);
     cluster_ = parent().owner().cluster_;
@@ -291,6 +306,8 @@ void Service::init() {
     Guid const current = Guid(low);
     high_guid_ = current.high();
     cluster_->guid_.store(current, std::memory_order_release);
+
+    row_flags() |= detail::SchedulingTable::flag_cluster_head;
   }
 
   detail::garbage_collector::on_service_init(*this);
@@ -397,6 +414,11 @@ void Service::destroy() {
   ServiceImpl::do_transition_phase_silent(*this, Phase::on_destroy,
                                           Phase::destroyed);
 
+  // The destroyed phase is kept by the sentinel row from now on
+  Row const row = this->row();
+  row_.store(detail::SchedulingTable::destroyed_row, std::memory_order_release);
+  table_->release(row);
+
   detail::garbage_collector::on_service_destroy(*this);
 
 #ifndef NDEBUG
@@ -430,13 +452,27 @@ void Service::name(std::ostream& os) const {
   detail::print_class_type(os, *this);
 }
 
+AllocationDomain* Service::allocationDomain() const noexcept {
+  if (isRoot()) {
+    return nullptr;
+  } else {
+    return parent().owner().allocationDomain();
+  }
+}
+
 void Service::print_state(std::ostream& os) const {
-  os << phase_.load(std::memory_order_acquire);
+  os << load_phase();
 }
 
 void Service::print_usage(std::ostream& os) const {
-  print(os, FMT_STRING("in (cluster): -{}, ~out: {}"), inner_deps_missing_,
-        uses_.load(std::memory_order_relaxed));
+  if (!detail::SchedulingTable::isValid(
+          row_.load(std::memory_order_acquire))) {
+    os << "in (cluster): -, ~out: -";
+    return;
+  }
+
+  print(os, FMT_STRING("in (cluster): -{}, ~out: {}"),
+        row_inner_deps_missing(), uses_.load(std::memory_order_relaxed));
 }
 
 std::ostream& operator<<(std::ostream& os, phase_t value) {
@@ -481,12 +517,12 @@ void Service::print_cluster(std::ostream& os) const {
 
 void Service::onInit() {
   IDLE_ASSERT(root().is_on_event_loop());
-  IDLE_ASSERT(phase_ == Phase::on_init);
+  IDLE_ASSERT(state().phase() == Phase::on_init);
 }
 
 void Service::onDestroy() {
   IDLE_ASSERT(root().is_on_event_loop());
-  IDLE_ASSERT(phase_ == Phase::on_destroy);
+  IDLE_ASSERT(state().phase() == Phase::on_destroy);
 }
 
 continuable<> Service::onStart() {
@@ -530,15 +566,17 @@ bool Service::isRoot() const noexcept {
 bool Service::State::isStartable() const noexcept {
   IDLE_ASSERT(me_->root().is_on_event_loop());
 
-  return (me_->inner_deps_missing_ == 0) &&
-         (is(Phase::locked) ||
-          (is(Phase::stopped) && me_->cluster_->outer_deps_missing_ == 0U));
+  // The phase is checked first since only initialized services own a row
+  return (is(Phase::locked) ||
+          (is(Phase::stopped) && me_->cluster_->outer_deps_missing_ == 0U)) &&
+         (me_->row_inner_deps_missing() == 0);
 }
 
 bool Service::State::isStoppable() const noexcept {
   IDLE_ASSERT(me_);
-  return isRunning() && ServiceImpl::has_no_external_uses(
-                            *me_, me_->uses_.load(std::memory_order_relaxed));
+  return isRunning() &&
+         ServiceImpl::has_no_external_uses(
+             *me_, me_->uses_.load(std::memory_order_relaxed));
 }
 
 bool Service::State::isManual() const noexcept {
@@ -559,7 +597,7 @@ bool Service::State::isHidden() const noexcept {
 bool Service::State::isInitializedUnsafe() const noexcept {
   IDLE_ASSERT(me_);
 
-  switch (me_->phase_) {
+  switch (phase()) {
     case Phase::uninitialized:
     case Phase::destroyed:
     case Phase::on_destroy:
@@ -572,7 +610,7 @@ bool Service::State::isInitializedUnsafe() const noexcept {
 bool Service::State::isDestroyedUnsafe() const noexcept {
   IDLE_ASSERT(me_);
 
-  switch (me_->phase_) {
+  switch (phase()) {
     case Phase::uninitialized:
     case Phase::destroyed:
       return true;
@@ -0,0 +1,217 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <thread>
+#include <fmt/format.h>
+#include <idle/core/detail/json.hpp>
+#include <idle/core/detail/unreachable.hpp>
+#include <idle/core/tracing.hpp>
+
+namespace idle {
+struct Tracing::Ring {
+  explicit Ring(std::uint32_t index_) noexcept
+    : index(index_)
+    , owner(std::this_thread::get_id()) {}
+
+  /// Returns the position of the oldest event which wasn't overwritten
+  std::uint64_t tail() const noexcept {
+    return (head > ring_size) ? (head - ring_size) : 0U;
+  }
+
+  std::uint32_t const index;
+  std::thread::id const owner;
+
+  /// Is only contended while the events are exported
+  std::mutex mutex;
+  std::uint64_t head{0U};
+  std::array<Event, ring_size> events;
+};
+
+static std::uint64_t next_instance() noexcept {
+  static std::atomic<std::uint64_t> next{1U};
+  return next.fetch_add(1U, std::memory_order_relaxed);
+}
+
+Tracing::Tracing()
+  : instance_(next_instance())
+  , created_(clock_type::now()) {}
+
+Tracing::~Tracing() = default;
+
+Tracing::Ring& Tracing::this_thread_ring() {
+  struct Cache {
+    std::uint64_t instance{0U};
+    Ring* ring{nullptr};
+  };
+
+  thread_local Cache cache;
+  if (cache.instance == instance_) {
+    return *cache.ring;
+  }
+
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+
+  // The thread might have alternated between multiple instances
+  std::thread::id const current = std::this_thread::get_id();
+  auto const itr = std::find_if(rings_.begin(), rings_.end(),
+                                [&](std::unique_ptr<Ring> const& ring) {
+                                  return ring->owner == current;
+                                });
+
+  Ring* ring;
+  if (itr != rings_.end()) {
+    ring = itr->get();
+  } else {
+    rings_.push_back(
+        std::make_unique<Ring>(static_cast<std::uint32_t>(rings_.size())));
+    ring = rings_.back().get();
+  }
+
+  cache.instance = instance_;
+  cache.ring = ring;
+  return *ring;
+}
+
+void Tracing::emit(Category category, Phase phase, char const* name,
+                   std::uint64_t id, StringView label) noexcept {
+  Ring& ring = this_thread_ring();
+
+  std::lock_guard<std::mutex> lock(ring.mutex);
+  Event& event = ring.events[ring.head % ring_size];
+  ++ring.head;
+
+  event.name = name;
+  event.category = category;
+  event.phase = phase;
+  event.id = id;
+  event.thread = ring.index;
+  event.time = clock_type::now();
+
+  std::size_t const size = std::min(label.size(), label_size - 1U);
+  if (size) {
+    std::memcpy(event.label.data(), label.data(), size);
+  }
+  event.label[size] = '\0';
+}
+
+std::vector<Tracing::Event> Tracing::events() const {
+  std::vector<Event> events;
+
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (std::unique_ptr<Ring> const& ring : rings_) {
+      std::lock_guard<std::mutex> ring_lock(ring->mutex);
+      for (std::uint64_t i = ring->tail(); i < ring->head; ++i) {
+        events.push_back(ring->events[i % ring_size]);
+      }
+    }
+  }
+
+  std::stable_sort(events.begin(), events.end(),
+                   [](Event const& left, Event const& right) {
+                     return left.time < right.time;
+                   });
+  return events;
+}
+
+std::uint64_t Tracing::dropped() const noexcept {
+  std::uint64_t dropped = 0U;
+
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  for (std::unique_ptr<Ring> const& ring : rings_) {
+    std::lock_guard<std::mutex> ring_lock(ring->mutex);
+    dropped += ring->tail();
+  }
+  return dropped;
+}
+
+void Tracing::clear() noexcept {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  for (std::unique_ptr<Ring> const& ring : rings_) {
+    std::lock_guard<std::mutex> ring_lock(ring->mutex);
+    ring->head = 0U;
+  }
+}
+
+void Tracing::write(std::ostream& os) const {
+  std::vector<Event> const recorded = events();
+
+  fmt::memory_buffer buffer;
+  format_to(buffer, FMT_STRING("{{\"traceEvents\":["));
+
+  bool first = true;
+  for (Event const& event : recorded) {
+    if (!first) {
+      buffer.push_back(',');
+    }
+    first = false;
+
+    double const ts = std::chrono::duration<double, std::micro>(event.time -
+                                                                created_)
+                          .count();
+
+    // Async events are matched by their category, name and id,
+    // which makes it possible to end spans on a different thread.
+    format_to(buffer,
+              FMT_STRING("\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"{}\","
+                         "\"id\":\"0x{:x}\",\"pid\":1,\"tid\":{},"
+                         "\"ts\":{:.3f}"),
+              event.name, nameOf(event.category),
+              (event.phase == Phase::Begin) ? 'b' : 'e', event.id,
+              event.thread, ts);
+
+    if (event.label[0] != '\0') {
+      format_to(buffer, FMT_STRING(",\"args\":{{\"label\":\""));
+      char const* const label = event.label.data();
+      detail::format_json_string(buffer,
+                                 StringView(label, std::strlen(label)));
+      format_to(buffer, FMT_STRING("\"}}"));
+    }
+
+    buffer.push_back('}');
+  }
+
+  format_to(buffer, FMT_STRING("\n],\"displayTimeUnit\":\"ms\"}}\n"));
+  os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+char const* Tracing::nameOf(Category category) noexcept {
+  switch (category) {
+    case Category::Service:
+      return "service";
+    case Category::Scheduler:
+      return "scheduler";
+    case Category::Plugin:
+      return "plugin";
+    case Category::Compiler:
+      return "compiler";
+  }
+
+  IDLE_DETAIL_UNREACHABLE();
+}
+} // namespace idle
@@ -0,0 +1,124 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <idle/core/util/rcu.hpp>
+
+namespace idle {
+EpochDomain::~EpochDomain() {
+  for (Retired const& current : retired_) {
+    current.deleter(current.object);
+  }
+}
+
+EpochDomain::Guard EpochDomain::pin() noexcept {
+  // Spread the readers of different threads over the slots
+  std::size_t const start = std::hash<std::thread::id>{}(
+                                std::this_thread::get_id()) %
+                            slot_count;
+
+  for (;;) {
+    // A slot might be pinned to an outdated epoch, which only delays
+    // the reclamation of retired objects.
+    std::uint64_t const current = epoch_.load(std::memory_order_seq_cst);
+
+    for (std::size_t i = 0; i < slot_count; ++i) {
+      Slot& slot = slots_[(start + i) % slot_count];
+
+      std::uint64_t expected = 0U;
+      if (slot.epoch.compare_exchange_strong(expected, current,
+                                             std::memory_order_seq_cst)) {
+        return Guard(*this, (start + i) % slot_count);
+      }
+    }
+
+    std::this_thread::yield();
+  }
+}
+
+void EpochDomain::unpin(std::size_t slot) noexcept {
+  IDLE_ASSERT(slot < slot_count);
+  IDLE_ASSERT(slots_[slot].epoch.load(std::memory_order_relaxed));
+
+  slots_[slot].epoch.store(0U, std::memory_order_release);
+}
+
+void EpochDomain::retire(void* object, void (*deleter)(void*)) {
+  IDLE_ASSERT(deleter);
+
+  if (!object) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Readers that pin the domain from now on are pinned to a newer
+    // epoch than the object and can't observe it anymore.
+    std::uint64_t const epoch = epoch_.fetch_add(1U,
+                                                 std::memory_order_seq_cst);
+    retired_.push_back(Retired{epoch, object, deleter});
+  }
+
+  collect();
+}
+
+void EpochDomain::collect() {
+  // Objects retired after this point are kept regardless of the readers,
+  // since a reader could pin the domain after its slot was visited.
+  std::uint64_t oldest = epoch_.load(std::memory_order_seq_cst);
+  for (Slot const& slot : slots_) {
+    std::uint64_t const epoch = slot.epoch.load(std::memory_order_seq_cst);
+    if (epoch) {
+      oldest = std::min(oldest, epoch);
+    }
+  }
+
+  std::vector<Retired> reclaimable;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto const itr = std::partition(retired_.begin(), retired_.end(),
+                                    [&](Retired const& current) {
+                                      return current.epoch >= oldest;
+                                    });
+
+    reclaimable.assign(itr, retired_.end());
+    retired_.erase(itr, retired_.end());
+  }
+
+  for (Retired const& current : reclaimable) {
+    current.deleter(current.object);
+  }
+}
+
+std::size_t EpochDomain::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return retired_.size();
+}
+} // namespace idle
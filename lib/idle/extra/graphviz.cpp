@@ -269,6 +269,25 @@ static void print_edge_props(std::ostream& os, EdgeProperties config) {
   os << "\"";
 }
 
+static void print_service_properties(std::ostream& out, Service const& s) {
+  if (s.isRoot()) {
+    print_node_properties(out, s, colors::color_service_root,
+                          "shape=doubleoctagon");
+  } else {
+    if (isa<Export>(s.parent())) {
+      if (s.state().isManual()) {
+        print_node_properties(out, s, service_color(s),
+                              "penwidth=3 shape=component");
+      } else {
+        // TODO maybe add a unqiue style for cluster heads
+        print_node_properties(out, s, service_color(s), "shape=component");
+      }
+    } else {
+      print_node_properties(out, s, service_color(s), "shape=component");
+    }
+  }
+}
+
 template <typename T>
 struct property_writer_trait;
 template <>
@@ -371,24 +390,7 @@ public:
   void operator()(std::ostream& out, Node const& n) const {
     switch (n.index()) {
       case Node::index_of<Service>(): {
-        Service const& s = n.get<Service>();
-        if (s.isRoot()) {
-          print_node_properties(out, s, colors::color_service_root,
-                                "shape=doubleoctagon");
-        } else {
-          if (isa<Export>(s.parent())) {
-            if (s.state().isManual()) {
-              print_node_properties(out, s, service_color(s),
-                                    "penwidth=3 shape=component");
-            } else {
-              // TODO maybe add a unqiue style for cluster heads
-              print_node_properties(out, s, service_color(s),
-                                    "shape=component");
-            }
-          } else {
-            print_node_properties(out, s, service_color(s), "shape=component");
-          }
-        }
+        print_service_properties(out, n.get<Service>());
         break;
       }
       case Node::index_of<Import>(): {
@@ -629,4 +631,33 @@ void graphviz(std::ostream& os, ClusterDependencyGraph const& graph) {
 void graphvizReverse(std::ostream& os, ClusterDependencyGraph const& graph) {
   print_service_gv_rev_impl(os, graph);
 }
+
+void graphvizHead(std::ostream& os) {
+  os << "digraph G {\n";
+  print_gv_graph_head(os);
+}
+
+void graphvizNode(std::ostream& os, Service const& service) {
+  IDLE_ASSERT(service.root().is_on_event_loop());
+
+  escape_guid(os, service.guid());
+  print_service_properties(os, service);
+  os << ";\n";
+}
+
+void graphvizEdge(std::ostream& os, Edge const& edge,
+                  ServiceDependencyGraph const& graph) {
+  IDLE_ASSERT(graph.get_context().is_on_event_loop());
+
+  escape_guid(os, source(edge, graph)->guid());
+  os << "->";
+  escape_guid(os, target(edge, graph)->guid());
+  os << " [";
+  print_edge_props(os, edge.properties());
+  os << "];\n";
+}
+
+void graphvizTail(std::ostream& os) {
+  write_tail(os);
+}
 } // namespace idle
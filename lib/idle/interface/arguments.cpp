@@ -23,31 +23,63 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <boost/algorithm/string.hpp>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 #include <idle/interface/arguments.hpp>
 
 namespace idle {
-std::string const& Arguments::get_string(std::size_t index) const {
-  IDLE_ASSERT(index < args_.size());
-  return args_[index];
+Arguments::Arguments(std::string buffer, std::size_t offset)
+  : buffer_(std::move(buffer))
+  , offset_(offset) {
+  IDLE_ASSERT(offset_ <= buffer_.size());
+
+  StringView const str(buffer_);
+  for (StringView const arg : ArgumentsView(str.substr(offset_))) {
+    slices_.push_back(
+        Slice{static_cast<std::size_t>(arg.data() - str.data()), arg.size()});
+  }
 }
 
 std::size_t Arguments::get_uint(std::size_t index) const {
-  IDLE_ASSERT(index < args_.size());
-  return std::stoll(args_[index]);
+  // Accepts the same range as std::stoll, negative values wrap around
+  StringView arg = get_string(index);
+  bool const is_negative = !arg.empty() && (arg[0] == '-');
+  if (!arg.empty() && ((arg[0] == '-') || (arg[0] == '+'))) {
+    arg = arg.substr(1U);
+  }
+
+  if (arg.empty()) {
+    throw std::invalid_argument("The argument is not a number");
+  }
+
+  // The magnitude of a negative value may exceed the maximum by one
+  auto const max = static_cast<unsigned long long>(
+      std::numeric_limits<long long>::max());
+  unsigned long long const limit = is_negative ? (max + 1U) : max;
+
+  unsigned long long value = 0U;
+  for (char const c : arg) {
+    if ((c < '0') || (c > '9')) {
+      throw std::invalid_argument("The argument is not a number");
+    }
+
+    auto const digit = static_cast<unsigned long long>(c - '0');
+    if (value > ((limit - digit) / 10U)) {
+      throw std::out_of_range("The argument is out of range");
+    }
+
+    value = value * 10U + digit;
+  }
+
+  return static_cast<std::size_t>(is_negative ? (0U - value) : value);
 }
 
 Arguments Arguments::from(StringView str) {
-  std::vector<std::string> args;
-  boost::split(args, str, boost::is_any_of(" "), boost::token_compress_on);
-
-  // Remove empty strings from the arguments
-  args.erase(std::remove_if(args.begin(), args.end(),
-                            [](std::string const& s) {
-                              return s.empty();
-                            }),
-             args.end());
+  return Arguments(std::string(str.data(), str.size()), 0U);
+}
 
-  return Arguments(std::move(args));
+Arguments Arguments::from(std::string&& str, std::size_t offset) {
+  return Arguments(std::move(str), offset);
 }
 } // namespace idle
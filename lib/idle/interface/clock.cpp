@@ -0,0 +1,59 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <utility>
+#include <idle/core/context.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/interface/clock.hpp>
+
+namespace idle {
+class SystemClock final : public Implements<Clock> {
+public:
+  using Implements<Clock>::Implements;
+
+  TimePoint now() const noexcept override {
+    return std::chrono::steady_clock::now();
+  }
+
+  IDLE_SERVICE
+};
+
+bool Clock::isSimulated() const noexcept {
+  return false;
+}
+
+void Clock::alarm(TimePoint deadline, unique_function<void()> callback) {
+  (void)deadline;
+  (void)callback;
+
+  IDLE_ASSERT(isSimulated() &&
+              "Alarms are only supported by simulated clocks!");
+}
+
+Ref<Clock> Clock::create(Inheritance parent) {
+  return spawn<SystemClock>(std::move(parent));
+}
+} // namespace idle
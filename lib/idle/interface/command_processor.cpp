@@ -24,8 +24,10 @@
  */
 
 #include <algorithm>
-#include <mutex>
+#include <functional>
+#include <string>
 #include <utility>
+#include <vector>
 #include <idle/core/dep/format.hpp>
 #include <idle/core/detail/log.hpp>
 #include <idle/core/parts/dependency.hpp>
@@ -34,6 +36,7 @@
 #include <idle/core/service.hpp>
 #include <idle/core/use.hpp>
 #include <idle/core/util/functional.hpp>
+#include <idle/core/util/rcu.hpp>
 #include <idle/core/util/string_view.hpp>
 #include <idle/interface/arguments.hpp>
 #include <idle/interface/command.hpp>
@@ -44,10 +47,7 @@
 namespace idle {
 class DefaultCommandProcessor final : public Implements<CommandProcessor>,
                                       public Subscriber {
-  // TODO Upgrade this to a shared mutex in C++17
-  using Mutex = std::mutex;
-  using ReadLock = std::lock_guard<Mutex>;
-  using WriteLock = std::lock_guard<Mutex>;
+  using CommandTrie = tsl::htrie_map<char, std::reference_wrapper<Command>>;
 
 public:
   explicit DefaultCommandProcessor(Inheritance parent)
@@ -60,11 +60,13 @@ public:
     command_registry_ = root().find<Command>();
 
     // Populate all existing commands
-    for (Interface& command : command_registry_->interfaces()) {
-      Command& current = cast<Command>(command);
-      auto const name = current.current_command_name();
-      commands_.insert_ks(name.data(), name.size(), current);
-    }
+    commands_.update([&](CommandTrie& commands) {
+      for (Interface& command : command_registry_->interfaces()) {
+        Command& current = cast<Command>(command);
+        auto const name = current.current_command_name();
+        commands.insert_ks(name.data(), name.size(), current);
+      }
+    });
 
     command_registry_->subscriberAdd(*this);
   }
@@ -72,27 +74,24 @@ public:
   void onDestroy() override {
     command_registry_->subscriberDel(*this);
 
-    commands_.clear();
+    pending_.clear();
+    commands_.store(CommandTrie{});
 
     command_registry_.reset();
   }
 
   void onSubscribedCreated(Interface& subscribed) override {
-    WriteLock lock(mutex_);
-
     Command& current = cast<Command>(subscribed);
     auto const name = current.current_command_name();
 
-    commands_.insert_ks(name.data(), name.size(), current);
+    enqueue(Change{std::string(name.data(), name.size()), &current, true});
   }
 
   void onSubscribedDestroy(Interface& subscribed) override {
-    WriteLock lock(mutex_);
-
     Command& current = cast<Command>(subscribed);
     auto const name = current.current_command_name();
 
-    commands_.insert_ks(name.data(), name.size(), current);
+    enqueue(Change{std::string(name.data(), name.size()), &current, false});
   }
 
   continuable<> invoke(Ref<Session> session, std::string args) override {
@@ -102,20 +101,24 @@ public:
               args = std::move(args)](auto&& me) mutable -> continuable<> {
                IDLE_ASSERT(me->root().is_on_event_loop());
 
+               // Commands registered in the same event loop iteration
+               // are invokable immediately.
+               me->publish();
+
                if (auto const result = me->longestPrefixMatch(args)) {
                  auto const name = result->current_command_name();
-                 auto const prefix_free = StringView(args).substr(name.size());
+                 Arguments arguments = Arguments::from(std::move(args),
+                                                       name.size());
 
                  // Acquire the usage regardless whether the command is started
                  me->dependencies_.acquireUsage(*result);
 
                  if (result->owner().state().isRunning()) {
                    return result->invoke(std::move(session),
-                                         Arguments::from(prefix_free));
+                                         std::move(arguments));
                  } else {
-                   return result->owner().start().then(
-                       result->invoke(std::move(session),
-                                      Arguments::from(prefix_free)));
+                   return result->owner().start().then(result->invoke(
+                       std::move(session), std::move(arguments)));
                  }
                } else {
                  IDLE_LOG_ERROR(me->log_, "There is no such command as '{}'!",
@@ -129,14 +132,13 @@ public:
 
   std::vector<std::string> complete(Session& session,
                                     StringView command) noexcept override {
-    ReadLock lock(mutex_);
-
     // For now complete everything non session agnostic
     (void)session;
 
     std::vector<std::string> completions;
 
-    auto const range = commands_.equal_prefix_range_ks(command.data(),
+    auto const commands = commands_.read();
+    auto const range = commands->equal_prefix_range_ks(command.data(),
                                                        command.size());
     for (auto itr = range.first; itr != range.second; ++itr) {
       completions.push_back(itr.key());
@@ -156,21 +158,71 @@ public:
   }
 
 private:
+  /// A registration or removal of a command that wasn't published yet
+  struct Change {
+    std::string name;
+    Command* command;
+    bool is_created;
+  };
+
+  /// Queues the change and publishes all changes of the current event loop
+  /// iteration at once, such that the trie is copied once for many
+  /// commands registered together instead of once per command.
+  void enqueue(Change change) {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    if (pending_.empty()) {
+      root().event_loop().post(weakly(handleOf(*this), [](auto&& me) {
+        me->publish();
+      }));
+    }
+
+    pending_.push_back(std::move(change));
+  }
+
+  void publish() {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    if (pending_.empty()) {
+      return;
+    }
+
+    commands_.update([&](CommandTrie& commands) {
+      for (Change const& change : pending_) {
+        if (change.is_created) {
+          commands.insert_ks(change.name.data(), change.name.size(),
+                             *change.command);
+        } else {
+          // Only erase the command if it wasn't shadowed by another one
+          auto const itr = commands.find_ks(change.name.data(),
+                                            change.name.size());
+          if ((itr != commands.end()) && (&itr->get() == change.command)) {
+            commands.erase(itr);
+          }
+        }
+      }
+    });
+
+    pending_.clear();
+  }
+
   /// Returns the command with the longest prefix matched
-  Nullable<Command> longestPrefixMatch(StringView command) {
-    ReadLock lock(mutex_);
+  Nullable<Command> longestPrefixMatch(StringView command) const noexcept {
+    auto const commands = commands_.read();
 
-    auto const longest = commands_.longest_prefix_ks(command.data(),
+    auto const longest = commands->longest_prefix_ks(command.data(),
                                                      command.size());
-    if (longest != commands_.end()) {
+    if (longest != commands->end()) {
       return longest->get();
     } else {
       return {};
     }
   }
 
-  Mutex mutex_;
-  tsl::htrie_map<char, std::reference_wrapper<Command>> commands_;
+  /// The commands are read from any thread through completions,
+  /// while being modified on the event loop through the registry.
+  Rcu<CommandTrie> commands_;
+  std::vector<Change> pending_;
 
   Ref<Registry> command_registry_;
 
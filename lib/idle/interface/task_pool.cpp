@@ -0,0 +1,415 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <idle/core/context.hpp>
+#include <idle/core/dep/format.hpp>
+#include <idle/core/platform.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/core/util/thread_name.hpp>
+#include <idle/core/util/work_stealing_deque.hpp>
+#include <idle/interface/task_pool.hpp>
+
+#ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace idle {
+class DefaultTaskPool;
+
+/// A CPU set of a single NUMA node
+using cpu_list_t = std::vector<unsigned>;
+
+/// Parses a sysfs cpulist, for example `0-3,8-11`
+static cpu_list_t parse_cpu_list(std::string const& list) {
+  cpu_list_t cpus;
+
+  std::size_t pos = 0;
+  while (pos < list.size()) {
+    std::size_t const end = std::min(list.find(',', pos), list.size());
+    std::string const range = list.substr(pos, end - pos);
+    pos = end + 1;
+
+    std::size_t const dash = range.find('-');
+    try {
+      if (dash == std::string::npos) {
+        cpus.push_back(static_cast<unsigned>(std::stoul(range)));
+      } else {
+        unsigned const first = static_cast<unsigned>(
+            std::stoul(range.substr(0, dash)));
+        unsigned const last = static_cast<unsigned>(
+            std::stoul(range.substr(dash + 1)));
+
+        for (unsigned cpu = first; cpu <= last; ++cpu) {
+          cpus.push_back(cpu);
+        }
+      }
+    } catch (std::exception const&) {
+      // Ignore malformed ranges
+    }
+  }
+
+  return cpus;
+}
+
+/// Returns the CPU sets of all NUMA nodes, or an empty vector
+/// if the topology is unknown on this platform.
+static std::vector<cpu_list_t> numa_nodes() {
+  std::vector<cpu_list_t> nodes;
+
+#ifdef __linux__
+  for (unsigned node = 0;; ++node) {
+    std::ifstream file(
+        format(FMT_STRING("/sys/devices/system/node/node{}/cpulist"), node));
+    if (!file) {
+      break;
+    }
+
+    std::string list;
+    std::getline(file, list);
+
+    cpu_list_t cpus = parse_cpu_list(list);
+    if (!cpus.empty()) {
+      nodes.push_back(std::move(cpus));
+    }
+  }
+#endif
+
+  return nodes;
+}
+
+/// Restricts the given thread to the CPUs of a NUMA node (best effort)
+static void pin_to(std::thread& thread, cpu_list_t const& cpus) noexcept {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (unsigned cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  (void)::pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+  (void)thread;
+  (void)cpus;
+#endif
+}
+
+struct TaskPoolWorker {
+  explicit TaskPoolWorker(std::size_t index_, std::size_t node_)
+    : index(index_)
+    , node(node_) {}
+
+  WorkStealingDeque<work*> deque;
+  std::size_t const index;
+  std::size_t const node;
+
+  /// The workers to steal from, ordered by locality
+  std::vector<TaskPoolWorker*> victims;
+
+  std::thread thread;
+};
+
+struct TaskPoolThisThread {
+  DefaultTaskPool const* pool{nullptr};
+  TaskPoolWorker* worker{nullptr};
+};
+
+static TaskPoolThisThread& task_pool_this_thread() noexcept {
+  static thread_local TaskPoolThisThread current;
+  return current;
+}
+
+class DefaultTaskPool final : public Implements<TaskPool> {
+public:
+  explicit DefaultTaskPool(Inheritance parent)
+    : Implements<TaskPool>(std::move(parent))
+    , concurrency_(std::max(1U, std::thread::hardware_concurrency())) {}
+
+  ~DefaultTaskPool() override {
+    IDLE_ASSERT(workers_.empty());
+    drain();
+  }
+
+  continuable<> onStart() override {
+    return async([this] {
+      std::vector<cpu_list_t> const nodes = numa_nodes();
+      std::size_t const count = concurrency_;
+      std::size_t const node_count = std::max(std::size_t(1U), nodes.size());
+
+      IDLE_ASSERT(workers_.empty());
+      workers_.reserve(count);
+      for (std::size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<TaskPoolWorker>(i, i % node_count));
+      }
+
+      // Steal from workers on the same node first, then from remote ones
+      for (auto& worker : workers_) {
+        for (std::size_t offset = 1; offset < count; ++offset) {
+          TaskPoolWorker& victim = *workers_[(worker->index + offset) % count];
+          if (victim.node == worker->node) {
+            worker->victims.push_back(&victim);
+          }
+        }
+        for (std::size_t offset = 1; offset < count; ++offset) {
+          TaskPoolWorker& victim = *workers_[(worker->index + offset) % count];
+          if (victim.node != worker->node) {
+            worker->victims.push_back(&victim);
+          }
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+      }
+      stopped_.store(false, std::memory_order_release);
+      running_.store(count, std::memory_order_release);
+
+      for (auto& worker : workers_) {
+        worker->thread = std::thread([this, current = worker.get()] {
+          run(*current);
+        });
+
+        if (nodes.size() > 1) {
+          pin_to(worker->thread, nodes[worker->node]);
+        }
+      }
+    });
+  }
+
+  continuable<> onStop() override {
+    return async([this] {
+             return make_continuable<void>([this](auto&& promise) mutable {
+               IDLE_ASSERT(root().is_on_event_loop());
+
+               {
+                 std::lock_guard<std::mutex> lock(mutex_);
+                 IDLE_ASSERT(!stopping_);
+                 stopping_ = true;
+                 joined_ = std::forward<decltype(promise)>(promise);
+               }
+
+               {
+                 std::lock_guard<std::mutex> lock(injected_mutex_);
+                 stopped_.store(true, std::memory_order_release);
+               }
+
+               wakeup_.notify_all();
+             });
+           })
+        .then(
+            [this] {
+              for (auto& worker : workers_) {
+                if (worker->thread.joinable()) {
+                  worker->thread.join();
+                }
+              }
+
+              drain();
+            },
+            root().event_loop().through_post());
+  }
+
+  std::size_t concurrency() const noexcept override {
+    return concurrency_;
+  }
+
+  bool isThisThread() const noexcept override {
+    return task_pool_this_thread().pool == this;
+  }
+
+protected:
+  void queue(work task) noexcept override {
+    TaskPoolThisThread const& current = task_pool_this_thread();
+    if (current.pool == this) {
+      // Workers are joined before the drain, thus work queued locally
+      // is either run by the worker itself or canceled by the drain.
+      if (stopped_.load(std::memory_order_acquire)) {
+        std::move(task).set_canceled();
+        return;
+      }
+
+      current.worker->deque.push(new work(std::move(task)));
+    } else {
+      std::unique_lock<std::mutex> lock(injected_mutex_);
+
+      // The stop is published under the same lock, such that no work
+      // can be injected after the drain took the injected queue.
+      if (stopped_.load(std::memory_order_relaxed)) {
+        lock.unlock();
+        std::move(task).set_canceled();
+        return;
+      }
+
+      injected_.push_back(new work(std::move(task)));
+      injected_size_.fetch_add(1U, std::memory_order_release);
+    }
+
+    epoch_.fetch_add(1U, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) != 0U) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      wakeup_.notify_one();
+    }
+  }
+
+private:
+  void run(TaskPoolWorker& self) {
+    set_this_thread_name(
+        format(FMT_STRING("idle::task_pool[{}]"), self.index));
+
+    TaskPoolThisThread& current = task_pool_this_thread();
+    current.pool = this;
+    current.worker = &self;
+
+    for (;;) {
+      std::uint64_t const epoch = epoch_.load(std::memory_order_seq_cst);
+
+      if (work* const task = find(self)) {
+        std::unique_ptr<work> owned(task);
+        std::move(*owned)();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (stopping_) {
+        break;
+      }
+
+      sleeping_.fetch_add(1U, std::memory_order_seq_cst);
+      wakeup_.wait(lock, [&] {
+        return stopping_ || epoch_.load(std::memory_order_seq_cst) != epoch;
+      });
+      sleeping_.fetch_sub(1U, std::memory_order_relaxed);
+    }
+
+    current = {};
+
+    auto const previous = running_.fetch_sub(1U, std::memory_order_acq_rel);
+    IDLE_ASSERT(previous != 0U);
+    if (previous == 1U) {
+      promise<> joined;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        joined = std::move(joined_);
+      }
+      joined.set_value();
+    }
+  }
+
+  work* find(TaskPoolWorker& self) noexcept {
+    work* task = nullptr;
+    if (self.deque.take(task)) {
+      return task;
+    }
+
+    if (injected_size_.load(std::memory_order_acquire) != 0U) {
+      std::lock_guard<std::mutex> lock(injected_mutex_);
+      if (!injected_.empty()) {
+        task = injected_.front();
+        injected_.pop_front();
+        injected_size_.fetch_sub(1U, std::memory_order_relaxed);
+        return task;
+      }
+    }
+
+    for (TaskPoolWorker* victim : self.victims) {
+      if (victim->deque.steal(task)) {
+        return task;
+      }
+    }
+
+    return nullptr;
+  }
+
+  /// Cancels all work that was not dispatched anymore
+  void drain() noexcept {
+    auto cancel = [](work* task) {
+      std::unique_ptr<work> owned(task);
+      std::move(*owned).set_canceled();
+    };
+
+    work* task = nullptr;
+    for (auto& worker : workers_) {
+      while (worker->deque.take(task)) {
+        cancel(task);
+      }
+    }
+    workers_.clear();
+
+    std::deque<work*> injected;
+    {
+      std::lock_guard<std::mutex> lock(injected_mutex_);
+      injected.swap(injected_);
+      injected_size_.store(0U, std::memory_order_relaxed);
+    }
+
+    for (work* current : injected) {
+      cancel(current);
+    }
+  }
+
+  std::size_t const concurrency_;
+  std::vector<std::unique_ptr<TaskPoolWorker>> workers_;
+
+  std::mutex injected_mutex_;
+  std::deque<work*> injected_;
+  std::atomic<std::size_t> injected_size_{0U};
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  bool stopping_{false};
+  promise<> joined_;
+
+  std::atomic<std::uint64_t> epoch_{0U};
+  std::atomic<std::size_t> sleeping_{0U};
+  std::atomic<std::size_t> running_{0U};
+  std::atomic<bool> stopped_{false};
+
+  IDLE_SERVICE
+};
+
+Ref<TaskPool> TaskPool::create(Inheritance parent) {
+  return spawn<DefaultTaskPool>(std::move(parent));
+}
+
+bool TaskPool::can_dispatch_inplace() const noexcept {
+  return isThisThread();
+}
+} // namespace idle
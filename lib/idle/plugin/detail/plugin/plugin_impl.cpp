@@ -23,7 +23,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <exception>
 #include <ostream>
+#include <string>
 #include <vector>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
@@ -35,18 +38,11 @@
 #include <idle/core/detail/log.hpp>
 #include <idle/core/platform.hpp>
 #include <idle/core/service.hpp>
+#include <idle/core/tracing.hpp>
 #include <idle/plugin/detail/plugin/plugin_impl.hpp>
 #include <idle/plugin/detail/shared_library.hpp>
 
 namespace idle {
-static optional<char const*> platform_debug_symbol_db_extension() {
-#ifdef _WIN32
-  return "pdb";
-#else
-  return nullopt;
-#endif
-}
-
 continuable<> PluginSourceImpl::onStart() {
   return async([this] {
     IDLE_ASSERT(loaded_modules_.empty());
@@ -82,12 +78,178 @@ Ref<Plugin> PluginSourceImpl::load_impl(PluginPaths paths,
   IDLE_ASSERT(root().is_on_event_loop());
   IDLE_ASSERT(state().isRunning());
 
+  return spawn_staged(stage(std::move(paths)), generation);
+}
+
+/// Returns the normalized name of the module at the given path
+static std::string module_name_of(std::string const& path) {
+  std::string name = boost::filesystem::path(path).filename().generic_string();
+  detail::shared_library::normalize_name(name);
+  return name;
+}
+
+/// Orders the staged plugins such that every plugin is placed after
+/// the plugins of the same batch it links against.
+static void order_by_dependencies(std::vector<StagedPlugin>& staged) {
+  std::vector<std::string> names;
+  names.reserve(staged.size());
+  for (StagedPlugin const& current : staged) {
+    names.push_back(module_name_of(current.paths.path));
+  }
+
+  auto const depends_on = [&](std::size_t dependent, std::size_t dependency) {
+    for (std::string imported : staged[dependent].info.imported_libraries) {
+      detail::shared_library::normalize_name(imported);
+      if (imported == names[dependency]) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::vector<StagedPlugin> ordered;
+  ordered.reserve(staged.size());
+  std::vector<bool> placed(staged.size(), false);
+
+  while (ordered.size() != staged.size()) {
+    std::size_t const previous = ordered.size();
+
+    for (std::size_t i = 0; i < staged.size(); ++i) {
+      if (placed[i]) {
+        continue;
+      }
+
+      bool ready = true;
+      for (std::size_t j = 0; j < staged.size(); ++j) {
+        if (!placed[j] && (i != j) && depends_on(i, j)) {
+          ready = false;
+          break;
+        }
+      }
+
+      if (ready) {
+        placed[i] = true;
+        ordered.push_back(std::move(staged[i]));
+      }
+    }
+
+    if (previous == ordered.size()) {
+      // The remaining plugins link against each other cyclically,
+      // keep their original order since there is no better one.
+      for (std::size_t i = 0; i < staged.size(); ++i) {
+        if (!placed[i]) {
+          placed[i] = true;
+          ordered.push_back(std::move(staged[i]));
+        }
+      }
+    }
+  }
+
+  staged = std::move(ordered);
+}
+
+namespace detail {
+void unique_batch(std::vector<PluginPaths>& batch) {
+  // Staging the same plugin twice would copy it concurrently into the same
+  // cache path and create two plugins for it.
+  std::vector<PluginPaths> unique;
+  unique.reserve(batch.size());
+  for (PluginPaths& paths : batch) {
+    auto const itr = std::find_if(unique.begin(), unique.end(),
+                                  [&](PluginPaths const& current) {
+                                    return current.path == paths.path;
+                                  });
+    if (itr == unique.end()) {
+      unique.push_back(std::move(paths));
+    } else {
+      IDLE_DETAIL_LOG_DEBUG("Skipping plugin '{}' given twice", paths.path);
+    }
+  }
+
+  batch = std::move(unique);
+}
+
+optional<StagedPlugin> try_stage(PluginPaths paths) noexcept {
+  boost::system::error_code ec;
+  if (!boost::filesystem::exists(paths.path, ec)) {
+    IDLE_DETAIL_LOG_ERROR("Plugin '{}' was removed before it was loaded!",
+                          paths.path);
+    return {};
+  }
+
+  std::string const path = paths.path;
+  try {
+    return PluginSourceImpl::stage(std::move(paths));
+  } catch (std::exception const& e) {
+    IDLE_DETAIL_LOG_ERROR("Failed to stage plugin '{}' ({}).", path,
+                          e.what());
+    (void)e;
+    (void)path;
+    return {};
+  }
+}
+
+std::vector<StagedPlugin>
+order_batch(std::vector<optional<StagedPlugin>> staged) {
+  std::vector<StagedPlugin> ordered;
+  ordered.reserve(staged.size());
+  for (optional<StagedPlugin>& current : staged) {
+    if (current) {
+      ordered.push_back(std::move(*current));
+    }
+  }
+
+  order_by_dependencies(ordered);
+  return ordered;
+}
+} // namespace detail
+
+continuable<std::vector<Ref<Plugin>>>
+PluginSourceImpl::load_batch_impl(std::vector<PluginPaths> batch,
+                                  Plugin::Generation generation) {
+  IDLE_ASSERT(root().is_on_event_loop());
+  IDLE_ASSERT(state().isRunning());
+
+  detail::unique_batch(batch);
+
+  IDLE_DETAIL_LOG_DEBUG("Staging {} plugins concurrently", batch.size());
+
+  std::vector<continuable<optional<StagedPlugin>>> staging;
+  staging.reserve(batch.size());
+  for (PluginPaths& paths : batch) {
+    staging.push_back(
+        thread_pool().async_post([paths = std::move(paths)]() mutable {
+          return detail::try_stage(std::move(paths));
+        }));
+  }
+
+  return when_all(std::move(staging))
+      .then(wrap(*this,
+                 [generation](std::vector<optional<StagedPlugin>> staged,
+                              auto&& me) {
+                   IDLE_ASSERT(me->root().is_on_event_loop());
+
+                   std::vector<StagedPlugin> ordered = detail::order_batch(
+                       std::move(staged));
+
+                   std::vector<Ref<Plugin>> plugins;
+                   plugins.reserve(ordered.size());
+                   for (StagedPlugin& current : ordered) {
+                     plugins.push_back(
+                         me->spawn_staged(std::move(current), generation));
+                   }
+                   return plugins;
+                 }),
+            root().event_loop().through_post());
+}
+
+StagedPlugin PluginSourceImpl::stage(PluginPaths paths) {
   IDLE_DETAIL_LOG_DEBUG("Loading plugin {}", paths.path);
 
   IDLE_ASSERT(!paths.path.empty());
   IDLE_ASSERT(boost::filesystem::exists(paths.path));
 
-  if (paths.cache_path) {
+  if (paths.cache_path && !paths.content_hash) {
     IDLE_DETAIL_LOG_DEBUG("Copying plugin '{}' to cache path '{}'", paths.path,
                           *paths.cache_path);
 
@@ -95,7 +257,7 @@ Ref<Plugin> PluginSourceImpl::load_impl(PluginPaths paths,
         paths.path, *paths.cache_path,
         boost::filesystem::copy_options::overwrite_existing);
 
-    if (auto ext = platform_debug_symbol_db_extension()) {
+    if (auto ext = detail::debug_symbol_db_extension()) {
       boost::filesystem::path debug_symbol_db(paths.path);
       debug_symbol_db.replace_extension(*ext);
 
@@ -111,9 +273,20 @@ Ref<Plugin> PluginSourceImpl::load_impl(PluginPaths paths,
     }
   }
 
+  StagedPlugin staged;
+  staged.info = detail::plugin_info::from(paths.library_location());
+  staged.paths = std::move(paths);
+  return staged;
+}
+
+Ref<Plugin> PluginSourceImpl::spawn_staged(StagedPlugin staged,
+                                           Plugin::Generation generation) {
+  IDLE_ASSERT(root().is_on_event_loop());
+
   Ref<PluginImpl> ptr = spawn<PluginImpl>(Inheritance(
                                               *static_cast<Collection*>(this)),
-                                          std::move(paths), generation);
+                                          std::move(staged.paths),
+                                          std::move(staged.info), generation);
   ptr->init();
   return std::move(ptr).cast<Plugin>();
 }
@@ -164,14 +337,15 @@ PluginContextImpl::~PluginContextImpl() {
   });
 }
 
-PluginImpl::PluginImpl(Inheritance inh, PluginPaths path, Generation generation)
+PluginImpl::PluginImpl(Inheritance inh, PluginPaths path,
+                       detail::plugin_info info, Generation generation)
   : Extends<Plugin, PluginRegistry>(std::move(inh))
   , id_(Id(plugin_id_of_path(path.path)))
   , singleton_(static_cast<Plugin&>(*this))
   , paths_(std::move(path))
   , generation_(generation)
   , handle_{}
-  , info_(detail::plugin_info::from(paths_.library_location())) {
+  , info_(std::move(info)) {
 
   IDLE_ASSERT(root().is_on_event_loop());
 
@@ -222,8 +396,18 @@ PluginImpl::~PluginImpl() {
 void PluginImpl::onDestroy() {
   boost::system::error_code ec;
 
+  // Artifacts of the content addressed cache can be accompanied by
+  // a reference to their object, which is removed together with them.
+  auto const remove = [&](std::string const& path) {
+    if (paths_.content_hash) {
+      detail::plugin_cache::remove(path, ec);
+    } else {
+      boost::filesystem::remove(path, ec);
+    }
+  };
+
   if (paths_.cache_path) {
-    boost::filesystem::remove(*paths_.cache_path, ec);
+    remove(*paths_.cache_path);
 
     if (ec) {
       IDLE_DETAIL_LOG_ERROR(
@@ -232,7 +416,7 @@ void PluginImpl::onDestroy() {
     }
   }
   if (paths_.cache_debug_db_path) {
-    boost::filesystem::remove(*paths_.cache_debug_db_path, ec);
+    remove(*paths_.cache_debug_db_path);
 
     if (ec) {
       IDLE_DETAIL_LOG_ERROR(
@@ -241,6 +425,18 @@ void PluginImpl::onDestroy() {
     }
   }
 
+  if (paths_.cache_path && paths_.content_hash) {
+    // Remove the generation of the cache if this was its last plugin,
+    // the unreferenced objects are reclaimed by the PluginLoader.
+    boost::filesystem::path const generation = boost::filesystem::path(
+                                                   *paths_.cache_path)
+                                                   .parent_path();
+
+    if (boost::filesystem::is_empty(generation, ec) && !ec) {
+      boost::filesystem::remove(generation, ec);
+    }
+  }
+
   Plugin::onDestroy();
 }
 
@@ -264,31 +460,49 @@ static bool isOnlyRunning(Interface& me) {
 
 continuable<> PluginImpl::onStart() {
   return async_on(
-      [this]() mutable {
-        IDLE_ASSERT(root().is_on_event_loop());
-        IDLE_DETAIL_LOG_DEBUG("Loading shared library {}", location_impl());
-
-        IDLE_ASSERT(isOnlyRunning(*this));
-
-        boost::system::error_code ec;
-        if (auto handle = detail::shared_library::load(
-                paths_.library_location().c_str(), ec)) {
-          handle_ = *handle;
-        } else {
-          IDLE_DETAIL_LOG_ERROR("Failed to load the plugin '{}' natively, real "
-                                "location: '{}'! ({})",
-                                paths_.path, paths_.library_location(),
-                                (ec.failed()) ? ec.message() : "no error code");
-
-          throw boost::system::error_code(ec);
-        }
-
-        Ref<PluginContextImpl> current = make_ref<PluginContextImpl>(
-            refOf(*this));
-        inject(*current);
-        plugin_context_ = RefCounter(std::move(current));
-      },
-      root().event_loop().through_post());
+             [this]() mutable {
+               IDLE_ASSERT(root().is_on_event_loop());
+               IDLE_ASSERT(isOnlyRunning(*this));
+             },
+             root().event_loop().through_post())
+      .then(
+          [this]() mutable {
+            // The shared library is loaded on the thread pool, such that
+            // independent plugins are loaded concurrently. Dependent plugins
+            // are started after their dependencies were started.
+            IDLE_DETAIL_LOG_DEBUG("Loading shared library {}", location_impl());
+
+            StringView const location = location_impl();
+            Tracing::Span const span = root().tracing().span(
+                Tracing::Category::Plugin, "dlopen",
+                location.substr(location.rfind('/') + 1U));
+
+            boost::system::error_code ec;
+            if (auto handle = detail::shared_library::load(
+                    paths_.library_location().c_str(), ec)) {
+              return *handle;
+            } else {
+              IDLE_DETAIL_LOG_ERROR(
+                  "Failed to load the plugin '{}' natively, real "
+                  "location: '{}'! ({})",
+                  paths_.path, paths_.library_location(),
+                  (ec.failed()) ? ec.message() : "no error code");
+
+              throw boost::system::error_code(ec);
+            }
+          },
+          parent().thread_pool().through_post())
+      .then(
+          [this](detail::shared_library::handle_t handle) mutable {
+            IDLE_ASSERT(root().is_on_event_loop());
+            handle_ = handle;
+
+            Ref<PluginContextImpl> current = make_ref<PluginContextImpl>(
+                refOf(*this));
+            inject(*current);
+            plugin_context_ = RefCounter(std::move(current));
+          },
+          root().event_loop().through_post());
 }
 
 continuable<> PluginImpl::onStop() {
@@ -312,6 +526,9 @@ continuable<> PluginImpl::onStop() {
             IDLE_DETAIL_LOG_DEBUG("Unloading shared library {}",
                                   location_impl());
 
+            Tracing::Span const span = root().tracing().span(
+                Tracing::Category::Plugin, "dlclose");
+
             IDLE_CHECK(detail::shared_library::unload(handle_));
 
             // TODO Maybe check if PDB is (exclusively) writeable to ensure the
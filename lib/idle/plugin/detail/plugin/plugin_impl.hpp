@@ -28,6 +28,9 @@
 
 #include <chrono>
 #include <memory>
+#include <vector>
+#include <idle/core/allocation_domain.hpp>
+#include <idle/core/api.hpp>
 #include <idle/core/dep/optional.hpp>
 #include <idle/core/detail/unordered_map.hpp>
 #include <idle/core/detail/unordered_set.hpp>
@@ -37,6 +40,7 @@
 #include <idle/core/util/string_view.hpp>
 #include <idle/core/util/upcastable.hpp>
 #include <idle/interface/io_context.hpp>
+#include <idle/plugin/detail/plugin_cache.hpp>
 #include <idle/plugin/detail/plugin_info.hpp>
 #include <idle/plugin/detail/shared_library.hpp>
 #include <idle/plugin/plugin.hpp>
@@ -47,6 +51,9 @@ struct PluginPaths {
   std::string path;
   optional<std::string> cache_path;
   optional<std::string> cache_debug_db_path;
+  /// Is set when the artifacts were already placed into the
+  /// content addressed cache by the PluginLoader.
+  optional<detail::content_hash_t> content_hash;
 
   std::string const& library_location() const noexcept {
     if (cache_path) {
@@ -57,6 +64,30 @@ struct PluginPaths {
   }
 };
 
+/// Represents a plugin whose files were copied into the cache and whose
+/// binary was inspected, which is safe to do outside of the event loop.
+struct StagedPlugin {
+  PluginPaths paths;
+  detail::plugin_info info;
+};
+
+namespace detail {
+/// Removes the plugins that are contained in the batch more than once,
+/// where the first occurrence is kept.
+IDLE_API(idle) void unique_batch(std::vector<PluginPaths>& batch);
+
+/// Stages the plugin, or returns an empty optional if it couldn't be staged,
+/// for instance because it was removed in the meantime.
+///
+/// \note This method is thread-safe.
+IDLE_API(idle) optional<StagedPlugin> try_stage(PluginPaths paths) noexcept;
+
+/// Drops the plugins that couldn't be staged and orders the remaining ones
+/// such that every plugin is placed after the plugins it links against.
+IDLE_API(idle) std::vector<StagedPlugin>
+order_batch(std::vector<optional<StagedPlugin>> staged);
+} // namespace detail
+
 class PluginSourceImpl final : public PluginSource,
                                public Upcastable<PluginSourceImpl> {
 public:
@@ -74,6 +105,23 @@ public:
 
   Ref<Plugin> load_impl(PluginPaths paths, Plugin::Generation generation);
 
+  /// Loads the given plugins, where the file staging happens concurrently
+  /// on the thread pool and only the creation of the plugins is
+  /// serialized on the event loop.
+  ///
+  /// The returned plugins are ordered such that a plugin is placed after
+  /// all plugins of the same batch it links against. Plugins given more
+  /// than once are loaded once, and plugins that couldn't be staged are
+  /// missing from the result without failing the rest of the batch.
+  continuable<std::vector<Ref<Plugin>>>
+  load_batch_impl(std::vector<PluginPaths> batch,
+                  Plugin::Generation generation);
+
+  /// Copies the plugin into its cache path and inspects its binary
+  ///
+  /// \note This method is thread-safe.
+  static StagedPlugin stage(PluginPaths paths);
+
   /// Returns true if the module could be sideloaded or is not needed
   bool sideloadModuleIfNeeded(std::string const& name);
 
@@ -99,6 +147,8 @@ public:
   }
 
 private:
+  Ref<Plugin> spawn_staged(StagedPlugin staged, Plugin::Generation generation);
+
   Component<Timer> timer_{*this};
   Dependency<IOContext> io_context_{*this};
 
@@ -139,7 +189,8 @@ class PluginImpl final : public Extends<Plugin, PluginRegistry>,
   friend class BundleImpl;
 
 public:
-  explicit PluginImpl(Inheritance inh, PluginPaths path, Generation generation);
+  explicit PluginImpl(Inheritance inh, PluginPaths path,
+                      detail::plugin_info info, Generation generation);
   virtual ~PluginImpl();
 
   void onDestroy() override;
@@ -188,6 +239,10 @@ public:
     return paths_.library_location();
   }
 
+  optional<detail::content_hash_t> const& content_hash_impl() const noexcept {
+    return paths_.content_hash;
+  }
+
   Collection& bundleCollection() noexcept {
     return static_cast<Plugin&>(*this);
   }
@@ -246,7 +301,8 @@ private:
 class BundleImpl final : public Bundle, public Upcastable<BundleImpl> {
 public:
   explicit BundleImpl(Inheritance parent)
-    : Bundle(std::move(parent)) {}
+    : Bundle(std::move(parent))
+    , domain_(AllocationDomain::create()) {}
 
   continuable<> onStart() override;
   continuable<> onStop() override;
@@ -261,11 +317,18 @@ public:
   PluginImpl& parent() noexcept;
   PluginImpl const& parent() const noexcept;
 
+  /// The services of a bundle are allocated contiguously from its own domain
+  AllocationDomain* allocationDomain() const noexcept override {
+    return domain_.get();
+  }
+
   static Ref<Bundle> create_from(PluginImpl& plugin);
 
 private:
   void create_children();
   void destroy_children();
+
+  Ref<AllocationDomain> domain_;
 };
 } // namespace idle
 
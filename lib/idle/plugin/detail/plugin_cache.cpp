@@ -0,0 +1,537 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <idle/core/dep/format.hpp>
+#include <idle/core/detail/log.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/plugin/detail/plugin_cache.hpp>
+
+namespace idle {
+namespace detail {
+static constexpr char const* reference_extension = ".object";
+static constexpr char const* lock_extension = ".lock";
+
+optional<char const*> debug_symbol_db_extension() noexcept {
+#ifdef _WIN32
+  return "pdb";
+#else
+  return nullopt;
+#endif
+}
+
+// Implements the XXH64 hash based on:
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+//
+// xxHash is licensed under the BSD 2-Clause License,
+// Copyright (c) 2012-2021 Yann Collet
+class xxh64 {
+  static constexpr std::uint64_t prime1 = 11400714785074694791ULL;
+  static constexpr std::uint64_t prime2 = 14029467366897019727ULL;
+  static constexpr std::uint64_t prime3 = 1609587929392839161ULL;
+  static constexpr std::uint64_t prime4 = 9650029242287828579ULL;
+  static constexpr std::uint64_t prime5 = 2870177450012600261ULL;
+
+public:
+  explicit xxh64(std::uint64_t seed = 0) noexcept
+    : acc_{seed + prime1 + prime2, seed + prime2, seed, seed - prime1}
+    , seed_(seed) {}
+
+  void update(unsigned char const* data, std::size_t size) noexcept {
+    total_ += size;
+
+    if (buffered_ + size < stripe) {
+      std::memcpy(buffer_.data() + buffered_, data, size);
+      buffered_ += size;
+      return;
+    }
+
+    if (buffered_ != 0) {
+      std::size_t const fill = stripe - buffered_;
+      std::memcpy(buffer_.data() + buffered_, data, fill);
+      consume(buffer_.data());
+      data += fill;
+      size -= fill;
+      buffered_ = 0;
+    }
+
+    for (; size >= stripe; data += stripe, size -= stripe) {
+      consume(data);
+    }
+
+    std::memcpy(buffer_.data(), data, size);
+    buffered_ = size;
+  }
+
+  std::uint64_t digest() const noexcept {
+    std::uint64_t hash;
+    if (total_ >= stripe) {
+      hash = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) +
+             rotl(acc_[3], 18);
+
+      for (std::uint64_t const acc : acc_) {
+        hash = merge(hash, acc);
+      }
+    } else {
+      hash = seed_ + prime5;
+    }
+
+    hash += total_;
+
+    unsigned char const* data = buffer_.data();
+    std::size_t size = buffered_;
+
+    for (; size >= 8; data += 8, size -= 8) {
+      hash ^= round(0, read64(data));
+      hash = rotl(hash, 27) * prime1 + prime4;
+    }
+
+    if (size >= 4) {
+      hash ^= static_cast<std::uint64_t>(read32(data)) * prime1;
+      hash = rotl(hash, 23) * prime2 + prime3;
+      data += 4;
+      size -= 4;
+    }
+
+    for (; size > 0; ++data, --size) {
+      hash ^= (*data) * prime5;
+      hash = rotl(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+
+private:
+  static constexpr std::size_t stripe = 32;
+
+  static std::uint64_t rotl(std::uint64_t value, unsigned bits) noexcept {
+    return (value << bits) | (value >> (64 - bits));
+  }
+
+  static std::uint64_t read64(unsigned char const* data) noexcept {
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  static std::uint32_t read32(unsigned char const* data) noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  static std::uint64_t round(std::uint64_t acc, std::uint64_t input) noexcept {
+    acc += input * prime2;
+    acc = rotl(acc, 31);
+    return acc * prime1;
+  }
+
+  static std::uint64_t merge(std::uint64_t hash, std::uint64_t acc) noexcept {
+    hash ^= round(0, acc);
+    return hash * prime1 + prime4;
+  }
+
+  void consume(unsigned char const* data) noexcept {
+    for (std::uint64_t& acc : acc_) {
+      acc = round(acc, read64(data));
+      data += 8;
+    }
+  }
+
+  std::array<std::uint64_t, 4> acc_;
+  std::uint64_t seed_;
+  std::uint64_t total_{0};
+  std::array<unsigned char, stripe> buffer_;
+  std::size_t buffered_{0};
+};
+
+content_hash_t hash_content(void const* data, std::size_t size,
+                            std::uint64_t seed) noexcept {
+  xxh64 hash(seed);
+  hash.update(static_cast<unsigned char const*>(data), size);
+  return hash.digest();
+}
+
+content_hash_t hash_file_content(boost::filesystem::path const& file) {
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if (!in.is_open()) {
+    throw boost::filesystem::filesystem_error(
+        "Failed to open the file for hashing", file,
+        boost::system::errc::make_error_code(
+            boost::system::errc::no_such_file_or_directory));
+  }
+
+  xxh64 hash;
+  std::array<char, 64 * 1024> buffer;
+  while (in) {
+    in.read(buffer.data(), buffer.size());
+    hash.update(reinterpret_cast<unsigned char const*>(buffer.data()),
+                static_cast<std::size_t>(in.gcount()));
+  }
+  return hash.digest();
+}
+
+/// The names of the sessions owned by this process
+///
+/// A process never conflicts with its own file locks and closing any
+/// handle to a locked file could release the lock, thus the own sessions
+/// are never probed through their lock.
+struct owned_sessions {
+  std::mutex mutex;
+  std::unordered_set<std::string> names;
+};
+
+static owned_sessions& this_process_sessions() {
+  static owned_sessions sessions;
+  return sessions;
+}
+
+static bool is_owned_session(std::string const& name) {
+  owned_sessions& owned = this_process_sessions();
+  std::lock_guard<std::mutex> lock(owned.mutex);
+  return owned.names.count(name) != 0U;
+}
+
+struct plugin_cache::session {
+  explicit session(std::string name_)
+    : name(std::move(name_)) {
+    owned_sessions& owned = this_process_sessions();
+    std::lock_guard<std::mutex> guard(owned.mutex);
+    owned.names.insert(name);
+  }
+  ~session() {
+    owned_sessions& owned = this_process_sessions();
+    std::lock_guard<std::mutex> guard(owned.mutex);
+    owned.names.erase(name);
+  }
+
+  session(session const&) = delete;
+  session& operator=(session const&) = delete;
+
+  std::string const name;
+  boost::interprocess::file_lock lock;
+};
+
+void plugin_cache::open() {
+  IDLE_ASSERT(!directory_.empty());
+  IDLE_ASSERT(!session_);
+
+  boost::filesystem::create_directories(directory_);
+
+  for (;;) {
+    auto current = std::make_shared<session>(
+        boost::filesystem::unique_path("%%%%%%%%%%%%%%%%").string());
+
+    boost::filesystem::path const lock_file = lock_of(current->name);
+    {
+      std::ofstream create(lock_file.c_str(),
+                           std::ios::app | std::ios::binary);
+      if (!create.is_open()) {
+        throw boost::filesystem::filesystem_error(
+            "Failed to create the plugin cache lock", lock_file,
+            boost::system::errc::make_error_code(
+                boost::system::errc::io_error));
+      }
+    }
+
+    current->lock = boost::interprocess::file_lock(lock_file.c_str());
+    if (!current->lock.try_lock()) {
+      continue;
+    }
+
+    // A concurrent reclamation could have removed the lock file
+    // between its creation and the lock, the session is unguarded then.
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(lock_file, ec)) {
+      continue;
+    }
+
+    boost::filesystem::create_directories(directory_ / current->name);
+
+    IDLE_DETAIL_LOG_DEBUG("Claimed the plugin cache session '{}'",
+                          (directory_ / current->name).generic_string());
+
+    session_ = std::move(current);
+    return;
+  }
+}
+
+boost::filesystem::path
+plugin_cache::generation_of(std::size_t generation) const {
+  IDLE_ASSERT(session_);
+  return directory_ / session_->name /
+         format(FMT_STRING("{}"), generation);
+}
+
+void plugin_cache::place(boost::filesystem::path const& artifact,
+                         content_hash_t hash,
+                         boost::filesystem::path const& target) const {
+  IDLE_ASSERT(!directory_.empty());
+
+  boost::filesystem::path const dir = objects();
+  boost::filesystem::create_directories(dir);
+
+  boost::filesystem::path const object = dir /
+                                         format(FMT_STRING("{:016x}{}"), hash,
+                                                artifact.extension().string());
+
+  // Generations are created lazily by their first artifact
+  boost::filesystem::create_directories(target.parent_path());
+
+  boost::system::error_code ec;
+  for (unsigned attempt = 0;; ++attempt) {
+    if (!boost::filesystem::exists(object, ec)) {
+      IDLE_DETAIL_LOG_DEBUG("Copying '{}' to the plugin cache object '{}'",
+                            artifact.generic_string(),
+                            object.generic_string());
+
+      // Copy to a temporary file first, such that the object is never
+      // observed partially written when it is placed concurrently.
+      boost::filesystem::path const temporary =
+          dir / boost::filesystem::unique_path("%%%%-%%%%-%%%%.tmp");
+
+      boost::filesystem::copy_file(artifact, temporary);
+      boost::filesystem::rename(temporary, object);
+    } else {
+      IDLE_DETAIL_LOG_DEBUG("Reusing the plugin cache object '{}' for '{}'",
+                            object.generic_string(),
+                            artifact.generic_string());
+    }
+
+    boost::filesystem::remove(target, ec);
+    boost::filesystem::create_hard_link(object, target, ec);
+    if (!ec) {
+      return;
+    }
+
+    // The object could have been collected by another process sharing
+    // the cache in the meantime, place it again in this case.
+    boost::system::error_code error;
+    if ((attempt < 2U) && !boost::filesystem::exists(object, error)) {
+      continue;
+    }
+    break;
+  }
+
+  // Hard links are not supported on every file system
+  IDLE_DETAIL_LOG_DEBUG("Failed to link '{}' to '{}' ('{}'), copying it.",
+                        object.generic_string(), target.generic_string(),
+                        ec.message());
+
+  // The artifact is copied instead of the object, which has the same
+  // content but could be collected concurrently.
+  boost::filesystem::copy_file(
+      artifact, target, boost::filesystem::copy_options::overwrite_existing);
+
+  // The copy doesn't raise the link count of the object,
+  // thus the reference is recorded next to the copy.
+  std::ofstream reference(reference_of(target).c_str(),
+                          std::ios::trunc | std::ios::binary);
+  reference << object.filename().generic_string();
+}
+
+void plugin_cache::remove(boost::filesystem::path const& target,
+                          boost::system::error_code& ec) noexcept {
+  boost::system::error_code error;
+  boost::filesystem::remove(reference_of(target), error);
+
+  boost::filesystem::remove(target, ec);
+}
+
+/// Collects the objects which are referenced by copies inside a generation
+static void
+collect_references(boost::filesystem::path const& generation,
+                   std::unordered_set<std::string>& referenced) noexcept {
+  boost::system::error_code error;
+  for (boost::filesystem::directory_iterator entry(generation, error), last;
+       !error && (entry != last); entry.increment(error)) {
+
+    boost::filesystem::path const& reference = entry->path();
+    if (reference.extension() != reference_extension) {
+      continue;
+    }
+
+    boost::system::error_code removed;
+    boost::filesystem::path target = reference;
+    target.replace_extension();
+
+    if (boost::filesystem::exists(target, removed)) {
+      std::ifstream in(reference.c_str(), std::ios::binary);
+      std::string object;
+      if (std::getline(in, object) && !object.empty()) {
+        referenced.insert(std::move(object));
+      }
+    } else {
+      // The copy was removed without its reference
+      boost::filesystem::remove(reference, removed);
+    }
+  }
+}
+
+std::uintmax_t plugin_cache::collect() const noexcept {
+  IDLE_ASSERT(!directory_.empty());
+
+  boost::system::error_code ec;
+  boost::system::error_code error;
+  std::uintmax_t reclaimed = 0;
+
+  // The objects which are referenced by copies inside a generation
+  std::unordered_set<std::string> referenced;
+
+  boost::filesystem::path const objects_dir = objects();
+  for (boost::filesystem::directory_iterator itr(directory_, ec), end;
+       !ec && (itr != end); itr.increment(ec)) {
+
+    boost::filesystem::path const& current = itr->path();
+    if ((current == objects_dir) ||
+        !boost::filesystem::is_directory(current, error)) {
+      continue;
+    }
+
+    // Generations of other sessions are still created and removed
+    // by their owners, thus only the own ones are removed here.
+    bool const is_own = session_ &&
+                        (current.filename().string() == session_->name);
+
+    for (boost::filesystem::directory_iterator entry(current, error), last;
+         !error && (entry != last); entry.increment(error)) {
+
+      boost::filesystem::path const& dir = entry->path();
+      boost::system::error_code status;
+      if (!boost::filesystem::is_directory(dir, status)) {
+        continue;
+      }
+
+      collect_references(dir, referenced);
+
+      // Generations are empty after all of their plugins were destroyed
+      if (is_own && boost::filesystem::is_empty(dir, status) && !status) {
+        boost::filesystem::remove(dir, status);
+      }
+    }
+    error.clear();
+  }
+
+  ec.clear();
+  for (boost::filesystem::directory_iterator itr(objects_dir, ec), end;
+       !ec && (itr != end); itr.increment(ec)) {
+
+    boost::filesystem::path const& object = itr->path();
+    if (referenced.count(object.filename().generic_string())) {
+      continue;
+    }
+
+    // The object is unreferenced if it is only linked from the store itself
+    std::uintmax_t const links = boost::filesystem::hard_link_count(object,
+                                                                    error);
+    if (error || (links > 1)) {
+      continue;
+    }
+
+    std::uintmax_t const size = boost::filesystem::file_size(object, error);
+    if (boost::filesystem::remove(object, error) && !error) {
+      IDLE_DETAIL_LOG_TRACE("Reclaimed plugin cache object '{}'",
+                            object.generic_string());
+      reclaimed += size;
+    }
+  }
+
+  IDLE_DETAIL_LOG_DEBUG("Reclaimed {} bytes from the plugin cache '{}'",
+                        reclaimed, directory_.generic_string());
+  return reclaimed;
+}
+
+void plugin_cache::clear_abandoned() const noexcept {
+  IDLE_ASSERT(!directory_.empty());
+
+  boost::system::error_code ec;
+  boost::system::error_code error;
+
+  boost::filesystem::path const objects_dir = objects();
+  for (boost::filesystem::directory_iterator itr(directory_, ec), end;
+       !ec && (itr != end); itr.increment(ec)) {
+
+    boost::filesystem::path const& current = itr->path();
+    std::string const name = current.stem().string();
+    if ((current == objects_dir) || is_owned_session(name)) {
+      continue;
+    }
+
+    if (current.extension() == lock_extension) {
+      try {
+        // The lock is held by the owning process until it has exited
+        boost::interprocess::file_lock lock(current.string().c_str());
+        if (!lock.try_lock()) {
+          continue;
+        }
+
+        IDLE_DETAIL_LOG_DEBUG("Removing the abandoned plugin cache session "
+                              "'{}'",
+                              (directory_ / name).generic_string());
+
+        boost::filesystem::remove_all(directory_ / name, error);
+        boost::filesystem::remove(current, error);
+      } catch (boost::interprocess::interprocess_exception const&) {
+        continue;
+      }
+    } else if (boost::filesystem::is_directory(current, error) &&
+               !boost::filesystem::exists(lock_of(current.filename().string()),
+                                          error)) {
+      // Sessions are locked before their directory is created, thus
+      // a directory without a lock is a leftover which is unowned.
+      boost::filesystem::remove_all(current, error);
+    }
+  }
+}
+
+boost::filesystem::path plugin_cache::objects() const {
+  return directory_ / "objects";
+}
+
+boost::filesystem::path plugin_cache::lock_of(std::string const& name) const {
+  return directory_ / (name + lock_extension);
+}
+
+boost::filesystem::path
+plugin_cache::reference_of(boost::filesystem::path const& target) {
+  boost::filesystem::path reference = target;
+  reference += reference_extension;
+  return reference;
+}
+} // namespace detail
+} // namespace idle
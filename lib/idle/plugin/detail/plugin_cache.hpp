@@ -0,0 +1,119 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_PLUGIN_DETAIL_PLUGIN_CACHE_HPP_INCLUDED
+#define IDLE_PLUGIN_DETAIL_PLUGIN_CACHE_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <boost/filesystem/path.hpp>
+#include <boost/system/error_code.hpp>
+#include <idle/core/api.hpp>
+#include <idle/core/dep/optional.hpp>
+
+namespace idle {
+namespace detail {
+using content_hash_t = std::uint64_t;
+
+/// Returns the extension of the debug symbol database which is placed
+/// next to shared libraries on the current platform, if any.
+optional<char const*> debug_symbol_db_extension() noexcept;
+
+/// Returns the XXH64 hash of the given content
+IDLE_API(idle)
+content_hash_t hash_content(void const* data, std::size_t size,
+                            std::uint64_t seed = 0) noexcept;
+
+/// Returns the XXH64 hash of the content of the given file
+IDLE_API(idle)
+content_hash_t hash_file_content(boost::filesystem::path const& file);
+
+/// A content addressed store for the artifacts inside the plugin cache
+///
+/// Every distinct content is copied only once into
+/// `<directory>/objects/<hash><extension>`. The cache paths of a generation
+/// which are actually loaded are hard links to these objects, thus an object
+/// becomes unreferenced as soon as all plugins using it were destroyed.
+/// On file systems without hard links the artifact is copied instead and
+/// the object it was copied from is recorded in a `<target>.object` file.
+///
+/// The cache directory can be shared between processes, every process
+/// places its generations into its own session `<directory>/<session>`
+/// which is guarded by the file lock `<directory>/<session>.lock`.
+/// Sessions are only reclaimed after the process owning them has exited.
+class IDLE_API(idle) plugin_cache {
+public:
+  plugin_cache() = default;
+  explicit plugin_cache(boost::filesystem::path directory)
+    : directory_(std::move(directory)) {}
+
+  /// Creates the cache directory and claims a new session inside of it,
+  /// the session is owned until all copies of this cache were destroyed.
+  void open();
+
+  /// Returns the directory of the given generation inside the session
+  boost::filesystem::path generation_of(std::size_t generation) const;
+
+  /// Places the given artifact with the given content hash at target,
+  /// the artifact is copied only if its content is not present yet.
+  void place(boost::filesystem::path const& artifact, content_hash_t hash,
+             boost::filesystem::path const& target) const;
+
+  /// Removes an artifact which was placed at target
+  static void remove(boost::filesystem::path const& target,
+                     boost::system::error_code& ec) noexcept;
+
+  /// Removes all objects which are not referenced from a generation of any
+  /// session anymore, as well as empty generation directories of
+  /// the own session.
+  ///
+  /// \returns the amount of reclaimed bytes
+  std::uintmax_t collect() const noexcept;
+
+  /// Removes the sessions whose owning process has exited
+  void clear_abandoned() const noexcept;
+
+  boost::filesystem::path const& directory() const noexcept {
+    return directory_;
+  }
+
+private:
+  struct session;
+
+  boost::filesystem::path objects() const;
+  boost::filesystem::path lock_of(std::string const& name) const;
+  static boost::filesystem::path
+  reference_of(boost::filesystem::path const& target);
+
+  boost::filesystem::path directory_;
+  std::shared_ptr<session const> session_;
+};
+} // namespace detail
+} // namespace idle
+
+#endif // IDLE_PLUGIN_DETAIL_PLUGIN_CACHE_HPP_INCLUDED
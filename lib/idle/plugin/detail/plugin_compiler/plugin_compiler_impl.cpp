@@ -23,10 +23,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <regex>
 #include <streambuf>
 #include <string>
+#include <thread>
+#include <vector>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <fmt/color.h>
@@ -37,6 +41,7 @@
 #include <idle/core/detail/format_ext.hpp>
 #include <idle/core/detail/log.hpp>
 #include <idle/core/platform.hpp>
+#include <idle/core/tracing.hpp>
 #include <idle/core/use.hpp>
 #include <idle/core/util/assert.hpp>
 #include <idle/core/version.hpp>
@@ -69,6 +74,27 @@ static bool is_ninja_generator(std::string const& generator) noexcept {
   return generator.find("Ninja") != std::string::npos;
 }
 
+/// Returns the arguments that make the native build tool of the generator
+/// build independent targets and translation units in parallel.
+///
+/// Ninja builds in parallel by default, make is serial unless jobs are
+/// passed explicitly (`cmake --build --parallel` requires CMake 3.12).
+static std::vector<std::string>
+parallel_build_args(std::string const& generator) {
+  if (is_vs_generator(generator)) {
+    return {"/m"};
+  }
+
+  if ((generator.find("Unix Makefiles") != std::string::npos) ||
+      (generator.find("MinGW Makefiles") != std::string::npos) ||
+      (generator.find("MSYS Makefiles") != std::string::npos)) {
+    unsigned const jobs = std::max(1U, std::thread::hardware_concurrency());
+    return {format(FMT_STRING("-j{}"), jobs)};
+  }
+
+  return {};
+}
+
 #ifdef IDLE_PLATFORM_WINDOWS
 static std::string const vcvarsall_bat_path =
     "C:\\Program Files (x86)\\Microsoft Visual "
@@ -251,27 +277,62 @@ continuable<> PluginCompilerImpl::generate_impl() {
                   root().event_loop().through_post());
 }
 
-continuable<> PluginCompilerImpl::build_impl(std::string target) {
+continuable<>
+PluginCompilerImpl::build_impl(std::vector<std::string> targets) {
+  IDLE_ASSERT(!targets.empty());
+
   return async_on(
       wrap(*this,
-           [target = std::move(target)](auto&& me) mutable {
+           [targets = std::move(targets)](auto&& me) mutable {
              IDLE_ASSERT(!me->config_.cmake_exe.empty());
 
-             IDLE_LOG_INFO(me->log_, "Building target {}", target);
+             IDLE_LOG_INFO(me->log_, "Building target {}",
+                           fmt::join(targets, ", "));
 
              IDLE_DETAIL_LOG_DEBUG(
-                 "Building target {} from cmake build dir '{}'...", target,
-                 me->config_.build_dir);
+                 "Building target {} from cmake build dir '{}'...",
+                 fmt::join(targets, ", "), me->config_.build_dir);
 
              auto activity = me->activities_->add(
                  fmt::format(FMT_STRING("Building {}"), //
-                             target));
-
-             std::vector<std::string> args{"--build", me->config_.build_dir,
-                                           "--target", std::move(target)};
-
-             if (me->is_config_generator_ && !me->config_.build_type.empty()) {
-               args.insert(args.end(), {"--config", me->config_.build_type});
+                             fmt::join(targets, ", ")));
+             auto span = me->root().tracing().span(
+                 Tracing::Category::Compiler, "build", activity->name());
+
+             // CMake accepts multiple --target arguments only since 3.15,
+             // thus multiple targets are passed to the native build tool
+             // directly, which schedules their compilation in parallel.
+             // Multi-config generators build one target per invocation.
+             std::vector<std::string> const parallel = parallel_build_args(
+                 me->config_.generator);
+
+             std::vector<std::vector<std::string>> invocations;
+             if (targets.size() == 1 || me->is_config_generator_) {
+               for (std::string& target : targets) {
+                 std::vector<std::string> args{"--build",
+                                               me->config_.build_dir,
+                                               "--target", std::move(target)};
+
+                 if (me->is_config_generator_ &&
+                     !me->config_.build_type.empty()) {
+                   args.insert(args.end(),
+                               {"--config", me->config_.build_type});
+                 }
+
+                 if (!parallel.empty()) {
+                   args.emplace_back("--");
+                   args.insert(args.end(), parallel.begin(), parallel.end());
+                 }
+
+                 invocations.push_back(std::move(args));
+               }
+             } else {
+               std::vector<std::string> args{"--build", me->config_.build_dir,
+                                             "--"};
+               args.insert(args.end(), parallel.begin(), parallel.end());
+               std::move(targets.begin(), targets.end(),
+                         std::back_inserter(args));
+               invocations.push_back(std::move(args));
              }
 
              SpawnOptions options;
@@ -279,12 +340,25 @@ continuable<> PluginCompilerImpl::build_impl(std::string target) {
              options.env_var = me->compiler_env_;
              IDLE_ASSERT(options.inherit_env);
 
-             return me->process_group_
-                 ->spawnProcessStreamed(me->config_.cmake_exe, std::move(args),
-                                        options, me->stream())
-                 .then([activity = std::move(activity)] {
-                   // Keep the activity valid
-                 });
+             // The invocations are spawned from the event loop only,
+             // the previous invocation could resolve on any thread.
+             continuable<> built = make_ready_continuable();
+             for (std::vector<std::string>& args : invocations) {
+               built = std::move(built).then(
+                   wrap(*me,
+                        [args = std::move(args), options](auto&& me) mutable {
+                          return me->process_group_->spawnProcessStreamed(
+                              me->config_.cmake_exe, std::move(args), options,
+                              me->stream());
+                        }),
+                   me->root().event_loop().through_post());
+             }
+
+             return std::move(built).then(
+                 [activity = std::move(activity), span = std::move(span)] {
+                   // Keep the activity and the span valid
+                 },
+                 me->root().event_loop().through_post());
            }),
       root().event_loop().through_post());
 }
@@ -293,10 +367,10 @@ continuable<> PluginCompilerImpl::build_install_impl() {
   return async(weakly(handleOf(*this), [](auto&& me) {
 #ifdef IDLE_PLATFORM_WINDOWS
     if (is_vs_generator(me->config_.generator)) {
-      return me->build_impl("INSTALL");
+      return me->build_impl({"INSTALL"});
     }
 #endif
-    return me->build_impl("install");
+    return me->build_impl({"install"});
   }));
 }
 
@@ -336,12 +410,15 @@ PluginCompilerImpl::install_component_impl(std::string component) {
              auto activity = me->activities_->add(
                  fmt::format(FMT_STRING("Installing {}"), //
                              component));
+             auto span = me->root().tracing().span(
+                 Tracing::Category::Compiler, "install", activity->name());
 
              return me->process_group_
                  ->spawnProcessStreamed(me->config_.cmake_exe, std::move(args),
                                         std::move(options), me->stream())
-                 .then([activity = std::move(activity)] {
-                   // Keep the activity valid
+                 .then([activity = std::move(activity),
+                        span = std::move(span)] {
+                   // Keep the activity and the span valid
                  });
            }),
       root().event_loop().through_post());
@@ -444,12 +521,14 @@ continuable<> PluginCompilerImpl::cmake_configure() {
   IDLE_ASSERT(options.inherit_env);
 
   auto activity = activities_->add("Configuring");
+  auto span = root().tracing().span(Tracing::Category::Compiler, "configure",
+                                    config_.build_dir);
 
   return process_group_
       ->spawnProcessStreamed(config_.cmake_exe, std::move(args),
                              std::move(options), stream())
-      .then([activity = std::move(activity)] {
-        // Keep the activity valid
+      .then([activity = std::move(activity), span = std::move(span)] {
+        // Keep the activity and the span valid
       });
 }
 
@@ -465,12 +544,14 @@ continuable<> PluginCompilerImpl::cmake_regenerate() {
   IDLE_ASSERT(options.inherit_env);
 
   auto activity = activities_->add("Regenerating");
+  auto span = root().tracing().span(Tracing::Category::Compiler, "regenerate",
+                                    config_.build_dir);
 
   return process_group_
       ->spawnProcessStreamed(config_.cmake_exe, {"."}, std::move(options),
                              stream())
-      .then([activity = std::move(activity)] {
-        // Keep the activity valid
+      .then([activity = std::move(activity), span = std::move(span)] {
+        // Keep the activity and the span valid
       });
 }
 
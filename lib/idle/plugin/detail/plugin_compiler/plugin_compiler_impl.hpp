@@ -27,6 +27,7 @@
 #define IDLE_PLUGIN_DETAIL_PLUGIN_COMPILER_PLUGIN_COMPILER_IMPL_HPP_INCLUDED
 
 #include <string>
+#include <vector>
 #include <boost/filesystem/path.hpp>
 #include <idle/core/parts/component.hpp>
 #include <idle/core/parts/dependency.hpp>
@@ -62,7 +63,7 @@ public:
 
   continuable<> generate_impl();
 
-  continuable<> build_impl(std::string target);
+  continuable<> build_impl(std::vector<std::string> targets);
   continuable<> build_install_impl();
   continuable<> install_component_impl(std::string component);
 
@@ -23,8 +23,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <array>
+#include <chrono>
 #include <exception>
 #include <memory>
+#include <utility>
 #include <boost/dll/runtime_symbol_info.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
@@ -34,7 +37,9 @@
 #include <idle/core/dep/format.hpp>
 #include <idle/core/detail/log.hpp>
 #include <idle/core/detail/when_completed.hpp>
+#include <idle/core/metrics.hpp>
 #include <idle/core/registry.hpp>
+#include <idle/core/tracing.hpp>
 #include <idle/core/util/assert.hpp>
 #include <idle/core/views/filter.hpp>
 #include <idle/core/views/transform.hpp>
@@ -92,6 +97,83 @@ static std::string default_cache_dir(Epoch epoch) noexcept {
       .generic_string();
 }
 
+/// Measures the phases of a single plugin reload and reports
+/// its progress through an Activity and a trace span per phase.
+class ReloadReport {
+public:
+  enum class Phase : std::uint8_t { stop, unload, load, start };
+
+  using clock_type = Metrics::clock_type;
+
+  explicit ReloadReport(ActivityHandle activity, Metrics& metrics,
+                        Tracing& tracing) noexcept
+    : activity_(std::move(activity))
+    , metrics_(metrics)
+    , tracing_(tracing)
+    , last_(clock_type::now()) {
+    trace(Phase::stop);
+  }
+
+  void complete(Phase phase) noexcept {
+    static constexpr std::array<Metrics::Distribution, 4> distributions{
+        Metrics::Distribution::ReloadStop, Metrics::Distribution::ReloadUnload,
+        Metrics::Distribution::ReloadLoad, Metrics::Distribution::ReloadStart};
+
+    auto const index = static_cast<std::size_t>(phase);
+    clock_type::time_point const now = clock_type::now();
+
+    durations_[index] = now - last_;
+    last_ = now;
+
+    metrics_.record(distributions[index], durations_[index]);
+
+    span_.end();
+    if (index + 1U < durations_.size()) {
+      trace(static_cast<Phase>(index + 1U));
+    }
+
+    activity_->update(static_cast<float>(index + 1U) / durations_.size());
+  }
+
+  auto elapsed(Phase phase) const noexcept {
+    return printable([this, phase](std::ostream& os) {
+      print(os, FMT_STRING("{}ms"),
+            as_millis(durations_[static_cast<std::size_t>(phase)]));
+    });
+  }
+
+  auto total() const noexcept {
+    return printable([this](std::ostream& os) {
+      clock_type::duration sum{};
+      for (clock_type::duration const& duration : durations_) {
+        sum += duration;
+      }
+      print(os, FMT_STRING("{}ms"), as_millis(sum));
+    });
+  }
+
+private:
+  static double as_millis(clock_type::duration duration) noexcept {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  }
+
+  void trace(Phase phase) noexcept {
+    static constexpr std::array<char const*, 4> names{
+        "reload_stop", "reload_unload", "reload_load", "reload_start"};
+
+    span_ = tracing_.span(Tracing::Category::Plugin,
+                          names[static_cast<std::size_t>(phase)],
+                          activity_->name());
+  }
+
+  ActivityHandle activity_;
+  Metrics& metrics_;
+  Tracing& tracing_;
+  Tracing::Span span_;
+  clock_type::time_point last_;
+  std::array<clock_type::duration, 4> durations_{};
+};
+
 void PluginHotswapImpl::onSetup() {
   if (config_.source_dir.empty()) {
     config_.source_dir = absolute(root_location() / "project").generic_string();
@@ -203,6 +285,8 @@ continuable<> PluginHotswapImpl::dispatch_op_eager(plugin_added const& op) {
   Bundle& current = *instance;
   bundles_.insert(std::make_pair(&parent, std::move(instance)));
 
+  outdated_ = true;
+
   return current.start();
 }
 
@@ -215,6 +299,9 @@ continuable<> PluginHotswapImpl::dispatch_op_eager(plugin_removed const& op) {
   IDLE_DETAIL_LOG_DEBUG("Removing plugin: {}", parent);
 
   bundles_.erase(&parent);
+
+  outdated_ = true;
+
   return parent.stop();
 }
 
@@ -232,6 +319,7 @@ continuable<> PluginHotswapImpl::dispatch_op_eager(plugin_modified const& op) {
 
   if (cast<Plugin>(interfaces.front()) != *op.to) {
     // The latest interface should always have the highest priority
+    outdated_ = true;
     return make_ready_continuable();
   }
 
@@ -239,28 +327,101 @@ continuable<> PluginHotswapImpl::dispatch_op_eager(plugin_modified const& op) {
   Ref<Bundle> instance = op.to->createBundle();
   bundles_.insert(std::make_pair(op.to.get(), instance));
 
-  if (auto other = interfaces.next()) {
-    return when_completed(other | views::transform([](Interface& inter) {
-                            IDLE_DETAIL_LOG_DEBUG("Stopping plugin {}",
-                                                  inter.owner());
-                            return inter.owner().stop();
-                          }))
-        .then(wrap(*this,
-                   [updated = op.to.weak()](auto&& impl) -> continuable<> {
-                     if (auto current = updated.lock()) {
-                       auto const itr = impl->bundles_.find(current.get());
-                       if (itr != impl->bundles_.end()) {
-                         IDLE_DETAIL_LOG_DEBUG("Starting plugin bundle {}",
-                                               *itr->second);
-                         return itr->second->start();
-                       }
-                     }
-                     return make_ready_continuable();
-                   }),
-              root().event_loop().through_post());
-  } else {
-    return instance->start();
+  // Only the dependents of the swapped plugins are restarted after the
+  // swap instead of updating the whole system.
+  std::vector<WeakRef<Service>> origins{
+      weakOf(static_cast<Service&>(*op.to)),
+      weakOf(static_cast<Service&>(*instance))};
+
+  std::vector<continuable<>> stops;
+  std::vector<WeakRef<Service>> unloads;
+  for (Interface& inter : interfaces.next()) {
+    Plugin& outdated = cast<Plugin>(inter);
+    for (Bundle& bundle : outdated.bundles()) {
+      IDLE_DETAIL_LOG_DEBUG("Stopping plugin bundle {}", bundle);
+      stops.push_back(bundle.stop());
+    }
+
+    unloads.push_back(weakOf(inter.owner()));
+    origins.push_back(weakOf(inter.owner()));
   }
+
+  using Phase = ReloadReport::Phase;
+  auto report = make_ref<ReloadReport>(
+      activities_->add(format(FMT_STRING("Reloading {}"), *op.to)),
+      root().metrics(), root().tracing());
+
+  // Services of the outgoing generation record their state on stop,
+  // the incoming generation restores it before it is started.
+  // The window is closed when the reload has completed or was cancelled.
+  StateHandoff::Window window = handoff_->open();
+
+  return detail::when_completed(std::move(stops))
+      .then(wrap(*this,
+                 [report, unloads = std::move(unloads)](auto&&) mutable {
+                   report->complete(Phase::stop);
+
+                   std::vector<continuable<>> stopped;
+                   for (WeakRef<Service> const& weak : unloads) {
+                     if (auto current = weak.lock()) {
+                       IDLE_DETAIL_LOG_DEBUG("Stopping plugin {}", *current);
+                       stopped.push_back(current->stop());
+                     }
+                   }
+                   return detail::when_completed(std::move(stopped));
+                 }),
+            root().event_loop().through_post())
+      .then(wrap(*this,
+                 [report, updated = weakOf(*op.to)](auto&&) -> continuable<> {
+                   report->complete(Phase::unload);
+
+                   if (auto current = updated.lock()) {
+                     IDLE_DETAIL_LOG_DEBUG("Loading plugin {}", *current);
+                     return current->start();
+                   }
+                   return make_ready_continuable();
+                 }),
+            root().event_loop().through_post())
+      .then(wrap(*this,
+                 [report, updated = weakOf(*op.to),
+                  origins = std::move(origins)](auto&& me) mutable {
+                   report->complete(Phase::load);
+
+                   continuable<> started = make_ready_continuable();
+                   if (auto current = updated.lock()) {
+                     auto const itr = me->bundles_.find(current.get());
+                     if (itr != me->bundles_.end()) {
+                       IDLE_DETAIL_LOG_DEBUG("Starting plugin bundle {}",
+                                             *itr->second);
+                       started = itr->second->start();
+                     }
+                   }
+
+                   return std::move(started).then(
+                       [root = refOf(me->root()),
+                        origins = std::move(origins)]() mutable {
+                         return root->update(std::move(origins));
+                       });
+                 }),
+            root().event_loop().through_post())
+      .then(wrap(*this,
+                 [report, updated = weakOf(*op.to),
+                  window = std::move(window)](auto&& me) mutable {
+                   report->complete(Phase::start);
+                   window.reset();
+
+                   if (auto current = updated.lock()) {
+                     IDLE_LOG_INFO(me->log_,
+                                   "Reloaded {} in {} (stop: {}, unload: {}, "
+                                   "load: {}, start: {})",
+                                   *current, report->total(),
+                                   report->elapsed(Phase::stop),
+                                   report->elapsed(Phase::unload),
+                                   report->elapsed(Phase::load),
+                                   report->elapsed(Phase::start));
+                   }
+                 }),
+            root().event_loop().through_post());
 }
 
 continuable<> PluginHotswapImpl::watch_plugins_and_reload_loop() {
@@ -322,7 +483,14 @@ continuable<> PluginHotswapImpl::watch_plugins_and_reload_loop() {
                    }),
               me->root().event_loop().through_post())
         .then(wrap(*me,
-                   [](auto&& me) {
+                   [](auto&& me) -> continuable<> {
+                     if (!std::exchange(me->outdated_, false)) {
+                       // Modified plugins already restarted their dependents
+                       IDLE_DETAIL_LOG_TRACE(
+                           "Skipping the system update after plugin changes");
+                       return make_ready_continuable();
+                     }
+
                      // Update the system
                      IDLE_DETAIL_LOG_DEBUG(
                          "Updating the system after plugin changes");
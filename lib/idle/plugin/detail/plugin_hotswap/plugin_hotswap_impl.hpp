@@ -40,6 +40,7 @@
 #include <idle/plugin/plugin_hotswap.hpp>
 #include <idle/plugin/plugin_loader.hpp>
 #include <idle/plugin/plugin_recompiler.hpp>
+#include <idle/service/handoff.hpp>
 #include <idle/service/process_group.hpp>
 
 namespace idle {
@@ -83,8 +84,13 @@ private:
   Dependency<IOContext> io_context_{*this};
   Dependency<Log> log_{*this};
   Dependency<Activities> activities_{*this};
+  Dependency<StateHandoff> handoff_{*this};
 
   detail::unordered_map<Plugin const*, Ref<Bundle>> bundles_;
+
+  /// Is set when plugins were added or removed, which requires
+  /// a full system update after the current changes.
+  bool outdated_{false};
 };
 } // namespace idle
 
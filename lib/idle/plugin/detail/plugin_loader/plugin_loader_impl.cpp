@@ -23,6 +23,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <boost/dll/shared_library.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <idle/core/async.hpp>
@@ -31,7 +34,11 @@
 #include <idle/core/detail/formatter.hpp>
 #include <idle/core/detail/log.hpp>
 #include <idle/core/util/assert.hpp>
+#include <idle/plugin/detail/plugin/plugin_impl.hpp>
+#include <idle/plugin/detail/plugin_cache.hpp>
+#include <idle/plugin/detail/plugin_info.hpp>
 #include <idle/plugin/detail/plugin_loader/plugin_loader_impl.hpp>
+#include <idle/plugin/detail/shared_library.hpp>
 #include <idle/plugin/plugin.hpp>
 
 namespace idle {
@@ -67,6 +74,8 @@ void PluginLoaderImpl::setupImpl(Config config) {
 
   cache_directory_ = std::move(config.cache_directory);
   IDLE_ASSERT(!cache_directory_.empty()); // TODO
+
+  cache_ = detail::plugin_cache(cache_directory_);
 }
 
 void PluginLoaderImpl::onSetup() {
@@ -87,9 +96,11 @@ continuable<> PluginLoaderImpl::onStart() {
     // Create the cache directory structure
     IDLE_ASSERT(!cache_directory_.empty());
 
-    if (!exists(cache_directory_)) {
-      create_directories(cache_directory_);
-    }
+    // Other processes could share the cache directory, thus only the
+    // sessions of processes that have exited are reclaimed.
+    cache_.open();
+    cache_.clear_abandoned();
+    cache_.collect();
   });
 }
 
@@ -114,12 +125,17 @@ continuable<PluginLoader::PluginChanges> PluginLoaderImpl::watch_impl() {
             changes.size());
 
         if (auto me = weak.lock()) {
-          auto plugin_changes = me->convert(std::move(changes));
-          if (!plugin_changes.empty()) {
-            return make_ready_continuable(std::move(plugin_changes));
-          } else {
-            return me->watch_impl();
-          }
+          return me->convert(std::move(changes))
+              .then([weak](PluginChanges plugin_changes)
+                        -> continuable<PluginChanges> {
+                if (!plugin_changes.empty()) {
+                  return make_ready_continuable(std::move(plugin_changes));
+                } else if (auto me = weak.lock()) {
+                  return me->watch_impl();
+                } else {
+                  return make_cancelling_continuable<PluginChanges>();
+                }
+              });
         } else {
           return make_cancelling_continuable<PluginChanges>();
         }
@@ -161,7 +177,108 @@ void PluginLoaderImpl::updateSideloadBannList(
   }
 }
 
-PluginLoader::PluginChanges
+/// Places the library and its debug database into the content addressed
+/// cache under the previously computed content hash.
+static void place_into_cache(detail::plugin_cache const& cache,
+                             PluginPaths& paths) {
+  IDLE_ASSERT(paths.cache_path);
+  IDLE_ASSERT(paths.content_hash);
+
+  cache.place(paths.path, *paths.content_hash, *paths.cache_path);
+
+  if (auto ext = detail::debug_symbol_db_extension()) {
+    boost::filesystem::path debug_symbol_db(paths.path);
+    debug_symbol_db.replace_extension(*ext);
+
+    if (exists(debug_symbol_db)) {
+      boost::filesystem::path target(*paths.cache_path);
+      target.replace_extension(*ext);
+
+      cache.place(debug_symbol_db, detail::hash_file_content(debug_symbol_db),
+                  target);
+
+      paths.cache_debug_db_path = target.generic_string();
+    }
+  }
+}
+
+static std::string module_name_of(std::string const& path) {
+  std::string name = boost::filesystem::path(path).filename().generic_string();
+  detail::shared_library::normalize_name(name);
+  return name;
+}
+
+/// Places all changed libraries of the batch into the content addressed
+/// cache. Libraries which are unchanged compared to their previous version
+/// are not placed and their cache path is reset.
+///
+/// A library with unchanged content is still treated as changed when it
+/// links against a changed library of the same batch, since it would stay
+/// bound to the previous version of its dependency otherwise.
+static void
+place_batch_into_cache(detail::plugin_cache const& cache,
+                       std::vector<PluginPaths>& batch,
+                       std::vector<optional<detail::content_hash_t>> const&
+                           previous) {
+  IDLE_ASSERT(batch.size() == previous.size());
+
+  std::vector<bool> changed(batch.size());
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    detail::content_hash_t const hash = detail::hash_file_content(
+        batch[i].path);
+    batch[i].content_hash = hash;
+    changed[i] = !previous[i] || (*previous[i] != hash);
+  }
+
+  if (std::find(changed.begin(), changed.end(), true) != changed.end() &&
+      std::find(changed.begin(), changed.end(), false) != changed.end()) {
+    std::vector<std::string> names;
+    std::vector<std::vector<std::string>> imports(batch.size());
+    names.reserve(batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      names.push_back(module_name_of(batch[i].path));
+
+      if (!changed[i]) {
+        imports[i] = detail::plugin_info::from(batch[i].path)
+                         .imported_libraries;
+        for (std::string& imported : imports[i]) {
+          detail::shared_library::normalize_name(imported);
+        }
+      }
+    }
+
+    // Propagate the change through the libraries of the batch
+    // until every transitive dependent was marked.
+    for (bool propagated = true; propagated;) {
+      propagated = false;
+
+      for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (changed[i]) {
+          continue;
+        }
+
+        for (std::size_t j = 0; j < batch.size(); ++j) {
+          if (changed[j] && (std::find(imports[i].begin(), imports[i].end(),
+                                       names[j]) != imports[i].end())) {
+            changed[i] = true;
+            propagated = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    if (changed[i]) {
+      place_into_cache(cache, batch[i]);
+    } else {
+      batch[i].cache_path.reset();
+    }
+  }
+}
+
+continuable<PluginLoader::PluginChanges>
 PluginLoaderImpl::convert(FileWatcher::FileChanges changes) {
   IDLE_ASSERT(root().is_on_event_loop());
 
@@ -176,17 +293,35 @@ PluginLoaderImpl::convert(FileWatcher::FileChanges changes) {
 
   updateSideloadBannList(changes);
 
+  // The plugins are loaded together after all changes were processed
+  std::vector<PendingLoad> pending;
+
+  auto const load_as_modified_or_added = [&](std::string const& key,
+                                             std::string path) {
+    auto itr = plugins_.find(key);
+    if (itr != plugins_.end()) {
+      // Notify as modified if the old library is still in use
+      if (auto plugin = itr->second.lock()) {
+        // Load a new version of the library and replace the old one
+        pending.push_back(PendingLoad{key, std::move(path), std::move(plugin)});
+        return;
+      }
+    }
+
+    // If not present or unused notify as added
+    std::string added = path;
+    pending.push_back(PendingLoad{std::move(added), std::move(path), {}});
+  };
+
   for (auto&& change : changes) {
     auto& path = change.first;
     visit(
         overload(
             [&](FileAdded /*fevent*/) mutable {
               IDLE_DETAIL_LOG_DEBUG("Plugin was added: {}", path);
-              if (auto library = load(path)) {
-                PluginAdded pevent{std::move(library)};
-                plugins_.insert(std::make_pair(std::move(path), pevent.source));
-                plugin_changes.push_back(std::move(pevent));
-              }
+              std::string key = path;
+              pending.push_back(
+                  PendingLoad{std::move(key), std::move(path), {}});
             },
             [&](FileRemoved /*fevent*/) mutable {
               IDLE_DETAIL_LOG_DEBUG("Plugin was removed: {}", path);
@@ -201,74 +336,136 @@ PluginLoaderImpl::convert(FileWatcher::FileChanges changes) {
             },
             [&](FileModified /*fevent*/) mutable {
               IDLE_DETAIL_LOG_DEBUG("Plugin was modified: {}", path);
-              auto itr = plugins_.find(path);
-              if (itr != plugins_.end()) {
-                // Load a new version of the library and replace the old one
-                if (auto plugin = itr->second.lock()) {
-                  // Notify as modified if the old library is still in use
-                  if (auto library = load(path)) {
-                    itr->second = library;
-                    plugin_changes.push_back(
-                        PluginModified{std::move(plugin), std::move(library)});
-                  }
-                  return; // Exit the lambda
-                }
-              }
-
-              // If not present or unused notify as added
-              if (auto library = load(path)) {
-                plugins_.insert(std::make_pair(std::move(path), library));
-                plugin_changes.push_back(PluginAdded{std::move(library)});
-              }
+              load_as_modified_or_added(path, path);
             },
             [&](FileRenamed fevent) mutable {
               IDLE_DETAIL_LOG_DEBUG("Plugin was renamed from \"{}\" to "
                                     "\"{}\"",
                                     fevent.old_path, path);
-              auto itr = plugins_.find(fevent.old_path);
-              if (itr != plugins_.end()) {
-                // Load a new version of the library and replace the old one
-                if (auto plugin = itr->second.lock()) {
-                  // Notify as modified if the old library is still in use
-                  if (auto library = load(path)) {
-                    itr->second = library;
-                    plugin_changes.push_back(
-                        PluginModified{std::move(plugin), std::move(library)});
-                  }
-                  return; // Exit the lambda
-                }
-              }
-
-              // If not present or unused notify as added
-              if (auto library = load(path)) {
-                plugins_.insert(std::make_pair(std::move(path), library));
-                plugin_changes.push_back(PluginAdded{std::move(library)});
-              }
+              load_as_modified_or_added(fevent.old_path, std::move(path));
             }),
         std::move(change.second));
   }
 
-  return plugin_changes;
+  if (pending.empty()) {
+    return make_ready_continuable(std::move(plugin_changes));
+  }
+
+  std::vector<PluginPaths> batch;
+  std::vector<optional<detail::content_hash_t>> previous;
+  batch.reserve(pending.size());
+  previous.reserve(pending.size());
+  for (PendingLoad const& load : pending) {
+    PluginPaths paths;
+    paths.path = load.path;
+    paths.cache_path = unique_path_cache_of(load.path).generic_string();
+    batch.push_back(std::move(paths));
+
+    if (load.previous) {
+      previous.push_back(PluginImpl::from(*load.previous).content_hash_impl());
+    } else {
+      previous.push_back({});
+    }
+  }
+
+  PluginSourceImpl& source = PluginSourceImpl::from(*plugin_source_);
+  return source.thread_pool()
+      .async_post([cache = cache_, batch = std::move(batch),
+                   previous = std::move(previous)]() mutable {
+        place_batch_into_cache(cache, batch, previous);
+
+        cache.collect();
+        return std::move(batch);
+      })
+      .then(wrap(*this,
+                 [pending = std::move(pending),
+                  plugin_changes = std::move(plugin_changes)](
+                     std::vector<PluginPaths> batch,
+                     auto&& me) mutable -> continuable<PluginChanges> {
+                   IDLE_ASSERT(me->root().is_on_event_loop());
+                   IDLE_ASSERT(batch.size() == pending.size());
+
+                   // Skip the libraries whose content did not change
+                   std::size_t size = 0;
+                   for (std::size_t i = 0; i < batch.size(); ++i) {
+                     if (!batch[i].cache_path) {
+                       IDLE_DETAIL_LOG_DEBUG("Plugin '{}' is unchanged, "
+                                             "skipping its reload",
+                                             batch[i].path);
+                       continue;
+                     }
+
+                     if (size != i) {
+                       batch[size] = std::move(batch[i]);
+                       pending[size] = std::move(pending[i]);
+                     }
+                     ++size;
+                   }
+                   batch.resize(size);
+                   pending.resize(size);
+
+                   if (batch.empty()) {
+                     return make_ready_continuable(std::move(plugin_changes));
+                   }
+
+                   return me->load_batch(std::move(batch), std::move(pending),
+                                         std::move(plugin_changes));
+                 }),
+            root().event_loop().through_post());
+}
+
+continuable<PluginLoader::PluginChanges>
+PluginLoaderImpl::load_batch(std::vector<PluginPaths> batch,
+                             std::vector<PendingLoad> pending,
+                             PluginChanges plugin_changes) {
+  IDLE_ASSERT(root().is_on_event_loop());
+
+  return PluginSourceImpl::from(*plugin_source_)
+      .load_batch_impl(std::move(batch), generation_)
+      .then(wrap(*this,
+                 [pending = std::move(pending),
+                  plugin_changes = std::move(plugin_changes)](
+                     std::vector<Ref<Plugin>> libraries,
+                     auto&& me) mutable -> PluginChanges {
+                   IDLE_ASSERT(me->root().is_on_event_loop());
+
+                   // The libraries are ordered by their dependencies,
+                   // such that we have to find the matching request again.
+                   for (Ref<Plugin>& library : libraries) {
+                     auto const itr = std::find_if(
+                         pending.begin(), pending.end(),
+                         [&](PendingLoad const& load) {
+                           return library->path() == StringView(load.path);
+                         });
+                     IDLE_ASSERT(itr != pending.end());
+
+                     if (itr->previous) {
+                       me->plugins_[itr->key] = library;
+                       plugin_changes.push_back(PluginModified{
+                           std::move(itr->previous), std::move(library)});
+                     } else {
+                       me->plugins_.insert(std::make_pair(itr->key, library));
+                       plugin_changes.push_back(
+                           PluginAdded{std::move(library)});
+                     }
+                   }
+
+                   return std::move(plugin_changes);
+                 }),
+            root().event_loop().through_post());
 }
 
 boost::filesystem::path
 PluginLoaderImpl::unique_path_cache_of(boost::filesystem::path const& path) {
   IDLE_ASSERT(!cache_directory_.empty());
 
-  auto const dir = cache_directory_ /
-                   fmt::format(FMT_STRING("{}"), generation_);
-  boost::filesystem::create_directory(dir);
+  // The directory of the generation is created lazily when the first
+  // library is placed into it, since all libraries could be unchanged.
+  auto const dir = cache_.generation_of(generation_);
 
   // Generate a new name for the file which includes the original name
   // and a unique counter which is incremented for every loading cycle when
   // a shared library is changed which is placed into the cache directory.
   return dir / path.filename();
 }
-
-Ref<Plugin> PluginLoaderImpl::load(std::string path) {
-  auto cache_path = unique_path_cache_of(path).generic_string();
-  auto plugin = plugin_source_->load(std::move(path), std::move(cache_path),
-                                     generation_);
-  return plugin;
-}
 } // namespace idle
@@ -37,11 +37,14 @@
 #include <idle/core/ref.hpp>
 #include <idle/core/util/assert.hpp>
 #include <idle/core/util/upcastable.hpp>
+#include <idle/plugin/detail/plugin_cache.hpp>
 #include <idle/plugin/plugin.hpp>
 #include <idle/plugin/plugin_loader.hpp>
 #include <idle/service/file_watcher.hpp>
 
 namespace idle {
+struct PluginPaths;
+
 class PluginLoaderImpl : public PluginLoader,
                          public Upcastable<PluginLoaderImpl> {
 
@@ -63,14 +66,26 @@ public:
   continuable<PluginChanges> watch_impl();
 
 private:
+  /// Describes a plugin that is loaded as part of the current batch
+  struct PendingLoad {
+    /// The key of the plugin inside plugins_
+    std::string key;
+    std::string path;
+    /// The plugin that is replaced, if any
+    Ref<Plugin> previous;
+  };
+
   void updateSideloadBannList(FileWatcher::FileChanges const& changes);
-  PluginChanges convert(FileWatcher::FileChanges changes);
+  continuable<PluginChanges> convert(FileWatcher::FileChanges changes);
+  continuable<PluginChanges> load_batch(std::vector<PluginPaths> batch,
+                                        std::vector<PendingLoad> pending,
+                                        PluginChanges plugin_changes);
   path_t unique_path_cache_of(path_t const& path);
-  Ref<Plugin> load(std::string path);
 
   std::vector<FileWatcher::Entry> dirs_;
   bool initial_load_{true};
   path_t cache_directory_;
+  detail::plugin_cache cache_;
 
   Component<FileWatcher> file_watcher_{*this};
   Component<PluginSource> plugin_source_{*this};
@@ -0,0 +1,482 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <boost/filesystem.hpp>
+#include <idle/core/detail/log.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/core/util/string_view.hpp>
+#include <idle/plugin/detail/plugin_recompiler/dependency_index.hpp>
+#include <nlohmann/json.hpp>
+
+namespace idle {
+namespace detail {
+static bool isFileInWorkSpace(StringView workspace, StringView file) noexcept {
+  IDLE_ASSERT(workspace);
+  IDLE_ASSERT(file);
+
+  if (workspace.size() > file.size()) {
+    return false;
+  } else {
+    return workspace == file.substr(0, workspace.size());
+  }
+}
+
+static std::string getComponentDir(std::vector<std::string> const& workspaces,
+                                   std::string const& file) {
+
+  for (std::string const& workspace : workspaces) {
+    if (!isFileInWorkSpace(workspace, file)) {
+      continue;
+    }
+
+    boost::filesystem::path rel = boost::filesystem::relative(file, workspace);
+    while (rel.has_parent_path()) {
+      rel = rel.parent_path();
+    }
+
+    if (rel.has_extension()) {
+      rel.replace_extension({});
+    }
+
+    return rel.generic_string();
+  }
+
+  return {};
+}
+
+static std::string normalize(std::string const& file,
+                             std::string const& directory) {
+  if (file.empty()) {
+    return {};
+  }
+
+  boost::filesystem::path const path = directory.empty()
+                                           ? boost::filesystem::absolute(file)
+                                           : boost::filesystem::absolute(
+                                                 file, directory);
+  return path.lexically_normal().generic_string();
+}
+
+std::vector<std::string> split_command(StringView command) {
+  std::vector<std::string> arguments;
+  std::string current;
+  bool quoted = false;
+  bool has_current = false;
+
+  for (std::size_t i = 0; i < command.size(); ++i) {
+    char const c = command[i];
+
+    if (quoted) {
+      if ((c == '\\') && (i + 1 < command.size()) &&
+          ((command[i + 1] == '"') || (command[i + 1] == '\\'))) {
+        current.push_back(command[++i]);
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        current.push_back(c);
+      }
+    } else if (c == '"') {
+      quoted = true;
+      has_current = true;
+    } else if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r')) {
+      if (has_current) {
+        arguments.push_back(std::move(current));
+        current.clear();
+        has_current = false;
+      }
+    } else {
+      current.push_back(c);
+      has_current = true;
+    }
+  }
+
+  if (has_current) {
+    arguments.push_back(std::move(current));
+  }
+  return arguments;
+}
+
+static std::vector<std::string> arguments_of(nlohmann::json const& command) {
+  auto const arguments = command.find("arguments");
+  if (arguments != command.end()) {
+    return arguments->get<std::vector<std::string>>();
+  }
+
+  return split_command(command.value("command", std::string{}));
+}
+
+/// Returns the value of an option which is passed either as separated
+/// argument (`-o file`) or joined with its option (`/Fofile`).
+static std::string option_of(std::vector<std::string> const& arguments,
+                             StringView separated, StringView joined) {
+  for (auto itr = arguments.begin(); itr != arguments.end(); ++itr) {
+    StringView const current = *itr;
+
+    if (!separated.empty() && (current == separated)) {
+      if (std::next(itr) != arguments.end()) {
+        return *std::next(itr);
+      }
+    } else if (!joined.empty() && (current.size() > joined.size()) &&
+               current.starts_with(joined)) {
+      StringView const value = current.substr(joined.size());
+      return std::string(value.begin(), value.end());
+    }
+  }
+  return {};
+}
+
+/// Returns the CMake target which owns the given object file,
+/// CMake places all objects of a target inside `CMakeFiles/<target>.dir/`.
+static std::string target_of(std::string const& object) {
+  boost::filesystem::path const path = object;
+
+  for (auto itr = path.begin(); itr != path.end(); ++itr) {
+    if (*itr != "CMakeFiles") {
+      continue;
+    }
+
+    auto const next = std::next(itr);
+    if ((next != path.end()) && (next->extension() == ".dir")) {
+      return next->stem().generic_string();
+    }
+    break;
+  }
+  return {};
+}
+
+std::vector<std::string> parse_depfile(StringView content) {
+  std::vector<std::string> prerequisites;
+  std::string current;
+  bool in_targets = true;
+
+  auto flush = [&] {
+    if (!current.empty()) {
+      if (!in_targets) {
+        prerequisites.push_back(std::move(current));
+      }
+      current.clear();
+    }
+  };
+
+  for (std::size_t i = 0; i < content.size(); ++i) {
+    char const c = content[i];
+    bool const has_next = (i + 1) < content.size();
+
+    switch (c) {
+      case '\\': {
+        if (!has_next) {
+          current.push_back(c);
+        } else if ((content[i + 1] == '\n') || (content[i + 1] == '\r')) {
+          // Line continuation
+          flush();
+          ++i;
+          if ((content[i] == '\r') && ((i + 1) < content.size()) &&
+              (content[i + 1] == '\n')) {
+            ++i;
+          }
+        } else if ((content[i + 1] == ' ') || (content[i + 1] == '#')) {
+          current.push_back(content[++i]);
+        } else {
+          // Windows path separators are written unescaped
+          current.push_back(c);
+        }
+        break;
+      }
+      case '$': {
+        if (has_next && (content[i + 1] == '$')) {
+          ++i;
+        }
+        current.push_back('$');
+        break;
+      }
+      case ':': {
+        // Drive letters are never followed by whitespace
+        if (in_targets && (!has_next || (content[i + 1] == ' ') ||
+                           (content[i + 1] == '\t') ||
+                           (content[i + 1] == '\n') ||
+                           (content[i + 1] == '\r'))) {
+          current.clear();
+          in_targets = false;
+        } else {
+          current.push_back(c);
+        }
+        break;
+      }
+      case '\n':
+      case '\r': {
+        flush();
+        if (!in_targets) {
+          // Only the first rule is of interest, the remaining ones are
+          // phony targets for every header generated through `-MP`.
+          return prerequisites;
+        }
+        break;
+      }
+      case ' ':
+      case '\t': {
+        flush();
+        break;
+      }
+      default: {
+        current.push_back(c);
+        break;
+      }
+    }
+  }
+
+  flush();
+  return prerequisites;
+}
+
+void dependency_index::refresh(std::string const& build_dir,
+                               std::vector<std::string> const& workspaces) {
+  bool changed = refresh_commands(build_dir, workspaces);
+  if (refresh_depfiles()) {
+    changed = true;
+  }
+
+  if (changed) {
+    rebuild_dependents();
+
+    IDLE_DETAIL_LOG_DEBUG("Refreshed the dependency index of '{}' "
+                          "({} translation units, {} files)",
+                          build_dir, units_.size(), dependents_.size());
+  }
+}
+
+optional<dependency_index::affected_t>
+dependency_index::affected(std::vector<std::string> const& files) const {
+  affected_t affected;
+
+  for (std::string const& file : files) {
+    auto const itr = dependents_.find(normalize(file, {}));
+    if (itr == dependents_.end()) {
+      IDLE_DETAIL_LOG_DEBUG("File '{}' is unknown to the dependency index",
+                            file);
+      return {};
+    }
+
+    for (std::string const& source : itr->second) {
+      auto const unit = units_.find(source);
+      IDLE_ASSERT(unit != units_.end());
+
+      if (unit->second.component.empty()) {
+        // The source is not part of a workspace, thus it is unknown
+        // to which component it is installed.
+        return {};
+      }
+
+      affected.targets.push_back(unit->second.target);
+      affected.components.push_back(unit->second.component);
+    }
+  }
+
+  auto const unique = [](std::vector<std::string>& values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+  };
+
+  unique(affected.targets);
+  unique(affected.components);
+  return affected;
+}
+
+void dependency_index::clear() noexcept {
+  commands_stamp_ = {};
+  units_.clear();
+  dependents_.clear();
+}
+
+optional<dependency_index::file_stamp>
+dependency_index::stamp_of(std::string const& file) noexcept {
+  boost::system::error_code ec;
+
+  file_stamp stamp;
+  stamp.time = boost::filesystem::last_write_time(file, ec);
+  if (ec) {
+    return {};
+  }
+
+  stamp.size = boost::filesystem::file_size(file, ec);
+  if (ec) {
+    return {};
+  }
+
+  return stamp;
+}
+
+bool dependency_index::refresh_commands(
+    std::string const& build_dir, std::vector<std::string> const& workspaces) {
+
+  std::string const path = normalize("compile_commands.json", build_dir);
+
+  optional<file_stamp> const stamp = stamp_of(path);
+  if (!stamp) {
+    IDLE_DETAIL_LOG_DEBUG("No compilation database present at '{}'", path);
+
+    if (!units_.empty()) {
+      clear();
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  if (*stamp == commands_stamp_) {
+    return false;
+  }
+
+  std::ifstream file(path.c_str());
+  if (!file.is_open()) {
+    return false;
+  }
+
+  nlohmann::json commands;
+  try {
+    commands = nlohmann::json::parse(std::istreambuf_iterator<char>(file),
+                                     std::istreambuf_iterator<char>());
+  } catch (std::exception const& e) {
+    IDLE_DETAIL_LOG_ERROR("Failed to parse {} ({}).", path, e.what());
+    (void)e;
+    return false;
+  }
+
+  unordered_map<std::string, unit> units;
+  units.reserve(commands.size());
+
+  for (nlohmann::json const& command : commands) {
+    std::string const directory = command.value("directory", std::string{});
+    std::string source = normalize(command.value("file", std::string{}),
+                                   directory);
+    if (source.empty()) {
+      continue;
+    }
+
+    std::vector<std::string> const arguments = arguments_of(command);
+
+    std::string object = command.value("output", std::string{});
+    if (object.empty()) {
+      object = option_of(arguments, "-o", {});
+    }
+    if (object.empty()) {
+      object = option_of(arguments, {}, "/Fo");
+    }
+    if (object.empty()) {
+      object = option_of(arguments, {}, "-Fo");
+    }
+
+    unit current;
+    current.directory = directory;
+    current.component = getComponentDir(workspaces, source);
+    current.target = target_of(object);
+    if (current.target.empty()) {
+      current.target = current.component;
+    }
+
+    std::string depfile = option_of(arguments, "-MF", {});
+    if (depfile.empty() && !object.empty()) {
+      depfile = object + ".d";
+    }
+    current.depfile = normalize(depfile, directory);
+
+    // Keep the already parsed depfile if it is still the same
+    auto const previous = units_.find(source);
+    if ((previous != units_.end()) &&
+        (previous->second.depfile == current.depfile)) {
+      current.depfile_stamp = previous->second.depfile_stamp;
+      current.includes = std::move(previous->second.includes);
+    }
+
+    units[std::move(source)] = std::move(current);
+  }
+
+  units_ = std::move(units);
+  commands_stamp_ = *stamp;
+  return true;
+}
+
+bool dependency_index::refresh_depfiles() {
+  bool changed = false;
+
+  for (auto& entry : units_) {
+    unit& current = entry.second;
+    if (current.depfile.empty()) {
+      continue;
+    }
+
+    optional<file_stamp> const stamp = stamp_of(current.depfile);
+    if (!stamp) {
+      // The unit was not compiled yet or the compiler does not emit depfiles
+      if (!current.includes.empty()) {
+        current.depfile_stamp = {};
+        current.includes.clear();
+        changed = true;
+      }
+      continue;
+    }
+
+    if (*stamp == current.depfile_stamp) {
+      continue;
+    }
+
+    std::ifstream file(current.depfile.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+      continue;
+    }
+
+    std::string const content{std::istreambuf_iterator<char>(file),
+                              std::istreambuf_iterator<char>()};
+
+    std::vector<std::string> includes = parse_depfile(content);
+    for (std::string& include : includes) {
+      include = normalize(include, current.directory);
+    }
+
+    current.includes = std::move(includes);
+    current.depfile_stamp = *stamp;
+    changed = true;
+  }
+
+  return changed;
+}
+
+void dependency_index::rebuild_dependents() {
+  dependents_.clear();
+
+  for (auto const& entry : units_) {
+    dependents_[entry.first].push_back(entry.first);
+
+    for (std::string const& include : entry.second.includes) {
+      if (include != entry.first) {
+        dependents_[include].push_back(entry.first);
+      }
+    }
+  }
+}
+} // namespace detail
+} // namespace idle
@@ -0,0 +1,112 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_PLUGIN_DETAIL_PLUGIN_RECOMPILER_DEPENDENCY_INDEX_HPP_INCLUDED
+#define IDLE_PLUGIN_DETAIL_PLUGIN_RECOMPILER_DEPENDENCY_INDEX_HPP_INCLUDED
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <idle/core/api.hpp>
+#include <idle/core/dep/optional.hpp>
+#include <idle/core/detail/unordered_map.hpp>
+#include <idle/core/util/string_view.hpp>
+
+namespace idle {
+namespace detail {
+/// Splits a shell command line into its arguments
+IDLE_API(idle) std::vector<std::string> split_command(StringView command);
+
+/// Returns the prerequisites of the first rule of a make style depfile
+/// as they are written by GCC and Clang through `-MD` or `-MMD`.
+IDLE_API(idle) std::vector<std::string> parse_depfile(StringView content);
+
+/// Maps source and header files to the CMake targets and install components
+/// they are compiled into.
+///
+/// The index is built from the `compile_commands.json` of the build directory
+/// and the depfiles the compiler emits for every translation unit.
+/// Both are only reparsed when they were modified since the last refresh.
+class dependency_index {
+public:
+  struct affected_t {
+    std::vector<std::string> targets;
+    std::vector<std::string> components;
+  };
+
+  dependency_index() = default;
+
+  /// Refreshes the index from the given build directory
+  void refresh(std::string const& build_dir,
+               std::vector<std::string> const& workspaces);
+
+  /// Returns the targets and components that are affected by the given files,
+  /// or an empty optional if at least one file is unknown to the index.
+  optional<affected_t> affected(std::vector<std::string> const& files) const;
+
+  bool empty() const noexcept {
+    return units_.empty();
+  }
+
+  void clear() noexcept;
+
+private:
+  struct file_stamp {
+    std::time_t time{0};
+    std::uintmax_t size{0};
+
+    bool operator==(file_stamp const& other) const noexcept {
+      return (time == other.time) && (size == other.size);
+    }
+    bool operator!=(file_stamp const& other) const noexcept {
+      return !(*this == other);
+    }
+  };
+
+  struct unit {
+    std::string directory;
+    std::string target;
+    std::string component;
+    std::string depfile;
+    file_stamp depfile_stamp;
+    std::vector<std::string> includes;
+  };
+
+  static optional<file_stamp> stamp_of(std::string const& file) noexcept;
+
+  bool refresh_commands(std::string const& build_dir,
+                        std::vector<std::string> const& workspaces);
+  bool refresh_depfiles();
+  void rebuild_dependents();
+
+  file_stamp commands_stamp_;
+  unordered_map<std::string, unit> units_;
+  unordered_map<std::string, std::vector<std::string>> dependents_;
+};
+} // namespace detail
+} // namespace idle
+
+#endif // IDLE_PLUGIN_DETAIL_PLUGIN_RECOMPILER_DEPENDENCY_INDEX_HPP_INCLUDED
@@ -24,6 +24,7 @@
  */
 
 #include <regex>
+#include <vector>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <fmt/ostream.h>
@@ -44,11 +45,6 @@ static bool is_cxx_file(StringView file) {
   return std::regex_match(file.begin(), file.end(), regex);
 }
 
-static bool is_cxx_source_file(StringView file) {
-  static std::regex const regex(".*\\.(c|cc|cpp)$");
-  return std::regex_match(file.begin(), file.end(), regex);
-}
-
 static bool is_cmake_file(boost::filesystem::path const& file) {
   if (file.filename() == "CMakeLists.txt") {
     return true;
@@ -129,73 +125,19 @@ static bool needs_regenerate(FileWatcher::FileChanges const& changes) noexcept {
   return false;
 }
 
-bool isFileInWorkSpace(StringView workspace, StringView file) noexcept {
-  IDLE_ASSERT(workspace);
-  IDLE_ASSERT(file);
-
-  if (workspace.size() > file.size()) {
-    return false;
-  } else {
-    return workspace == file.substr(0, workspace.size());
-  }
-}
-
-std::string getComponentDir(std::vector<std::string> const& workspaces,
-                            std::string const& file) {
-
-  for (std::string const& workspace : workspaces) {
-    if (!isFileInWorkSpace(workspace, file)) {
-      continue;
-    }
-
-    boost::filesystem::path rel = boost::filesystem::relative(file, workspace);
-    while (rel.has_parent_path()) {
-      rel = rel.parent_path();
-    }
-
-    if (rel.has_extension()) {
-      rel.replace_extension({});
-    }
-
-    return rel.generic_string();
-  }
-
-  return {};
-}
-
-static constexpr std::size_t FILE_CHANGED_THRESHOLD = 5;
-
-static std::string
-getInstallComponent(std::vector<std::string> const& workspaces,
-                    FileWatcher::FileChanges const& changes) noexcept {
-
-  if (workspaces.empty() || (changes.size() > FILE_CHANGED_THRESHOLD)) {
-    return {};
-  }
-
-  std::string component;
+continuable<optional<detail::dependency_index::affected_t>>
+PluginRecompilerImpl::affected_by(FileWatcher::FileChanges const& changes) {
+  std::vector<std::string> files;
+  files.reserve(changes.size());
   for (auto const& change : changes) {
-    // If there is a different op than modified initiate a full rebuild
-    if (get_if<file_event::FileModified>(&change.second) == nullptr) {
-      return {};
-    }
-
-    // If there was header or different file modified initiate a full rebuild
-    if (!is_cxx_source_file(change.first)) {
-      return {};
-    }
-
-    std::string current = getComponentDir(workspaces, change.first);
-    if (current.empty()) {
-      return {};
-    } else if (component.empty()) {
-      component = std::move(current);
-    } else if (component != current) {
-      return {};
-    }
+    files.push_back(change.first);
   }
 
-  return component;
+  return io_context_->async_post(
+      wrap(*this, [files = std::move(files)](auto&& me) {
+        me->index_.refresh(me->config_.build_dir, me->config_.workspaces);
+        return me->index_.affected(files);
+      }));
 }
 
 continuable<>
@@ -226,17 +168,31 @@ PluginRecompilerImpl::watch_and_compile_impl(bool force_regenerate) {
                    if (force_regenerate || regenerate) {
                      return me->plugin_compiler_->generate().then(
                          me->plugin_compiler_->buildInstall());
-                   } else {
-                     std::string const component = getInstallComponent(
-                         me->config_.workspaces, changes);
-
-                     if (component.empty()) {
-                       return me->plugin_compiler_->buildInstall();
-                     } else {
-                       return me->plugin_compiler_->build(component).then(
-                           me->plugin_compiler_->installComponent(component));
-                     }
                    }
+
+                   return me->affected_by(changes).then(
+                       wrap(*me,
+                            [](optional<detail::dependency_index::affected_t>
+                                   affected,
+                               auto&& me) -> continuable<> {
+                              if (!affected) {
+                                return me->plugin_compiler_->buildInstall();
+                              }
+
+                              std::vector<continuable<>> installs;
+                              installs.reserve(affected->components.size());
+                              for (std::string& component :
+                                   affected->components) {
+                                installs.push_back(
+                                    me->plugin_compiler_->installComponent(
+                                        std::move(component)));
+                              }
+
+                              return me->plugin_compiler_
+                                  ->buildTargets(std::move(affected->targets))
+                                  .then(when_all(std::move(installs)));
+                            }),
+                       me->root().event_loop().through_dispatch());
                  }),
             root().event_loop().through_dispatch());
 }
@@ -26,9 +26,13 @@
 #ifndef IDLE_PLUGIN_DETAIL_PLUGIN_RECOMPILER_PLUGIN_RECOMPILER_IMPL_HPP_INCLUDED
 #define IDLE_PLUGIN_DETAIL_PLUGIN_RECOMPILER_PLUGIN_RECOMPILER_IMPL_HPP_INCLUDED
 
+#include <idle/core/dep/optional.hpp>
 #include <idle/core/parts/component.hpp>
+#include <idle/core/parts/dependency.hpp>
 #include <idle/core/ref.hpp>
 #include <idle/core/util/upcastable.hpp>
+#include <idle/interface/io_context.hpp>
+#include <idle/plugin/detail/plugin_recompiler/dependency_index.hpp>
 #include <idle/plugin/plugin_compiler.hpp>
 #include <idle/plugin/plugin_recompiler.hpp>
 #include <idle/service/file_watcher.hpp>
@@ -56,10 +60,19 @@ protected:
   void onSetup() override;
 
 private:
+  /// Refreshes the dependency index on the thread pool and returns
+  /// the targets and components which are affected by the given changes.
+  continuable<optional<detail::dependency_index::affected_t>>
+  affected_by(FileWatcher::FileChanges const& changes);
+
   Config config_;
 
   Component<PluginCompiler> plugin_compiler_{*this};
   Component<FileWatcher> file_watcher_{*this};
+  Dependency<IOContext> io_context_{*this};
+
+  /// Only accessed from the thread pool, changes are processed sequentially
+  detail::dependency_index index_;
 
   bool failed_last_{false};
 };
@@ -38,7 +38,11 @@ continuable<> PluginCompiler::generate() {
 }
 
 continuable<> PluginCompiler::build(std::string target) {
-  return PluginCompilerImpl::from(this)->build_impl(std::move(target));
+  return PluginCompilerImpl::from(this)->build_impl({std::move(target)});
+}
+
+continuable<> PluginCompiler::buildTargets(std::vector<std::string> targets) {
+  return PluginCompilerImpl::from(this)->build_impl(std::move(targets));
 }
 
 continuable<> PluginCompiler::buildInstall() {
@@ -0,0 +1,328 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <idle/core/util/assert.hpp>
+#include <idle/core/util/string_view.hpp>
+#include <idle/service/art/binary.hpp>
+#include <idle/service/art/types.hpp>
+#include <idle/service/art/visitor.hpp>
+
+namespace idle {
+namespace art {
+/// Implements the 64 bit FNV-1a hash which is stable across processes
+class SchemaHasher {
+public:
+  void add(void const* data, std::size_t size) noexcept {
+    auto const* const bytes = static_cast<unsigned char const*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+      value_ ^= bytes[i];
+      value_ *= 0x100000001B3ULL;
+    }
+  }
+  void add(StringView str) noexcept {
+    add(str.data(), str.size());
+
+    // Separate adjacent names
+    add(std::uint8_t(0U));
+  }
+  template <typename T, std::enable_if_t<std::is_arithmetic<T>::value ||
+                                         std::is_enum<T>::value>* = nullptr>
+  void add(T value) noexcept {
+    add(&value, sizeof(T));
+  }
+
+  std::uint64_t value() const noexcept {
+    return value_;
+  }
+
+private:
+  std::uint64_t value_{0xCBF29CE484222325ULL};
+};
+
+static void hash_reflection(SchemaHasher& hasher, Reflection const& reflection,
+                            std::vector<Reflection const*>& stack);
+
+static void hash_type(SchemaHasher& hasher, Subtyped const& type,
+                      std::vector<Reflection const*>& stack) {
+  MappedType const mapped = type.type();
+  hasher.add(mapped);
+
+  if (isPrimitive(mapped)) {
+    if (type.hasSubtype()) {
+      // Enumerations are stored through their underlying value
+      auto const& primitive = static_cast<PrimitiveType const&>(
+          type.subtype());
+      for (PrimitiveType::Entry const& entry : primitive.entries()) {
+        hasher.add(entry.name);
+      }
+    }
+  } else if (isArray(mapped)) {
+    auto const& array = static_cast<ArrayType const&>(type.subtype());
+    hasher.add(array.isResizeable());
+    hash_type(hasher, array, stack);
+  } else if (isSet(mapped)) {
+    hash_type(hasher, static_cast<SetType const&>(type.subtype()), stack);
+  } else {
+    IDLE_ASSERT(isObject(mapped));
+    hash_reflection(
+        hasher, static_cast<ObjectType const&>(type.subtype()).reflection(),
+        stack);
+  }
+}
+
+static void hash_reflection(SchemaHasher& hasher, Reflection const& reflection,
+                            std::vector<Reflection const*>& stack) {
+  for (Reflection const* current : stack) {
+    if (current == &reflection) {
+      // The layout is recursive
+      hasher.add(StringView("<recursive>"));
+      return;
+    }
+  }
+
+  stack.push_back(&reflection);
+
+  if (auto const super = reflection.super()) {
+    hash_reflection(hasher, *super, stack);
+  }
+
+  for (FieldType const& field : reflection.fields()) {
+    hasher.add(StringView(field.name(), std::strlen(field.name())));
+    hash_type(hasher, field, stack);
+  }
+
+  stack.pop_back();
+}
+
+std::uint64_t schema_hash(Reflection const& reflection) noexcept {
+  SchemaHasher hasher;
+  std::vector<Reflection const*> stack;
+  hash_reflection(hasher, reflection, stack);
+  return hasher.value();
+}
+
+class BinarySerializerVisitor {
+public:
+  explicit BinarySerializerVisitor(std::vector<char>& buffer)
+    : buffer_(buffer) {}
+
+  VisitorResult accept(MappedType mapped, void const* primitive,
+                       PrimitiveType const* type) {
+    (void)type;
+
+    // Enumerations are stored through their underlying value
+    return accept(mapped, primitive);
+  }
+  VisitorResult accept(MappedType mapped, void const* primitive) {
+    return type_cast(mapped, primitive, *this);
+  }
+
+  VisitorResult peek(MappedType mapped, std::size_t size, ContainerType type) {
+    (void)mapped;
+    (void)type;
+
+    write(static_cast<std::uint64_t>(size));
+    return VisitorResult::Ok;
+  }
+
+  VisitorResult push(MappedType mapped, char const* name,
+                     char const* description) {
+    (void)mapped;
+    (void)name;
+    (void)description;
+    return VisitorResult::Ok;
+  }
+  VisitorResult push(MappedType mapped, std::size_t index) {
+    (void)mapped;
+    (void)index;
+    return VisitorResult::Ok;
+  }
+
+  void pop(MappedType type) {
+    (void)type;
+  }
+
+  VisitorResult operator()(std::string const* obj) {
+    write(static_cast<std::uint64_t>(obj->size()));
+    buffer_.insert(buffer_.end(), obj->begin(), obj->end());
+    return VisitorResult::Ok;
+  }
+  VisitorResult operator()(std::chrono::system_clock::time_point const* obj) {
+    write(static_cast<std::int64_t>(obj->time_since_epoch().count()));
+    return VisitorResult::Ok;
+  }
+  VisitorResult operator()(std::chrono::system_clock::duration const* obj) {
+    write(static_cast<std::int64_t>(obj->count()));
+    return VisitorResult::Ok;
+  }
+  template <typename T>
+  VisitorResult operator()(T const* obj) {
+    static_assert(std::is_arithmetic<T>::value, "Unsupported primitive!");
+
+    write(*obj);
+    return VisitorResult::Ok;
+  }
+
+private:
+  template <typename T>
+  void write(T const& value) {
+    auto const* const data = reinterpret_cast<char const*>(&value);
+    buffer_.insert(buffer_.end(), data, data + sizeof(T));
+  }
+
+  std::vector<char>& buffer_;
+};
+
+class BinaryDeserializerVisitor {
+public:
+  explicit BinaryDeserializerVisitor(Span<char const> buffer)
+    : current_(buffer.data())
+    , end_(buffer.data() + buffer.size()) {}
+
+  VisitorResult accept(MappedType mapped, void* primitive,
+                       PrimitiveType const* type) {
+    (void)type;
+    return accept(mapped, primitive);
+  }
+  VisitorResult accept(MappedType mapped, void* primitive) {
+    return type_cast(mapped, primitive, *this);
+  }
+
+  VisitorResult peek(MappedType mapped, std::size_t& in_out_size,
+                     ContainerType type) {
+    (void)mapped;
+
+    std::uint64_t size;
+    if (!read(size)) {
+      return VisitorResult::Cancel;
+    }
+
+    if ((type == ContainerType::ArrayLike) && (size != in_out_size)) {
+      return VisitorResult::Cancel;
+    }
+
+    // Never resize a container beyond the remaining buffer,
+    // which would indicate a corrupted size.
+    if (size > remaining()) {
+      return VisitorResult::Cancel;
+    }
+
+    in_out_size = static_cast<std::size_t>(size);
+    return VisitorResult::Ok;
+  }
+
+  VisitorResult push(MappedType mapped, char const* name,
+                     char const* description) {
+    (void)mapped;
+    (void)name;
+    (void)description;
+    return VisitorResult::Ok;
+  }
+  VisitorResult push(MappedType mapped, std::size_t index) {
+    (void)mapped;
+    (void)index;
+    return VisitorResult::Ok;
+  }
+
+  void pop(MappedType type) {
+    (void)type;
+  }
+
+  VisitorResult operator()(std::string* obj) {
+    std::uint64_t size;
+    if (!read(size) || (size > remaining())) {
+      return VisitorResult::Cancel;
+    }
+
+    obj->assign(current_, static_cast<std::size_t>(size));
+    current_ += size;
+    return VisitorResult::Ok;
+  }
+  VisitorResult operator()(std::chrono::system_clock::time_point* obj) {
+    std::int64_t count;
+    if (!read(count)) {
+      return VisitorResult::Cancel;
+    }
+
+    *obj = std::chrono::system_clock::time_point(
+        std::chrono::system_clock::duration(count));
+    return VisitorResult::Ok;
+  }
+  VisitorResult operator()(std::chrono::system_clock::duration* obj) {
+    std::int64_t count;
+    if (!read(count)) {
+      return VisitorResult::Cancel;
+    }
+
+    *obj = std::chrono::system_clock::duration(count);
+    return VisitorResult::Ok;
+  }
+  template <typename T>
+  VisitorResult operator()(T* obj) {
+    static_assert(std::is_arithmetic<T>::value, "Unsupported primitive!");
+
+    return read(*obj) ? VisitorResult::Ok : VisitorResult::Cancel;
+  }
+
+  bool isFinished() const noexcept {
+    return current_ == end_;
+  }
+
+private:
+  std::size_t remaining() const noexcept {
+    return static_cast<std::size_t>(end_ - current_);
+  }
+
+  template <typename T>
+  bool read(T& value) noexcept {
+    if (remaining() < sizeof(T)) {
+      return false;
+    }
+
+    std::memcpy(&value, current_, sizeof(T));
+    current_ += sizeof(T);
+    return true;
+  }
+
+  char const* current_;
+  char const* end_;
+};
+
+void binary_serialize(std::vector<char>& buffer, ConstReflectionPtr ptr) {
+  BinarySerializerVisitor visitor(buffer);
+  reflection_visit(visitor, ptr);
+}
+
+bool binary_deserialize(Span<char const> buffer, ReflectionPtr ptr) {
+  BinaryDeserializerVisitor visitor(buffer);
+  return reflection_visit(visitor, ptr) && visitor.isFinished();
+}
+} // namespace art
+} // namespace idle
@@ -23,6 +23,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <fmt/color.h>
@@ -30,10 +32,13 @@
 #include <fmt/ostream.h>
 #include <idle/core/context.hpp>
 #include <idle/core/dep/format.hpp>
+#include <idle/core/detail/json.hpp>
 #include <idle/core/graph.hpp>
 #include <idle/core/iterators.hpp>
+#include <idle/core/metrics.hpp>
 #include <idle/core/parts/component.hpp>
 #include <idle/core/registry.hpp>
+#include <idle/core/tracing.hpp>
 #include <idle/core/views/dereference.hpp>
 #include <idle/interface/arguments.hpp>
 #include <idle/service/commands.hpp>
@@ -272,7 +277,7 @@ public:
       opt.type = options::GraphType::dependency_graph;
 
       if (!args.empty()) {
-        std::string const type = args.get_string(0);
+        StringView const type = args.get_string(0);
 
         if (type == "service") {
           opt.type = options::GraphType::service_graph;
@@ -308,6 +313,178 @@ continuable<> VerifyCommand::invoke(Ref<Session> session,
       });
 }
 
+/// The number of slowest services that are printed
+static constexpr std::size_t metrics_slowest_services = 10U;
+
+static void format_histogram(fmt::memory_buffer& buffer, StringView name,
+                             Histogram const& histogram) {
+  format_to(buffer,
+            FMT_STRING("  {:<20} count: {:>8} mean: {:>8} p50: {:>8} "
+                       "p99: {:>8} max: {:>8}\n"),
+            name, histogram.count(), histogram.mean(),
+            histogram.percentile(50U), histogram.percentile(99U),
+            histogram.max());
+}
+
+static void format_histogram_json(fmt::memory_buffer& buffer,
+                                  Histogram const& histogram) {
+  format_to(buffer,
+            FMT_STRING("{{\"count\":{},\"total\":{},\"max\":{},"
+                       "\"p50\":{},\"p99\":{},\"buckets\":[{}]}}"),
+            histogram.count(), histogram.total(), histogram.max(),
+            histogram.percentile(50U), histogram.percentile(99U),
+            fmt::join(histogram.buckets().begin(), histogram.buckets().end(),
+                      ","));
+}
+
+static void dump_metrics(Sink& sink, Context& root) {
+  Metrics const& metrics = root.metrics();
+  fmt::memory_buffer buffer;
+
+  format_to(buffer, FMT_STRING("Counters:\n"));
+  for (std::size_t i = 0; i < Metrics::counter_count; ++i) {
+    auto const counter = static_cast<Metrics::Counter>(i);
+    format_to(buffer, FMT_STRING("  {:<20} {:>8}\n"),
+              Metrics::nameOf(counter), metrics.get(counter));
+  }
+
+  format_to(buffer, FMT_STRING("Distributions:\n"));
+  for (std::size_t i = 0; i < Metrics::distribution_count; ++i) {
+    auto const distribution = static_cast<Metrics::Distribution>(i);
+    format_histogram(buffer, Metrics::nameOf(distribution),
+                     metrics.get(distribution));
+  }
+
+  using Entry = Metrics::ServiceMap::value_type;
+  std::vector<Entry const*> slowest;
+  for (Entry const& entry : metrics.services()) {
+    slowest.push_back(&entry);
+  }
+
+  std::sort(slowest.begin(), slowest.end(),
+            [](Entry const* left, Entry const* right) {
+              return left->second.start.total() > right->second.start.total();
+            });
+
+  if (slowest.size() > metrics_slowest_services) {
+    slowest.resize(metrics_slowest_services);
+  }
+
+  format_to(buffer, FMT_STRING("Slowest services (start us):\n"));
+  for (Entry const* entry : slowest) {
+    if (Ref<Service> const current = root.lookup(Guid(entry->first))) {
+      format_to(buffer, FMT_STRING("  [{:>4}] {:>8} (stop: {:>8}) {}\n"),
+                entry->first, entry->second.start.total(),
+                entry->second.stop.total(), *current);
+    }
+  }
+
+  sink.write(buffer);
+}
+
+static void dump_metrics_json(Sink& sink, Context& root) {
+  Metrics const& metrics = root.metrics();
+  fmt::memory_buffer buffer;
+
+  format_to(buffer, FMT_STRING("{{\"counters\":{{"));
+  for (std::size_t i = 0; i < Metrics::counter_count; ++i) {
+    auto const counter = static_cast<Metrics::Counter>(i);
+    format_to(buffer, FMT_STRING("{}\"{}\":{}"), i ? "," : "",
+              Metrics::nameOf(counter), metrics.get(counter));
+  }
+
+  format_to(buffer, FMT_STRING("}},\"distributions\":{{"));
+  for (std::size_t i = 0; i < Metrics::distribution_count; ++i) {
+    auto const distribution = static_cast<Metrics::Distribution>(i);
+    format_to(buffer, FMT_STRING("{}\"{}\":"), i ? "," : "",
+              Metrics::nameOf(distribution));
+    format_histogram_json(buffer, metrics.get(distribution));
+  }
+
+  format_to(buffer, FMT_STRING("}},\"services\":["));
+  bool first = true;
+  for (auto const& entry : metrics.services()) {
+    if (Ref<Service> const current = root.lookup(Guid(entry.first))) {
+      format_to(buffer, FMT_STRING("{}{{\"guid\":{},\"name\":\""),
+                first ? "" : ",", entry.first);
+      detail::format_json_string(buffer, fmt::format("{}", current->name()));
+      format_to(buffer, FMT_STRING("\",\"start_us\":"));
+      format_histogram_json(buffer, entry.second.start);
+      format_to(buffer, FMT_STRING(",\"stop_us\":"));
+      format_histogram_json(buffer, entry.second.stop);
+      format_to(buffer, FMT_STRING("}}"));
+      first = false;
+    }
+  }
+  format_to(buffer, FMT_STRING("]}}"));
+
+  sink.write(buffer);
+}
+
+continuable<> MetricsCommand::invoke(Ref<Session> session, Arguments&& args) {
+  return root().event_loop().async_post(
+      [root = &root(), session = std::move(session),
+       args = std::move(args)]() mutable {
+        Sink& sink = session->sink();
+
+        if ((args.size() >= 1) && (args.get_string(0) == "json")) {
+          dump_metrics_json(sink, *root);
+        } else {
+          dump_metrics(sink, *root);
+        }
+      });
+}
+
+static void export_trace(Sink& sink, Tracing const& tracing,
+                         StringView file_path) {
+  std::string const path(file_path.begin(), file_path.end());
+
+  std::ofstream file(path, std::ofstream::trunc);
+  if (!file.is_open()) {
+    fmt::memory_buffer buffer;
+    format_to(buffer, FMT_STRING("Failed to open '{}' for writing!"), path);
+    sink.write(buffer);
+    return;
+  }
+
+  tracing.write(file);
+
+  fmt::memory_buffer buffer;
+  format_to(buffer,
+            FMT_STRING("Exported the trace to '{}', open it through "
+                       "chrome://tracing or ui.perfetto.dev"),
+            path);
+  sink.write(buffer);
+}
+
+continuable<> TraceCommand::invoke(Ref<Session> session, Arguments&& args) {
+  return root().event_loop().async_post(
+      [root = &root(), session = std::move(session),
+       args = std::move(args)]() mutable {
+        Sink& sink = session->sink();
+        Tracing& tracing = root->tracing();
+
+        StringView const action = args.empty() ? StringView{}
+                                               : args.get_string(0);
+        if (action == "on") {
+          tracing.setEnabled(true);
+        } else if (action == "off") {
+          tracing.setEnabled(false);
+        } else if (action == "clear") {
+          tracing.clear();
+        } else if ((action == "export") && (args.size() >= 2)) {
+          export_trace(sink, tracing, args.get_string(1));
+          return;
+        }
+
+        fmt::memory_buffer buffer;
+        format_to(buffer, FMT_STRING("Tracing is {}, {} events ({} dropped)"),
+                  tracing.isEnabled() ? "on" : "off", tracing.events().size(),
+                  tracing.dropped());
+        sink.write(buffer);
+      });
+}
+
 Ref<GraphShowCommand> GraphShowCommand::create(Inheritance parent) {
   return spawn<graph_show_command_impl>(std::move(parent));
 }
@@ -398,7 +398,7 @@ void CommandLineImpl::onActivityUpdate(Activity const& activity) noexcept {
 
 static constexpr StringView progress_bar = "-\\|/-\\|/";
 
-void CommandLineImpl::update(Clock::time_point now) noexcept {
+void CommandLineImpl::update(Clock::TimePoint now) noexcept {
   IDLE_ASSERT(root().is_on_event_loop());
 
   auto const& activities = activities_->activities();
@@ -423,7 +423,7 @@ void CommandLineImpl::update(Clock::time_point now) noexcept {
   }
 }
 
-void CommandLineImpl::schedule(Clock::duration next) noexcept {
+void CommandLineImpl::schedule(Clock::Duration next) noexcept {
   IDLE_ASSERT(root().is_on_event_loop());
 
   scheduled_ = true;
@@ -431,7 +431,7 @@ void CommandLineImpl::schedule(Clock::duration next) noexcept {
   timer_->waitFor(next).then(wrap(*this,
                                   [](auto&& me) {
                                     me->scheduled_ = false;
-                                    me->update(Clock::now());
+                                    me->update(me->clock_->now());
                                   }),
                              root().event_loop().through_post());
 }
@@ -439,7 +439,7 @@ void CommandLineImpl::schedule(Clock::duration next) noexcept {
 void CommandLineImpl::debounce() noexcept {
   IDLE_ASSERT(root().is_on_event_loop());
 
-  auto const now = Clock::now();
+  auto const now = clock_->now();
   auto const diff = now - last_;
 
   if (diff > frequency_) {
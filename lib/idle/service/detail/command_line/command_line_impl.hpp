@@ -35,6 +35,7 @@
 #include <idle/core/parts/thread.hpp>
 #include <idle/core/util/upcastable.hpp>
 #include <idle/interface/activity.hpp>
+#include <idle/interface/clock.hpp>
 #include <idle/interface/command.hpp>
 #include <idle/interface/command_processor.hpp>
 #include <idle/interface/log_sink_facade.hpp>
@@ -118,8 +119,6 @@ class CommandLineImpl final
     public LogSinkFacade<CommandLineImpl>,
     public Upcastable<CommandLineImpl> {
 
-  using Clock = std::chrono::steady_clock;
-
 public:
   using Extends<CommandLine, Thread, Logger, Command,
                 ActivityListener>::Extends;
@@ -160,8 +159,8 @@ protected:
   void onActivityDel(Activity const& activity) noexcept override;
   void onActivityUpdate(Activity const& activity) noexcept override;
 
-  void update(Clock::time_point now) noexcept;
-  void schedule(Clock::duration next) noexcept;
+  void update(Clock::TimePoint now) noexcept;
+  void schedule(Clock::Duration next) noexcept;
   void debounce() noexcept;
 
 private:
@@ -178,6 +177,7 @@ private:
   Dependency<CommandProcessor> command_processor_{*this};
   Dependency<Store> store_{*this};
   Component<Timer> timer_{*this};
+  Dependency<Clock> clock_{*this};
   Dependency<Activities> activities_{*this};
 
   Store::ID record_;
@@ -194,8 +194,8 @@ private:
   StreambufToSink sink_out_;
   StreambufToSink sink_err_;
 
-  Clock::duration frequency_{std::chrono::milliseconds(500)};
-  Clock::time_point last_;
+  Clock::Duration frequency_{std::chrono::milliseconds(500)};
+  Clock::TimePoint last_;
   bool scheduled_{false};
   std::size_t step_{0};
 };
@@ -162,7 +162,7 @@ FileWatcherImpl::watchImpl(duration debounce_time) {
 
               if (!me->changes_.empty()) {
                 if (initialized ||
-                    has_elapsed(me->time_last_changed_, debounce_time)) {
+                    me->has_elapsed(me->time_last_changed_, debounce_time)) {
                   // Resolve the previous promise in case any
                   // changes were made meanwhile
                   IDLE_DETAIL_LOG_TRACE("Resolving promise "
@@ -175,7 +175,8 @@ FileWatcherImpl::watchImpl(duration debounce_time) {
                   // Resolve the promise later or when the timer has elapsed
                   me->promise_.emplace(PromisePair{std::move(promise), //
                                                    debounce_time});
-                  me->debounce(clock_type::now() - me->time_last_changed_);
+                  me->debounce(me->clock_->now() -
+                               me->time_last_changed_);
                 }
               } else {
                 IDLE_DETAIL_LOG_TRACE("Storing promise for later resolution "
@@ -300,7 +301,7 @@ void FileWatcherImpl::handleFileAction(efsw::WatchID /*watchid*/,
         if (me->promise_) {
           me->debounce(me->promise_->debounce_time_);
         } else {
-          me->time_last_changed_ = clock_type::now();
+          me->time_last_changed_ = me->clock_->now();
         }
       }));
 }
@@ -345,6 +346,7 @@ continuable<> FileWatcherImpl::onStop() {
   return async([this] {
     removeWatches();
 
+    ++debounce_generation_;
     debounce_timer_->cancel();
     debounce_timer_.reset();
 
@@ -373,6 +375,22 @@ void FileWatcherImpl::removeWatches() {
 void FileWatcherImpl::debounce(duration debounce_time) {
   IDLE_ASSERT(root().is_on_event_loop());
 
+  if (clock_->isSimulated()) {
+    // A simulated clock is never observed by the platform timer,
+    // alarms that were superseded by a later debounce are discarded.
+    std::size_t const generation = ++debounce_generation_;
+
+    clock_->alarm(clock_->now() + debounce_time,
+                  [handle = handleOf(*this), generation] {
+                    if (auto me = handle.lock()) {
+                      if (generation == me->debounce_generation_) {
+                        me->resolve();
+                      }
+                    }
+                  });
+    return;
+  }
+
   debounce_timer_->expires_from_now(debounce_time);
 
   debounce_timer_->async_wait(cti::use_continuable)
@@ -397,8 +415,8 @@ void FileWatcherImpl::resolve() {
 }
 
 bool FileWatcherImpl::has_elapsed(time_point time_point,
-                                  duration duration) noexcept {
-  return clock_type::now() - time_point >= duration;
+                                  duration duration) const noexcept {
+  return clock_->now() - time_point >= duration;
 }
 
 void FileWatcherImpl::add_files_recursively(boost::filesystem::path const& dir,
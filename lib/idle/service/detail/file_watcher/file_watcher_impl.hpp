@@ -40,6 +40,7 @@
 #include <idle/core/util/lazy.hpp>
 #include <idle/core/util/string_view.hpp>
 #include <idle/core/util/upcastable.hpp>
+#include <idle/interface/clock.hpp>
 #include <idle/interface/io_context.hpp>
 #include <idle/service/file_watcher.hpp>
 
@@ -118,7 +119,7 @@ private:
   void debounce(duration debounce_time);
 
   void resolve();
-  static bool has_elapsed(time_point time_point, duration duration) noexcept;
+  bool has_elapsed(time_point time_point, duration duration) const noexcept;
 
   void add_files_recursively(boost::filesystem::path const& dir,
                              bool recursive);
@@ -130,10 +131,13 @@ private:
   };
 
   Dependency<FileWatcherInstance> instance_{*this};
+  Dependency<Clock> clock_{*this};
 
   Config config_;
   bool initial_add_{false};
   Lazy<boost::asio::basic_waitable_timer<clock_type>> debounce_timer_;
+  /// Invalidates alarms of a simulated clock that were rescheduled
+  std::size_t debounce_generation_{0};
   FileChanges changes_;
   time_point time_last_changed_;
   Lazy<PromisePair> promise_;
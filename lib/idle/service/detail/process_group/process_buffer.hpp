@@ -0,0 +1,168 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_SERVICE_DETAIL_PROCESS_GROUP_PROCESS_BUFFER_HPP_INCLUDED
+#define IDLE_SERVICE_DETAIL_PROCESS_GROUP_PROCESS_BUFFER_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <idle/core/ref.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/core/util/string_view.hpp>
+#include <idle/service/sink.hpp>
+
+namespace idle {
+namespace detail {
+/// A pool of fixed size buffers that are reused by the streamed processes,
+/// such that spawning a process doesn't allocate new stream buffers.
+class ProcessBufferPool {
+public:
+  using Buffer = std::unique_ptr<char[]>;
+
+  static constexpr std::size_t buffer_size = 16U * 1024U;
+  static constexpr std::size_t max_cached = 16U;
+
+  Buffer acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_.empty()) {
+        Buffer buffer = std::move(free_.back());
+        free_.pop_back();
+        return buffer;
+      }
+    }
+
+    return Buffer(new char[buffer_size]);
+  }
+
+  void release(Buffer buffer) {
+    IDLE_ASSERT(buffer);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < max_cached) {
+      free_.push_back(std::move(buffer));
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<Buffer> free_;
+};
+
+/// Receives the output of a process chunk-wise into a pooled buffer
+/// and writes it to the sink directly out of the buffer.
+class ProcessStreamBuffer {
+public:
+  explicit ProcessStreamBuffer(Sink& sink, Ref<ProcessBufferPool> pool,
+                               bool split_lines)
+    : pool_(std::move(pool))
+    , buffer_(pool_->acquire())
+    , sink_(sink)
+    , split_lines_(split_lines) {}
+
+  ~ProcessStreamBuffer() {
+    pool_->release(std::move(buffer_));
+  }
+
+  ProcessStreamBuffer(ProcessStreamBuffer&&) = delete;
+  ProcessStreamBuffer(ProcessStreamBuffer const&) = delete;
+  ProcessStreamBuffer& operator=(ProcessStreamBuffer&&) = delete;
+  ProcessStreamBuffer& operator=(ProcessStreamBuffer const&) = delete;
+
+  /// Returns the free space behind the pending line to read into
+  char* free_data() noexcept {
+    return buffer_.get() + pending_;
+  }
+  std::size_t free_size() const noexcept {
+    return ProcessBufferPool::buffer_size - pending_;
+  }
+
+  /// Writes the received data to the sink, where only the newly received
+  /// data is scanned for delimiters, and keeps incomplete lines pending.
+  void consume(std::size_t length) {
+    IDLE_ASSERT(length <= free_size());
+
+    char* const data = buffer_.get();
+    std::size_t const end = pending_ + length;
+
+    if (!split_lines_) {
+      sink_.write(StringView(data, end));
+      pending_ = 0U;
+      return;
+    }
+
+    std::size_t begin = 0U;
+    char const* const last = data + end;
+    char const* cursor = data + pending_;
+    while (auto const* found = static_cast<char const*>(std::memchr(
+               cursor, delimiter, static_cast<std::size_t>(last - cursor)))) {
+      if (found != data + begin) {
+        sink_.write(StringView(
+            data + begin, static_cast<std::size_t>(found - (data + begin))));
+      }
+
+      begin = static_cast<std::size_t>(found - data) + 1U;
+      cursor = found + 1;
+    }
+
+    if ((begin == 0U) && (end == ProcessBufferPool::buffer_size)) {
+      // The line doesn't fit into the buffer, write it partially
+      // to keep the memory bounded.
+      sink_.write(StringView(data, end));
+      pending_ = 0U;
+    } else {
+      pending_ = end - begin;
+      if (pending_ && begin) {
+        std::memmove(data, data + begin, pending_);
+      }
+    }
+  }
+
+  /// Writes the remaining incomplete line
+  void flush() {
+    if (pending_) {
+      sink_.write(StringView(buffer_.get(), pending_));
+      pending_ = 0U;
+    }
+  }
+
+private:
+  static constexpr char delimiter = '\n';
+
+  Ref<ProcessBufferPool> pool_;
+  ProcessBufferPool::Buffer buffer_;
+  /// The size of the incomplete line at the front of the buffer
+  std::size_t pending_{0U};
+  Sink& sink_;
+  bool const split_lines_;
+};
+} // namespace detail
+} // namespace idle
+
+#endif // IDLE_SERVICE_DETAIL_PROCESS_GROUP_PROCESS_BUFFER_HPP_INCLUDED
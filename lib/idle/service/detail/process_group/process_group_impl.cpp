@@ -137,7 +137,7 @@ continuable<ProcessResult> ProcessGroupImpl::spawn_streamed_impl(
 
   using trait = spawn_trait<StreamedProcessResultDataImpl, ProcessResultData>;
   return trait::spawn_from(*this, std::move(executable), std::move(arguments),
-                           std::move(options), std::move(stream));
+                           std::move(options), std::move(stream), buffers_);
 }
 
 continuable<> ProcessGroupImpl::open_impl(std::string&& file_path,
@@ -26,8 +26,11 @@
 #ifndef IDLE_SERVICE_DETAIL_PROCESS_GROUP_PROCESS_GROUP_IMPL_HPP_INCLUDED
 #define IDLE_SERVICE_DETAIL_PROCESS_GROUP_PROCESS_GROUP_IMPL_HPP_INCLUDED
 
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/process/group.hpp>
@@ -45,6 +48,7 @@
 #include <idle/core/util/upcastable.hpp>
 #include <idle/interface/io_context.hpp>
 #include <idle/service/detail/process_group/async_process.hpp>
+#include <idle/service/detail/process_group/process_buffer.hpp>
 #include <idle/service/process_group.hpp>
 
 namespace idle {
@@ -166,17 +170,17 @@ public:
   explicit StreamedProcessResultDataImpl(
       boost::asio::io_context::strand& strand,
       promise<Ref<ProcessResultData>> promise, bool throw_on_bad_exit_code,
-      StreamingOptions&& options)
+      StreamingOptions&& options, Ref<detail::ProcessBufferPool> const& pool)
     : ProcessFrame<StreamedProcessResultDataImpl, ProcessResultData>(
           strand, std::move(promise), throw_on_bad_exit_code)
     , options_(std::move(options)) {
 
     if (options_.out) {
-      out_.emplace(strand, *options_.out);
+      out_.emplace(strand, *options_.out, pool, options_.split_lines);
     }
 
     if (options_.err) {
-      err_.emplace(strand, *options_.err);
+      err_.emplace(strand, *options_.err, pool, options_.split_lines);
     }
   }
 
@@ -203,11 +207,11 @@ public:
 
   void onSpawned() {
     if (out_) {
-      async_read_line(refOf(*this).pin(*out_));
+      async_read_chunk(refOf(*this).pin(*out_));
     }
 
     if (err_) {
-      async_read_line(refOf(*this).pin(*err_));
+      async_read_chunk(refOf(*this).pin(*err_));
     }
   }
 
@@ -228,11 +232,18 @@ public:
 private:
   int exit_code_{EXIT_FAILURE};
 
+  /// Reads the output of the process into a fixed size buffer and writes it
+  /// to the sink directly out of the buffer.
+  ///
+  /// The next read is only issued after the sink consumed the previous one,
+  /// such that a slow sink throttles the process through its pipe
+  /// instead of buffering its output without bounds.
   struct Stream {
-    explicit Stream(boost::asio::io_context::strand& strand_, Sink& sink_)
+    explicit Stream(boost::asio::io_context::strand& strand_, Sink& sink_,
+                    Ref<detail::ProcessBufferPool> pool_, bool split_lines_)
       : strand(strand_)
       , pipe(strand_.context())
-      , sink(sink_) {
+      , buffer(sink_, std::move(pool_), split_lines_) {
 
       IDLE_ASSERT(pipe.is_open());
       IDLE_ASSERT(pipe.native_sink());
@@ -251,49 +262,50 @@ private:
       return pipe.is_open();
     }
 
+    auto free_space() noexcept {
+      return boost::asio::buffer(buffer.free_data(), buffer.free_size());
+    }
+
+    void consume(std::size_t length) {
+      buffer.consume(length);
+    }
+
+    void flush() {
+      buffer.flush();
+    }
+
     boost::asio::io_context::strand& strand;
     boost::process::async_pipe pipe;
-    boost::asio::streambuf buffer;
-    Sink& sink;
+    detail::ProcessStreamBuffer buffer;
   };
 
-  static constexpr char delimiter = '\n';
-  static constexpr std::size_t delimiter_length = 1;
-
-  static void async_read_line(Ref<Stream>&& stream) {
+  static void async_read_chunk(Ref<Stream>&& stream) {
     IDLE_ASSERT(stream);
     Stream& current = *stream;
 
-    boost::asio::async_read_until(
-        current.pipe, current.buffer, delimiter,
+    current.pipe.async_read_some(
+        current.free_space(),
         [stream = std::move(stream)](boost::system::error_code const& ec,
                                      std::size_t length) mutable {
           IDLE_ASSERT(stream);
-          IDLE_ASSERT(length != 0 || ec);
 
           if (ec) {
             if (ec != boost::asio::error::broken_pipe &&
                 ec != boost::asio::error::misc_errors::eof) {
               IDLE_DETAIL_LOG_ERROR(
-                  "async_read_line: Size: {}, Value: {}, Message: '{}'", length,
-                  ec.value(), ec.message());
-            }
-          } else {
-            IDLE_ASSERT(length);
-
-            if (length > delimiter_length) {
-              stream->sink.write(
-                  StringView(&*buffers_begin(stream->buffer.data()),
-                             length - delimiter_length));
+                  "async_read_chunk: Size: {}, Value: {}, Message: '{}'",
+                  length, ec.value(), ec.message());
             }
 
-            stream->buffer.consume(length);
+            stream->flush();
+          } else {
+            stream->consume(length);
 
             Stream& current = *stream;
             boost::asio::post(current.strand,
                               [stream = std::move(stream)]() mutable {
                                 if (stream->is_open()) {
-                                  async_read_line(std::move(stream));
+                                  async_read_chunk(std::move(stream));
                                 }
                               });
           }
@@ -356,6 +368,8 @@ private:
   Dependency<IOContext> io_context_{*this};
   Lazy<boost::asio::io_context::strand> strand_;
   Lazy<boost::process::group> group_;
+  Ref<detail::ProcessBufferPool> buffers_{
+      make_ref<detail::ProcessBufferPool>()};
 };
 } // namespace idle
 
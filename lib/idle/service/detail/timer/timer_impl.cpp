@@ -58,6 +58,7 @@ continuable<> timer_impl::onStart() {
 
 continuable<> timer_impl::onStop() {
   return async([this] {
+    ++generation_;
     timer_->cancel();
     timer_.reset();
     strand_.reset();
@@ -66,10 +67,10 @@ continuable<> timer_impl::onStop() {
 
 continuable<> timer_impl::wait_for_impl(Duration exact) {
   return [weak = weakOf(this), exact](auto&& promise) {
-    // The timepoint when the continuable shall be resolved
-    auto const deadline = clock_type::now() + exact;
-
     if (auto me = weak.lock()) {
+      // The timepoint when the continuable shall be resolved
+      auto const deadline = me->clock_->now() + exact;
+
       boost::asio::post(*me->strand_, [weak = std::move(weak), deadline,
                                        promise = std::forward<
                                            decltype(promise)>(
@@ -87,7 +88,7 @@ continuable<> timer_impl::wait_for_impl(Duration exact) {
 continuable<> timer_impl::wait_for_impl(Duration min, Duration max) {
   return [weak = weakOf(this), min, max](auto&& promise) mutable {
     if (auto me = weak.lock()) {
-      auto now = clock_type::now();
+      auto now = me->clock_->now();
 
       boost::asio::post(*me->strand_, [weak = std::move(weak), now, min, max,
                                        promise = std::forward<
@@ -158,7 +159,7 @@ void timer_impl::ready(boost::system::error_code const& error) {
       IDLE_ASSERT(!me->queue_.empty());
 
       // Resolve all pending timed events
-      auto const now = clock_type::now();
+      auto const now = me->clock_->now();
       while (!me->queue_.empty() && (me->queue_.top().deadline_ <= now)) {
         auto const& top = me->queue_.top();
 
@@ -176,6 +177,21 @@ void timer_impl::ready(boost::system::error_code const& error) {
 }
 
 void timer_impl::schedule(TimePoint deadline) {
+  if (clock_->isSimulated()) {
+    // A simulated clock is never observed by the platform timer,
+    // alarms that were superseded by a later schedule are discarded.
+    std::size_t const generation = ++generation_;
+
+    clock_->alarm(deadline, [weak = weakOf(this), generation] {
+      if (auto me = weak.lock()) {
+        if (generation == me->generation_) {
+          me->ready({});
+        }
+      }
+    });
+    return;
+  }
+
   timer_->expires_at(deadline);
 
   timer_->async_wait([this](boost::system::error_code const& error) {
@@ -37,6 +37,7 @@
 #include <idle/core/ref.hpp>
 #include <idle/core/registry.hpp>
 #include <idle/core/util/upcastable.hpp>
+#include <idle/interface/clock.hpp>
 #include <idle/interface/io_context.hpp>
 #include <idle/service/timer.hpp>
 
@@ -76,10 +77,13 @@ private:
   void deposit(timed_work&& work);
 
   Dependency<IOContext> io_context_{*this};
+  Dependency<Clock> clock_{*this};
   optional<boost::asio::basic_waitable_timer<clock_type>> timer_;
   optional<boost::asio::io_context::strand> strand_;
   std::default_random_engine random_engine_;
   std::priority_queue<timed_work> queue_;
+  /// Invalidates alarms of a simulated clock that were rescheduled
+  std::size_t generation_{0};
 };
 } // namespace idle
 
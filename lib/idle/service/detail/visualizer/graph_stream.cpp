@@ -0,0 +1,139 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <functional>
+#include <utility>
+#include <idle/core/context.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/extra/graphviz.hpp>
+#include <idle/service/detail/visualizer/graph_stream.hpp>
+
+namespace idle {
+GraphStream::GraphStream(Context& root, GraphFlags flags,
+                         std::string file_path,
+                         std::shared_ptr<GraphSnapshot const> previous)
+  : graph_(root, graph_view, flags)
+  , file_path_(std::move(file_path))
+  , previous_(std::move(previous))
+  , current_(std::make_shared<GraphSnapshot>()) {
+
+  pending_.push_back(weakOf(static_cast<Service&>(root)));
+}
+
+bool GraphStream::next(std::string& buffer, std::size_t count) {
+  IDLE_ASSERT(graph_.get_context().is_on_event_loop());
+
+  if (!started_) {
+    started_ = true;
+
+    record_.str(std::string());
+    graphvizHead(record_);
+    if (previous_) {
+      record_ << "// Contains only services that changed since the previous "
+                 "snapshot\n";
+    }
+    buffer += record_.str();
+  }
+
+  std::size_t rendered = 0U;
+  while ((rendered < count) && !pending_.empty()) {
+    Ref<Service> current = pending_.back().lock();
+    pending_.pop_back();
+
+    // Services might have been destroyed in between two chunks
+    if (!current || current->state().isDestroyedUnsafe()) {
+      continue;
+    }
+
+    render(buffer, *current);
+    ++rendered;
+
+    for (Part& part : current->parts()) {
+      for (Service& child : part.children()) {
+        pending_.push_back(weakOf(child));
+      }
+    }
+  }
+
+  return !pending_.empty();
+}
+
+void GraphStream::write(std::string const& buffer) {
+  if (!file_.is_open()) {
+    file_.open(file_path_, std::ios::trunc);
+  }
+
+  file_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+bool GraphStream::finish() {
+  if (!file_.is_open()) {
+    file_.open(file_path_, std::ios::trunc);
+  }
+
+  if (previous_) {
+    for (auto const& entry : *previous_) {
+      if (current_->find(entry.first) == current_->end()) {
+        file_ << "// removed \"" << Guid::fromValue(entry.first).hex()
+              << "\"\n";
+      }
+    }
+  }
+
+  graphvizTail(file_);
+  file_.close();
+  return !file_.fail();
+}
+
+std::shared_ptr<GraphSnapshot const> GraphStream::release() noexcept {
+  return std::move(current_);
+}
+
+void GraphStream::render(std::string& buffer, Service& current) {
+  record_.str(std::string());
+
+  graphvizNode(record_, current);
+  for (Edge const& edge : out_edges(&current, graph_)) {
+    graphvizEdge(record_, edge, graph_);
+  }
+
+  std::string const record = record_.str();
+  std::size_t const fingerprint = std::hash<std::string>{}(record);
+  Guid::Value const id = current.guid().value();
+
+  current_->emplace(id, fingerprint);
+
+  if (previous_) {
+    auto const itr = previous_->find(id);
+    if ((itr != previous_->end()) && (itr->second == fingerprint)) {
+      // The service and its outgoing edges are unchanged
+      return;
+    }
+  }
+
+  buffer += record;
+}
+} // namespace idle
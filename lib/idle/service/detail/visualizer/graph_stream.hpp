@@ -0,0 +1,91 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_SERVICE_DETAIL_VISUALIZER_GRAPH_STREAM_HPP_INCLUDED
+#define IDLE_SERVICE_DETAIL_VISUALIZER_GRAPH_STREAM_HPP_INCLUDED
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <idle/core/detail/unordered_map.hpp>
+#include <idle/core/graph.hpp>
+#include <idle/core/guid.hpp>
+#include <idle/core/ref.hpp>
+
+namespace idle {
+/// Stores the fingerprint of every exported service together with
+/// its outgoing edges
+using GraphSnapshot = detail::unordered_map<Guid::Value, std::size_t>;
+
+/// Streams the ServiceDependencyGraph into a graphviz file
+///
+/// The graph is rendered in chunks on the event loop through next,
+/// while the rendered chunks are written from a worker thread through
+/// write and finish. A service is only rendered if it or one of its
+/// outgoing edges has changed since the previous snapshot (if any).
+class GraphStream {
+public:
+  explicit GraphStream(Context& root, GraphFlags flags, std::string file_path,
+                       std::shared_ptr<GraphSnapshot const> previous);
+
+  /// Renders the next services into the buffer
+  ///
+  /// \returns false if all services were rendered
+  ///
+  /// \attention Must be called on the event loop.
+  bool next(std::string& buffer, std::size_t count);
+
+  /// Writes a rendered chunk to the file
+  void write(std::string const& buffer);
+
+  /// Writes the services that were removed since the previous snapshot
+  /// and closes the file.
+  ///
+  /// \returns false if the file could not be written
+  bool finish();
+
+  /// Returns the snapshot of the exported graph
+  ///
+  /// \attention Must be called after finish.
+  std::shared_ptr<GraphSnapshot const> release() noexcept;
+
+private:
+  void render(std::string& buffer, Service& current);
+
+  ServiceDependencyGraph const graph_;
+  std::string const file_path_;
+  std::shared_ptr<GraphSnapshot const> const previous_;
+  std::shared_ptr<GraphSnapshot> current_;
+  std::vector<WeakRef<Service>> pending_;
+  std::ostringstream record_;
+  std::ofstream file_;
+  bool started_{false};
+};
+} // namespace idle
+
+#endif // IDLE_SERVICE_DETAIL_VISUALIZER_GRAPH_STREAM_HPP_INCLUDED
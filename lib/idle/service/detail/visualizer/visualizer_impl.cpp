@@ -23,8 +23,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <chrono>
+#include <exception>
 #include <fstream>
+#include <ios>
 #include <utility>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
@@ -35,6 +38,7 @@
 #include <idle/core/graph.hpp>
 #include <idle/core/use.hpp>
 #include <idle/extra/graphviz.hpp>
+#include <idle/service/detail/visualizer/graph_stream.hpp>
 #include <idle/service/detail/visualizer/visualizer_impl.hpp>
 
 #ifdef _MSC_VER
@@ -135,4 +139,78 @@ continuable<> VisualizerImpl::show_graph_impl(std::string file_path,
         }
       }));
 }
+
+/// The count of recent snapshots that are kept for delta exports
+static constexpr std::size_t max_snapshots = 8U;
+
+continuable<std::size_t>
+VisualizerImpl::export_graph_impl(std::string file_path, ExportOptions opt) {
+  return root().event_loop().async_dispatch(wrap(
+      *this,
+      [file_path = std::move(file_path),
+       opt = std::move(opt)](auto&& me) mutable -> continuable<std::size_t> {
+        IDLE_ASSERT(me->state().isRunning());
+
+        std::size_t const id = me->next_snapshot_++;
+        std::size_t const chunk_size = std::max(opt.chunk_size,
+                                                std::size_t(1U));
+
+        auto stream = std::make_shared<GraphStream>(
+            me->root(), opt.flags, std::move(file_path),
+            me->find_snapshot(opt.since));
+
+        // Render the next chunk on the event loop and write it from the
+        // task pool, which yields back to the event loop in between.
+        return loop(wrap(*me,
+                         [stream, chunk_size](auto&& me) {
+                           std::string chunk;
+                           bool const pending = stream->next(chunk,
+                                                             chunk_size);
+
+                           return me->task_pool_
+                               ->async_post(
+                                   [stream, chunk = std::move(chunk)] {
+                                     stream->write(chunk);
+                                   })
+                               .then(
+                                   [pending]() -> loop_result<> {
+                                     if (pending) {
+                                       return loop_continue();
+                                     } else {
+                                       return loop_break();
+                                     }
+                                   },
+                                   me->root().event_loop().through_post());
+                         }))
+            .then(me->task_pool_->async_post([stream] {
+              return stream->finish();
+            }))
+            .then(wrap(*me,
+                       [id, stream](bool written,
+                                    auto&& me) -> result<std::size_t> {
+                         if (!written) {
+                           return exceptional_result(
+                               std::make_exception_ptr(std::ios_base::failure(
+                                   "Failed to write the graph!")));
+                         }
+
+                         me->snapshots_.emplace_back(id, stream->release());
+                         if (me->snapshots_.size() > max_snapshots) {
+                           me->snapshots_.pop_front();
+                         }
+                         return make_result(id);
+                       }),
+                  me->root().event_loop().through_post());
+      }));
+}
+
+std::shared_ptr<GraphSnapshot const>
+VisualizerImpl::find_snapshot(std::size_t id) const {
+  for (auto const& snapshot : snapshots_) {
+    if (snapshot.first == id) {
+      return snapshot.second;
+    }
+  }
+  return nullptr;
+}
 } // namespace idle
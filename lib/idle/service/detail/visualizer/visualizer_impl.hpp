@@ -26,8 +26,15 @@
 #ifndef IDLE_SERVICE_DETAIL_VISUALIZER_VISUALIZER_IMPL_HPP_INCLUDED
 #define IDLE_SERVICE_DETAIL_VISUALIZER_VISUALIZER_IMPL_HPP_INCLUDED
 
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <utility>
 #include <idle/core/parts/component.hpp>
+#include <idle/core/parts/dependency.hpp>
 #include <idle/core/util/upcastable.hpp>
+#include <idle/interface/task_pool.hpp>
+#include <idle/service/detail/visualizer/graph_stream.hpp>
 #include <idle/service/process_group.hpp>
 #include <idle/service/visualizer.hpp>
 
@@ -41,8 +48,19 @@ public:
 
   continuable<> show_graph_impl(std::string file_path, Options opt);
 
+  continuable<std::size_t> export_graph_impl(std::string file_path,
+                                             ExportOptions opt);
+
 private:
+  std::shared_ptr<GraphSnapshot const> find_snapshot(std::size_t id) const;
+
   Component<ProcessGroup> process_group_{*this};
+  Dependency<TaskPool> task_pool_{*this};
+
+  /// The recently exported snapshots, which can be used for deltas
+  std::deque<std::pair<std::size_t, std::shared_ptr<GraphSnapshot const>>>
+      snapshots_;
+  std::size_t next_snapshot_{1U};
 };
 } // namespace idle
 
@@ -0,0 +1,216 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <idle/core/context.hpp>
+#include <idle/core/detail/log.hpp>
+#include <idle/core/detail/unordered_map.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/service/art/binary.hpp>
+#include <idle/service/handoff.hpp>
+
+namespace idle {
+/// The version of the buffer header, increment this on header changes
+static constexpr std::uint32_t handoff_version = 1U;
+static constexpr std::size_t handoff_header_size = sizeof(std::uint32_t) +
+                                                   sizeof(std::uint64_t);
+
+class DefaultStateHandoff final : public Implements<StateHandoff> {
+public:
+  using Implements<StateHandoff>::Implements;
+
+  Window openImpl() {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    ++windows_;
+    return Window(weakOf(static_cast<StateHandoff&>(*this)));
+  }
+
+  void closeImpl() noexcept {
+    IDLE_ASSERT(root().is_on_event_loop());
+    IDLE_ASSERT(windows_ > 0U);
+
+    if (--windows_ == 0U) {
+      if (!buffers_.empty()) {
+        IDLE_DETAIL_LOG_DEBUG("Dropping {} state(s) which were not taken",
+                              buffers_.size());
+      }
+
+      buffers_.clear();
+    }
+  }
+
+  bool isOpenImpl() const noexcept {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    return windows_ != 0U;
+  }
+
+  void putImpl(StringView key, ConstReflectionPtr state) {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    if (!windows_) {
+      return;
+    }
+
+    std::uint64_t const schema = art::schema_hash(state.reflection());
+
+    std::vector<char> buffer(handoff_header_size);
+    std::memcpy(buffer.data(), &handoff_version, sizeof(handoff_version));
+    std::memcpy(buffer.data() + sizeof(handoff_version), &schema,
+                sizeof(schema));
+
+    art::binary_serialize(buffer, state);
+
+    buffers_[std::string(key.data(), key.size())] = std::move(buffer);
+  }
+
+  bool takeImpl(StringView key, ReflectionPtr state) {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    auto const itr = buffers_.find(std::string(key.data(), key.size()));
+    if (itr == buffers_.end()) {
+      return false;
+    }
+
+    std::vector<char> const buffer = std::move(itr->second);
+    buffers_.erase(itr);
+
+    if (buffer.size() < handoff_header_size) {
+      return false;
+    }
+
+    std::uint32_t version;
+    std::memcpy(&version, buffer.data(), sizeof(version));
+    std::uint64_t schema;
+    std::memcpy(&schema, buffer.data() + sizeof(version), sizeof(schema));
+
+    if ((version != handoff_version) ||
+        (schema != art::schema_hash(state.reflection()))) {
+      IDLE_DETAIL_LOG_DEBUG("Discarding the state of '{}' because its layout "
+                            "has changed",
+                            key);
+      return false;
+    }
+
+    return art::binary_deserialize(
+        {buffer.data() + handoff_header_size,
+         buffer.size() - handoff_header_size},
+        state);
+  }
+
+private:
+  std::size_t windows_{0U};
+  detail::unordered_map<std::string, std::vector<char>> buffers_;
+
+  IDLE_SERVICE
+};
+
+StateHandoff::Window StateHandoff::open() {
+  return static_cast<DefaultStateHandoff*>(this)->openImpl();
+}
+
+bool StateHandoff::isOpen() const noexcept {
+  return static_cast<DefaultStateHandoff const*>(this)->isOpenImpl();
+}
+
+void StateHandoff::put(StringView key, ConstReflectionPtr state) {
+  static_cast<DefaultStateHandoff*>(this)->putImpl(key, state);
+}
+
+bool StateHandoff::take(StringView key, ReflectionPtr state) {
+  return static_cast<DefaultStateHandoff*>(this)->takeImpl(key, state);
+}
+
+Ref<StateHandoff> StateHandoff::create(Inheritance parent) {
+  return spawn<DefaultStateHandoff>(std::move(parent));
+}
+
+StateHandoff::Window::~Window() {
+  reset();
+}
+
+StateHandoff::Window&
+StateHandoff::Window::operator=(Window&& other) noexcept {
+  if (this != &other) {
+    reset();
+    handoff_ = std::move(other.handoff_);
+  }
+  return *this;
+}
+
+void StateHandoff::Window::reset() noexcept {
+  if (auto handoff = handoff_.lock()) {
+    Context& root = handoff->owner().root();
+
+    root.event_loop().dispatch([handoff = std::move(handoff)] {
+      static_cast<DefaultStateHandoff&>(*handoff).closeImpl();
+    });
+  }
+
+  handoff_ = nullptr;
+}
+
+HandoffBase::HandoffBase(Service& owner, std::string key)
+  : DependencyBase(owner)
+  , key_(std::move(key)) {
+
+  IDLE_ASSERT(!key_.empty());
+}
+
+void HandoffBase::partName(std::ostream& os) const {
+  print(os, FMT_STRING("idle::Handoff<{}>"), key_);
+}
+
+void HandoffBase::onImportUnlock() noexcept {
+  DependencyBase::onImportUnlock();
+
+  warm_ = false;
+}
+
+StateHandoff& HandoffBase::raw() noexcept {
+  return cast<StateHandoff>(DependencyBase::raw());
+}
+
+StateHandoff const& HandoffBase::raw() const noexcept {
+  return cast<StateHandoff>(DependencyBase::raw());
+}
+
+Interface::Id HandoffBase::type() const noexcept {
+  return StateHandoff::id();
+}
+
+bool HandoffBase::hasDefault() const noexcept {
+  return true;
+}
+
+Ref<Interface> HandoffBase::createDefault(Inheritance inh) {
+  return StateHandoff::create(std::move(inh));
+}
+} // namespace idle
@@ -0,0 +1,126 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <idle/core/context.hpp>
+#include <idle/core/detail/log.hpp>
+#include <idle/core/parts/component.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/core/util/upcastable.hpp>
+#include <idle/service/idle_timeout.hpp>
+#include <idle/service/timer.hpp>
+
+namespace idle {
+class IdleTimeoutImpl final : public IdleTimeout,
+                              public Upcastable<IdleTimeoutImpl> {
+public:
+  explicit IdleTimeoutImpl(Inheritance parent, Duration timeout)
+    : IdleTimeout(std::move(parent))
+    , timeout_(timeout) {}
+
+  continuable<> onStart() override {
+    return async([this] {
+      Service& current = guarded();
+
+      // Hold the guarded service such that it isn't stopped by the garbage
+      // collector when its users are destroyed, and start it manually such
+      // that it isn't stopped by the scheduler when its users are stopped.
+      keep_alive_ = refOf(current);
+      current.start().done();
+
+      unused_checks_ = 0U;
+      schedule();
+    });
+  }
+
+  continuable<> onStop() override {
+    return async([this] {
+      // The guarded service owns this component, thus it must not
+      // be released from inside its stop.
+      root().event_loop().post([keep_alive = std::move(keep_alive_)] {
+        (void)keep_alive;
+      });
+    });
+  }
+
+private:
+  Service& guarded() noexcept {
+    return parent().owner();
+  }
+
+  void schedule() {
+    timer_->waitFor(timeout_)
+        .then(weakly(handleOf(*this),
+                     [](auto&& me) {
+                       me->check();
+                     }),
+              root().event_loop().through_post())
+        .done();
+  }
+
+  void check() {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    Service& current = guarded();
+    if (!current.state().isRunning()) {
+      return;
+    }
+
+    if (isUsed(current)) {
+      unused_checks_ = 0U;
+    } else if (++unused_checks_ >= 2U) {
+      IDLE_DETAIL_LOG_DEBUG("Stopping {} after its idle timeout", current);
+
+      current.stop().done();
+      return;
+    }
+
+    schedule();
+  }
+
+  /// Returns true if any user of an export of the given service is running
+  static bool isUsed(Service& current) {
+    for (Export& exp : current.exports()) {
+      for (Usage& usage : exp.exports()) {
+        if (!usage.isWeak() && usage.user().owner().state().isUsable()) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  Duration const timeout_;
+  Component<Timer> timer_{*this};
+  Ref<Service> keep_alive_;
+  std::size_t unused_checks_{0U};
+
+  IDLE_SERVICE
+};
+
+Ref<IdleTimeout> IdleTimeout::create(Inheritance parent, Duration timeout) {
+  return spawn<IdleTimeoutImpl>(std::move(parent), timeout);
+}
+} // namespace idle
@@ -40,6 +40,7 @@
 #include <idle/core/parts/dependency.hpp>
 #include <idle/core/util/assert.hpp>
 #include <idle/core/util/upcastable.hpp>
+#include <idle/interface/clock.hpp>
 #include <idle/interface/logger.hpp>
 #include <idle/service/art/reflection.hpp>
 #include <idle/service/detail/default_paths.hpp>
@@ -67,8 +68,7 @@ public:
   }
 
   void bounce() {
-    TimePoint const next = std::chrono::steady_clock::now() +
-                           debounce_duration_;
+    TimePoint const next = clock_->now() + debounce_duration_;
     TimePoint previous = next_.load(std::memory_order_relaxed);
 
     if (next <= previous) {
@@ -96,7 +96,7 @@ private:
     return async(weakly(handleOf(*this), [](auto&& me) -> continuable<> {
       TimePoint const next = me->next_.load(std::memory_order_acquire) +
                              me->debounce_duration_;
-      TimePoint const now = std::chrono::steady_clock::now();
+      TimePoint const now = me->clock_->now();
 
       if (next <= now) {
         return make_ready_continuable();
@@ -107,6 +107,7 @@ private:
   }
 
   Component<Timer> timer_{*this};
+  Dependency<Clock> clock_{*this};
   Duration debounce_duration_{std::chrono::milliseconds(50)};
   std::atomic<TimePoint> next_{{}};
 };
@@ -252,10 +253,21 @@ public:
 
   bool changed(StringView key) const noexcept override;
 
+  bool equals(Properties const& other,
+              StringView key) const noexcept override;
+
 private:
   Ref<PropertiesSource const> data_;
   Ref<PropertiesSource const> previous_;
 
+  /// Caches the comparisons against other generations, such that all Vars
+  /// sharing a key only compare its subtree once per generation.
+  struct Comparison {
+    Generation other;
+    bool equal;
+  };
+  mutable std::unordered_map<std::string, Comparison> comparisons_;
+
   IDLE_SERVICE
 };
 
@@ -544,12 +556,41 @@ bool ReloablePropertiesGeneration::changed(StringView key) const noexcept {
   return !(previous_ && data_->equals(*previous_, key));
 }
 
+bool ReloablePropertiesGeneration::equals(Properties const& other,
+                                          StringView key) const noexcept {
+  IDLE_ASSERT(root().is_on_event_loop());
+
+  // Only generations of the same parent share a comparable source
+  if (&other.owner().parent() != &Super::parent()) {
+    return Properties::equals(other, key);
+  }
+
+  auto const& real = static_cast<ReloablePropertiesGeneration const&>(other);
+
+  std::string str(key.begin(), key.end());
+  auto const itr = comparisons_.find(str);
+  if (itr != comparisons_.end() && itr->second.other == real.generation()) {
+    return itr->second.equal;
+  }
+
+  bool const equal = data_->equals(*real.data_, key);
+  comparisons_[std::move(str)] = Comparison{real.generation(), equal};
+  return equal;
+}
+
 PropertiesSource::~PropertiesSource() {}
 
 Properties::Properties(Service& owner, Generation generation)
   : Interface(owner)
   , generation_(generation) {}
 
+bool Properties::equals(Properties const& other,
+                        StringView key) const noexcept {
+  (void)other;
+  (void)key;
+  return false;
+}
+
 bool Properties::operator>(Interface const& other) const noexcept {
   return generation_ > cast<Properties>(other).generation();
 }
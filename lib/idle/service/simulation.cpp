@@ -0,0 +1,314 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <utility>
+#include <boost/asio/io_context.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/dep/format.hpp>
+#include <idle/core/detail/log.hpp>
+#include <idle/core/util/assert.hpp>
+#include <idle/service/simulation.hpp>
+
+namespace idle {
+class SimulationImpl final : public Simulation {
+  struct Alarm {
+    TimePoint deadline_;
+    std::uint64_t sequence_;
+    unique_function<void()> callback_;
+
+    bool operator<(Alarm const& other) const noexcept {
+      // Alarms with an equal deadline fire in the order they were set
+      if (deadline_ == other.deadline_) {
+        return sequence_ > other.sequence_;
+      } else {
+        return deadline_ > other.deadline_;
+      }
+    }
+  };
+
+public:
+  explicit SimulationImpl(Inheritance parent)
+    : Simulation(std::move(parent))
+    , origin_(std::chrono::steady_clock::now())
+    , now_(origin_.time_since_epoch().count()) {
+    this->io_context_ = &context_;
+  }
+
+  continuable<> onStart() override {
+    return async([this] {
+      IDLE_ASSERT(!work_);
+      work_.emplace(context_);
+
+      root().setIdleHandler([this] {
+        return step();
+      });
+    });
+  }
+
+  continuable<> onStop() override {
+    return async([this] {
+      IDLE_ASSERT(!!work_);
+      root().setIdleHandler({});
+
+      // Dispatch the handlers that were posted while stopping
+      work_.reset();
+      while (context_.poll_one()) {
+        observe(Event::Kind::Handler, now(), ++handlers_);
+      }
+      context_.restart();
+
+      IDLE_DETAIL_LOG_DEBUG("Simulation stopped at {}ms with {} pending "
+                            "alarms",
+                            std::chrono::duration_cast<
+                                std::chrono::milliseconds>(now() - origin_)
+                                .count(),
+                            alarms_.size());
+
+      alarms_ = {};
+    });
+  }
+
+  TimePoint now() const noexcept override {
+    return TimePoint(Duration(now_.load(std::memory_order_acquire)));
+  }
+
+  bool isSimulated() const noexcept override {
+    return true;
+  }
+
+  void alarm(TimePoint deadline, unique_function<void()> callback) override {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    alarms_.push(Alarm{deadline, ++alarm_sequence_, std::move(callback)});
+  }
+
+  void advanceToImpl(TimePoint target) {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    if (target > now()) {
+      observe(Event::Kind::Advance, target, 0U);
+    }
+
+    while (!alarms_.empty() && (alarms_.top().deadline_ <= target)) {
+      // The queue doesn't allow moving out of its top element
+      Alarm current = std::move(const_cast<Alarm&>(alarms_.top()));
+      alarms_.pop();
+
+      if (current.deadline_ > now()) {
+        set_now(current.deadline_);
+      }
+
+      observe(Event::Kind::Alarm, now(), current.sequence_);
+      std::move(current.callback_)();
+    }
+
+    if (target > now()) {
+      set_now(target);
+    }
+  }
+
+  void setAutoAdvanceImpl(bool enabled) noexcept {
+    auto_advance_ = enabled;
+  }
+
+  void recordImpl() {
+    recording_ = true;
+  }
+
+  Trace const& traceImpl() const noexcept {
+    return trace_;
+  }
+
+  void replayImpl(Trace&& trace) {
+    IDLE_ASSERT(!state().isRunning());
+
+    replay_ = std::move(trace);
+    cursor_ = 0U;
+    divergence_.reset();
+    replaying_ = true;
+  }
+
+  optional<std::size_t> divergenceImpl() const noexcept {
+    return divergence_;
+  }
+
+private:
+  /// Makes progress on the simulation, returns false when nothing was left
+  bool step() {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    // Only one handler is dispatched at a time such that work queued
+    // on the event loop meanwhile interleaves deterministically.
+    if (context_.poll_one()) {
+      observe(Event::Kind::Handler, now(), ++handlers_);
+      return true;
+    }
+
+    if (replaying_) {
+      if ((cursor_ < replay_.size()) &&
+          (replay_[cursor_].kind == Event::Kind::Advance)) {
+        advanceToImpl(origin_ + replay_[cursor_].at);
+        return true;
+      }
+    } else if (auto_advance_ && !alarms_.empty()) {
+      advanceToImpl(alarms_.top().deadline_);
+      return true;
+    }
+
+    return false;
+  }
+
+  void observe(Event::Kind kind, TimePoint at, std::uint64_t sequence) {
+    Event const event{kind, at - origin_, sequence};
+
+    if (recording_) {
+      trace_.push_back(event);
+    }
+
+    if (replaying_ && !divergence_) {
+      if ((cursor_ < replay_.size()) && (replay_[cursor_] == event)) {
+        ++cursor_;
+      } else {
+        divergence_ = cursor_;
+
+        IDLE_DETAIL_LOG_ERROR("Simulation diverged from the replayed trace "
+                              "at event {}",
+                              cursor_);
+      }
+    }
+  }
+
+  void set_now(TimePoint time) noexcept {
+    now_.store(time.time_since_epoch().count(), std::memory_order_release);
+  }
+
+  TimePoint const origin_;
+  std::atomic<Duration::rep> now_;
+
+  boost::asio::io_context context_{1};
+  optional<boost::asio::io_context::work> work_;
+  std::priority_queue<Alarm> alarms_;
+  std::uint64_t alarm_sequence_{0U};
+  std::uint64_t handlers_{0U};
+  bool auto_advance_{true};
+
+  bool recording_{false};
+  Trace trace_;
+
+  bool replaying_{false};
+  Trace replay_;
+  std::size_t cursor_{0U};
+  optional<std::size_t> divergence_;
+
+  IDLE_SERVICE
+};
+
+void Simulation::advance(Duration duration) {
+  advanceTo(now() + duration);
+}
+
+void Simulation::advanceTo(TimePoint deadline) {
+  static_cast<SimulationImpl*>(this)->advanceToImpl(deadline);
+}
+
+void Simulation::setAutoAdvance(bool enabled) noexcept {
+  static_cast<SimulationImpl*>(this)->setAutoAdvanceImpl(enabled);
+}
+
+void Simulation::record() {
+  static_cast<SimulationImpl*>(this)->recordImpl();
+}
+
+Simulation::Trace const& Simulation::trace() const noexcept {
+  return static_cast<SimulationImpl const*>(this)->traceImpl();
+}
+
+void Simulation::replay(Trace trace) {
+  static_cast<SimulationImpl*>(this)->replayImpl(std::move(trace));
+}
+
+optional<std::size_t> Simulation::divergence() const noexcept {
+  return static_cast<SimulationImpl const*>(this)->divergenceImpl();
+}
+
+static char const* event_kind_name(Simulation::Event::Kind kind) noexcept {
+  switch (kind) {
+    case Simulation::Event::Kind::Handler:
+      return "handler";
+    case Simulation::Event::Kind::Alarm:
+      return "alarm";
+    default:
+      IDLE_ASSERT(kind == Simulation::Event::Kind::Advance);
+      return "advance";
+  }
+}
+
+void Simulation::writeTrace(std::ostream& os, Trace const& trace) {
+  for (Event const& event : trace) {
+    auto const at = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        event.at);
+
+    print(os, FMT_STRING("{} {} {}\n"), event_kind_name(event.kind),
+          at.count(), event.sequence);
+  }
+}
+
+bool Simulation::readTrace(std::istream& is, Trace& trace) {
+  std::string kind;
+  std::chrono::nanoseconds::rep at;
+  std::uint64_t sequence;
+
+  while (is >> kind >> at >> sequence) {
+    Event event{Event::Kind::Handler,
+                std::chrono::duration_cast<Duration>(
+                    std::chrono::nanoseconds(at)),
+                sequence};
+
+    if (kind == event_kind_name(Event::Kind::Handler)) {
+      event.kind = Event::Kind::Handler;
+    } else if (kind == event_kind_name(Event::Kind::Alarm)) {
+      event.kind = Event::Kind::Alarm;
+    } else if (kind == event_kind_name(Event::Kind::Advance)) {
+      event.kind = Event::Kind::Advance;
+    } else {
+      return false;
+    }
+
+    trace.push_back(event);
+  }
+
+  return is.eof();
+}
+
+Ref<Simulation> Simulation::create(Inheritance parent) {
+  return spawn<SimulationImpl>(std::move(parent));
+}
+} // namespace idle
@@ -23,64 +23,192 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <boost/asio/defer.hpp>
-#include <boost/asio/dispatch.hpp>
-#include <boost/asio/io_context.hpp>
-#include <boost/asio/post.hpp>
-#include <boost/asio/strand.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <idle/core/context.hpp>
-#include <idle/core/detail/exception_handling.hpp>
 #include <idle/core/parts/dependency.hpp>
-#include <idle/core/registry.hpp>
-#include <idle/core/util/lazy.hpp>
+#include <idle/core/util/mpsc_queue.hpp>
 #include <idle/core/util/upcastable.hpp>
 #include <idle/interface/io_context.hpp>
+#include <idle/interface/task_pool.hpp>
 #include <idle/service/strand.hpp>
 
 namespace idle {
+class StrandImpl;
+
+struct StrandWork : MpscQueueNode {
+  explicit StrandWork(work&& task_)
+    : task(std::move(task_)) {}
+
+  work task;
+};
+
+/// Returns the strand whose turn is running on the current thread
+static StrandImpl const*& strand_this_thread() noexcept {
+  static thread_local StrandImpl const* current{nullptr};
+  return current;
+}
+
 class StrandImpl : public Strand, public Upcastable<StrandImpl> {
 public:
-  using Strand::Strand;
+  explicit StrandImpl(Inheritance parent, std::size_t batch)
+    : Strand(std::move(parent))
+    , batch_(std::max(batch, std::size_t(1U))) {}
+
+  ~StrandImpl() override {
+    while (StrandWork* const current = mailbox_.pop()) {
+      std::unique_ptr<StrandWork> owned(current);
+      std::move(owned->task).set_canceled();
+    }
+  }
 
   void queue_impl(work&& work) noexcept {
-    boost::asio::dispatch(*strand_, [work = std::move(work),
-                                     actor = weakOf(this)]() mutable {
-      if (auto ref = actor.lock()) {
-        (void)ref;
-        work.set_value();
-      } else {
-        std::move(work).set_canceled();
+    auto* const current = new StrandWork(std::move(work));
+
+    // The depth is raised before the work is published, otherwise the
+    // consumer could pop and decrement it first, which wraps it around.
+    std::size_t const depth = depth_.fetch_add(1U, std::memory_order_seq_cst) +
+                              1U;
+    mailbox_.push(*current);
+
+    std::size_t max_depth = max_depth_.load(std::memory_order_relaxed);
+    while (max_depth < depth &&
+           !max_depth_.compare_exchange_weak(max_depth, depth,
+                                             std::memory_order_relaxed)) {
+    }
+
+    if (!scheduled_.exchange(true, std::memory_order_acq_rel)) {
+      schedule();
+    }
+  }
+
+  bool is_this_thread() const noexcept {
+    return strand_this_thread() == this;
+  }
+
+  Statistics statistics_impl() const noexcept {
+    Statistics statistics;
+    statistics.depth = depth_.load(std::memory_order_relaxed);
+    statistics.max_depth = max_depth_.load(std::memory_order_relaxed);
+    statistics.dispatched = dispatched_.load(std::memory_order_relaxed);
+    statistics.turns = turns_.load(std::memory_order_relaxed);
+    return statistics;
+  }
+
+  /// Dispatches up to batch_ items of the mailbox
+  void run_turn() noexcept {
+    StrandImpl const*& current = strand_this_thread();
+    StrandImpl const* const previous = current;
+    current = this;
+
+    std::size_t dispatched = 0;
+    for (; dispatched < batch_; ++dispatched) {
+      StrandWork* const item = mailbox_.pop();
+      if (!item) {
+        break;
       }
-    });
+
+      depth_.fetch_sub(1U, std::memory_order_relaxed);
+
+      std::unique_ptr<StrandWork> owned(item);
+      std::move(owned->task)();
+    }
+
+    current = previous;
+    dispatched_.fetch_add(dispatched, std::memory_order_relaxed);
+
+    if (dispatched == batch_) {
+      // Yield to other work of the executor but keep the turn
+      schedule();
+      return;
+    }
+
+    scheduled_.store(false, std::memory_order_seq_cst);
+
+    // Producers that observed the turn as scheduled before it was released
+    // rely on us to pick up their work.
+    if (depth_.load(std::memory_order_seq_cst) != 0U &&
+        !scheduled_.exchange(true, std::memory_order_acq_rel)) {
+      schedule();
+    }
   }
 
 protected:
-  continuable<> onStart() override {
-    return root().event_loop().async_post(*this, [](auto&& me) {
-      me->strand_.emplace(me->io_context_->get());
-    });
+  /// Posts a turn of this strand to the underlying executor
+  virtual void post_turn() noexcept = 0;
+
+private:
+  void schedule() noexcept {
+    turns_.fetch_add(1U, std::memory_order_relaxed);
+    post_turn();
   }
 
-  continuable<> onStop() override {
-    return root().event_loop().async_post(*this, [](auto&& me) {
-      me->strand_.reset();
+  std::size_t const batch_;
+  MpscQueue<StrandWork> mailbox_;
+  std::atomic<bool> scheduled_{false};
+
+  std::atomic<std::size_t> depth_{0U};
+  std::atomic<std::size_t> max_depth_{0U};
+  std::atomic<std::uint64_t> dispatched_{0U};
+  std::atomic<std::uint64_t> turns_{0U};
+};
+
+template <typename Executor>
+class ExecutorStrand final : public StrandImpl {
+public:
+  using StrandImpl::StrandImpl;
+
+protected:
+  void post_turn() noexcept override {
+    executor_->post([me = refOf(static_cast<StrandImpl&>(*this))] {
+      me->run_turn();
     });
   }
 
 private:
-  Dependency<IOContext> io_context_{*this};
-  Lazy<boost::asio::io_context::strand> strand_;
+  Dependency<Executor> executor_{*this};
+
+  IDLE_SERVICE
+};
+
+class EventLoopStrand final : public StrandImpl {
+public:
+  using StrandImpl::StrandImpl;
+
+protected:
+  void post_turn() noexcept override {
+    root().event_loop().post([me = refOf(static_cast<StrandImpl&>(*this))] {
+      me->run_turn();
+    });
+  }
+
+  IDLE_SERVICE
 };
 
 bool Strand::can_dispatch_inplace() const noexcept {
-  return false;
+  return StrandImpl::from(this)->is_this_thread();
 }
 
 void Strand::queue(work&& work) noexcept {
   StrandImpl::from(this)->queue_impl(std::move(work));
 }
 
-Ref<Strand> Strand::create(Inheritance parent) {
-  return spawn<StrandImpl>(std::move(parent));
+Strand::Statistics Strand::statistics() const noexcept {
+  return StrandImpl::from(this)->statistics_impl();
+}
+
+Ref<Strand> Strand::create(Inheritance parent, std::size_t batch) {
+  return spawn<ExecutorStrand<IOContext>>(std::move(parent), batch);
+}
+
+Ref<Strand> Strand::createOnTaskPool(Inheritance parent, std::size_t batch) {
+  return spawn<ExecutorStrand<TaskPool>>(std::move(parent), batch);
+}
+
+Ref<Strand> Strand::createOnEventLoop(Inheritance parent, std::size_t batch) {
+  return spawn<EventLoopStrand>(std::move(parent), batch);
 }
 } // namespace idle
@@ -23,6 +23,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <utility>
+#include <idle/core/casting.hpp>
 #include <idle/core/util/assert.hpp>
 #include <idle/service/detail/default_paths.hpp>
 #include <idle/service/properties.hpp>
@@ -65,4 +67,63 @@ void VarBase::save(ConstReflectionPtr reflected) noexcept {
 
   raw().set(reflected, key());
 }
+
+bool VarBase::isEqualIn(Interface const& from,
+                        Interface const& to) const noexcept {
+  return cast<Properties>(to).equals(cast<Properties>(from), key());
+}
+
+void VarBase::stage(Interface const& to, ReflectionPtr staged) noexcept {
+  Properties const& properties = cast<Properties>(to);
+  properties.get(staged, key());
+
+  staged_generation_ = properties.generation();
+  is_staged_ = true;
+}
+
+bool VarBase::takeStaged(Interface const& to) noexcept {
+  if (is_staged_ &&
+      (staged_generation_ == cast<Properties>(to).generation())) {
+    is_staged_ = false;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+std::size_t VarUpdates::apply() noexcept {
+  std::size_t applied = 0U;
+  for (Commit& commit : commits_) {
+    if (commit()) {
+      ++applied;
+    }
+  }
+
+  commits_.clear();
+  return applied;
+}
+
+void VarGroupBase::add(VarUpdates::Commit commit) {
+  IDLE_ASSERT(owner_.root().is_on_event_loop());
+
+  if (pending_.empty()) {
+    // The updates of all Vars are offered through separate event loop
+    // handlers, deliver the group after the ones that are queued already.
+    owner_.root().event_loop().post([this, weak = weakOf(owner_)] {
+      if (auto locked = weak.lock()) {
+        deliver();
+      }
+    });
+  }
+
+  pending_.commits_.push_back(std::move(commit));
+}
+
+void VarGroupBase::deliver() noexcept {
+  IDLE_ASSERT(owner_.root().is_on_event_loop());
+
+  VarUpdates updates;
+  std::swap(updates, pending_);
+  onUpdates(std::move(updates));
+}
 } // namespace idle
@@ -37,6 +37,12 @@ continuable<> Visualizer::showGraph(std::string file_path, Options opt) {
                                                      std::move(opt));
 }
 
+continuable<std::size_t> Visualizer::exportGraph(std::string file_path,
+                                                 ExportOptions opt) {
+  return VisualizerImpl::from(this)->export_graph_impl(std::move(file_path),
+                                                       std::move(opt));
+}
+
 Ref<Visualizer> Visualizer::create(Inheritance parent) {
   return spawn<VisualizerImpl>(std::move(parent));
 }
@@ -0,0 +1,128 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/allocation_domain.hpp>
+#include <idle/core/ref.hpp>
+
+using namespace idle;
+
+struct Counted {
+  explicit Counted(int& alive_)
+    : alive(alive_) {
+    ++alive;
+  }
+  ~Counted() {
+    --alive;
+  }
+
+  int& alive;
+};
+
+TEST_CASE("allocation domains are used by make_ref", "[allocation-domain]") {
+  Ref<AllocationDomain> domain = AllocationDomain::create();
+  REQUIRE(domain->statistics().blocks == 0);
+
+  int alive = 0;
+  std::vector<Ref<Counted>> objects;
+
+  {
+    AllocationScope scope(domain.get());
+    for (int i = 0; i < 100; ++i) {
+      objects.push_back(make_ref<Counted>(alive));
+    }
+  }
+
+  REQUIRE(alive == 100);
+  REQUIRE(domain->statistics().blocks == 100);
+  REQUIRE(domain->statistics().slabs == 1);
+
+  // Objects allocated outside of a scope use the heap
+  Ref<Counted> heap = make_ref<Counted>(alive);
+  REQUIRE(domain->statistics().blocks == 100);
+
+  objects.erase(objects.begin(), objects.begin() + 50);
+  REQUIRE(alive == 51);
+  REQUIRE(domain->statistics().blocks == 50);
+
+  // Released blocks are reused
+  {
+    AllocationScope scope(domain.get());
+    for (int i = 0; i < 50; ++i) {
+      objects.push_back(make_ref<Counted>(alive));
+    }
+  }
+
+  REQUIRE(domain->statistics().blocks == 100);
+  REQUIRE(domain->statistics().slabs == 1);
+
+  // The domain is kept alive by its objects
+  WeakRef<AllocationDomain> weak = domain;
+  domain.reset();
+  REQUIRE(!weak.expired());
+
+  objects.clear();
+  REQUIRE(weak.expired());
+  REQUIRE(alive == 1);
+}
+
+struct alignas(64) OverAligned {
+  explicit OverAligned(int& alive_)
+    : alive(alive_) {
+    ++alive;
+  }
+  ~OverAligned() {
+    --alive;
+  }
+
+  int& alive;
+};
+
+TEST_CASE("allocation domains respect over-aligned types",
+          "[allocation-domain]") {
+  Ref<AllocationDomain> domain = AllocationDomain::create();
+
+  int alive = 0;
+  std::vector<Ref<OverAligned>> objects;
+
+  {
+    AllocationScope scope(domain.get());
+    for (int i = 0; i < 10; ++i) {
+      objects.push_back(make_ref<OverAligned>(alive));
+    }
+  }
+
+  REQUIRE(alive == 10);
+  for (Ref<OverAligned> const& object : objects) {
+    REQUIRE(reinterpret_cast<std::uintptr_t>(object.get()) %
+                alignof(OverAligned) ==
+            0U);
+  }
+
+  objects.clear();
+  REQUIRE(alive == 0);
+}
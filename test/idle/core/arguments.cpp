@@ -0,0 +1,102 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/interface/arguments.hpp>
+
+using namespace idle;
+
+static std::vector<std::string> tokens_of(ArgumentsView view) {
+  std::vector<std::string> tokens;
+  for (StringView const token : view) {
+    tokens.emplace_back(token.data(), token.size());
+  }
+  return tokens;
+}
+
+TEST_CASE("ArgumentsView slices space separated arguments",
+          "[arguments]") {
+  CHECK(ArgumentsView().empty());
+  CHECK(ArgumentsView("").empty());
+  CHECK(ArgumentsView("    ").empty());
+  CHECK(ArgumentsView("    ").size() == 0U);
+
+  StringView const str = "  start   my_service  now ";
+  ArgumentsView const view(str);
+  CHECK(view.size() == 3U);
+  CHECK(tokens_of(view) ==
+        (std::vector<std::string>{"start", "my_service", "now"}));
+
+  // The arguments are slices of the viewed string
+  for (StringView const token : view) {
+    CHECK(token.data() >= str.data());
+    CHECK(token.data() + token.size() <= str.data() + str.size());
+  }
+}
+
+TEST_CASE("Arguments own the slices of their string", "[arguments]") {
+  Arguments const arguments = Arguments::from(std::string("stop  a b"), 4U);
+  REQUIRE(arguments.size() == 2U);
+  CHECK(arguments.get_string(0) == "a");
+  CHECK(arguments.get_string(1) == "b");
+  CHECK(tokens_of(arguments.view()) == (std::vector<std::string>{"a", "b"}));
+
+  // Copies refer to their own buffer
+  Arguments const copy = arguments;
+  CHECK(copy.get_string(0) == "a");
+  CHECK(copy.get_string(0).data() != arguments.get_string(0).data());
+
+  CHECK(Arguments::from(StringView("")).empty());
+  CHECK(Arguments::from(std::string("cmd"), 3U).empty());
+}
+
+TEST_CASE("Arguments are converted to numbers", "[arguments]") {
+  Arguments const arguments = Arguments::from(StringView(
+      "0 42 +7 -1 9223372036854775807 -9223372036854775808 "
+      "9223372036854775808 -9223372036854775809 99999999999999999999 "
+      "12a - abc"));
+
+  CHECK(arguments.get_uint(0) == 0U);
+  CHECK(arguments.get_uint(1) == 42U);
+  CHECK(arguments.get_uint(2) == 7U);
+
+  // Negative numbers wrap around as they did through std::stoll
+  CHECK(arguments.get_uint(3) == std::numeric_limits<std::size_t>::max());
+  CHECK(arguments.get_uint(4) == 9223372036854775807U);
+  CHECK(arguments.get_uint(5) == 9223372036854775808U);
+
+  CHECK_THROWS_AS(arguments.get_uint(6), std::out_of_range);
+  CHECK_THROWS_AS(arguments.get_uint(7), std::out_of_range);
+  CHECK_THROWS_AS(arguments.get_uint(8), std::out_of_range);
+
+  CHECK_THROWS_AS(arguments.get_uint(9), std::invalid_argument);
+  CHECK_THROWS_AS(arguments.get_uint(10), std::invalid_argument);
+  CHECK_THROWS_AS(arguments.get_uint(11), std::invalid_argument);
+}
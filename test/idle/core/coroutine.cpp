@@ -0,0 +1,105 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+#include <utility>
+#include <catch2/catch.hpp>
+#include <idle/core/coroutine.hpp>
+
+using namespace idle;
+
+TEST_CASE("coroutine frames are reused", "[coroutine]") {
+  void* const first = detail::allocate_coroutine_frame(100);
+  detail::deallocate_coroutine_frame(first, 100);
+
+  // Frames of the same size class are served from the pool
+  void* const second = detail::allocate_coroutine_frame(120);
+  CHECK(first == second);
+  detail::deallocate_coroutine_frame(second, 120);
+
+  // Large frames bypass the pool
+  void* const large = detail::allocate_coroutine_frame(1U << 20U);
+  REQUIRE(large != nullptr);
+  detail::deallocate_coroutine_frame(large, 1U << 20U);
+}
+
+#ifdef IDLE_HAS_COROUTINES
+enum class Outcome { Pending, Value, Exception, Cancelled };
+
+struct OutcomeRecorder {
+  template <typename... Args>
+  void operator()(Args&&...) {
+    *outcome = Outcome::Value;
+  }
+  void operator()(exception_arg_t, exception_t exception) {
+    *outcome = exception ? Outcome::Exception : Outcome::Cancelled;
+  }
+
+  Outcome* outcome;
+};
+
+static Task<int> twice(continuable<int> value) {
+  int const current = co_await std::move(value);
+  co_return current * 2;
+}
+
+static Task<int> nested(continuable<int> value) {
+  int const first = co_await twice(std::move(value));
+  int const second = co_await twice(make_ready_continuable(first));
+  co_return second;
+}
+
+static Task<> throwing() {
+  co_await make_ready_continuable();
+  throw std::runtime_error("Task failed");
+}
+
+TEST_CASE("tasks resolve the continuable they are converted to",
+          "[coroutine]") {
+  int result = 0;
+  continuable<int> current = nested(make_ready_continuable(5));
+  std::move(current).then([&](int value) {
+    result = value;
+  });
+
+  CHECK(result == 20);
+}
+
+TEST_CASE("tasks forward exceptions and cancellation", "[coroutine]") {
+  Outcome outcome = Outcome::Pending;
+
+  SECTION("exceptions are rethrown") {
+    continuable<> current = throwing();
+    std::move(current).next(OutcomeRecorder{&outcome});
+    CHECK(outcome == Outcome::Exception);
+  }
+
+  SECTION("cancellation is propagated") {
+    continuable<int> current = nested(make_cancelling_continuable<int>());
+    std::move(current).next(OutcomeRecorder{&outcome});
+    CHECK(outcome == Outcome::Cancelled);
+  }
+}
+#endif // IDLE_HAS_COROUTINES
@@ -0,0 +1,80 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <catch2/catch.hpp>
+#include <idle/core/metrics.hpp>
+
+using namespace idle;
+
+TEST_CASE("Histograms place values into logarithmic buckets", "[metrics]") {
+  Histogram histogram;
+  for (std::uint64_t value : {0U, 1U, 2U, 3U, 4U, 7U, 8U, 1000U}) {
+    histogram.record(value);
+  }
+
+  auto const buckets = histogram.buckets();
+  CHECK(buckets[0] == 1U); // 0
+  CHECK(buckets[1] == 1U); // [1, 2)
+  CHECK(buckets[2] == 2U); // [2, 4)
+  CHECK(buckets[3] == 2U); // [4, 8)
+  CHECK(buckets[4] == 1U); // [8, 16)
+  CHECK(buckets[10] == 1U); // [512, 1024)
+
+  CHECK(histogram.count() == 8U);
+  CHECK(histogram.total() == 1025U);
+  CHECK(histogram.max() == 1000U);
+  CHECK(histogram.mean() == 128U);
+}
+
+TEST_CASE("Histograms saturate in the last bucket", "[metrics]") {
+  Histogram histogram;
+  histogram.record(UINT64_MAX);
+
+  CHECK(histogram.buckets()[Histogram::bucket_count - 1U] == 1U);
+  CHECK(histogram.percentile(100U) == UINT64_MAX);
+}
+
+TEST_CASE("Histograms return the upper bound of the percentile bucket",
+          "[metrics]") {
+  Histogram histogram;
+  CHECK(histogram.percentile(50U) == 0U);
+
+  // 90 values in [4, 8) and 10 values in [64, 128)
+  for (std::size_t i = 0; i < 90U; ++i) {
+    histogram.record(5U);
+  }
+  for (std::size_t i = 0; i < 10U; ++i) {
+    histogram.record(100U);
+  }
+
+  CHECK(histogram.percentile(0U) == 0U);
+  CHECK(histogram.percentile(50U) == 8U);
+  CHECK(histogram.percentile(90U) == 8U);
+  CHECK(histogram.percentile(91U) == 100U);
+  CHECK(histogram.percentile(99U) == 100U);
+  CHECK(histogram.percentile(100U) == 100U);
+}
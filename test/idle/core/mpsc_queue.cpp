@@ -0,0 +1,105 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/util/mpsc_queue.hpp>
+
+using namespace idle;
+
+struct Message : MpscQueueNode {
+  std::size_t producer{0};
+  std::size_t sequence{0};
+};
+
+TEST_CASE("mpsc queue is fifo", "[mpsc-queue]") {
+  MpscQueue<Message> queue;
+  REQUIRE(queue.emptyUnsafe());
+  REQUIRE(queue.pop() == nullptr);
+
+  std::vector<Message> messages(5);
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    messages[i].sequence = i;
+    queue.push(messages[i]);
+  }
+
+  REQUIRE_FALSE(queue.emptyUnsafe());
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    Message* const current = queue.pop();
+    REQUIRE(current == &messages[i]);
+  }
+
+  REQUIRE(queue.pop() == nullptr);
+  REQUIRE(queue.emptyUnsafe());
+
+  // The queue is reusable after being drained
+  queue.push(messages[2]);
+  REQUIRE(queue.pop() == &messages[2]);
+  REQUIRE(queue.pop() == nullptr);
+}
+
+TEST_CASE("mpsc queue preserves the order of each producer", "[mpsc-queue]") {
+  constexpr std::size_t producers = 4;
+  constexpr std::size_t count = 50000;
+
+  MpscQueue<Message> queue;
+  std::vector<std::unique_ptr<Message[]>> messages;
+  for (std::size_t p = 0; p < producers; ++p) {
+    messages.push_back(std::make_unique<Message[]>(count));
+  }
+
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (std::size_t i = 0; i < count; ++i) {
+        messages[p][i].producer = p;
+        messages[p][i].sequence = i;
+        queue.push(messages[p][i]);
+      }
+    });
+  }
+
+  std::vector<std::size_t> expected(producers, 0);
+  std::size_t received = 0;
+  bool ordered = true;
+  while (received < producers * count) {
+    if (Message* const current = queue.pop()) {
+      ordered = ordered &&
+                (current->sequence == expected[current->producer]);
+      ++expected[current->producer];
+      ++received;
+    }
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(ordered);
+  REQUIRE(queue.pop() == nullptr);
+}
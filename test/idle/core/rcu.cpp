@@ -0,0 +1,100 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/util/rcu.hpp>
+
+using namespace idle;
+
+TEST_CASE("rcu snapshots stay valid while updated", "[rcu]") {
+  Rcu<std::vector<int>> values;
+  values.store({1, 2, 3});
+
+  auto const before = values.read();
+  values.update([](std::vector<int>& current) {
+    current.push_back(4);
+  });
+
+  // The old snapshot is unchanged and kept alive until released
+  CHECK(before->size() == 3);
+  CHECK(values.read()->size() == 4);
+}
+
+TEST_CASE("epoch domains reclaim unreachable objects", "[rcu]") {
+  EpochDomain domain;
+
+  {
+    auto const guard = domain.pin();
+    domain.retire(new int(1));
+
+    // The object could still be observed by the pinned reader
+    CHECK(domain.pending() == 1);
+  }
+
+  domain.collect();
+  CHECK(domain.pending() == 0);
+}
+
+TEST_CASE("rcu readers observe consistent snapshots", "[rcu]") {
+  Rcu<std::map<std::size_t, std::size_t>> values;
+  std::atomic<bool> stop{false};
+  std::atomic<bool> consistent{true};
+
+  std::vector<std::thread> readers;
+  for (std::size_t i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto const snapshot = values.read();
+
+        // Every published map contains the keys [0, size)
+        std::size_t expected = 0;
+        for (auto const& entry : *snapshot) {
+          if (entry.first != expected++) {
+            consistent.store(false, std::memory_order_relaxed);
+          }
+        }
+      }
+    });
+  }
+
+  for (std::size_t i = 0; i < 1000; ++i) {
+    values.update([&](std::map<std::size_t, std::size_t>& current) {
+      current.emplace(current.size(), i);
+    });
+  }
+
+  stop.store(true, std::memory_order_relaxed);
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  CHECK(consistent.load());
+  CHECK(values.read()->size() == 1000);
+}
@@ -0,0 +1,105 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/util/work_stealing_deque.hpp>
+
+using namespace idle;
+
+TEST_CASE("work stealing deque takes lifo and steals fifo",
+          "[work-stealing-deque]") {
+  WorkStealingDeque<std::size_t> deque(2);
+  REQUIRE(deque.emptyUnsafe());
+
+  for (std::size_t i = 0; i < 10; ++i) {
+    deque.push(i);
+  }
+  REQUIRE(deque.sizeUnsafe() == 10);
+
+  std::size_t value = 0;
+  REQUIRE(deque.take(value));
+  REQUIRE(value == 9);
+  REQUIRE(deque.steal(value));
+  REQUIRE(value == 0);
+  REQUIRE(deque.steal(value));
+  REQUIRE(value == 1);
+  REQUIRE(deque.take(value));
+  REQUIRE(value == 8);
+
+  while (deque.take(value)) {
+  }
+
+  REQUIRE(deque.emptyUnsafe());
+  REQUIRE_FALSE(deque.take(value));
+  REQUIRE_FALSE(deque.steal(value));
+}
+
+TEST_CASE("work stealing deque hands out every value exactly once",
+          "[work-stealing-deque]") {
+  constexpr std::size_t count = 200000;
+  constexpr std::size_t stealers = 3;
+
+  WorkStealingDeque<std::size_t> deque(16);
+  std::vector<std::atomic<std::size_t>> seen(count);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < stealers; ++i) {
+    threads.emplace_back([&] {
+      std::size_t value;
+      while (!done.load(std::memory_order_acquire) || !deque.emptyUnsafe()) {
+        if (deque.steal(value)) {
+          seen[value].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  std::size_t value;
+  for (std::size_t i = 0; i < count; ++i) {
+    deque.push(i);
+
+    if ((i % 3) == 0 && deque.take(value)) {
+      seen[value].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  while (deque.take(value)) {
+    seen[value].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  done.store(true, std::memory_order_release);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (std::atomic<std::size_t> const& times : seen) {
+    REQUIRE(times.load() == 1);
+  }
+}
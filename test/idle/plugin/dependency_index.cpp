@@ -0,0 +1,72 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/plugin/detail/plugin_recompiler/dependency_index.hpp>
+
+using namespace idle;
+using namespace idle::detail;
+
+using strings = std::vector<std::string>;
+
+TEST_CASE("Command lines are split into their arguments",
+          "[dependency_index]") {
+  CHECK(split_command("") == strings{});
+  CHECK(split_command("  c++  -c\tmain.cpp \n") ==
+        (strings{"c++", "-c", "main.cpp"}));
+
+  // Quoted arguments keep their whitespace and escaped characters
+  CHECK(split_command(R"(c++ "-DNAME=\"a b\"" "C:\\dir\\x.cpp")") ==
+        (strings{"c++", "-DNAME=\"a b\"", "C:\\dir\\x.cpp"}));
+
+  // Empty quotes are an argument on their own
+  CHECK(split_command(R"(c++ "" -o"out file.o")") ==
+        (strings{"c++", "", "-oout file.o"}));
+}
+
+TEST_CASE("Depfiles yield the prerequisites of their first rule",
+          "[dependency_index]") {
+  CHECK(parse_depfile("") == strings{});
+  CHECK(parse_depfile("main.o: main.cpp a.hpp\n") ==
+        (strings{"main.cpp", "a.hpp"}));
+
+  // Line continuations separate prerequisites
+  CHECK(parse_depfile("main.o: main.cpp \\\n a.hpp\\\n  b.hpp \\\r\n c.hpp") ==
+        (strings{"main.cpp", "a.hpp", "b.hpp", "c.hpp"}));
+
+  // Escaped spaces, hashes and dollars are part of the path
+  CHECK(parse_depfile("main.o: my\\ dir/main.cpp x\\#1.hpp $$HOME.hpp\n") ==
+        (strings{"my dir/main.cpp", "x#1.hpp", "$HOME.hpp"}));
+
+  // Drive letters and unescaped Windows separators are kept
+  CHECK(parse_depfile("C:\\build\\main.obj: C:\\src\\main.cpp\n") ==
+        (strings{"C:\\src\\main.cpp"}));
+
+  // Phony rules emitted through -MP are ignored
+  CHECK(parse_depfile("main.o: main.cpp a.hpp\n\na.hpp:\n") ==
+        (strings{"main.cpp", "a.hpp"}));
+}
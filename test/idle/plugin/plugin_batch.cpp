@@ -0,0 +1,111 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <catch2/catch.hpp>
+#include <idle/plugin/detail/plugin/plugin_impl.hpp>
+
+using namespace idle;
+using namespace idle::detail;
+
+namespace fs = boost::filesystem;
+
+static PluginPaths paths_of(std::string path) {
+  PluginPaths paths;
+  paths.path = std::move(path);
+  return paths;
+}
+
+static optional<StagedPlugin> staged_of(std::string path,
+                                        std::vector<std::string> imports) {
+  StagedPlugin staged;
+  staged.paths = paths_of(std::move(path));
+  staged.info.imported_libraries = std::move(imports);
+  return staged;
+}
+
+static std::vector<std::string> paths_in(std::vector<StagedPlugin> const& v) {
+  std::vector<std::string> paths;
+  for (StagedPlugin const& staged : v) {
+    paths.push_back(staged.paths.path);
+  }
+  return paths;
+}
+
+TEST_CASE("Plugins given twice are loaded once", "[plugin_batch]") {
+  std::vector<PluginPaths> batch;
+  batch.push_back(paths_of("/plugins/liba.so"));
+  batch.push_back(paths_of("/plugins/libb.so"));
+  batch.push_back(paths_of("/plugins/liba.so"));
+
+  unique_batch(batch);
+  REQUIRE(batch.size() == 2U);
+  CHECK(batch[0].path == "/plugins/liba.so");
+  CHECK(batch[1].path == "/plugins/libb.so");
+}
+
+TEST_CASE("Plugins are ordered after the plugins they link against",
+          "[plugin_batch]") {
+  std::vector<optional<StagedPlugin>> staged;
+  staged.push_back(staged_of("/plugins/libapp.so", {"libcore.so"}));
+  staged.push_back(staged_of("/plugins/libcore.so", {"libbase.so"}));
+  staged.push_back(staged_of("/plugins/libbase.so", {"libc.so.6"}));
+  staged.push_back(staged_of("/plugins/libother.so", {}));
+
+  CHECK(paths_in(order_batch(std::move(staged))) ==
+        (std::vector<std::string>{"/plugins/libbase.so", "/plugins/libother.so",
+                                  "/plugins/libcore.so",
+                                  "/plugins/libapp.so"}));
+}
+
+TEST_CASE("Plugins linking against each other keep their order",
+          "[plugin_batch]") {
+  std::vector<optional<StagedPlugin>> staged;
+  staged.push_back(staged_of("/plugins/liba.so", {"libb.so"}));
+  staged.push_back(staged_of("/plugins/libb.so", {"liba.so"}));
+
+  CHECK(paths_in(order_batch(std::move(staged))) ==
+        (std::vector<std::string>{"/plugins/liba.so", "/plugins/libb.so"}));
+}
+
+TEST_CASE("A plugin that fails to stage doesn't fail its batch",
+          "[plugin_batch]") {
+  fs::path const missing = fs::temp_directory_path() /
+                           fs::unique_path("idle-missing-%%%%%%.so");
+  CHECK_FALSE(try_stage(paths_of(missing.generic_string())));
+
+  std::vector<optional<StagedPlugin>> staged;
+  staged.push_back(staged_of("/plugins/libapp.so", {"libcore.so"}));
+  staged.push_back({});
+  staged.push_back(staged_of("/plugins/libcore.so", {}));
+
+  CHECK(paths_in(order_batch(std::move(staged))) ==
+        (std::vector<std::string>{"/plugins/libcore.so",
+                                  "/plugins/libapp.so"}));
+}
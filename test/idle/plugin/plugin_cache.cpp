@@ -0,0 +1,171 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <catch2/catch.hpp>
+#include <idle/plugin/detail/plugin_cache.hpp>
+
+using namespace idle;
+using namespace idle::detail;
+
+namespace fs = boost::filesystem;
+
+static content_hash_t hash_of(char const* str) {
+  return hash_content(str, std::strlen(str));
+}
+
+static void write_file(fs::path const& path, std::string const& content) {
+  fs::create_directories(path.parent_path());
+  std::ofstream out(path.c_str(), std::ios::trunc | std::ios::binary);
+  out << content;
+}
+
+static std::size_t count_files(fs::path const& dir) {
+  std::size_t count = 0U;
+  boost::system::error_code ec;
+  for (fs::directory_iterator itr(dir, ec), end; !ec && (itr != end);
+       itr.increment(ec)) {
+    ++count;
+  }
+  return count;
+}
+
+/// Creates an empty directory that is removed together with its content
+class temporary_directory {
+public:
+  temporary_directory()
+    : path_(fs::temp_directory_path() /
+            fs::unique_path("idle-plugin-cache-%%%%-%%%%-%%%%")) {
+    fs::create_directories(path_);
+  }
+  ~temporary_directory() {
+    boost::system::error_code ec;
+    fs::remove_all(path_, ec);
+  }
+
+  fs::path const& path() const noexcept {
+    return path_;
+  }
+
+private:
+  fs::path path_;
+};
+
+TEST_CASE("The content hash matches the XXH64 reference vectors",
+          "[plugin_cache]") {
+  CHECK(hash_of("") == 0xEF46DB3751D8E999ULL);
+  CHECK(hash_of("a") == 0xD24EC4F1A98C6E5BULL);
+  CHECK(hash_of("abc") == 0x44BC2CF5AD770999ULL);
+  CHECK(hash_of("Nobody inspects the spammish repetition") ==
+        0xFBCEA83C8A378BF1ULL);
+  CHECK(hash_of("The quick brown fox jumps over the lazy dog") ==
+        0x0B242D361FDA71BCULL);
+
+  // Files are hashed in blocks, which yields the same hash
+  temporary_directory temporary;
+  std::string content(100000U, '\0');
+  for (std::size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>(i * 31U + 7U);
+  }
+  fs::path const file = temporary.path() / "content.bin";
+  write_file(file, content);
+
+  CHECK(hash_file_content(file) ==
+        hash_content(content.data(), content.size()));
+}
+
+TEST_CASE("The plugin cache stores equal content once and reclaims it",
+          "[plugin_cache]") {
+  temporary_directory temporary;
+  fs::path const artifact = temporary.path() / "build" / "plugin.so";
+  write_file(artifact, "plugin");
+
+  plugin_cache cache(temporary.path() / "cache");
+  cache.open();
+
+  content_hash_t const hash = hash_file_content(artifact);
+  fs::path const first = cache.generation_of(0U) / "plugin.so";
+  fs::path const second = cache.generation_of(1U) / "plugin.so";
+  cache.place(artifact, hash, first);
+  cache.place(artifact, hash, second);
+
+  CHECK(fs::exists(first));
+  CHECK(fs::exists(second));
+
+  fs::path const objects = cache.directory() / "objects";
+  CHECK(count_files(objects) == 1U);
+
+  // Objects which are still placed are kept
+  CHECK(cache.collect() == 0U);
+  CHECK(count_files(objects) == 1U);
+
+  boost::system::error_code ec;
+  plugin_cache::remove(first, ec);
+  CHECK_FALSE(ec);
+  CHECK(cache.collect() == 0U);
+  CHECK_FALSE(fs::exists(first.parent_path()));
+
+  plugin_cache::remove(second, ec);
+  CHECK_FALSE(ec);
+  CHECK(cache.collect() == std::string("plugin").size());
+  CHECK(count_files(objects) == 0U);
+  CHECK_FALSE(fs::exists(second.parent_path()));
+}
+
+TEST_CASE("The plugin cache only clears sessions of exited processes",
+          "[plugin_cache]") {
+  temporary_directory temporary;
+  fs::path const artifact = temporary.path() / "build" / "plugin.so";
+  write_file(artifact, "plugin");
+
+  fs::path const directory = temporary.path() / "cache";
+  plugin_cache running(directory);
+  running.open();
+
+  fs::path const placed = running.generation_of(0U) / "plugin.so";
+  running.place(artifact, hash_file_content(artifact), placed);
+
+  // A session whose lock isn't held anymore and one without a lock
+  write_file(directory / "exited.lock", "");
+  write_file(directory / "exited" / "0" / "plugin.so", "plugin");
+  write_file(directory / "unlocked" / "0" / "plugin.so", "plugin");
+
+  plugin_cache other(directory);
+  other.open();
+  other.clear_abandoned();
+
+  CHECK(fs::exists(placed));
+  CHECK_FALSE(fs::exists(directory / "exited"));
+  CHECK_FALSE(fs::exists(directory / "exited.lock"));
+  CHECK_FALSE(fs::exists(directory / "unlocked"));
+
+  // The object is still linked from the running session
+  other.collect();
+  CHECK(count_files(directory / "objects") == 1U);
+}
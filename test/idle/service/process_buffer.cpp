@@ -0,0 +1,169 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/ref.hpp>
+#include <idle/service/detail/process_group/process_buffer.hpp>
+#include <idle/service/sink.hpp>
+
+using namespace idle;
+using namespace idle::detail;
+
+namespace process_buffer_test {
+class RecordingSink final : public Sink {
+public:
+  void write(StringView data) override {
+    writes.emplace_back(data.data(), data.size());
+  }
+
+  std::vector<std::string> writes;
+};
+
+/// Simulates a read of the chunk from the pipe of a process
+void receive(ProcessStreamBuffer& buffer, std::string const& chunk) {
+  REQUIRE(chunk.size() <= buffer.free_size());
+  std::memcpy(buffer.free_data(), chunk.data(), chunk.size());
+  buffer.consume(chunk.size());
+}
+} // namespace process_buffer_test
+
+using namespace process_buffer_test;
+
+using strings = std::vector<std::string>;
+
+TEST_CASE("Process output is split into lines across reads",
+          "[process_buffer]") {
+  RecordingSink sink;
+  ProcessStreamBuffer buffer(sink, make_ref<ProcessBufferPool>(), true);
+
+  receive(buffer, "hel");
+  CHECK(sink.writes.empty());
+
+  // The line split across both reads is written at once
+  receive(buffer, "lo\nwor");
+  CHECK(sink.writes == strings{"hello"});
+
+  // Empty lines are skipped
+  receive(buffer, "ld\n\nfoo\nbar\n");
+  CHECK(sink.writes == (strings{"hello", "world", "foo", "bar"}));
+
+  // The pending line is moved to the front of the buffer
+  receive(buffer, "baz");
+  std::size_t const buffer_size = ProcessBufferPool::buffer_size;
+  CHECK(buffer.free_size() == buffer_size - 3U);
+}
+
+TEST_CASE("A trailing partial line is written on flush", "[process_buffer]") {
+  RecordingSink sink;
+  ProcessStreamBuffer buffer(sink, make_ref<ProcessBufferPool>(), true);
+
+  receive(buffer, "first\nlast");
+  CHECK(sink.writes == strings{"first"});
+
+  buffer.flush();
+  CHECK(sink.writes == (strings{"first", "last"}));
+
+  // Flushing without a pending line writes nothing
+  buffer.flush();
+  CHECK(sink.writes.size() == 2U);
+}
+
+TEST_CASE("Lines exceeding the buffer are written partially",
+          "[process_buffer]") {
+  RecordingSink sink;
+  ProcessStreamBuffer buffer(sink, make_ref<ProcessBufferPool>(), true);
+
+  std::size_t const buffer_size = ProcessBufferPool::buffer_size;
+  receive(buffer, std::string(buffer_size - 1U, 'x'));
+  CHECK(sink.writes.empty());
+
+  receive(buffer, "x");
+  REQUIRE(sink.writes.size() == 1U);
+  CHECK(sink.writes[0] == std::string(buffer_size, 'x'));
+  CHECK(buffer.free_size() == buffer_size);
+
+  receive(buffer, "x\n");
+  CHECK(sink.writes.back() == "x");
+}
+
+TEST_CASE("Unsplit process output is written as received",
+          "[process_buffer]") {
+  RecordingSink sink;
+  ProcessStreamBuffer buffer(sink, make_ref<ProcessBufferPool>(), false);
+
+  receive(buffer, "a\nb");
+  receive(buffer, "c");
+  buffer.flush();
+  CHECK(sink.writes == (strings{"a\nb", "c"}));
+}
+
+TEST_CASE("Process buffers are reused from the pool", "[process_buffer]") {
+  RecordingSink sink;
+  Ref<ProcessBufferPool> pool = make_ref<ProcessBufferPool>();
+
+  char const* data;
+  {
+    ProcessStreamBuffer buffer(sink, pool, true);
+    data = buffer.free_data();
+  }
+
+  {
+    // The buffer was returned to the pool on destruction
+    ProcessStreamBuffer buffer(sink, pool, true);
+    CHECK(buffer.free_data() == data);
+
+    // A buffer in use is never handed out twice
+    ProcessStreamBuffer other(sink, pool, true);
+    CHECK(other.free_data() != data);
+  }
+
+  // Only a bounded count of buffers is cached
+  std::size_t const max_cached = ProcessBufferPool::max_cached;
+  std::vector<ProcessBufferPool::Buffer> buffers;
+  for (std::size_t i = 0; i < max_cached + 1U; ++i) {
+    buffers.push_back(pool->acquire());
+  }
+
+  std::vector<char const*> cached;
+  for (std::size_t i = 0; i < max_cached; ++i) {
+    cached.push_back(buffers[i].get());
+  }
+
+  for (ProcessBufferPool::Buffer& buffer : buffers) {
+    pool->release(std::move(buffer));
+  }
+
+  for (std::size_t i = 0; i < max_cached; ++i) {
+    ProcessBufferPool::Buffer buffer = pool->acquire();
+    CHECK(std::find(cached.begin(), cached.end(), buffer.get()) !=
+          cached.end());
+    buffers[i] = std::move(buffer);
+  }
+}
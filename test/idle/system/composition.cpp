@@ -0,0 +1,175 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/composition.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/service.hpp>
+
+using namespace idle;
+
+namespace composition_test {
+class Log : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class Storage : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class Network : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class LogService final : public Implements<Log> {
+public:
+  using Implements<Log>::Implements;
+
+  IDLE_SERVICE
+};
+
+class StorageService final : public Implements<Storage> {
+public:
+  using Implements<Storage>::Implements;
+
+private:
+  Dependency<Log> log_{*this};
+
+  IDLE_SERVICE
+};
+
+class NetworkService final : public Implements<Network> {
+public:
+  using Implements<Network>::Implements;
+
+private:
+  Dependency<Log> log_{*this};
+
+  IDLE_SERVICE
+};
+
+/// Depends on the log through both, the storage and the network
+class Application final : public Service {
+public:
+  using Service::Service;
+
+private:
+  Dependency<Storage> storage_{*this};
+  Dependency<Network> network_{*this};
+
+  IDLE_SERVICE
+};
+
+/// Is never part of the composition
+class Unrelated final : public Service {
+public:
+  using Service::Service;
+
+  IDLE_SERVICE
+};
+} // namespace composition_test
+
+using namespace composition_test;
+
+static std::size_t index_of(StaticComposition const& composition,
+                            Service const& service) {
+  std::size_t index = 0U;
+  for (StaticComposition::Entry const& entry : composition.entries()) {
+    if (entry.head.lock().get() == &service) {
+      return index;
+    }
+    ++index;
+  }
+  return composition.size();
+}
+
+TEST_CASE("A StaticComposition orders a diamond of dependencies once",
+          "[composition]") {
+  Persistent<Context> context;
+  Persistent<LogService> log(*context);
+  Persistent<StorageService> storage(*context);
+  Persistent<NetworkService> network(*context);
+  Persistent<Application> application(*context);
+  Persistent<Unrelated> unrelated(*context);
+
+  StaticComposition composition;
+
+  context->event_loop()
+      .async_post([&] {
+        composition = context->compose({weakOf(*application)});
+
+        // The shared log is contained once and the unrelated service never
+        CHECK(composition.size() == 4U);
+        CHECK(index_of(composition, *unrelated) == composition.size());
+
+        // The dependencies are placed before their dependents
+        CHECK(index_of(composition, *log) < index_of(composition, *storage));
+        CHECK(index_of(composition, *log) < index_of(composition, *network));
+        CHECK(index_of(composition, *storage) <
+              index_of(composition, *application));
+        CHECK(index_of(composition, *network) <
+              index_of(composition, *application));
+
+        // Only the application was requested and nothing depends on it
+        for (StaticComposition::Entry const& entry : composition.entries()) {
+          bool const is_application = entry.head.lock().get() ==
+                                      &*application;
+          CHECK(entry.requested == is_application);
+          CHECK(entry.sink == is_application);
+        }
+
+        return context->start(composition);
+      })
+      .then([&] {
+        CHECK(log->state().isRunning());
+        CHECK(storage->state().isRunning());
+        CHECK(network->state().isRunning());
+        CHECK(application->state().isRunning());
+        CHECK_FALSE(unrelated->state().isRunning());
+
+        // The composition can be started again while it is running
+        return context->start(composition);
+      })
+      .then([&] {
+        CHECK(application->state().isRunning());
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
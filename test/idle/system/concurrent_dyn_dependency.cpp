@@ -0,0 +1,197 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/concurrent_dyn_dependency.hpp>
+#include <idle/core/service.hpp>
+
+using namespace idle;
+
+namespace concurrent_dyn_dependency_test {
+constexpr std::size_t reader_threads = 16U;
+constexpr std::size_t swaps = 64U;
+
+class Generation : public Interface {
+public:
+  using Interface::Interface;
+
+  /// Returns false as soon as the provider was stopped
+  virtual bool isAlive() const noexcept = 0;
+
+  virtual std::size_t generation() const noexcept = 0;
+
+  IDLE_INTERFACE
+};
+
+class GenerationProvider final : public Implements<Generation> {
+public:
+  explicit GenerationProvider(Inheritance parent, std::size_t generation)
+    : Super(std::move(parent))
+    , generation_(generation) {}
+
+  bool isAlive() const noexcept override {
+    return is_alive_.load(std::memory_order_acquire);
+  }
+
+  std::size_t generation() const noexcept override {
+    return generation_;
+  }
+
+  /// Newer generations are always preferred over older ones
+  bool operator>(Interface const& other) const noexcept override {
+    return generation_ >
+           static_cast<GenerationProvider const&>(other).generation_;
+  }
+
+protected:
+  continuable<> onStart() override {
+    is_alive_.store(true, std::memory_order_release);
+    return make_ready_continuable();
+  }
+
+  continuable<> onStop() override {
+    is_alive_.store(false, std::memory_order_release);
+    return make_ready_continuable();
+  }
+
+private:
+  std::size_t const generation_;
+  std::atomic<bool> is_alive_{false};
+
+  IDLE_SERVICE
+};
+
+class GenerationConsumer final : public Implements<> {
+public:
+  using Super::Super;
+
+  ConcurrentDynDependency<Generation> const& current() const noexcept {
+    return current_;
+  }
+
+private:
+  ConcurrentDynDependency<Generation> current_{*this};
+
+  IDLE_SERVICE
+};
+} // namespace concurrent_dyn_dependency_test
+
+using namespace concurrent_dyn_dependency_test;
+
+TEST_CASE("ConcurrentDynDependency keeps swapped providers running while "
+          "readers on other threads pin them",
+          "[dyn_dependency]") {
+  Persistent<Context> context;
+
+  Ref<GenerationConsumer> consumer;
+  std::vector<Ref<GenerationProvider>> providers;
+  std::size_t generation = 0;
+
+  std::atomic<bool> stop{false};
+  std::atomic<std::size_t> stale{0};
+  std::vector<std::thread> readers;
+
+  auto join_readers = [&] {
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& reader : readers) {
+      reader.join();
+    }
+    readers.clear();
+  };
+
+  context->event_loop()
+      .async_post([&] {
+        Ref<GenerationProvider> first = spawn<GenerationProvider>(*context,
+                                                                  generation);
+        first->init();
+        providers.push_back(std::move(first));
+
+        consumer = spawn<GenerationConsumer>(*context);
+        consumer->init();
+        return consumer->start();
+      })
+      .then([&] {
+        for (std::size_t i = 0; i < reader_threads; ++i) {
+          readers.emplace_back([&] {
+            std::size_t last = 0;
+
+            while (!stop.load(std::memory_order_relaxed)) {
+              if (auto current = consumer->current().pin()) {
+                // A pinned provider is never stopped and
+                // providers are only ever swapped to newer generations.
+                if (!current->isAlive() || current->generation() < last) {
+                  stale.fetch_add(1U, std::memory_order_relaxed);
+                }
+                last = current->generation();
+              }
+            }
+          });
+        }
+
+        return loop([&] {
+          Ref<GenerationProvider> previous = providers.back();
+          Ref<GenerationProvider> next = spawn<GenerationProvider>(
+              *context, ++generation);
+          next->init();
+          providers.push_back(next);
+
+          // The previous provider can only stop after the swap was applied
+          // and all readers released it.
+          return next->start()
+              .then([previous] {
+                return previous->stop();
+              })
+              .then([&]() -> loop_result<> {
+                if (generation < swaps) {
+                  return loop_continue();
+                } else {
+                  return loop_break();
+                }
+              });
+        });
+      })
+      .then([&] {
+        join_readers();
+
+        CHECK(stale.load() == 0U);
+        CHECK(consumer->current()->generation() == swaps);
+
+        for (std::size_t i = 0; i < swaps; ++i) {
+          CHECK_FALSE(providers[i]->state().isRunning());
+        }
+
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        join_readers();
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
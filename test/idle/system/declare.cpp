@@ -0,0 +1,181 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The declarations of this test are instantiated by the Context directly
+#define IDLE_EXECUTABLE
+
+#include <chrono>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/declare.hpp>
+#include <idle/core/parts/component.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/registry.hpp>
+#include <idle/core/service.hpp>
+#include <idle/service/idle_timeout.hpp>
+#include <idle/service/timer.hpp>
+
+using namespace idle;
+
+namespace declare_test {
+class Lazy : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class LazyService final : public Implements<Lazy> {
+public:
+  using Implements<Lazy>::Implements;
+
+  IDLE_SERVICE
+};
+
+IDLE_DECLARE_LAZY(LazyService, Lazy)
+
+class ConsumerService final : public Service {
+public:
+  using Service::Service;
+
+  Lazy& lazy() noexcept {
+    return *lazy_;
+  }
+
+private:
+  Dependency<Lazy> lazy_{*this};
+
+  IDLE_SERVICE
+};
+
+class Lingering : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class LingeringService final : public Implements<Lingering> {
+public:
+  using Implements<Lingering>::Implements;
+
+private:
+  Component<IdleTimeout> idle_timeout_{*this, std::chrono::milliseconds(10)};
+
+  IDLE_SERVICE
+};
+
+IDLE_DECLARE_LAZY(LingeringService, Lingering)
+
+class LingeringConsumerService final : public Service {
+public:
+  using Service::Service;
+
+  Lingering& lingering() noexcept {
+    return *lingering_;
+  }
+
+private:
+  Dependency<Lingering> lingering_{*this};
+
+  IDLE_SERVICE
+};
+} // namespace declare_test
+
+using namespace declare_test;
+
+TEST_CASE("Lazily declared services are instantiated on their first use",
+          "[declare]") {
+  Persistent<Context> context;
+
+  context->event_loop()
+      .async_post([&] {
+        Ref<Registry> registry = context->find<Lazy>();
+        CHECK(registry->interfaces().empty());
+
+        Ref<ConsumerService> consumer = spawn<ConsumerService>(*context);
+        consumer->init();
+
+        // The lazy service is published as soon as it is required
+        CHECK(registry->interfaces().size() == 1U);
+
+        return consumer->start().then([consumer] {
+          CHECK(consumer->lazy().owner().state().isRunning());
+          CHECK(consumer->lazy().owner().state().isDefaultCreated());
+
+          return consumer->stop();
+        });
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("Lazily declared services are stopped after their idle timeout",
+          "[declare]") {
+  Persistent<Context> context;
+  Ref<Timer> timer;
+  Ref<LingeringConsumerService> consumer;
+  Service* lingering = nullptr;
+
+  context->event_loop()
+      .async_post([&] {
+        timer = Timer::create(*context);
+        timer->init();
+
+        consumer = spawn<LingeringConsumerService>(*context);
+        consumer->init();
+        return when_all(timer->start(), consumer->start());
+      })
+      .then([&] {
+        lingering = &consumer->lingering().owner();
+        CHECK(lingering->state().isRunning());
+
+        return consumer->stop();
+      })
+      .then([&] {
+        // The unused service is kept running for its idle timeout
+        CHECK(lingering->state().isRunning());
+
+        return timer->waitFor(std::chrono::milliseconds(500));
+      })
+      .then(
+          [&] {
+            CHECK_FALSE(lingering->state().isRunning());
+
+            return context->stop(0);
+          },
+          context->event_loop().through_post())
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
@@ -0,0 +1,209 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/service.hpp>
+#include <idle/service/art/reflection_tree.hpp>
+#include <idle/service/handoff.hpp>
+
+using namespace idle;
+
+namespace handoff_test {
+static constexpr std::size_t entry_count = 1000000U;
+
+struct Entry {
+  std::uint64_t key{0U};
+  std::uint64_t value{0U};
+};
+
+IDLE_REFLECT(Entry, key, value)
+
+struct Cache {
+  std::vector<Entry> entries;
+};
+
+IDLE_REFLECT(Cache, entries)
+
+/// Has a different layout than Cache
+struct ChangedCache {
+  std::vector<std::uint64_t> entries;
+};
+
+IDLE_REFLECT(ChangedCache, entries)
+
+/// Keeps the handoff alive in between two generations,
+/// as done by the PluginHotSwap during a reload.
+class KeeperService final : public Service {
+public:
+  using Service::Service;
+
+  StateHandoff& handoff() noexcept {
+    return *handoff_;
+  }
+
+private:
+  Dependency<StateHandoff> handoff_{*this};
+
+  IDLE_SERVICE
+};
+
+template <typename T>
+class CacheService final : public Service {
+public:
+  using Service::Service;
+
+  Handoff<T> cache{*this, "handoff_test.cache"};
+
+  IDLE_SERVICE
+};
+} // namespace handoff_test
+
+using namespace handoff_test;
+
+TEST_CASE("A Handoff restores the state of the previous generation",
+          "[handoff]") {
+  using Clock = std::chrono::steady_clock;
+
+  Persistent<Context> context;
+  Persistent<KeeperService> keeper(*context);
+
+  Ref<CacheService<Cache>> outgoing;
+  Ref<CacheService<Cache>> incoming;
+  StateHandoff::Window window;
+  Clock::time_point begin;
+
+  context->event_loop()
+      .async_post([&] {
+        return keeper->start();
+      })
+      .then([&] {
+        outgoing = spawn<CacheService<Cache>>(*context);
+        outgoing->init();
+        return outgoing->start();
+      })
+      .then([&] {
+        // The first generation is started cold
+        CHECK_FALSE(outgoing->cache.isWarm());
+
+        std::vector<Entry>& entries = outgoing->cache->entries;
+        entries.reserve(entry_count);
+        for (std::uint64_t i = 0U; i < entry_count; ++i) {
+          entries.push_back({i, i * 2U});
+        }
+
+        // Simulates the reload of a plugin
+        begin = Clock::now();
+        window = keeper->handoff().open();
+        return outgoing->stop();
+      })
+      .then([&] {
+        outgoing.reset();
+
+        incoming = spawn<CacheService<Cache>>(*context);
+        incoming->init();
+        return incoming->start();
+      })
+      .then([&] {
+        window.reset();
+
+        auto const elapsed = Clock::now() - begin;
+        CHECK(elapsed < std::chrono::seconds(10));
+
+        REQUIRE(incoming->cache.isWarm());
+
+        std::vector<Entry> const& entries = incoming->cache->entries;
+        REQUIRE(entries.size() == entry_count);
+        CHECK(entries.front().value == 0U);
+        CHECK(entries[entry_count / 2U].key == (entry_count / 2U));
+        CHECK(entries.back().value == ((entry_count - 1U) * 2U));
+
+        return incoming->stop();
+      })
+      .then([&] {
+        // States are dropped after the handoff was closed
+        CHECK_FALSE(keeper->handoff().isOpen());
+
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("A Handoff with a changed layout falls back to a cold start",
+          "[handoff]") {
+  Persistent<Context> context;
+  Persistent<KeeperService> keeper(*context);
+
+  Ref<CacheService<Cache>> outgoing;
+  Ref<CacheService<ChangedCache>> incoming;
+  StateHandoff::Window window;
+
+  context->event_loop()
+      .async_post([&] {
+        return keeper->start();
+      })
+      .then([&] {
+        outgoing = spawn<CacheService<Cache>>(*context);
+        outgoing->init();
+        return outgoing->start();
+      })
+      .then([&] {
+        outgoing->cache->entries.push_back({1U, 2U});
+
+        window = keeper->handoff().open();
+        return outgoing->stop();
+      })
+      .then([&] {
+        outgoing.reset();
+
+        incoming = spawn<CacheService<ChangedCache>>(*context);
+        incoming->init();
+        return incoming->start();
+      })
+      .then([&] {
+        window.reset();
+
+        CHECK_FALSE(incoming->cache.isWarm());
+        CHECK(incoming->cache->entries.empty());
+
+        return incoming->stop();
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
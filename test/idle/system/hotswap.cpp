@@ -0,0 +1,213 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/service.hpp>
+
+using namespace idle;
+
+namespace hotswap_test {
+class Api : public Interface {
+public:
+  using Interface::Interface;
+
+  virtual std::size_t generation() const noexcept = 0;
+
+  IDLE_INTERFACE
+};
+
+class Middle : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class Other : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+/// Represents the services of a single plugin generation
+class Generation final : public Implements<Api> {
+public:
+  explicit Generation(Inheritance parent, std::size_t generation)
+    : Super(std::move(parent))
+    , generation_(generation) {}
+
+  std::size_t generation() const noexcept override {
+    return generation_;
+  }
+
+  /// Newer generations are always preferred over older ones,
+  /// as the plugins loaded through a hot-swap are.
+  bool operator>(Interface const& other) const noexcept override {
+    return generation_ > static_cast<Generation const&>(other).generation_;
+  }
+
+private:
+  std::size_t const generation_;
+
+  IDLE_SERVICE
+};
+
+class Dependent final : public Implements<Middle> {
+public:
+  using Super::Super;
+
+  std::size_t generation() const noexcept {
+    return api_->generation();
+  }
+
+  std::size_t starts{0};
+
+protected:
+  continuable<> onStart() override {
+    ++starts;
+    return make_ready_continuable();
+  }
+
+private:
+  Dependency<Api> api_{*this};
+
+  IDLE_SERVICE
+};
+
+class Transitive final : public Service {
+public:
+  using Service::Service;
+
+  std::size_t starts{0};
+
+protected:
+  continuable<> onStart() override {
+    ++starts;
+    return make_ready_continuable();
+  }
+
+private:
+  Dependency<Middle> middle_{*this};
+
+  IDLE_SERVICE
+};
+
+class OtherService final : public Implements<Other> {
+public:
+  using Super::Super;
+
+  IDLE_SERVICE
+};
+
+class Unrelated final : public Service {
+public:
+  using Service::Service;
+
+private:
+  Dependency<Other> other_{*this};
+
+  IDLE_SERVICE
+};
+} // namespace hotswap_test
+
+using namespace hotswap_test;
+
+TEST_CASE("A hot-swap restarts only the dependents of the swapped services",
+          "[hotswap]") {
+  Persistent<Context> context;
+  Persistent<Dependent> dependent(*context);
+  Persistent<Transitive> transitive(*context);
+  Persistent<OtherService> other(*context);
+  Persistent<Unrelated> unrelated(*context);
+
+  Ref<Generation> previous;
+  Ref<Generation> next;
+
+  context->event_loop()
+      .async_post([&] {
+        previous = spawn<Generation>(*context, 1U);
+        previous->init();
+
+        return when_all(transitive->start(), unrelated->start());
+      })
+      .then([&] {
+        CHECK(dependent->generation() == 1U);
+
+        // Leaves an unhealthy service behind that is unrelated to the swap
+        return other->stop();
+      })
+      .then([&] {
+        CHECK_FALSE(unrelated->state().isRunning());
+        return other->start();
+      })
+      .then([&] {
+        // The swap is performed in the same order as the PluginHotswap does:
+        // the new generation is loaded, the outdated one is stopped,
+        // the new one is started and the dependents of both are updated.
+        next = spawn<Generation>(*context, 2U);
+        next->init();
+
+        return previous->stop();
+      })
+      .then([&] {
+        CHECK_FALSE(dependent->state().isRunning());
+        CHECK_FALSE(transitive->state().isRunning());
+
+        return next->start();
+      })
+      .then([&] {
+        return context->update({weakOf(static_cast<Service&>(*next)),
+                                weakOf(static_cast<Service&>(*previous))});
+      })
+      .then([&] {
+        // The direct and the transitive dependent were restarted once
+        CHECK(dependent->state().isRunning());
+        CHECK(transitive->state().isRunning());
+        CHECK(dependent->generation() == 2U);
+        CHECK(dependent->starts == 2U);
+        CHECK(transitive->starts == 2U);
+
+        // The unhealthy service that doesn't depend on the swapped
+        // services isn't visited, a full update restarts it.
+        CHECK_FALSE(unrelated->state().isRunning());
+        return context->update();
+      })
+      .then([&] {
+        CHECK(unrelated->state().isRunning());
+        CHECK(dependent->starts == 2U);
+        CHECK(transitive->starts == 2U);
+
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
@@ -0,0 +1,151 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/parts/listener.hpp>
+#include <idle/core/service.hpp>
+
+using namespace idle;
+
+namespace listener_test {
+class Source : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class SourceService final : public Implements<Source> {
+public:
+  using Implements<Source>::Implements;
+
+  IDLE_SERVICE
+};
+
+class DependentService final : public Service {
+public:
+  using Service::Service;
+
+private:
+  Dependency<Source> source_{*this};
+
+  IDLE_SERVICE
+};
+
+using Change = std::tuple<Guid, Service::Phase, Service::Phase>;
+
+/// Records the single and the batched phase transitions
+class Recorder final : public Implements<Listener> {
+public:
+  explicit Recorder(Inheritance parent)
+    : Implements<Listener>(std::move(parent)) {
+    enable({Event::OnServiceChanged, Event::OnServiceChangedBatch});
+  }
+
+  std::vector<Change> singles;
+  std::vector<std::vector<Change>> batches;
+
+protected:
+  void onServiceChanged(Service& current, Phase from,
+                        Phase to) noexcept override {
+    singles.emplace_back(current.guid(), from, to);
+  }
+
+  void onServiceChangedBatch(ChangeLog const& changes) noexcept override {
+    std::vector<Change> batch;
+    for (std::size_t i = 0; i < changes.size(); ++i) {
+      batch.emplace_back(changes.guids()[i], changes.from()[i],
+                         changes.to()[i]);
+    }
+    batches.push_back(std::move(batch));
+  }
+
+  IDLE_SERVICE
+};
+} // namespace listener_test
+
+using namespace listener_test;
+
+TEST_CASE("Listeners receive coalesced phase transitions in order",
+          "[listener]") {
+  Persistent<Context> context;
+  Persistent<Recorder> recorder(*context);
+  Persistent<SourceService> source(*context);
+  Persistent<DependentService> dependent(*context);
+
+  auto const is_observed = [&](Change const& change) {
+    return (std::get<0>(change) == source->guid()) ||
+           (std::get<0>(change) == dependent->guid());
+  };
+
+  recorder->start()
+      .then([&] {
+        return dependent->start();
+      })
+      .then(context->event_loop().async_post([&] {
+        // The transitions of the recorder itself are ignored
+        std::vector<Change> singles;
+        for (Change const& change : recorder->singles) {
+          if (is_observed(change)) {
+            singles.push_back(change);
+          }
+        }
+
+        std::vector<Change> batched;
+        std::size_t batches = 0U;
+        for (std::vector<Change> const& batch : recorder->batches) {
+          bool is_relevant = false;
+          for (Change const& change : batch) {
+            if (is_observed(change)) {
+              batched.push_back(change);
+              is_relevant = true;
+            }
+          }
+          if (is_relevant) {
+            ++batches;
+          }
+        }
+
+        // Every transition is delivered once and in the same order
+        CHECK(batched == singles);
+
+        // The transitions of a pass are coalesced into a single batch
+        CHECK(!singles.empty());
+        CHECK(batches < singles.size());
+      }))
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
@@ -0,0 +1,195 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <thread>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/pollable_executor.hpp>
+#include <idle/core/service.hpp>
+
+#ifdef __linux__
+#  include <poll.h>
+#endif
+
+using namespace idle;
+
+namespace pollable_executor_test {
+class Polled final : public Implements<> {
+public:
+  explicit Polled(Inheritance parent, bool waitable)
+    : Super(std::move(parent))
+    , executor_(*this, waitable) {}
+
+  PollableExecutor& executor() noexcept {
+    return executor_;
+  }
+
+private:
+  PollableExecutor executor_;
+
+  IDLE_SERVICE
+};
+
+#ifdef __linux__
+static bool is_readable(int handle) {
+  pollfd fd{};
+  fd.fd = handle;
+  fd.events = POLLIN;
+  return ::poll(&fd, 1, 0) == 1 && (fd.revents & POLLIN);
+}
+#endif
+} // namespace pollable_executor_test
+
+using namespace pollable_executor_test;
+
+TEST_CASE("PollableExecutor::pollSome dispatches bounded batches",
+          "[pollable_executor]") {
+  Persistent<Context> context;
+  Ref<Polled> polled;
+
+  std::size_t ran = 0;
+
+  context->event_loop()
+      .async_post([&] {
+        polled = spawn<Polled>(*context, false);
+        polled->init();
+        return polled->start();
+      })
+      .then([&] {
+        for (std::size_t i = 0; i < 10; ++i) {
+          polled->executor().post([&] {
+            ++ran;
+          });
+        }
+
+        CHECK(polled->executor().pollSome(4) == 4U);
+        CHECK(ran == 4U);
+
+        CHECK(polled->executor().pollSome(
+                  std::numeric_limits<std::size_t>::max()) == 6U);
+        CHECK(ran == 10U);
+
+        CHECK(polled->executor().pollSome(1) == 0U);
+        return polled->stop();
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("PollableExecutor::pollFor wakes up on work from other threads",
+          "[pollable_executor]") {
+  Persistent<Context> context;
+  Ref<Polled> polled;
+
+  std::atomic<std::size_t> ran{0};
+
+  context->event_loop()
+      .async_post([&] {
+        polled = spawn<Polled>(*context, false);
+        polled->init();
+        return polled->start();
+      })
+      .then([&] {
+        // Nothing was queued so the wait runs into the timeout
+        CHECK(polled->executor().pollFor(std::chrono::milliseconds(1)) == 0U);
+
+        std::thread producer([&] {
+          std::this_thread::sleep_for(std::chrono::milliseconds(20));
+          polled->executor().post([&] {
+            ++ran;
+          });
+        });
+
+        CHECK(polled->executor().pollFor(std::chrono::seconds(10)) == 1U);
+        CHECK(ran.load() == 1U);
+
+        producer.join();
+        return polled->stop();
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("PollableExecutor::waitableHandle signals available work",
+          "[pollable_executor]") {
+  Persistent<Context> context;
+  Ref<Polled> plain;
+  Ref<Polled> waitable;
+
+  context->event_loop()
+      .async_post([&] {
+        plain = spawn<Polled>(*context, false);
+        plain->init();
+        waitable = spawn<Polled>(*context, true);
+        waitable->init();
+        return when_all(plain->start(), waitable->start());
+      })
+      .then([&] {
+        CHECK(plain->executor().waitableHandle() == -1);
+
+#ifdef __linux__
+        int const handle = waitable->executor().waitableHandle();
+        REQUIRE(handle >= 0);
+        CHECK_FALSE(is_readable(handle));
+
+        waitable->executor().post([] {});
+        waitable->executor().post([] {});
+        CHECK(is_readable(handle));
+
+        // Bounded polling keeps the handle readable while work remains
+        CHECK(waitable->executor().pollSome(1) == 1U);
+        CHECK(is_readable(handle));
+
+        waitable->executor().poll();
+        CHECK_FALSE(is_readable(handle));
+#endif
+
+        return when_all(plain->stop(), waitable->stop());
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
@@ -0,0 +1,205 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/registry_snapshot.hpp>
+#include <idle/core/service.hpp>
+
+using namespace idle;
+
+namespace registry_snapshot_test {
+class Published : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class PublishingService final : public Implements<Published> {
+public:
+  using Implements<Published>::Implements;
+
+  IDLE_SERVICE
+};
+} // namespace registry_snapshot_test
+
+using namespace registry_snapshot_test;
+
+TEST_CASE("The registry snapshot can be queried from other threads",
+          "[registry]") {
+  Persistent<Context> context;
+
+  RegistrySnapshot::Version before = 0;
+  std::size_t found = 0;
+
+  context->event_loop()
+      .async_post([&] {
+        before = context->snapshot()->version();
+        return spawn<PublishingService>(*context);
+      })
+      .then([&](Ref<PublishingService> service) {
+        service->init();
+
+        // The snapshot is published on the next event loop iteration
+        return context->event_loop().async_post([&, service] {
+          std::thread reader([&] {
+            RegistryView const view = context->snapshot();
+            CHECK(view->version() > before);
+
+            for (WeakRef<Interface> const& inter :
+                 view->find<Published>()) {
+              if (auto locked = inter.lock()) {
+                CHECK(&locked->owner() == service.get());
+                ++found;
+              }
+            }
+          });
+          reader.join();
+
+          service->destroy();
+        });
+      })
+      .then([&] {
+        CHECK(found == 1U);
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("Revoked interfaces disappear from the next registry snapshot",
+          "[registry]") {
+  Persistent<Context> context;
+  Ref<PublishingService> service;
+  RegistrySnapshot::Version published = 0;
+
+  context->event_loop()
+      .async_post([&] {
+        service = spawn<PublishingService>(*context);
+        service->init();
+      })
+      .then(context->event_loop().async_post([&] {
+        RegistryView const view = context->snapshot();
+        published = view->version();
+        CHECK(view->find<Published>().size() == 1U);
+
+        service->destroy();
+      }))
+      .then(context->event_loop().async_post([&] {
+        RegistryView const view = context->snapshot();
+        CHECK(view->version() > published);
+        CHECK(view->find<Published>().empty());
+
+        return context->stop(0);
+      }))
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("Registry snapshots are read consistently while being published",
+          "[registry]") {
+  constexpr std::size_t readers = 4U;
+  constexpr std::size_t rounds = 64U;
+
+  Persistent<Context> context;
+
+  std::atomic<bool> stop{false};
+  std::atomic<std::size_t> regressed{0};
+  std::vector<std::thread> threads;
+  std::size_t round = 0;
+
+  auto join_readers = [&] {
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    threads.clear();
+  };
+
+  context->event_loop()
+      .async_post([&] {
+        for (std::size_t i = 0; i < readers; ++i) {
+          threads.emplace_back([&] {
+            RegistrySnapshot::Version last = 0;
+
+            while (!stop.load(std::memory_order_relaxed)) {
+              RegistryView const view = context->snapshot();
+
+              // Versions never go backwards
+              if (view->version() < last) {
+                regressed.fetch_add(1U, std::memory_order_relaxed);
+              }
+              last = view->version();
+
+              // Revoked interfaces can't be locked anymore but never dangle
+              for (WeakRef<Interface> const& inter : view->find<Published>()) {
+                (void)inter.lock();
+              }
+            }
+          });
+        }
+
+        return loop([&] {
+          Ref<PublishingService> service = spawn<PublishingService>(*context);
+          service->init();
+
+          // Revoke the interface after it was published
+          return context->event_loop()
+              .async_post([service] {
+                service->destroy();
+              })
+              .then([&]() -> loop_result<> {
+                if (++round < rounds) {
+                  return loop_continue();
+                } else {
+                  return loop_break();
+                }
+              });
+        });
+      })
+      .then([&] {
+        join_readers();
+
+        CHECK(regressed.load() == 0U);
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        join_readers();
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
@@ -0,0 +1,135 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/service.hpp>
+
+using namespace idle;
+
+namespace scheduling_table_test {
+class PlainService final : public Service {
+public:
+  using Service::Service;
+
+  IDLE_SERVICE
+};
+} // namespace scheduling_table_test
+
+using namespace scheduling_table_test;
+
+TEST_CASE("The phase of a destroyed service is never read from a reused row",
+          "[scheduling_table]") {
+  constexpr std::size_t rounds = 128U;
+
+  Persistent<Context> context;
+
+  // The destroyed services are kept alive, such that their phase
+  // can still be read after their row was reused.
+  std::vector<Ref<PlainService>> destroyed(rounds);
+  std::vector<Ref<PlainService>> started;
+  std::atomic<std::size_t> published{0U};
+
+  std::atomic<bool> stop{false};
+  std::atomic<std::size_t> foreign{0U};
+  std::thread reader;
+  std::size_t round = 0U;
+
+  auto join_reader = [&] {
+    stop.store(true, std::memory_order_relaxed);
+    if (reader.joinable()) {
+      reader.join();
+    }
+  };
+
+  context->event_loop()
+      .async_post([&] {
+        reader = std::thread([&] {
+          while (!stop.load(std::memory_order_relaxed)) {
+            std::size_t const count = published.load(
+                std::memory_order_acquire);
+
+            for (std::size_t i = 0; i < count; ++i) {
+              // The destroyed services were never started, a started phase
+              // belongs to the service that reused the row.
+              switch (destroyed[i]->state().phase()) {
+                case Service::Phase::locked:
+                case Service::Phase::starting:
+                case Service::Phase::running:
+                case Service::Phase::stopping:
+                case Service::Phase::pending:
+                  foreign.fetch_add(1U, std::memory_order_relaxed);
+                  break;
+                default:
+                  break;
+              }
+            }
+          }
+        });
+
+        return loop([&] {
+          Ref<PlainService> service = spawn<PlainService>(*context);
+          service->init();
+
+          destroyed[round] = service;
+          published.store(round + 1U, std::memory_order_release);
+
+          service->destroy();
+
+          // The replacement reuses the row which was just released
+          Ref<PlainService> replacement = spawn<PlainService>(*context);
+          replacement->init();
+          started.push_back(replacement);
+
+          return replacement->start().then([&]() -> loop_result<> {
+            if (++round < rounds) {
+              return loop_continue();
+            } else {
+              return loop_break();
+            }
+          });
+        });
+      })
+      .then([&] {
+        join_reader();
+
+        CHECK(foreign.load() == 0U);
+        for (Ref<PlainService> const& service : destroyed) {
+          CHECK(service->state().phase() == Service::Phase::destroyed);
+        }
+
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        join_reader();
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
@@ -0,0 +1,197 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <sstream>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/dep/optional.hpp>
+#include <idle/service/simulation.hpp>
+#include <idle/service/timer.hpp>
+
+using namespace idle;
+
+namespace simulation_test {
+/// Waits an hour on the Timer inside a fresh simulated Context,
+/// the Simulation is inspected before the Context is stopped again.
+template <typename Prepare, typename Inspect>
+void wait_simulated_hour(Prepare&& prepare, Inspect&& inspect) {
+  Persistent<Context> context;
+  Ref<Simulation> simulation;
+  Ref<Timer> timer;
+
+  context->event_loop()
+      .async_post([&] {
+        simulation = Simulation::create(*context);
+        simulation->init();
+        prepare(*simulation);
+
+        timer = Timer::create(*context);
+        timer->init();
+        return timer->start();
+      })
+      .then([&] {
+        return timer->waitFor(std::chrono::hours(1));
+      })
+      .then([&] {
+        inspect(*simulation);
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+} // namespace simulation_test
+
+using namespace simulation_test;
+
+TEST_CASE("Simulation traces survive a write and read round trip",
+          "[simulation]") {
+  using Kind = Simulation::Event::Kind;
+  using std::chrono::milliseconds;
+
+  Simulation::Trace const trace{
+      {Kind::Handler, milliseconds(0), 1},
+      {Kind::Advance, milliseconds(250), 0},
+      {Kind::Alarm, milliseconds(250), 1},
+      {Kind::Handler, milliseconds(250), 2},
+  };
+
+  std::stringstream ss;
+  Simulation::writeTrace(ss, trace);
+
+  Simulation::Trace read;
+  REQUIRE(Simulation::readTrace(ss, read));
+  CHECK(read == trace);
+}
+
+TEST_CASE("Simulation traces reject unknown events", "[simulation]") {
+  std::stringstream ss("handler 0 1\ntimeout 10 2\n");
+
+  Simulation::Trace read;
+  CHECK_FALSE(Simulation::readTrace(ss, read));
+}
+
+TEST_CASE("Simulation advances explicitly to pending alarms", "[simulation]") {
+  using std::chrono::milliseconds;
+
+  Persistent<Context> context;
+  Ref<Simulation> simulation;
+  std::size_t fired = 0;
+
+  context->event_loop()
+      .async_post([&] {
+        simulation = Simulation::create(*context);
+        simulation->init();
+        simulation->setAutoAdvance(false);
+        return simulation->start();
+      })
+      .then([&] {
+        Clock::TimePoint const start = simulation->now();
+
+        simulation->alarm(start + milliseconds(100), [&] {
+          ++fired;
+        });
+
+        simulation->advance(milliseconds(50));
+        CHECK(fired == 0U);
+        CHECK(simulation->now() == start + milliseconds(50));
+
+        simulation->advance(milliseconds(50));
+        CHECK(fired == 1U);
+        CHECK(simulation->now() == start + milliseconds(100));
+
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("Simulation auto advances the Timer to its deadline",
+          "[simulation]") {
+  auto const started = std::chrono::steady_clock::now();
+  Clock::TimePoint simulated_start;
+
+  wait_simulated_hour(
+      [&](Simulation& simulation) {
+        simulated_start = simulation.now();
+      },
+      [&](Simulation& simulation) {
+        CHECK(simulation.now() - simulated_start >= std::chrono::hours(1));
+      });
+
+  // The hour passed in simulated time only
+  CHECK(std::chrono::steady_clock::now() - started < std::chrono::minutes(1));
+}
+
+TEST_CASE("Simulation replays recorded traces and reports divergences",
+          "[simulation]") {
+  using Kind = Simulation::Event::Kind;
+
+  Simulation::Trace recorded;
+  wait_simulated_hour(
+      [](Simulation& simulation) {
+        simulation.record();
+      },
+      [&](Simulation& simulation) {
+        recorded = simulation.trace();
+      });
+
+  REQUIRE_FALSE(recorded.empty());
+
+  // Replaying the unmodified trace reproduces every event
+  wait_simulated_hour(
+      [&](Simulation& simulation) {
+        simulation.replay(recorded);
+      },
+      [](Simulation& simulation) {
+        CHECK_FALSE(simulation.divergence());
+      });
+
+  // Shift the first time advance, the replay diverges right there
+  Simulation::Trace tampered = recorded;
+  std::size_t advance = 0;
+  while ((advance < tampered.size()) &&
+         (tampered[advance].kind != Kind::Advance)) {
+    ++advance;
+  }
+  REQUIRE(advance < tampered.size());
+  tampered[advance].at += std::chrono::milliseconds(1);
+
+  wait_simulated_hour(
+      [&](Simulation& simulation) {
+        simulation.replay(tampered);
+      },
+      [&](Simulation& simulation) {
+        optional<std::size_t> const divergence = simulation.divergence();
+        CHECK(divergence.value_or(tampered.size()) == advance);
+      });
+}
@@ -0,0 +1,214 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/service.hpp>
+#include <idle/interface/task_pool.hpp>
+
+using namespace idle;
+
+namespace task_pool_test {
+/// A pool without workers which runs all work inplace
+class InlineTaskPool final : public Implements<TaskPool> {
+public:
+  using Implements<TaskPool>::Implements;
+
+  std::size_t concurrency() const noexcept override {
+    return 0U;
+  }
+
+  bool isThisThread() const noexcept override {
+    return false;
+  }
+
+protected:
+  void queue(work task) noexcept override {
+    std::move(task)();
+  }
+
+  IDLE_SERVICE
+};
+} // namespace task_pool_test
+
+using namespace task_pool_test;
+
+TEST_CASE("TaskPool workers steal locally queued work", "[task_pool]") {
+  Persistent<Context> context;
+  Ref<TaskPool> pool;
+
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<std::size_t> ran{0};
+
+  context->event_loop()
+      .async_post([&] {
+        pool = TaskPool::create(*context);
+        pool->init();
+        return pool->start();
+      })
+      .then([&] {
+        // Work queued from a worker is kept in its own deque,
+        // the idle workers have to steal it from there.
+        return pool->async_post([&] {
+          std::vector<continuable<>> forked;
+          for (std::size_t i = 0; i < 64; ++i) {
+            forked.push_back(pool->async_post([&] {
+              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+              std::lock_guard<std::mutex> lock(mutex);
+              threads.insert(std::this_thread::get_id());
+              ++ran;
+            }));
+          }
+          return when_all(std::move(forked));
+        });
+      })
+      .then(
+          [&] {
+            CHECK(ran.load() == 64U);
+            if (pool->concurrency() > 1U) {
+              CHECK(threads.size() > 1U);
+            }
+
+            return pool->stop();
+          },
+          context->event_loop().through_post())
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("TaskPool resolves pending work on stop and cancels later work",
+          "[task_pool]") {
+  Persistent<Context> context;
+  Ref<TaskPool> pool;
+
+  constexpr std::size_t pending = 256U;
+  std::atomic<std::size_t> ran{0};
+  std::atomic<std::size_t> resolved{0};
+  std::atomic<std::size_t> canceled{0};
+
+  auto count = [&](auto&&... args) {
+    if (sizeof...(args) != 0U) {
+      ++canceled;
+    }
+    ++resolved;
+  };
+
+  context->event_loop()
+      .async_post([&] {
+        pool = TaskPool::create(*context);
+        pool->init();
+        return pool->start();
+      })
+      .then([&] {
+        for (std::size_t i = 0; i < pending; ++i) {
+          pool->async_post([&] {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                ++ran;
+              })
+              .next(count)
+              .done();
+        }
+
+        // Every pending work is either run or canceled, none is leaked
+        return pool->stop();
+      })
+      .then([&] {
+        CHECK(resolved.load() == pending);
+        CHECK(ran.load() + canceled.load() == pending);
+
+        // Work queued after the stop is canceled immediately
+        std::size_t const before = ran.load();
+        pool->async_post([&] {
+              ++ran;
+            })
+            .next(count)
+            .done();
+
+        CHECK(resolved.load() == pending + 1U);
+        CHECK(ran.load() == before);
+
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("TaskPool::fork_each runs every index on a pool without workers",
+          "[task_pool]") {
+  Persistent<Context> context;
+  Ref<InlineTaskPool> pool;
+
+  constexpr std::size_t count = 100U;
+  std::vector<std::size_t> visited(count, 0U);
+
+  context->event_loop()
+      .async_post([&] {
+        pool = spawn<InlineTaskPool>(*context);
+        pool->init();
+        return pool->start();
+      })
+      .then([&] {
+        return pool->fork_each(
+            count,
+            [&](std::size_t i) {
+              ++visited[i];
+            },
+            7U);
+      })
+      .then([&] {
+        for (std::size_t i = 0; i < count; ++i) {
+          CHECK(visited[i] == 1U);
+        }
+
+        return pool->stop();
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
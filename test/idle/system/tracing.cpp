@@ -0,0 +1,192 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/service.hpp>
+#include <idle/core/tracing.hpp>
+
+using namespace idle;
+
+namespace tracing_test {
+class Source : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class SourceService final : public Implements<Source> {
+public:
+  using Implements<Source>::Implements;
+
+  IDLE_SERVICE
+};
+
+class DependentService final : public Service {
+public:
+  using Service::Service;
+
+private:
+  Dependency<Source> source_{*this};
+
+  IDLE_SERVICE
+};
+} // namespace tracing_test
+
+using namespace tracing_test;
+
+using Category = Tracing::Category;
+using Phase = Tracing::Phase;
+
+static std::size_t count_of(std::string const& str, std::string const& sub) {
+  std::size_t count = 0U;
+  for (std::size_t pos = str.find(sub); pos != std::string::npos;
+       pos = str.find(sub, pos + sub.size())) {
+    ++count;
+  }
+  return count;
+}
+
+static Tracing::Event const*
+find_event(std::vector<Tracing::Event> const& events, char const* name,
+           Phase phase, std::uint64_t id) {
+  auto const itr = std::find_if(events.begin(), events.end(),
+                                [&](Tracing::Event const& event) {
+                                  return (std::string(event.name) == name) &&
+                                         (event.phase == phase) &&
+                                         (event.id == id);
+                                });
+  return (itr != events.end()) ? &*itr : nullptr;
+}
+
+TEST_CASE("Tracing records nothing while disabled", "[tracing]") {
+  Tracing tracing;
+  REQUIRE_FALSE(tracing.isEnabled());
+
+  tracing.begin(Category::Scheduler, "process");
+  tracing.end(Category::Scheduler, "process");
+  { Tracing::Span const span = tracing.span(Category::Plugin, "dlopen"); }
+
+  CHECK(tracing.events().empty());
+}
+
+TEST_CASE("Tracing spans end when they are destroyed", "[tracing]") {
+  Tracing tracing;
+  tracing.setEnabled(true);
+
+  {
+    Tracing::Span const span = tracing.span(Category::Compiler, "build",
+                                            "a \"quoted\" label");
+  }
+
+  std::vector<Tracing::Event> const events = tracing.events();
+  REQUIRE(events.size() == 2U);
+  CHECK(events[0].phase == Phase::Begin);
+  CHECK(events[1].phase == Phase::End);
+  CHECK(events[0].id == events[1].id);
+  CHECK(std::string(events[0].label.data()) == "a \"quoted\" label");
+
+  std::stringstream ss;
+  tracing.write(ss);
+  CHECK(ss.str().find("\"label\":\"a \\\"quoted\\\" label\"") !=
+        std::string::npos);
+}
+
+TEST_CASE("Tracing overwrites the oldest events of a full ring", "[tracing]") {
+  Tracing tracing;
+  tracing.setEnabled(true);
+
+  std::size_t const capacity = Tracing::ring_size;
+  for (std::size_t i = 0; i < capacity + 10U; ++i) {
+    tracing.begin(Category::Scheduler, "process", i);
+  }
+
+  std::vector<Tracing::Event> const events = tracing.events();
+  REQUIRE(events.size() == capacity);
+  CHECK(events.front().id == 10U);
+  CHECK(tracing.dropped() == 10U);
+
+  tracing.clear();
+  CHECK(tracing.events().empty());
+}
+
+TEST_CASE("Tracing exports the lifecycle of a started graph", "[tracing]") {
+  Persistent<Context> context;
+  Persistent<SourceService> source(*context);
+  Persistent<DependentService> dependent(*context);
+
+  Tracing& tracing = context->tracing();
+  tracing.setEnabled(true);
+
+  dependent->start()
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+
+  std::vector<Tracing::Event> const events = tracing.events();
+
+  // Every lifecycle hook is enclosed by a begin and an end event
+  for (Guid const guid : {source->guid(), dependent->guid()}) {
+    std::uint64_t const id = guid.value();
+    for (char const* hook : {"onStart", "onStop"}) {
+      Tracing::Event const* begin = find_event(events, hook, Phase::Begin, id);
+      Tracing::Event const* end = find_event(events, hook, Phase::End, id);
+      REQUIRE(begin);
+      REQUIRE(end);
+      CHECK(begin->category == Category::Service);
+      CHECK(begin->time <= end->time);
+      CHECK(begin->label[0] != '\0');
+    }
+  }
+
+  // The dependency is started before its dependent
+  Tracing::Event const* source_started = find_event(
+      events, "onStart", Phase::End, source->guid().value());
+  Tracing::Event const* dependent_starting = find_event(
+      events, "onStart", Phase::Begin, dependent->guid().value());
+  REQUIRE(source_started);
+  REQUIRE(dependent_starting);
+  CHECK(source_started->time <= dependent_starting->time);
+
+  std::stringstream ss;
+  tracing.write(ss);
+  std::string const json = ss.str();
+
+  CHECK(json.find("{\"traceEvents\":[") == 0U);
+  CHECK(count_of(json, "\"ph\":\"b\"") == count_of(json, "\"ph\":\"e\""));
+  CHECK(count_of(json, "\"name\":\"onStart\"") >= 4U);
+  CHECK(count_of(json, "\"cat\":\"scheduler\"") >= 2U);
+}
@@ -0,0 +1,131 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/service.hpp>
+
+using namespace idle;
+
+namespace update_test {
+class First : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class Second : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class FirstService final : public Implements<First> {
+public:
+  using Implements<First>::Implements;
+
+  IDLE_SERVICE
+};
+
+class SecondService final : public Implements<Second> {
+public:
+  using Implements<Second>::Implements;
+
+private:
+  Dependency<First> first_{*this};
+
+  IDLE_SERVICE
+};
+
+class ThirdService final : public Service {
+public:
+  using Service::Service;
+
+private:
+  Dependency<Second> second_{*this};
+
+  IDLE_SERVICE
+};
+
+class UnrelatedService final : public Service {
+public:
+  using Service::Service;
+
+  IDLE_SERVICE
+};
+} // namespace update_test
+
+using namespace update_test;
+
+TEST_CASE("Context::update restarts the dependents of a toggled service",
+          "[update]") {
+  Persistent<Context> context;
+  Persistent<FirstService> first(*context);
+  Persistent<SecondService> second(*context);
+  Persistent<ThirdService> third(*context);
+  Persistent<UnrelatedService> unrelated(*context);
+
+  context->event_loop()
+      .async_post([&] {
+        return when_all(third->start(), unrelated->start());
+      })
+      .then([&] {
+        // Nothing changed since the start, the update is a no-op
+        return context->update();
+      })
+      .then([&] {
+        CHECK(third->state().isRunning());
+        CHECK(unrelated->state().isRunning());
+
+        return first->stop();
+      })
+      .then([&] {
+        CHECK_FALSE(second->state().isRunning());
+        CHECK_FALSE(third->state().isRunning());
+        CHECK(unrelated->state().isRunning());
+
+        return first->start();
+      })
+      .then([&] {
+        // Only the clusters changed through the toggle are revisited
+        return context->update();
+      })
+      .then([&] {
+        CHECK(first->state().isRunning());
+        CHECK(second->state().isRunning());
+        CHECK(third->state().isRunning());
+        CHECK(unrelated->state().isRunning());
+
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
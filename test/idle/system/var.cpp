@@ -0,0 +1,278 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/parts/dependency.hpp>
+#include <idle/core/service.hpp>
+#include <idle/service/art/reflection_tree.hpp>
+#include <idle/service/properties.hpp>
+#include <idle/service/var.hpp>
+
+using namespace idle;
+
+namespace var_test {
+struct Value {
+  std::int64_t value{0};
+};
+
+IDLE_REFLECT(Value, value)
+
+class Writer final : public Implements<> {
+public:
+  using Super::Super;
+
+  void write(std::string const& key, std::int64_t value) noexcept {
+    Value config;
+    config.value = value;
+    properties_->set(ConstReflectionPtr(config), key);
+  }
+
+private:
+  Dependency<Properties> properties_{*this};
+
+  IDLE_SERVICE
+};
+
+/// Records every update of its Var on its own
+class Reader final : public Implements<> {
+public:
+  explicit Reader(Inheritance parent, std::string key)
+    : Super(std::move(parent))
+    , var_(*this, std::move(key), {}, &Reader::onUpdate) {}
+
+  std::int64_t value() const noexcept {
+    return var_->value;
+  }
+
+  void set(std::int64_t value) {
+    Value replacement;
+    replacement.value = value;
+    var_.set(replacement);
+  }
+
+  std::vector<std::int64_t> updates;
+
+private:
+  static bool onUpdate(Reader& me, VarUpdate<Value>&& update) {
+    me.updates.push_back(update->value);
+    return update.apply();
+  }
+
+  Var<Value, Reader> var_;
+
+  IDLE_SERVICE
+};
+
+/// Records the updates of all its Vars at once
+class GroupedReader final : public Implements<> {
+public:
+  using Super::Super;
+
+  std::int64_t a() const noexcept {
+    return a_->value;
+  }
+  std::int64_t b() const noexcept {
+    return b_->value;
+  }
+  std::int64_t c() const noexcept {
+    return c_->value;
+  }
+
+  /// The sizes of the delivered groups
+  std::vector<std::size_t> groups;
+  std::size_t applied{0};
+
+private:
+  static void onUpdates(GroupedReader& me, VarUpdates&& updates) {
+    me.groups.push_back(updates.size());
+    me.applied += updates.apply();
+  }
+
+  VarGroup<GroupedReader> group_{*this, &GroupedReader::onUpdates};
+  GroupedVar<Value, GroupedReader> a_{*this, "var_test.a", {}, group_};
+  GroupedVar<Value, GroupedReader> b_{*this, "var_test.b", {}, group_};
+  GroupedVar<Value, GroupedReader> c_{*this, "var_test.c", {}, group_};
+
+  IDLE_SERVICE
+};
+
+/// A temporary Properties file that is removed afterwards
+class TemporaryFile {
+public:
+  TemporaryFile()
+    : path_(boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path("idle-var-test-%%%%%%.toml")) {}
+
+  ~TemporaryFile() {
+    boost::system::error_code ec;
+    boost::filesystem::remove(path_, ec);
+  }
+
+  ReloadableProperties::Config config() const {
+    ReloadableProperties::Config config;
+    config.path = path_.generic_string();
+    config.write_back = false;
+    return config;
+  }
+
+private:
+  boost::filesystem::path path_;
+};
+
+/// Resolves after the condition became true on the event loop
+template <typename Condition>
+continuable<> wait_until(Context& context, Condition condition) {
+  return loop([&context, condition] {
+    return context.event_loop().async_post([] {}).then(
+        [condition]() -> loop_result<> {
+          if (condition()) {
+            return loop_break();
+          } else {
+            return loop_continue();
+          }
+        });
+  });
+}
+} // namespace var_test
+
+using namespace var_test;
+
+TEST_CASE("GroupedVars deliver the updates of a service at once", "[var]") {
+  TemporaryFile file;
+  Persistent<Context> context;
+  Persistent<ReloadableProperties> properties(*context);
+  properties->setup(file.config());
+  Persistent<Writer> writer(*context);
+  Persistent<GroupedReader> reader(*context);
+
+  properties->start()
+      .then([&] {
+        return writer->start() && reader->start();
+      })
+      .then(
+          [&] {
+            writer->write("var_test.a", 1);
+            writer->write("var_test.b", 2);
+
+            return wait_until(*context, [&] {
+              return !reader->groups.empty();
+            });
+          },
+          context->event_loop().through_post())
+      .then(context->event_loop().async_post([&] {
+        // The changed Vars are grouped, the unchanged one is skipped
+        CHECK(reader->groups == std::vector<std::size_t>{2U});
+        CHECK(reader->applied == 2U);
+
+        CHECK(reader->a() == 1);
+        CHECK(reader->b() == 2);
+        CHECK(reader->c() == 0);
+      }))
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
+
+TEST_CASE("Vars are updated only when their key changed", "[var]") {
+  TemporaryFile file;
+  Persistent<Context> context;
+  Persistent<ReloadableProperties> properties(*context);
+  properties->setup(file.config());
+  Persistent<Writer> writer(*context);
+  Persistent<Reader> first(*context, "var_test.shared");
+  Persistent<Reader> second(*context, "var_test.shared");
+  Persistent<Reader> other(*context, "var_test.other");
+
+  properties->start()
+      .then([&] {
+        return writer->start() && first->start() && second->start() &&
+               other->start();
+      })
+      .then(
+          [&] {
+            writer->write("var_test.shared", 1);
+
+            return wait_until(*context, [&] {
+              return !first->updates.empty() && !second->updates.empty();
+            });
+          },
+          context->event_loop().through_post())
+      .then([&] {
+        // Every following generation is compared against its predecessor,
+        // a cached comparison of a previous generation is never reused.
+        writer->write("var_test.other", 5);
+
+        return wait_until(*context, [&] {
+          return !other->updates.empty();
+        });
+      })
+      .then([&] {
+        CHECK(first->updates == std::vector<std::int64_t>{1});
+        CHECK(second->updates == std::vector<std::int64_t>{1});
+
+        writer->write("var_test.shared", 2);
+
+        return wait_until(*context, [&] {
+          return first->updates.size() == 2U && second->updates.size() == 2U;
+        });
+      })
+      .then([&] {
+        CHECK(first->value() == 2);
+        CHECK(second->value() == 2);
+        CHECK(other->updates == std::vector<std::int64_t>{5});
+
+        // A Var isn't notified about the change it made on its own
+        first->set(3);
+
+        return wait_until(*context, [&] {
+          return second->updates.size() == 3U;
+        });
+      })
+      .then(context->event_loop().async_post([&] {
+        CHECK(first->updates == std::vector<std::int64_t>{1, 2});
+        CHECK(first->value() == 3);
+        CHECK(second->updates == std::vector<std::int64_t>{1, 2, 3});
+        CHECK(second->value() == 3);
+      }))
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+}
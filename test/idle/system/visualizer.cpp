@@ -0,0 +1,120 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <catch2/catch.hpp>
+#include <idle/core/context.hpp>
+#include <idle/core/service.hpp>
+#include <idle/service/visualizer.hpp>
+
+using namespace idle;
+
+namespace visualizer_test {
+class UnchangedService final : public Service {
+public:
+  using Service::Service;
+
+  IDLE_SERVICE
+};
+
+class AddedService final : public Service {
+public:
+  using Service::Service;
+
+  IDLE_SERVICE
+};
+} // namespace visualizer_test
+
+using namespace visualizer_test;
+
+static std::string read_file(std::string const& path) {
+  std::ifstream file(path);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+/// Returns the beginning of the node of the service inside a graphviz file
+static std::string node_of(Service const& service) {
+  std::ostringstream ss;
+  ss << '"' << service.guid().hex() << '"' << '\n' << "[label=";
+  return ss.str();
+}
+
+TEST_CASE("The Visualizer exports deltas of the service graph",
+          "[visualizer]") {
+  std::string const path = "visualizer_test.gv";
+
+  Persistent<Context> context;
+  Persistent<UnchangedService> unchanged(*context);
+  Ref<Visualizer> visualizer;
+  Ref<AddedService> added;
+
+  context->event_loop()
+      .async_post([&] {
+        visualizer = Visualizer::create(*context);
+        visualizer->init();
+        return visualizer->start();
+      })
+      .then([&] {
+        Visualizer::ExportOptions options;
+        // Yield back to the event loop after every service
+        options.chunk_size = 1U;
+        return visualizer->exportGraph(path, options);
+      })
+      .then([&](std::size_t id) {
+        std::string const full = read_file(path);
+        CHECK(full.find("digraph") != std::string::npos);
+        CHECK(full.find(node_of(*unchanged)) != std::string::npos);
+
+        added = spawn<AddedService>(*context);
+        added->init();
+
+        Visualizer::ExportOptions options;
+        options.since = id;
+        return visualizer->exportGraph(path, options);
+      })
+      .then([&](std::size_t) {
+        std::string const delta = read_file(path);
+        CHECK(delta.find(node_of(*added)) != std::string::npos);
+        CHECK(delta.find(node_of(*unchanged)) == std::string::npos);
+
+        added->destroy();
+        return visualizer->stop();
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  REQUIRE(context->run() == 0);
+
+  std::remove(path.c_str());
+}
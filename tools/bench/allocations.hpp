@@ -0,0 +1,42 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_TOOLS_BENCH_ALLOCATIONS_HPP_INCLUDED
+#define IDLE_TOOLS_BENCH_ALLOCATIONS_HPP_INCLUDED
+
+#include <cstdint>
+
+namespace idle {
+namespace bench {
+/// Returns the count of global operator new calls made by the benchmark
+///
+/// The count is collected through replacing the global operator new
+/// of the benchmark executable, allocations inside of a dynamically linked
+/// libidle are only visible on platforms with symbol interposition.
+std::uint64_t allocation_count() noexcept;
+} // namespace bench
+} // namespace idle
+
+#endif // IDLE_TOOLS_BENCH_ALLOCATIONS_HPP_INCLUDED
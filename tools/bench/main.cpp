@@ -0,0 +1,1698 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <idle/core/dep/format.hpp>
+#include <idle/idle.hpp>
+#include <bench/allocations.hpp>
+#include <bench/topology.hpp>
+#include <nlohmann/json.hpp>
+
+using namespace idle;
+using namespace idle::bench;
+
+namespace idle {
+namespace bench {
+/// The Interface provided by all nodes of a single layer
+template <std::size_t Layer>
+class BenchLayer : public Interface {
+public:
+  using Interface::Interface;
+
+  static Interface::Id id() noexcept {
+    static Interface::Id const this_id{
+        format(FMT_STRING("idle::bench::BenchLayer<{}>"), Layer)};
+    return this_id;
+  }
+  Interface::Id type() const noexcept override {
+    return id();
+  }
+  static bool classof(Interface const& inter) noexcept {
+    return inter.type() == id();
+  }
+};
+
+template <std::size_t Layer>
+class SourceNode final : public Implements<BenchLayer<Layer>> {
+public:
+  using Implements<BenchLayer<Layer>>::Implements;
+
+  IDLE_SERVICE
+};
+
+template <std::size_t Layer>
+class DependingNode final : public Implements<BenchLayer<Layer>> {
+public:
+  using Implements<BenchLayer<Layer>>::Implements;
+
+private:
+  Dependency<BenchLayer<Layer - 1>> dependency_{*this};
+
+  IDLE_SERVICE
+};
+
+template <std::size_t Layer>
+class CollectingNode final : public Implements<BenchLayer<Layer>> {
+public:
+  using Implements<BenchLayer<Layer>>::Implements;
+
+private:
+  DynDependencyList<BenchLayer<Layer - 1>> dependencies_{*this};
+
+  IDLE_SERVICE
+};
+
+template <std::size_t Layer>
+Ref<Service> spawn_layer(std::true_type /*is_source*/, Inheritance parent,
+                         bool collects) {
+  (void)collects;
+  return spawn<SourceNode<Layer>>(std::move(parent));
+}
+template <std::size_t Layer>
+Ref<Service> spawn_layer(std::false_type /*is_source*/, Inheritance parent,
+                         bool collects) {
+  if (collects) {
+    return spawn<CollectingNode<Layer>>(std::move(parent));
+  } else {
+    return spawn<DependingNode<Layer>>(std::move(parent));
+  }
+}
+template <std::size_t Layer>
+Ref<Service> spawn_layer(Inheritance parent, bool collects) {
+  return spawn_layer<Layer>(std::integral_constant<bool, Layer == 0>{},
+                            std::move(parent), collects);
+}
+
+template <std::size_t... Layers>
+Ref<Service> spawn_node(std::index_sequence<Layers...>, TopologyNode node,
+                        Inheritance parent) {
+  using factory_t = Ref<Service> (*)(Inheritance, bool);
+  static factory_t const factories[] = {&spawn_layer<Layers>...};
+
+  IDLE_ASSERT(node.layer < sizeof...(Layers));
+  return factories[node.layer](std::move(parent), node.collects);
+}
+
+/// The Interface that is published and revoked by the churn scenario
+class ChurnInterface : public Interface {
+public:
+  using Interface::Interface;
+
+  IDLE_INTERFACE
+};
+
+class ChurnProvider final : public Implements<ChurnInterface> {
+public:
+  using Implements<ChurnInterface>::Implements;
+
+  IDLE_SERVICE
+};
+
+class ChurnConsumer final : public Implements<> {
+public:
+  using Super::Super;
+
+private:
+  DynDependencyList<ChurnInterface> providers_{*this};
+
+  IDLE_SERVICE
+};
+
+/// The threads, providers and reloads per iteration of registry_lookup
+constexpr std::size_t lookup_threads = 4U;
+constexpr std::size_t lookup_providers = 8U;
+constexpr std::size_t lookup_reloads = 100U;
+
+/// The Interface that is read by the dyn_read scenario
+class ReadInterface : public Interface {
+public:
+  using Interface::Interface;
+
+  std::uint64_t value() const noexcept {
+    return value_;
+  }
+
+private:
+  std::uint64_t value_{1U};
+
+  IDLE_INTERFACE
+};
+
+class ReadProvider final : public Implements<ReadInterface> {
+public:
+  using Implements<ReadInterface>::Implements;
+
+  IDLE_SERVICE
+};
+
+class ReadConsumer final : public Implements<> {
+public:
+  using Super::Super;
+
+  ConcurrentDynDependency<ReadInterface> const& current() const noexcept {
+    return current_;
+  }
+
+private:
+  ConcurrentDynDependency<ReadInterface> current_{*this};
+
+  IDLE_SERVICE
+};
+
+/// The threads and reads per thread and iteration of dyn_read
+constexpr std::size_t read_threads = 4U;
+constexpr std::size_t read_iterations = 100000U;
+
+/// Accumulates the read values, so the reads can't be optimized out
+static std::atomic<std::uint64_t> read_sink{0U};
+
+struct StormConfig {
+  std::int64_t value{0};
+};
+
+IDLE_REFLECT(StormConfig, value)
+
+class StormReader final : public Implements<> {
+public:
+  using Super::Super;
+
+private:
+  Var<StormConfig> config_{*this, "bench.storm"};
+
+  IDLE_SERVICE
+};
+
+class StormWriter final : public Implements<> {
+public:
+  using Super::Super;
+
+  void write(std::int64_t value) noexcept {
+    StormConfig config;
+    config.value = value;
+    properties_->set(ConstReflectionPtr(config), "bench.storm");
+  }
+
+private:
+  Dependency<Properties> properties_{*this};
+
+  IDLE_SERVICE
+};
+
+struct BatchConfig {
+  std::int64_t value{0};
+};
+
+IDLE_REFLECT(BatchConfig, value)
+
+constexpr std::size_t batch_services = 100U;
+constexpr std::size_t batch_vars_per_service = 10U;
+
+static std::string batch_key(std::size_t service, std::size_t var) {
+  return "bench.batch.s" + std::to_string(service) + ".v" +
+         std::to_string(var);
+}
+
+/// Counts the Var hook invocations and the applied values of the
+/// var_batch scenario.
+struct BatchCounters {
+  std::size_t hooks{0};
+  std::size_t applied{0};
+};
+
+static BatchCounters batch_counters;
+
+/// Reacts on the update of every Var on its own
+class BatchReader final : public Implements<> {
+public:
+  using VarType = Var<BatchConfig, BatchReader>;
+
+  explicit BatchReader(Inheritance parent, std::size_t index)
+    : Super(std::move(parent)) {
+    for (std::size_t i = 0; i < batch_vars_per_service; ++i) {
+      vars_.push_back(std::make_unique<VarType>(
+          *this, batch_key(index, i), DefaultConstruct<BatchConfig>{},
+          &BatchReader::onUpdate));
+    }
+  }
+
+private:
+  static bool onUpdate(BatchReader&, VarUpdate<BatchConfig>&& update) {
+    ++batch_counters.hooks;
+    if (update.apply()) {
+      ++batch_counters.applied;
+    }
+    return true;
+  }
+
+  std::vector<std::unique_ptr<VarType>> vars_;
+
+  IDLE_SERVICE
+};
+
+/// Reacts on the updates of all its Vars at once through a VarGroup
+class GroupedBatchReader final : public Implements<> {
+public:
+  using VarType = GroupedVar<BatchConfig, GroupedBatchReader>;
+
+  explicit GroupedBatchReader(Inheritance parent, std::size_t index)
+    : Super(std::move(parent)) {
+    for (std::size_t i = 0; i < batch_vars_per_service; ++i) {
+      vars_.push_back(std::make_unique<VarType>(
+          *this, batch_key(index, i), DefaultConstruct<BatchConfig>{},
+          group_));
+    }
+  }
+
+private:
+  static void onUpdates(GroupedBatchReader&, VarUpdates&& updates) {
+    ++batch_counters.hooks;
+    batch_counters.applied += updates.apply();
+  }
+
+  VarGroup<GroupedBatchReader> group_{*this, &GroupedBatchReader::onUpdates};
+  std::vector<std::unique_ptr<VarType>> vars_;
+
+  IDLE_SERVICE
+};
+
+class BatchWriter final : public Implements<> {
+public:
+  using Super::Super;
+
+  void write(std::int64_t value) noexcept {
+    BatchConfig config;
+    config.value = value;
+
+    for (std::size_t s = 0; s < batch_services; ++s) {
+      for (std::size_t v = 0; v < batch_vars_per_service; ++v) {
+        properties_->set(ConstReflectionPtr(config), batch_key(s, v));
+      }
+    }
+  }
+
+private:
+  Dependency<Properties> properties_{*this};
+
+  IDLE_SERVICE
+};
+
+/// A Logger that discards all messages, such that only the overhead
+/// of the Log itself is measured.
+class CountingLogger final : public Implements<Logger> {
+public:
+  using Implements<Logger>::Implements;
+
+  void log(LogLevel level, LogMessage const& message) noexcept override {
+    (void)level;
+    bytes_ += message.message.size();
+    ++messages_;
+  }
+
+  std::uint64_t messages() const noexcept {
+    return messages_;
+  }
+
+private:
+  std::uint64_t messages_{0};
+  std::uint64_t bytes_{0};
+
+  IDLE_SERVICE
+};
+
+class LogEmitter final : public Implements<> {
+public:
+  using Super::Super;
+
+  void emit(std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      IDLE_LOG_INFO(log_, "Benchmark message {} of {}", i, count);
+    }
+  }
+
+private:
+  Dependency<Log> log_{*this};
+
+  IDLE_SERVICE
+};
+
+/// A Command that is registered and unregistered by the command
+/// contention scenario.
+class ChurnCommand final : public Implements<Command> {
+public:
+  explicit ChurnCommand(Inheritance parent, std::string name)
+    : Super(std::move(parent))
+    , name_(std::move(name)) {}
+
+  continuable<> invoke(Ref<Session> session, Arguments&& args) override {
+    (void)session;
+    (void)args;
+    return make_ready_continuable();
+  }
+
+  std::string command_name() const noexcept override {
+    return name_;
+  }
+
+private:
+  std::string const name_;
+
+  IDLE_SERVICE
+};
+
+/// The Session of the completing threads, which never produces output
+class SilentSession final : public Session {
+public:
+  Sink& sink() noexcept override {
+    IDLE_DETAIL_UNREACHABLE();
+  }
+};
+
+/// The count of services that are declared lazily but never used
+constexpr std::size_t unused_service_count = 256;
+
+/// The Interface of a service that is declared but never used
+template <std::size_t Index>
+class UnusedInterface : public Interface {
+public:
+  using Interface::Interface;
+
+  static Interface::Id id() noexcept {
+    static Interface::Id const this_id{
+        format(FMT_STRING("idle::bench::UnusedInterface<{}>"), Index)};
+    return this_id;
+  }
+  Interface::Id type() const noexcept override {
+    return id();
+  }
+  static bool classof(Interface const& inter) noexcept {
+    return inter.type() == id();
+  }
+};
+
+template <std::size_t Index>
+class UnusedService final : public Implements<UnusedInterface<Index>> {
+public:
+  using Implements<UnusedInterface<Index>>::Implements;
+
+  IDLE_SERVICE
+};
+
+template <std::size_t Index>
+Ref<Service> spawn_unused(Inheritance parent) {
+  return spawn<UnusedService<Index>>(std::move(parent));
+}
+template <std::size_t Index>
+Interface::Id unused_id() {
+  return UnusedInterface<Index>::id();
+}
+
+/// Declares an UnusedService lazily as IDLE_DECLARE_LAZY does it,
+/// which can't be used with class templates.
+template <std::size_t Index>
+struct UnusedDeclaration {
+  detail::ServiceDeclaration const declaration{&spawn_unused<Index>,
+                                               &unused_id<Index>};
+};
+
+template <std::size_t... Indices>
+struct UnusedDeclarations : UnusedDeclaration<Indices>... {};
+
+template <std::size_t... Indices>
+UnusedDeclarations<Indices...> declare_unused(std::index_sequence<Indices...>);
+
+static decltype(declare_unused(
+    std::make_index_sequence<unused_service_count>{})) unused_declarations;
+
+/// Instantiates all unused services as IDLE_DECLARE would do it
+template <std::size_t... Indices>
+std::vector<Ref<Service>> spawn_unused_eagerly(std::index_sequence<Indices...>,
+                                               Context& context) {
+  using factory_t = Ref<Service> (*)(Inheritance);
+  static factory_t const factories[] = {&spawn_unused<Indices>...};
+
+  std::vector<Ref<Service>> services;
+  services.reserve(sizeof...(Indices));
+  for (factory_t const factory : factories) {
+    Ref<Service> current = factory(context);
+    current->init();
+    services.push_back(std::move(current));
+  }
+  return services;
+}
+
+/// The count of event loop hops performed by a single lifecycle hook
+constexpr std::size_t lifecycle_steps = 3;
+
+/// A service with multi step asynchronous lifecycle hooks,
+/// that are expressed through continuation chains.
+class ContinuableHooks final : public Implements<> {
+public:
+  using Super::Super;
+
+protected:
+  continuable<> onStart() override {
+    return steps(lifecycle_steps);
+  }
+  continuable<> onStop() override {
+    return steps(lifecycle_steps);
+  }
+
+private:
+  continuable<> steps(std::size_t remaining) {
+    if (!remaining) {
+      return make_ready_continuable();
+    }
+
+    return root().event_loop().async_post([] {}).then([this, remaining] {
+      return steps(remaining - 1);
+    });
+  }
+
+  IDLE_SERVICE
+};
+
+#ifdef IDLE_HAS_COROUTINES
+/// A service with the same lifecycle hooks as ContinuableHooks,
+/// that are expressed through coroutines.
+class TaskHooks final : public Implements<> {
+public:
+  using Super::Super;
+
+protected:
+  continuable<> onStart() override {
+    return steps();
+  }
+  continuable<> onStop() override {
+    return steps();
+  }
+
+private:
+  Task<> steps() {
+    for (std::size_t i = 0; i < lifecycle_steps; ++i) {
+      co_await resume_on(root().event_loop());
+    }
+  }
+
+  IDLE_SERVICE
+};
+#endif // IDLE_HAS_COROUTINES
+
+using Clock = std::chrono::steady_clock;
+
+/// Collects the durations of the iterations of a scenario
+class Samples {
+public:
+  void add(Clock::time_point begin) {
+    add(Clock::now() - begin);
+  }
+  void add(Clock::duration elapsed) {
+    micros_.push_back(
+        std::chrono::duration<double, std::micro>(elapsed).count());
+  }
+
+  nlohmann::json summarize() const {
+    nlohmann::json result;
+    result["iterations"] = micros_.size();
+    if (micros_.empty()) {
+      return result;
+    }
+
+    std::vector<double> sorted = micros_;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0;
+    for (double current : sorted) {
+      total += current;
+    }
+
+    auto percentile = [&](std::size_t p) {
+      return sorted[std::min(sorted.size() - 1, sorted.size() * p / 100U)];
+    };
+
+    result["min_us"] = sorted.front();
+    result["mean_us"] = total / static_cast<double>(sorted.size());
+    result["p50_us"] = percentile(50);
+    result["p99_us"] = percentile(99);
+    result["max_us"] = sorted.back();
+    return result;
+  }
+
+  double mean() const noexcept {
+    double total = 0;
+    for (double current : micros_) {
+      total += current;
+    }
+    return micros_.empty() ? 0. : total / static_cast<double>(micros_.size());
+  }
+
+private:
+  std::vector<double> micros_;
+};
+
+/// Invokes the factory `count` times sequentially
+template <typename Factory>
+continuable<> repeat(std::size_t count, Factory factory) {
+  if (!count) {
+    return make_ready_continuable();
+  }
+
+  return factory().then([count, factory]() mutable {
+    return repeat(count - 1, std::move(factory));
+  });
+}
+
+/// Performs read_iterations reads on every of the read_threads threads
+/// and samples the time each thread took.
+template <typename Read>
+void sample_reads(Samples& samples, Read const& read) {
+  std::vector<Clock::duration> elapsed(read_threads);
+  std::vector<std::thread> threads;
+
+  for (std::size_t i = 0; i < read_threads; ++i) {
+    threads.emplace_back([&, i] {
+      std::uint64_t sum = 0;
+      auto const begin = Clock::now();
+      for (std::size_t j = 0; j < read_iterations; ++j) {
+        sum += read();
+      }
+      elapsed[i] = Clock::now() - begin;
+      read_sink.fetch_add(sum, std::memory_order_relaxed);
+    });
+  }
+
+  for (std::size_t i = 0; i < read_threads; ++i) {
+    threads[i].join();
+    samples.add(elapsed[i]);
+  }
+}
+
+/// Runs a fresh Context on a separate thread and returns the time from its
+/// creation until the first tick of its event loop after its initialization.
+static Clock::duration time_to_first_tick(bool eager) {
+  Clock::duration elapsed{};
+
+  std::thread runner([&] {
+    auto const begin = Clock::now();
+    Persistent<Context> context;
+
+    std::vector<Ref<Service>> services;
+    if (eager) {
+      context->event_loop().dispatch([&] {
+        services = spawn_unused_eagerly(
+            std::make_index_sequence<unused_service_count>{}, *context);
+      });
+    }
+
+    context->event_loop().dispatch([&] {
+      elapsed = Clock::now() - begin;
+
+      for (Ref<Service> const& service : services) {
+        service->destroy();
+      }
+      services.clear();
+
+      // Stop the context after it was started by Context::run
+      context->event_loop().post([&] {
+        context->stop(0);
+      });
+    });
+
+    context->run();
+  });
+
+  runner.join();
+  return elapsed;
+}
+
+/// Measures the worst delay of work posted to the event loop
+class StallProbe : public std::enable_shared_from_this<StallProbe> {
+public:
+  explicit StallProbe(Context& root)
+    : root_(root) {}
+
+  void start() {
+    active_ = true;
+    schedule();
+  }
+
+  /// Stops the probe and returns the worst delay
+  Clock::duration stop() noexcept {
+    active_ = false;
+    return worst_;
+  }
+
+private:
+  void schedule() {
+    auto const posted = Clock::now();
+    root_.event_loop().post([self = shared_from_this(), posted] {
+      self->worst_ = std::max(self->worst_, Clock::now() - posted);
+      if (self->active_) {
+        self->schedule();
+      }
+    });
+  }
+
+  Context& root_;
+  Clock::duration worst_{};
+  bool active_{false};
+};
+
+struct Options {
+  TopologyKind kind{TopologyKind::Random};
+  std::size_t nodes{256};
+  std::size_t edges{512};
+  std::uint64_t seed{1};
+  std::size_t iterations{10};
+  std::size_t messages{100000};
+  std::vector<std::string> scenarios;
+  std::string output;
+};
+
+class BenchDriver final : public Implements<Collection> {
+public:
+  explicit BenchDriver(Inheritance parent, Options options)
+    : Super(std::move(parent))
+    , options_(std::move(options))
+    , topology_(make_topology(options_.kind, options_.nodes, options_.edges,
+                              options_.seed)) {}
+
+  /// Runs all selected scenarios and writes the results
+  continuable<> run() {
+    IDLE_ASSERT(root().is_on_event_loop());
+
+    result_["topology"] = {
+        {"kind", std::string(topology_kind_name(topology_.kind))},
+        {"nodes", topology_.nodes.size()},
+        {"edges", topology_.edges},
+        {"layers", topology_.layers},
+        {"seed", options_.seed}};
+
+    using scenario_t = continuable<nlohmann::json> (BenchDriver::*)();
+    static std::pair<char const*, scenario_t> const scenarios[] = {
+        {"cold_start", &BenchDriver::coldStart},
+        {"static_start", &BenchDriver::staticStart},
+        {"declared_start", &BenchDriver::declaredStart},
+        {"full_stop", &BenchDriver::fullStop},
+        {"restart", &BenchDriver::restart},
+        {"leaf_toggle", &BenchDriver::leafToggle},
+        {"churn", &BenchDriver::churn},
+        {"var_storm", &BenchDriver::varStorm},
+        {"var_batch", &BenchDriver::varBatch},
+        {"registry_lookup", &BenchDriver::registryLookup},
+        {"dyn_read", &BenchDriver::dynRead},
+        {"log_throughput", &BenchDriver::logThroughput},
+        {"lifecycle_allocations", &BenchDriver::lifecycleAllocations},
+        {"command_contention", &BenchDriver::commandContention},
+        {"graph_export", &BenchDriver::graphExport}};
+
+    continuable<> chain = make_ready_continuable();
+    for (auto const& scenario : scenarios) {
+      if (!isSelected(scenario.first)) {
+        continue;
+      }
+
+      char const* const name = scenario.first;
+      scenario_t const method = scenario.second;
+      chain = std::move(chain).then([this, name, method] {
+        return (this->*method)().then([this, name](nlohmann::json result) {
+          result_["scenarios"][name] = std::move(result);
+        });
+      });
+    }
+
+    return std::move(chain).then([this] {
+      writeResult();
+    });
+  }
+
+private:
+  bool isSelected(StringView name) const noexcept {
+    return options_.scenarios.empty() ||
+           std::any_of(options_.scenarios.begin(), options_.scenarios.end(),
+                       [&](std::string const& selected) {
+                         return name == selected;
+                       });
+  }
+
+  Inheritance inherit() noexcept {
+    return static_cast<Collection&>(*this).inherit();
+  }
+
+  void spawnTopology() {
+    IDLE_ASSERT(nodes_.empty());
+
+    nodes_.reserve(topology_.nodes.size());
+    for (TopologyNode const& node : topology_.nodes) {
+      Ref<Service> current = spawn_node(std::make_index_sequence<max_layers>{},
+                                        node, inherit());
+      current->init();
+      nodes_.push_back(std::move(current));
+    }
+  }
+
+  continuable<> startTopology() {
+    std::vector<continuable<>> started;
+    started.reserve(nodes_.size());
+    for (Ref<Service> const& node : nodes_) {
+      started.push_back(node->start());
+    }
+    return when_all(std::move(started));
+  }
+
+  continuable<> stopTopology() {
+    std::vector<continuable<>> stopped;
+    stopped.reserve(nodes_.size());
+    for (Ref<Service> const& node : nodes_) {
+      stopped.push_back(node->stop());
+    }
+    return when_all(std::move(stopped)).then([this] {
+      nodes_.clear();
+    });
+  }
+
+  /// Measures the start of the whole topology
+  continuable<nlohmann::json> coldStart() {
+    auto samples = std::make_shared<Samples>();
+
+    return repeat(options_.iterations,
+                  [this, samples] {
+                    spawnTopology();
+
+                    auto const begin = Clock::now();
+                    return startTopology()
+                        .then([samples, begin] {
+                          samples->add(begin);
+                        })
+                        .then([this] {
+                          return stopTopology();
+                        });
+                  })
+        .then([samples] {
+          return samples->summarize();
+        });
+  }
+
+  /// Compares the time from the creation of a Context until its first event
+  /// loop tick, with unused_service_count services that are declared lazily,
+  /// against the same services being instantiated eagerly.
+  continuable<nlohmann::json> declaredStart() {
+    Samples lazy;
+    Samples eager;
+    for (std::size_t i = 0; i < options_.iterations; ++i) {
+      lazy.add(time_to_first_tick(false));
+      eager.add(time_to_first_tick(true));
+    }
+
+    nlohmann::json result;
+    result["declared"] = unused_service_count;
+    result["lazy"] = lazy.summarize();
+    result["eager"] = eager.summarize();
+    result["speedup"] = lazy.mean() > 0. ? eager.mean() / lazy.mean() : 0.;
+    return make_ready_continuable(std::move(result));
+  }
+
+  /// Compares the start of the whole topology through individual start
+  /// requests against the start through a precomputed StaticComposition.
+  ///
+  /// The composition is computed once before the measurement, as it would be
+  /// for services that are linked statically into the same binary.
+  /// Run it through `--scenario static_start --nodes 10000` for a graph
+  /// of 10k services.
+  continuable<nlohmann::json> staticStart() {
+    auto dynamic = std::make_shared<Samples>();
+    auto composed = std::make_shared<Samples>();
+
+    return repeat(options_.iterations,
+                  [this, dynamic, composed] {
+                    spawnTopology();
+
+                    auto const begin = Clock::now();
+                    return startTopology()
+                        .then([dynamic, begin] {
+                          dynamic->add(begin);
+                        })
+                        .then([this] {
+                          return stopTopology();
+                        })
+                        .then([this, composed] {
+                          spawnTopology();
+
+                          std::vector<WeakRef<Service>> services;
+                          services.reserve(nodes_.size());
+                          for (Ref<Service> const& node : nodes_) {
+                            services.push_back(weakOf(*node));
+                          }
+
+                          auto composition =
+                              std::make_shared<StaticComposition>(
+                                  root().compose(services));
+
+                          auto const begin = Clock::now();
+                          return root().start(*composition).then(
+                              [composed, begin, composition] {
+                                composed->add(begin);
+                              });
+                        })
+                        .then([this] {
+                          return stopTopology();
+                        });
+                  })
+        .then([dynamic, composed] {
+          nlohmann::json result;
+          result["dynamic"] = dynamic->summarize();
+          result["static"] = composed->summarize();
+          result["speedup"] = composed->mean() > 0.
+                                  ? dynamic->mean() / composed->mean()
+                                  : 0.;
+          return result;
+        });
+  }
+
+  /// Measures the stop of the whole running topology
+  continuable<nlohmann::json> fullStop() {
+    auto samples = std::make_shared<Samples>();
+
+    return repeat(options_.iterations,
+                  [this, samples] {
+                    spawnTopology();
+
+                    return startTopology().then([this, samples] {
+                      auto const begin = Clock::now();
+                      return stopTopology().then([samples, begin] {
+                        samples->add(begin);
+                      });
+                    });
+                  })
+        .then([samples] {
+          return samples->summarize();
+        });
+  }
+
+  /// Measures the restart of a single service inside the running topology,
+  /// including the update of its dependents.
+  continuable<nlohmann::json> restart() {
+    auto samples = std::make_shared<Samples>();
+    spawnTopology();
+
+    // Restart a provider from the middle of the topology
+    auto const middle = std::find_if(topology_.nodes.begin(),
+                                     topology_.nodes.end(),
+                                     [&](TopologyNode const& node) {
+                                       return node.layer ==
+                                              topology_.layers / 2;
+                                     });
+    IDLE_ASSERT(middle != topology_.nodes.end());
+    Ref<Service> target = nodes_[static_cast<std::size_t>(
+        middle - topology_.nodes.begin())];
+
+    return startTopology()
+        .then([this, samples, target] {
+          return repeat(options_.iterations, [this, samples, target] {
+            auto const begin = Clock::now();
+            return target->stop()
+                .then([target] {
+                  return target->start();
+                })
+                .then([this] {
+                  return root().update();
+                })
+                .then([samples, begin] {
+                  samples->add(begin);
+                });
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([samples] {
+          return samples->summarize();
+        });
+  }
+
+  /// Measures toggling a single leaf service inside the running topology
+  /// and the following system update, which only visits the clusters that
+  /// changed instead of the whole system.
+  ///
+  /// Run it through `--scenario leaf_toggle --nodes 20000` for a system
+  /// that is large compared to the change.
+  continuable<nlohmann::json> leafToggle() {
+    auto samples = std::make_shared<Samples>();
+    auto updates = std::make_shared<Samples>();
+    spawnTopology();
+
+    // Nothing depends on the services of the last layer
+    auto const leaf = std::find_if(topology_.nodes.rbegin(),
+                                   topology_.nodes.rend(),
+                                   [&](TopologyNode const& node) {
+                                     return node.layer + 1 == topology_.layers;
+                                   });
+    IDLE_ASSERT(leaf != topology_.nodes.rend());
+    Ref<Service> target = nodes_[static_cast<std::size_t>(
+        topology_.nodes.rend() - leaf - 1)];
+
+    return startTopology()
+        .then([this, samples, updates, target] {
+          return repeat(options_.iterations, [this, samples, updates,
+                                              target] {
+            auto const begin = Clock::now();
+            return target->stop()
+                .then([target] {
+                  return target->start();
+                })
+                .then([this, updates] {
+                  auto const updating = Clock::now();
+                  return root().update().then([updates, updating] {
+                    updates->add(updating);
+                  });
+                })
+                .then([samples, begin] {
+                  samples->add(begin);
+                });
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([samples, updates] {
+          nlohmann::json result = samples->summarize();
+          result["update"] = updates->summarize();
+          return result;
+        });
+  }
+
+  /// Measures publishing and revoking an Interface that is consumed
+  /// through DynDependencyLists.
+  continuable<nlohmann::json> churn() {
+    auto samples = std::make_shared<Samples>();
+
+    Ref<Service> provider = spawn<ChurnProvider>(inherit());
+    provider->init();
+
+    std::size_t const consumers = std::max(std::size_t(1U),
+                                           topology_.nodes.size());
+    for (std::size_t i = 0; i < consumers; ++i) {
+      Ref<Service> consumer = spawn<ChurnConsumer>(inherit());
+      consumer->init();
+      nodes_.push_back(std::move(consumer));
+    }
+
+    return startTopology()
+        .then([this, samples, provider] {
+          return repeat(options_.iterations, [samples, provider] {
+            auto const begin = Clock::now();
+            return provider->start()
+                .then([provider] {
+                  return provider->stop();
+                })
+                .then([samples, begin] {
+                  samples->add(begin);
+                });
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([samples, consumers] {
+          nlohmann::json result = samples->summarize();
+          result["consumers"] = consumers;
+          return result;
+        });
+  }
+
+  /// Measures updates of a Var that is read by many services
+  continuable<nlohmann::json> varStorm() {
+    auto samples = std::make_shared<Samples>();
+
+    Ref<StormWriter> writer = spawn<StormWriter>(inherit());
+    writer->init();
+    nodes_.push_back(writer);
+
+    std::size_t const readers = std::max(std::size_t(1U),
+                                         topology_.nodes.size());
+    for (std::size_t i = 0; i < readers; ++i) {
+      Ref<Service> reader = spawn<StormReader>(inherit());
+      reader->init();
+      nodes_.push_back(std::move(reader));
+    }
+
+    auto value = std::make_shared<std::int64_t>(0);
+    return startTopology()
+        .then([this, samples, writer, value] {
+          return repeat(options_.iterations, [this, samples, writer, value] {
+            auto const begin = Clock::now();
+            return writer->start()
+                .then([writer, value] {
+                  writer->write(++*value);
+                })
+                .then([this] {
+                  return root().update();
+                })
+                .then([samples, begin] {
+                  samples->add(begin);
+                });
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([samples, readers] {
+          nlohmann::json result = samples->summarize();
+          result["readers"] = readers;
+          return result;
+        });
+  }
+
+  /// Measures a Properties change touching 1000 Vars across 100 services,
+  /// once with a hook per Var and once grouped per service.
+  continuable<nlohmann::json> varBatch() {
+    auto result = std::make_shared<nlohmann::json>();
+    // The value is shared such that every write is a change
+    auto value = std::make_shared<std::int64_t>(0);
+
+    return varBatchOf<BatchReader>("individual", result, value)
+        .then([this, result, value] {
+          return varBatchOf<GroupedBatchReader>("grouped", result, value);
+        })
+        .then([result] {
+          (*result)["vars"] = batch_services * batch_vars_per_service;
+          (*result)["services"] = batch_services;
+          return std::move(*result);
+        });
+  }
+
+  template <typename Reader>
+  continuable<> varBatchOf(char const* name,
+                           std::shared_ptr<nlohmann::json> result,
+                           std::shared_ptr<std::int64_t> value) {
+    auto samples = std::make_shared<Samples>();
+
+    Ref<BatchWriter> writer = spawn<BatchWriter>(inherit());
+    writer->init();
+    nodes_.push_back(writer);
+
+    for (std::size_t i = 0; i < batch_services; ++i) {
+      Ref<Service> reader = spawn<Reader>(inherit(), i);
+      reader->init();
+      nodes_.push_back(std::move(reader));
+    }
+
+    batch_counters = {};
+    std::size_t const iterations = options_.iterations;
+
+    return startTopology()
+        .then([this, samples, writer, value] {
+          return repeat(options_.iterations, [this, samples, writer, value] {
+            std::size_t const expected = batch_counters.applied +
+                                         batch_services *
+                                             batch_vars_per_service;
+
+            auto const begin = Clock::now();
+            writer->write(++*value);
+
+            // Wait until the change was committed and reached all Vars
+            return loop([this, expected] {
+                     return root().event_loop().async_post([] {}).then(
+                         [expected]() -> loop_result<> {
+                           if (batch_counters.applied < expected) {
+                             return loop_continue();
+                           } else {
+                             return loop_break();
+                           }
+                         });
+                   })
+                .then([samples, begin] {
+                  samples->add(begin);
+                });
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([result, name, samples, iterations] {
+          nlohmann::json current = samples->summarize();
+          current["hooks_per_change"] =
+              iterations ? static_cast<double>(batch_counters.hooks) /
+                               static_cast<double>(iterations)
+                         : 0.;
+          (*result)[name] = std::move(current);
+        });
+  }
+
+  /// Measures the throughput of Interface lookups from threads outside of
+  /// the event loop while providers are reloaded, once through the
+  /// registry snapshot and once by posting the lookup to the event loop.
+  continuable<nlohmann::json> registryLookup() {
+    auto result = std::make_shared<nlohmann::json>();
+
+    return registryLookupOf("snapshot", true, result)
+        .then([this, result] {
+          return registryLookupOf("posted", false, result);
+        })
+        .then([result] {
+          (*result)["threads"] = lookup_threads;
+          return std::move(*result);
+        });
+  }
+
+  continuable<> registryLookupOf(char const* name, bool snapshot,
+                                 std::shared_ptr<nlohmann::json> result) {
+    auto stop = std::make_shared<std::atomic<bool>>(false);
+    auto lookups = std::make_shared<std::atomic<std::uint64_t>>(0U);
+    auto threads = std::make_shared<std::vector<std::thread>>();
+
+    Context& context = root();
+    for (std::size_t i = 0; i < lookup_threads; ++i) {
+      threads->emplace_back([&context, snapshot, stop, lookups] {
+        while (!stop->load(std::memory_order_relaxed)) {
+          if (snapshot) {
+            RegistryView const view = context.snapshot();
+            for (WeakRef<Interface> const& inter :
+                 view->find<ChurnInterface>()) {
+              (void)inter.lock();
+            }
+          } else {
+            auto found = std::make_shared<std::promise<std::size_t>>();
+            std::future<std::size_t> future = found->get_future();
+            context.event_loop().post([&context, found] {
+              found->set_value(
+                  context.find<ChurnInterface>()->interfaces().size());
+            });
+
+            // The event loop joins the threads when the scenario finishes
+            while (future.wait_for(std::chrono::milliseconds(1)) ==
+                   std::future_status::timeout) {
+              if (stop->load(std::memory_order_relaxed)) {
+                return;
+              }
+            }
+          }
+
+          lookups->fetch_add(1U, std::memory_order_relaxed);
+        }
+      });
+    }
+
+    // Every reload replaces the oldest provider by a new one
+    auto providers = std::make_shared<std::vector<Ref<Service>>>();
+    for (std::size_t i = 0; i < lookup_providers; ++i) {
+      Ref<Service> provider = spawn<ChurnProvider>(inherit());
+      provider->init();
+      providers->push_back(std::move(provider));
+    }
+
+    std::size_t const reloads = options_.iterations * lookup_reloads;
+    auto const begin = Clock::now();
+
+    return repeat(reloads,
+                  [this, providers] {
+                    return root().event_loop().async_post([this, providers] {
+                      providers->front()->destroy();
+                      providers->erase(providers->begin());
+
+                      Ref<Service> provider = spawn<ChurnProvider>(inherit());
+                      provider->init();
+                      providers->push_back(std::move(provider));
+                    });
+                  })
+        .then([result, name, stop, lookups, threads, providers, reloads,
+               begin] {
+          stop->store(true, std::memory_order_relaxed);
+          for (std::thread& thread : *threads) {
+            thread.join();
+          }
+
+          double const seconds =
+              std::chrono::duration<double>(Clock::now() - begin).count();
+
+          for (Ref<Service> const& provider : *providers) {
+            provider->destroy();
+          }
+
+          nlohmann::json current;
+          current["lookups"] = lookups->load();
+          current["lookups_per_second"] =
+              seconds > 0. ? static_cast<double>(lookups->load()) / seconds
+                           : 0.;
+          current["reloads"] = reloads;
+          current["seconds"] = seconds;
+          (*result)[name] = std::move(current);
+        });
+  }
+
+  /// Measures the latency of reading a dependency from threads outside of
+  /// the event loop, once pinned through a ConcurrentDynDependency and once
+  /// by locking a Handle into a Use.
+  continuable<nlohmann::json> dynRead() {
+    auto pinned = std::make_shared<Samples>();
+    auto used = std::make_shared<Samples>();
+
+    Ref<ReadProvider> provider = spawn<ReadProvider>(inherit());
+    provider->init();
+    nodes_.push_back(provider);
+
+    Ref<ReadConsumer> consumer = spawn<ReadConsumer>(inherit());
+    consumer->init();
+    nodes_.push_back(consumer);
+
+    return startTopology()
+        .then([this, pinned, used, provider, consumer] {
+          Handle<ReadInterface> handle = handleOf(
+              static_cast<ReadInterface&>(*provider));
+
+          return repeat(options_.iterations, [pinned, used, consumer,
+                                              handle] {
+            sample_reads(*pinned, [&] {
+              return consumer->current()->value();
+            });
+            sample_reads(*used, [&]() -> std::uint64_t {
+              if (Use<ReadInterface> current = handle.lock()) {
+                return current->value();
+              } else {
+                return 0U;
+              }
+            });
+            return make_ready_continuable();
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([pinned, used] {
+          auto summarize = [](Samples const& samples) {
+            nlohmann::json result = samples.summarize();
+            result["ns_per_read"] = samples.mean() * 1000. /
+                                    static_cast<double>(read_iterations);
+            return result;
+          };
+
+          nlohmann::json result;
+          result["pinned"] = summarize(*pinned);
+          result["use"] = summarize(*used);
+          result["threads"] = read_threads;
+          result["reads"] = read_iterations;
+          return result;
+        });
+  }
+
+  /// Measures the throughput of the Log into a discarding Logger
+  continuable<nlohmann::json> logThroughput() {
+    auto samples = std::make_shared<Samples>();
+
+    Ref<CountingLogger> logger = spawn<CountingLogger>(inherit());
+    logger->init();
+    nodes_.push_back(logger);
+
+    Ref<LogEmitter> emitter = spawn<LogEmitter>(inherit());
+    emitter->init();
+    nodes_.push_back(emitter);
+
+    std::size_t const messages = options_.messages;
+    return startTopology()
+        .then([this, samples, emitter, messages] {
+          return repeat(options_.iterations, [samples, emitter, messages] {
+            auto const begin = Clock::now();
+            emitter->emit(messages);
+            samples->add(begin);
+            return make_ready_continuable();
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([samples, logger, messages] {
+          nlohmann::json result = samples->summarize();
+          result["messages"] = messages;
+          result["received"] = logger->messages();
+
+          double const mean = samples->mean();
+          result["messages_per_second"] = mean > 0.
+                                              ? static_cast<double>(messages) *
+                                                    1000000. / mean
+                                              : 0.;
+          return result;
+        });
+  }
+
+  /// Measures the allocations per start and stop cycle of a service
+  /// with asynchronous lifecycle hooks, once for every hook style.
+  continuable<nlohmann::json> lifecycleAllocations() {
+    auto result = std::make_shared<nlohmann::json>();
+
+    continuable<> measured = measureLifecycle<ContinuableHooks>(result,
+                                                                "continuable");
+#ifdef IDLE_HAS_COROUTINES
+    measured = std::move(measured).then([this, result] {
+      return measureLifecycle<TaskHooks>(result, "task");
+    });
+#endif // IDLE_HAS_COROUTINES
+
+    return std::move(measured).then([result] {
+      return std::move(*result);
+    });
+  }
+
+  /// Measures the registration of commands on the event loop,
+  /// while several threads complete commands concurrently.
+  continuable<nlohmann::json> commandContention() {
+    struct Completers {
+      std::atomic<bool> stop{false};
+      std::atomic<std::uint64_t> completions{0};
+      std::vector<std::thread> threads;
+      Clock::time_point begin;
+    };
+
+    auto samples = std::make_shared<Samples>();
+    auto completers = std::make_shared<Completers>();
+    auto counter = std::make_shared<std::size_t>(0);
+
+    Ref<CommandProcessor> processor = CommandProcessor::create(inherit());
+    processor->owner().init();
+
+    std::size_t const threads = std::max(
+        2U, std::thread::hardware_concurrency() / 2U);
+    std::size_t const commands = options_.nodes;
+
+    return processor->owner()
+        .start()
+        .then([this, samples, completers, counter, processor, threads,
+               commands] {
+          completers->begin = Clock::now();
+          for (std::size_t i = 0; i < threads; ++i) {
+            completers->threads.emplace_back(
+                [completers, target = processor.get()] {
+                  SilentSession session;
+                  while (!completers->stop.load(std::memory_order_relaxed)) {
+                    (void)target->complete(session, "bench-");
+                    completers->completions.fetch_add(
+                        1, std::memory_order_relaxed);
+                  }
+                });
+          }
+
+          return repeat(options_.iterations, [this, samples, counter,
+                                              commands] {
+            auto const begin = Clock::now();
+
+            std::vector<Ref<ChurnCommand>> registered;
+            registered.reserve(commands);
+            for (std::size_t i = 0; i < commands; ++i) {
+              registered.push_back(spawn<ChurnCommand>(
+                  inherit(), format(FMT_STRING("bench-{}"), (*counter)++)));
+              registered.back()->init();
+            }
+            for (Ref<ChurnCommand> const& command : registered) {
+              command->destroy();
+            }
+
+            samples->add(begin);
+            return make_ready_continuable();
+          });
+        })
+        .then([samples, completers, processor, threads, commands] {
+          completers->stop.store(true, std::memory_order_relaxed);
+          for (std::thread& thread : completers->threads) {
+            thread.join();
+          }
+
+          double const elapsed = std::chrono::duration<double>(
+                                     Clock::now() - completers->begin)
+                                     .count();
+          std::uint64_t const completions = completers->completions.load(
+              std::memory_order_relaxed);
+
+          nlohmann::json result = samples->summarize();
+          result["threads"] = threads;
+          result["commands_per_iteration"] = commands;
+          result["completions"] = completions;
+          result["completions_per_second"] =
+              elapsed > 0. ? static_cast<double>(completions) / elapsed : 0.;
+
+          return processor->owner().stop().then([result] {
+            return result;
+          });
+        });
+  }
+
+  /// Compares the event loop stall of a synchronous graphviz export of the
+  /// whole service graph against the streaming export of the Visualizer,
+  /// as well as a delta export of the unchanged graph.
+  ///
+  /// Run it through `--scenario graph_export --nodes 50000` for a graph
+  /// of 50k services.
+  continuable<nlohmann::json> graphExport() {
+    auto blocking = std::make_shared<Samples>();
+    auto streamed = std::make_shared<Samples>();
+    auto stalls = std::make_shared<Samples>();
+    auto delta = std::make_shared<Samples>();
+
+    std::string const path = (boost::filesystem::temp_directory_path() /
+                              boost::filesystem::unique_path(
+                                  "idle-bench-%%%%%%.gv"))
+                                 .generic_string();
+
+    Ref<Visualizer> visualizer = Visualizer::create(inherit());
+    visualizer->init();
+
+    spawnTopology();
+    nodes_.push_back(visualizer);
+
+    return startTopology()
+        .then([this, blocking, streamed, stalls, delta, visualizer, path] {
+          return repeat(options_.iterations, [this, blocking, streamed, stalls,
+                                              delta, visualizer, path] {
+            {
+              // The synchronous export stalls the event loop completely
+              auto const begin = Clock::now();
+              std::ofstream file(path, std::ios::trunc);
+              graphviz(file, ServiceDependencyGraph(root(), graph_view));
+              blocking->add(begin);
+            }
+
+            auto probe = std::make_shared<StallProbe>(root());
+            probe->start();
+
+            auto const begin = Clock::now();
+            return visualizer->exportGraph(path).then(
+                [streamed, stalls, delta, visualizer, path, probe,
+                 begin](std::size_t id) {
+                  streamed->add(begin);
+                  stalls->add(probe->stop());
+
+                  Visualizer::ExportOptions options;
+                  options.since = id;
+
+                  auto const delta_begin = Clock::now();
+                  return visualizer->exportGraph(path, options)
+                      .then([delta, delta_begin](std::size_t) {
+                        delta->add(delta_begin);
+                      });
+                });
+          });
+        })
+        .then([this] {
+          return stopTopology();
+        })
+        .then([blocking, streamed, stalls, delta, path] {
+          boost::system::error_code ec;
+          boost::filesystem::remove(path, ec);
+
+          nlohmann::json result;
+          result["blocking"] = blocking->summarize();
+          result["streamed"] = streamed->summarize();
+          result["streamed_worst_stall"] = stalls->summarize();
+          result["delta"] = delta->summarize();
+          return result;
+        });
+  }
+
+  template <typename Hooks>
+  continuable<> measureLifecycle(std::shared_ptr<nlohmann::json> result,
+                                 char const* name) {
+    auto samples = std::make_shared<Samples>();
+    auto allocations = std::make_shared<std::uint64_t>(0);
+
+    Ref<Hooks> service = spawn<Hooks>(inherit());
+    service->init();
+
+    std::size_t const iterations = options_.iterations;
+    return repeat(iterations,
+                  [samples, allocations, service] {
+                    auto const begin = Clock::now();
+                    std::uint64_t const before = allocation_count();
+
+                    return service->start()
+                        .then([service] {
+                          return service->stop();
+                        })
+                        .then([samples, allocations, begin, before] {
+                          *allocations += allocation_count() - before;
+                          samples->add(begin);
+                        });
+                  })
+        .then([result, name, samples, allocations, iterations] {
+          nlohmann::json current = samples->summarize();
+          current["allocations_per_cycle"] =
+              iterations ? static_cast<double>(*allocations) /
+                               static_cast<double>(iterations)
+                         : 0.;
+          (*result)[name] = std::move(current);
+        });
+  }
+
+  void writeResult() {
+    Metrics& metrics = root().metrics();
+    for (std::size_t i = 0; i < Metrics::counter_count; ++i) {
+      auto const counter = static_cast<Metrics::Counter>(i);
+      result_["metrics"][Metrics::nameOf(counter)] = metrics.get(counter);
+    }
+
+    std::string const dumped = result_.dump(2);
+    if (options_.output.empty()) {
+      std::cout << dumped << std::endl;
+    } else {
+      std::ofstream file(options_.output, std::ios::trunc);
+      file << dumped << std::endl;
+    }
+  }
+
+  Options const options_;
+  Topology const topology_;
+  std::vector<Ref<Service>> nodes_;
+  nlohmann::json result_;
+
+  IDLE_SERVICE
+};
+
+static void print_usage(char const* program) {
+  std::cerr << "Usage: " << program << R"( [options]
+
+Options:
+  --topology <chain|fan-out|fan-in|random>  (default: random)
+  --nodes <count>         The count of services          (default: 256)
+  --edges <count>         The target count of edges      (default: 512)
+  --seed <value>          The seed of random topologies  (default: 1)
+  --iterations <count>    The iterations per scenario    (default: 10)
+  --messages <count>      The messages per log iteration (default: 100000)
+  --scenario <name>       Runs only the given scenario, can be repeated:
+                          cold_start, static_start, declared_start,
+                          full_stop, restart, leaf_toggle, churn, var_storm,
+                          var_batch, registry_lookup, dyn_read,
+                          log_throughput, lifecycle_allocations,
+                          command_contention, graph_export
+  --output <file>         Writes the JSON result to the given file
+)";
+}
+
+static bool parse_options(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+
+    std::string const value = argv[++i];
+    try {
+      if (arg == "--topology") {
+        if (!parse_topology_kind(value, options.kind)) {
+          return false;
+        }
+      } else if (arg == "--nodes") {
+        options.nodes = std::stoull(value);
+      } else if (arg == "--edges") {
+        options.edges = std::stoull(value);
+      } else if (arg == "--seed") {
+        options.seed = std::stoull(value);
+      } else if (arg == "--iterations") {
+        options.iterations = std::stoull(value);
+      } else if (arg == "--messages") {
+        options.messages = std::stoull(value);
+      } else if (arg == "--scenario") {
+        options.scenarios.push_back(value);
+      } else if (arg == "--output") {
+        options.output = value;
+      } else {
+        return false;
+      }
+    } catch (std::exception const&) {
+      return false;
+    }
+  }
+
+  return options.nodes > 0;
+}
+} // namespace bench
+} // namespace idle
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  Persistent<Context> context;
+  Persistent<ReloadableProperties> properties(*context);
+  Persistent<BenchDriver> driver(*context, std::move(options));
+
+  // Var updates are stored inside a temporary properties file
+  auto const path = boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("idle-bench-%%%%%%.toml");
+
+  ReloadableProperties::Config config;
+  config.path = path.generic_string();
+  config.write_back = false;
+  properties->setup(std::move(config));
+
+  (properties->start() && driver->start())
+      .then([&] {
+        return driver->run();
+      })
+      .then([&] {
+        return context->stop(0);
+      })
+      .fail([&](exception_t const&) {
+        context->stop(1);
+      });
+
+  int const exit_code = context->run();
+
+  boost::system::error_code ec;
+  boost::filesystem::remove(path, ec);
+  return exit_code;
+}
@@ -0,0 +1,153 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <random>
+#include <idle/core/detail/unreachable.hpp>
+#include <bench/topology.hpp>
+
+namespace idle {
+namespace bench {
+bool parse_topology_kind(StringView name, TopologyKind& kind) noexcept {
+  if (name == "chain") {
+    kind = TopologyKind::Chain;
+  } else if (name == "fan-out") {
+    kind = TopologyKind::FanOut;
+  } else if (name == "fan-in") {
+    kind = TopologyKind::FanIn;
+  } else if (name == "random") {
+    kind = TopologyKind::Random;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+StringView topology_kind_name(TopologyKind kind) noexcept {
+  switch (kind) {
+    case TopologyKind::Chain:
+      return "chain";
+    case TopologyKind::FanOut:
+      return "fan-out";
+    case TopologyKind::FanIn:
+      return "fan-in";
+    case TopologyKind::Random:
+      return "random";
+  }
+  IDLE_DETAIL_UNREACHABLE();
+}
+
+std::size_t Topology::providers(std::size_t layer) const noexcept {
+  return static_cast<std::size_t>(
+      std::count_if(nodes.begin(), nodes.end(), [&](TopologyNode const& node) {
+        return node.layer == layer;
+      }));
+}
+
+static std::size_t count_edges(Topology const& topology) noexcept {
+  std::size_t edges = 0;
+  for (TopologyNode const& node : topology.nodes) {
+    if (node.layer != 0) {
+      edges += node.collects ? topology.providers(node.layer - 1) : 1U;
+    }
+  }
+  return edges;
+}
+
+Topology make_topology(TopologyKind kind, std::size_t nodes, std::size_t edges,
+                       std::uint64_t seed) {
+  Topology topology;
+  topology.kind = kind;
+  topology.nodes.reserve(nodes);
+
+  switch (kind) {
+    case TopologyKind::Chain: {
+      for (std::size_t i = 0; i < nodes; ++i) {
+        topology.nodes.push_back({i % max_layers, false});
+      }
+      break;
+    }
+    case TopologyKind::FanOut: {
+      for (std::size_t i = 0; i < nodes; ++i) {
+        topology.nodes.push_back({i == 0 ? 0U : 1U, false});
+      }
+      break;
+    }
+    case TopologyKind::FanIn: {
+      for (std::size_t i = 0; i + 1 < nodes; ++i) {
+        topology.nodes.push_back({0U, false});
+      }
+      if (nodes) {
+        topology.nodes.push_back({nodes > 1 ? 1U : 0U, nodes > 1});
+      }
+      break;
+    }
+    case TopologyKind::Random: {
+      std::mt19937_64 engine(seed);
+      std::size_t const layers = std::max(
+          std::size_t(1U), std::min(max_layers, nodes / 4U));
+
+      // Every layer gets at least one provider such that all
+      // dependencies are resolvable.
+      for (std::size_t i = 0; i < nodes; ++i) {
+        std::size_t const layer = i < layers
+                                      ? i
+                                      : std::uniform_int_distribution<
+                                            std::size_t>(0, layers - 1)(engine);
+        topology.nodes.push_back({layer, false});
+      }
+
+      // Turn random nodes into collectors until the edge target is reached
+      std::vector<std::size_t> order(nodes);
+      for (std::size_t i = 0; i < nodes; ++i) {
+        order[i] = i;
+      }
+      std::shuffle(order.begin(), order.end(), engine);
+
+      std::size_t current = count_edges(topology);
+      for (std::size_t index : order) {
+        TopologyNode& node = topology.nodes[index];
+        if (node.layer == 0) {
+          continue;
+        }
+
+        std::size_t const added = topology.providers(node.layer - 1) - 1U;
+        if (added && current + added <= edges) {
+          node.collects = true;
+          current += added;
+        }
+      }
+      break;
+    }
+  }
+
+  for (TopologyNode const& node : topology.nodes) {
+    topology.layers = std::max(topology.layers, node.layer + 1);
+  }
+  topology.edges = count_edges(topology);
+  return topology;
+}
+} // namespace bench
+} // namespace idle
@@ -0,0 +1,82 @@
+
+/*
+ *   _____    _ _        .      .    .
+ *  |_   _|  | | |  .       .           .
+ *    | |  __| | | ___         .    .        .
+ *    | | / _` | |/ _ \                .
+ *   _| || (_| | |  __/ github.com/Naios/idle
+ *  |_____\__,_|_|\___| AGPL v3 (Early Access)
+ *
+ * Copyright(c) 2018 - 2021 Denis Blank <denis.blank at outlook dot com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDLE_TOOLS_BENCH_TOPOLOGY_HPP_INCLUDED
+#define IDLE_TOOLS_BENCH_TOPOLOGY_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <idle/core/util/string_view.hpp>
+
+namespace idle {
+namespace bench {
+/// The count of distinct interfaces a synthetic topology can be built from
+///
+/// Since a Dependency is resolved by the type of its Interface,
+/// every layer of a topology is represented by its own interface type.
+constexpr std::size_t max_layers = 64;
+
+enum class TopologyKind {
+  Chain,  ///< Every node depends on the previous one
+  FanOut, ///< All nodes depend on a single root
+  FanIn,  ///< A single sink collects all nodes of the layer below
+  Random  ///< A random layered DAG with a target count of edges
+};
+
+/// Returns the topology kind of the given name, or false if unknown
+bool parse_topology_kind(StringView name, TopologyKind& kind) noexcept;
+StringView topology_kind_name(TopologyKind kind) noexcept;
+
+struct TopologyNode {
+  /// The layer (and therefore the Interface) this node provides
+  std::size_t layer{0};
+  /// True if the node depends on all providers of the previous layer
+  /// through a DynDependencyList, otherwise it depends on exactly one
+  /// provider through a Dependency.
+  bool collects{false};
+};
+
+struct Topology {
+  TopologyKind kind{TopologyKind::Chain};
+  std::vector<TopologyNode> nodes;
+  std::size_t layers{0};
+  std::size_t edges{0};
+
+  /// Returns the count of nodes that provide the given layer
+  std::size_t providers(std::size_t layer) const noexcept;
+};
+
+/// Generates a synthetic topology of the given kind
+///
+/// Chains that are longer than max_layers are split into parallel chains.
+/// For random topologies `edges` is a target, the resulting count of edges
+/// is stored inside the Topology.
+Topology make_topology(TopologyKind kind, std::size_t nodes, std::size_t edges,
+                       std::uint64_t seed);
+} // namespace bench
+} // namespace idle
+
+#endif // IDLE_TOOLS_BENCH_TOPOLOGY_HPP_INCLUDED